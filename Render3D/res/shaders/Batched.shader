@@ -0,0 +1,34 @@
+$Shader$	%Vertex%
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 a_color;
+
+out vec2 v_texCoord;
+out vec4 v_color;
+
+#include "include/Camera.glsl"
+
+void main()
+{
+	gl_Position = u_viewProj * position * vec4(-1.0, 1.0, 1.0, 1.0);
+	v_texCoord = texCoord;
+	v_color = a_color;
+};
+
+$Shader$	%Fragment%
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_texCoord;
+in vec4 v_color;
+
+uniform sampler2D u_texture;
+
+void main()
+{
+	vec4 texColor = texture(u_texture, v_texCoord);
+	color = texColor * v_color;
+};
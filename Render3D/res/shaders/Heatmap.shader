@@ -0,0 +1,27 @@
+$Shader$	%Vertex%
+#version 330 core
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+
+out vec2 v_texCoord;
+
+void main()
+{
+	gl_Position = vec4(position, 0.0, 1.0);
+	v_texCoord = texCoord;
+};
+
+$Shader$	%Fragment%
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_texCoord;
+
+uniform sampler2D u_texture;
+
+void main()
+{
+	color = texture(u_texture, v_texCoord);
+};
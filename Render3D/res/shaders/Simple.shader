@@ -1,33 +1,75 @@
+$Option$	INSTANCED
+$Option$	ATLAS
+$Option$	UNTINTED
+
 $Shader$	%Vertex%
 #version 330 core
 
 layout(location = 0) in vec4 position;
 layout(location = 1) in vec2 texCoord;
+#ifdef INSTANCED
+layout(location = 2) in mat4 a_model;
+layout(location = 6) in vec4 a_color;
+
+out vec4 v_color;
+#endif
 
 out vec2 v_texCoord;
 
-uniform mat4 u_mvp;
+#include "include/Camera.glsl"
+#ifndef INSTANCED
+#include "include/Object.glsl"
+#endif
 
 void main()
 {
-	gl_Position = u_mvp * position * vec4(-1.0, 1.0, 1.0, 1.0);
+#ifdef INSTANCED
+	mat4 model = a_model;
+	v_color = a_color;
+#else
+	mat4 model = u_model;
+#endif
+	gl_Position = u_viewProj * model * position * vec4(-1.0, 1.0, 1.0, 1.0);
 	v_texCoord = texCoord;
 };
 
 $Shader$	%Fragment%
 #version 330 core
 
+#if defined(INSTANCED) && defined(ATLAS)
+#error "Instances carry no atlas region"
+#endif
+
 layout(location = 0) out vec4 color;
 
 in vec2 v_texCoord;
+#ifdef INSTANCED
+in vec4 v_color;
+#else
+#include "include/Object.glsl"
+#endif
 
-uniform vec4 u_color;
+#ifdef ATLAS
+uniform sampler2DArray u_texture;
+#else
 uniform sampler2D u_texture;
+#endif
 
 void main()
 {
-	vec4 texColor = texture2D(u_texture, fract(v_texCoord));
+#ifdef ATLAS
+	// The image repeats within its rectangle of the layer. The gradients come from the
+	// coordinates before fract, whose jump at the rectangle's edges would pick the smallest mip.
+	vec2 texCoord = u_texRect.xy + fract(v_texCoord) * u_texRect.zw;
+	vec4 texColor = textureGrad(u_texture, vec3(texCoord, u_texLayer), dFdx(v_texCoord) * u_texRect.zw, dFdy(v_texCoord) * u_texRect.zw);
+#else
+	vec4 texColor = texture(u_texture, v_texCoord);
+#endif
+#if defined(UNTINTED)
+	color = texColor;
+#elif defined(INSTANCED)
+	color = texColor * v_color;
+#else
 	color = texColor * u_color;
-	//color = texColor;
-	//color = u_color;
-};
\ No newline at end of file
+#endif
+};
@@ -0,0 +1,5 @@
+layout(std140) uniform Camera
+{
+	mat4 u_viewProj;
+	vec4 u_cameraPosition;
+};
@@ -0,0 +1,7 @@
+layout(std140) uniform Object
+{
+	mat4 u_model;
+	vec4 u_color;
+	vec4 u_texRect;
+	float u_texLayer;
+};
@@ -0,0 +1,579 @@
+#include "BVH.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const unsigned int BVH::INVALID;
+
+static const unsigned int BIN_COUNT = 12;
+// Nodes with more objects than this are split even when SAH prefers a leaf, so a cluster of
+// overlapping objects cannot turn into one huge leaf.
+static const unsigned int MAX_LEAF_SIZE = 8;
+
+static float surfaceArea(const AABB& box)
+{
+    glm::vec3 size = box.max - box.min;
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+static AABB emptyBox()
+{
+    float big = std::numeric_limits<float>::max();
+    return { glm::vec3(big), glm::vec3(-big) };
+}
+
+static void grow(AABB& box, const AABB& other)
+{
+    box.min = glm::min(box.min, other.min);
+    box.max = glm::max(box.max, other.max);
+}
+
+static bool equal(const AABB& a, const AABB& b)
+{
+    return a.min == b.min && a.max == b.max;
+}
+
+static bool overlaps(const AABB& a, const AABB& b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x
+        && a.min.y <= b.max.y && a.max.y >= b.min.y
+        && a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+static bool overlaps(const AABB& box, const BoundingSphere& sphere)
+{
+    glm::vec3 offset = glm::clamp(sphere.center, box.min, box.max) - sphere.center;
+    return glm::dot(offset, offset) <= sphere.radius * sphere.radius;
+}
+
+// Tests the box against the frustum planes whose bit is set in mask. Returns -1 if it is
+// outside one of them, otherwise the planes it still straddles.
+static int classify(const AABB& box, const Frustum& frustum, int mask)
+{
+    glm::vec3 center = box.getCenter();
+    glm::vec3 extent = box.getExtent();
+    for (int i = 0; i < Frustum::PLANE_COUNT; i++)
+    {
+        if (!(mask & (1 << i)))
+            continue;
+        const glm::vec4& plane = frustum.planes[i];
+        float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        float radius = std::fabs(plane.x) * extent.x + std::fabs(plane.y) * extent.y + std::fabs(plane.z) * extent.z;
+        if (distance + radius < 0.0f)
+            return -1;
+        if (distance - radius >= 0.0f)
+            mask &= ~(1 << i);
+    }
+    return mask;
+}
+
+// Slab test. Returns the distance at which the ray enters the box, or a negative value if it
+// misses it within maxDistance.
+static float intersectRay(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+{
+    glm::vec3 t0 = (box.min - origin) * inverseDirection;
+    glm::vec3 t1 = (box.max - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::fmax(std::fmax(tNear.x, tNear.y), std::fmax(tNear.z, 0.0f));
+    float exit = std::fmin(std::fmin(tFar.x, tFar.y), std::fmin(tFar.z, maxDistance));
+    return enter <= exit ? enter : -1.0f;
+}
+
+BVH::BVH()
+    : m_builtCost(0.0f), m_rebuildThreshold(1.3f)
+{
+    m_tree.cost = 0.0f;
+}
+
+BVH::~BVH()
+{
+    if (m_rebuild.valid())
+        m_rebuild.wait();
+}
+
+float BVH::nodeCost(const Node& node)
+{
+    return surfaceArea(node.box) * (node.isLeaf() ? (float)node.count : 1.0f);
+}
+
+float BVH::getRelativeCost() const
+{
+    if (m_tree.nodes.empty())
+        return 0.0f;
+    float rootArea = surfaceArea(m_tree.nodes[0].box);
+    return rootArea > 0.0f ? m_tree.cost / rootArea : 0.0f;
+}
+
+float BVH::getDegradation() const
+{
+    return m_builtCost > 0.0f ? getRelativeCost() / m_builtCost : 1.0f;
+}
+
+BVH::Tree BVH::buildTree(const std::vector<AABB>& bounds)
+{
+    Tree tree;
+    tree.cost = 0.0f;
+    unsigned int objectCount = (unsigned int)bounds.size();
+    tree.objectIndices.resize(objectCount);
+    tree.objectLeaves.resize(objectCount);
+    if (objectCount == 0)
+        return tree;
+
+    // Boxes and centers are kept in the same order as the index array and partitioned with it,
+    // so every pass over a node reads memory sequentially.
+    std::vector<AABB> boxes(bounds);
+    std::vector<glm::vec3> centers(objectCount);
+    for (unsigned int i = 0; i < objectCount; i++)
+    {
+        tree.objectIndices[i] = i;
+        centers[i] = bounds[i].getCenter();
+    }
+    std::vector<unsigned int> order;
+
+    tree.nodes.reserve(2 * objectCount - 1);
+    tree.parents.reserve(2 * objectCount - 1);
+    tree.nodes.push_back({ emptyBox(), 0, objectCount });
+    tree.parents.push_back(INVALID);
+
+    struct Bin
+    {
+        AABB box;
+        unsigned int count;
+    };
+    Bin bins[3][BIN_COUNT];
+    float rightAreas[BIN_COUNT];
+    unsigned int rightCounts[BIN_COUNT];
+
+    std::vector<unsigned int> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        unsigned int nodeIndex = stack.back();
+        stack.pop_back();
+        unsigned int first = tree.nodes[nodeIndex].leftOrFirst;
+        unsigned int count = tree.nodes[nodeIndex].count;
+        unsigned int* indices = tree.objectIndices.data() + first;
+        AABB* nodeBoxes = boxes.data() + first;
+        glm::vec3* nodeCenters = centers.data() + first;
+
+        AABB box = emptyBox();
+        AABB centerBox = emptyBox();
+        for (unsigned int i = 0; i < count; i++)
+        {
+            grow(box, nodeBoxes[i]);
+            centerBox.min = glm::min(centerBox.min, nodeCenters[i]);
+            centerBox.max = glm::max(centerBox.max, nodeCenters[i]);
+        }
+        tree.nodes[nodeIndex].box = box;
+
+        // Bin the centers along all three axes in one pass and take the cheapest bin boundary.
+        float bestCost = std::numeric_limits<float>::max();
+        int bestAxis = -1;
+        unsigned int bestSplit = 0;
+        glm::vec3 centerSize = centerBox.max - centerBox.min;
+        if (count > 1)
+        {
+            glm::vec3 scale;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                scale[axis] = centerSize[axis] > 0.0f ? BIN_COUNT / centerSize[axis] : 0.0f;
+                for (Bin& bin : bins[axis])
+                    bin = { emptyBox(), 0 };
+            }
+            for (unsigned int i = 0; i < count; i++)
+            {
+                const AABB& objectBox = nodeBoxes[i];
+                glm::vec3 offset = (nodeCenters[i] - centerBox.min) * scale;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    Bin& bin = bins[axis][std::min((unsigned int)offset[axis], BIN_COUNT - 1)];
+                    grow(bin.box, objectBox);
+                    bin.count++;
+                }
+            }
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (centerSize[axis] <= 0.0f)
+                    continue;
+                AABB right = emptyBox();
+                unsigned int rightCount = 0;
+                for (unsigned int bin = BIN_COUNT - 1; bin > 0; bin--)
+                {
+                    grow(right, bins[axis][bin].box);
+                    rightCount += bins[axis][bin].count;
+                    rightAreas[bin] = rightCount ? surfaceArea(right) : 0.0f;
+                    rightCounts[bin] = rightCount;
+                }
+                AABB left = emptyBox();
+                unsigned int leftCount = 0;
+                for (unsigned int split = 1; split < BIN_COUNT; split++)
+                {
+                    grow(left, bins[axis][split - 1].box);
+                    leftCount += bins[axis][split - 1].count;
+                    if (leftCount == 0 || rightCounts[split] == 0)
+                        continue;
+                    float cost = surfaceArea(left) * leftCount + rightAreas[split] * rightCounts[split];
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = split;
+                    }
+                }
+            }
+        }
+
+        unsigned int leftCount = 0;
+        float area = surfaceArea(box);
+        if (bestAxis >= 0 && area + bestCost < area * count)
+        {
+            float scale = BIN_COUNT / centerSize[bestAxis];
+            float minimum = centerBox.min[bestAxis];
+            unsigned int end = count;
+            while (leftCount < end)
+            {
+                if (std::min((unsigned int)((nodeCenters[leftCount][bestAxis] - minimum) * scale), BIN_COUNT - 1) < bestSplit)
+                {
+                    leftCount++;
+                    continue;
+                }
+                end--;
+                std::swap(indices[leftCount], indices[end]);
+                std::swap(nodeBoxes[leftCount], nodeBoxes[end]);
+                std::swap(nodeCenters[leftCount], nodeCenters[end]);
+            }
+        }
+        else if (count > MAX_LEAF_SIZE)
+        {
+            // SAH would rather keep the objects together; split at the median of the widest
+            // axis, which also handles objects that all share one center.
+            int axis = centerSize.x >= centerSize.y && centerSize.x >= centerSize.z ? 0 : centerSize.y >= centerSize.z ? 1 : 2;
+            leftCount = count / 2;
+            order.resize(count);
+            for (unsigned int i = 0; i < count; i++)
+                order[i] = i;
+            std::nth_element(order.begin(), order.begin() + leftCount, order.end(), [&](unsigned int a, unsigned int b) {
+                return nodeCenters[a][axis] < nodeCenters[b][axis];
+            });
+            std::vector<unsigned int> sortedIndices(count);
+            std::vector<AABB> sortedBoxes(count);
+            std::vector<glm::vec3> sortedCenters(count);
+            for (unsigned int i = 0; i < count; i++)
+            {
+                sortedIndices[i] = indices[order[i]];
+                sortedBoxes[i] = nodeBoxes[order[i]];
+                sortedCenters[i] = nodeCenters[order[i]];
+            }
+            std::copy(sortedIndices.begin(), sortedIndices.end(), indices);
+            std::copy(sortedBoxes.begin(), sortedBoxes.end(), nodeBoxes);
+            std::copy(sortedCenters.begin(), sortedCenters.end(), nodeCenters);
+        }
+
+        if (leftCount == 0 || leftCount == count)
+        {
+            for (unsigned int i = 0; i < count; i++)
+                tree.objectLeaves[indices[i]] = nodeIndex;
+            tree.cost += nodeCost(tree.nodes[nodeIndex]);
+            continue;
+        }
+
+        unsigned int leftIndex = (unsigned int)tree.nodes.size();
+        tree.nodes.push_back({ emptyBox(), first, leftCount });
+        tree.nodes.push_back({ emptyBox(), first + leftCount, count - leftCount });
+        tree.parents.push_back(nodeIndex);
+        tree.parents.push_back(nodeIndex);
+        tree.nodes[nodeIndex].leftOrFirst = leftIndex;
+        tree.nodes[nodeIndex].count = 0;
+        tree.cost += nodeCost(tree.nodes[nodeIndex]);
+        stack.push_back(leftIndex + 1);
+        stack.push_back(leftIndex);
+    }
+    return tree;
+}
+
+void BVH::build(const std::vector<AABB>& bounds)
+{
+    // A rebuild of the old objects is of no use any more.
+    if (m_rebuild.valid())
+        m_rebuild.get();
+    m_bounds = bounds;
+    Tree tree = buildTree(m_bounds);
+    swapIn(tree);
+}
+
+void BVH::swapIn(Tree& tree)
+{
+    std::swap(m_tree, tree);
+    m_dirtyLeaves.clear();
+    m_leafDirty.assign(m_tree.nodes.size(), 0);
+    m_builtCost = getRelativeCost();
+}
+
+void BVH::update(unsigned int object, const AABB& box)
+{
+    m_bounds[object] = box;
+    unsigned int leaf = m_tree.objectLeaves[object];
+    if (!m_leafDirty[leaf])
+    {
+        m_leafDirty[leaf] = 1;
+        m_dirtyLeaves.push_back(leaf);
+    }
+}
+
+void BVH::refit()
+{
+    if (pollRebuild())
+        return;
+
+    // Walking up from each leaf revisits the upper levels once per leaf; when a large part of
+    // the tree moved, one bottom-up pass over every node is cheaper.
+    if (m_dirtyLeaves.size() * 4 > m_tree.nodes.size())
+    {
+        for (unsigned int leaf : m_dirtyLeaves)
+            m_leafDirty[leaf] = 0;
+        m_dirtyLeaves.clear();
+        refitAll();
+    }
+
+    for (unsigned int leaf : m_dirtyLeaves)
+    {
+        m_leafDirty[leaf] = 0;
+        unsigned int nodeIndex = leaf;
+        while (nodeIndex != INVALID)
+        {
+            Node& node = m_tree.nodes[nodeIndex];
+            AABB box = emptyBox();
+            if (node.isLeaf())
+            {
+                for (unsigned int i = 0; i < node.count; i++)
+                    grow(box, m_bounds[m_tree.objectIndices[node.leftOrFirst + i]]);
+            }
+            else
+            {
+                box = m_tree.nodes[node.leftOrFirst].box;
+                grow(box, m_tree.nodes[node.leftOrFirst + 1].box);
+            }
+            // Once a node keeps its box nothing above it can change either.
+            if (equal(box, node.box))
+                break;
+            m_tree.cost -= nodeCost(node);
+            node.box = box;
+            m_tree.cost += nodeCost(node);
+            nodeIndex = m_tree.parents[nodeIndex];
+        }
+    }
+    m_dirtyLeaves.clear();
+
+    if (m_rebuildThreshold > 0.0f && !isRebuilding() && getDegradation() > m_rebuildThreshold)
+        rebuildAsync();
+}
+
+void BVH::refitAll()
+{
+    m_tree.cost = 0.0f;
+    // Children always come after their parent, so walking backwards visits them first.
+    for (size_t i = m_tree.nodes.size(); i-- > 0;)
+    {
+        Node& node = m_tree.nodes[i];
+        if (node.isLeaf())
+        {
+            node.box = emptyBox();
+            for (unsigned int j = 0; j < node.count; j++)
+                grow(node.box, m_bounds[m_tree.objectIndices[node.leftOrFirst + j]]);
+        }
+        else
+        {
+            node.box = m_tree.nodes[node.leftOrFirst].box;
+            grow(node.box, m_tree.nodes[node.leftOrFirst + 1].box);
+        }
+        m_tree.cost += nodeCost(node);
+    }
+}
+
+void BVH::rebuildAsync()
+{
+    if (isRebuilding())
+        return;
+    m_rebuild = std::async(std::launch::async, buildTree, m_bounds);
+}
+
+bool BVH::pollRebuild()
+{
+    if (!isRebuilding() || m_rebuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return false;
+    finishRebuild();
+    return true;
+}
+
+void BVH::finishRebuild()
+{
+    if (!isRebuilding())
+        return;
+    Tree tree = m_rebuild.get();
+    swapIn(tree);
+    // The tree was built from a snapshot; bring it up to date with what moved since.
+    refitAll();
+    m_builtCost = getRelativeCost();
+}
+
+void BVH::addSubtree(unsigned int node, std::vector<unsigned int>& objects) const
+{
+    // Building partitions the index array in place, so a subtree's objects are the run from
+    // its leftmost leaf to its rightmost one.
+    unsigned int first = node;
+    while (!m_tree.nodes[first].isLeaf())
+        first = m_tree.nodes[first].leftOrFirst;
+    unsigned int last = node;
+    while (!m_tree.nodes[last].isLeaf())
+        last = m_tree.nodes[last].leftOrFirst + 1;
+    const Node& lastLeaf = m_tree.nodes[last];
+    objects.insert(objects.end(), m_tree.objectIndices.begin() + m_tree.nodes[first].leftOrFirst,
+        m_tree.objectIndices.begin() + lastLeaf.leftOrFirst + lastLeaf.count);
+}
+
+void BVH::queryFrustum(const Frustum& frustum, std::vector<unsigned int>& objects)
+{
+    if (m_tree.nodes.empty())
+        return;
+    const int ALL_PLANES = (1 << Frustum::PLANE_COUNT) - 1;
+
+    // Pairs of node and the planes its parent still straddled.
+    m_stack.clear();
+    m_stack.push_back(0);
+    m_stack.push_back(ALL_PLANES);
+    while (!m_stack.empty())
+    {
+        int mask = (int)m_stack.back();
+        m_stack.pop_back();
+        unsigned int nodeIndex = m_stack.back();
+        m_stack.pop_back();
+
+        const Node& node = m_tree.nodes[nodeIndex];
+        mask = classify(node.box, frustum, mask);
+        if (mask < 0)
+            continue;
+        if (mask == 0)
+        {
+            addSubtree(nodeIndex, objects);
+            continue;
+        }
+        if (node.isLeaf())
+        {
+            for (unsigned int i = 0; i < node.count; i++)
+            {
+                unsigned int object = m_tree.objectIndices[node.leftOrFirst + i];
+                if (classify(m_bounds[object], frustum, mask) >= 0)
+                    objects.push_back(object);
+            }
+            continue;
+        }
+        m_stack.push_back(node.leftOrFirst + 1);
+        m_stack.push_back((unsigned int)mask);
+        m_stack.push_back(node.leftOrFirst);
+        m_stack.push_back((unsigned int)mask);
+    }
+}
+
+void BVH::queryRange(const AABB& box, std::vector<unsigned int>& objects)
+{
+    if (m_tree.nodes.empty())
+        return;
+    m_stack.clear();
+    m_stack.push_back(0);
+    while (!m_stack.empty())
+    {
+        const Node& node = m_tree.nodes[m_stack.back()];
+        m_stack.pop_back();
+        if (!overlaps(node.box, box))
+            continue;
+        if (!node.isLeaf())
+        {
+            m_stack.push_back(node.leftOrFirst + 1);
+            m_stack.push_back(node.leftOrFirst);
+            continue;
+        }
+        for (unsigned int i = 0; i < node.count; i++)
+        {
+            unsigned int object = m_tree.objectIndices[node.leftOrFirst + i];
+            if (overlaps(m_bounds[object], box))
+                objects.push_back(object);
+        }
+    }
+}
+
+void BVH::queryRange(const BoundingSphere& sphere, std::vector<unsigned int>& objects)
+{
+    if (m_tree.nodes.empty())
+        return;
+    m_stack.clear();
+    m_stack.push_back(0);
+    while (!m_stack.empty())
+    {
+        const Node& node = m_tree.nodes[m_stack.back()];
+        m_stack.pop_back();
+        if (!overlaps(node.box, sphere))
+            continue;
+        if (!node.isLeaf())
+        {
+            m_stack.push_back(node.leftOrFirst + 1);
+            m_stack.push_back(node.leftOrFirst);
+            continue;
+        }
+        for (unsigned int i = 0; i < node.count; i++)
+        {
+            unsigned int object = m_tree.objectIndices[node.leftOrFirst + i];
+            if (overlaps(m_bounds[object], sphere))
+                objects.push_back(object);
+        }
+    }
+}
+
+BVH::RayHit BVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+{
+    RayHit hit = { INVALID, maxDistance };
+    if (m_tree.nodes.empty())
+        return hit;
+    // Division by a zero component gives an infinity, which the slab test handles.
+    glm::vec3 inverseDirection = 1.0f / direction;
+
+    m_stack.clear();
+    if (intersectRay(m_tree.nodes[0].box, origin, inverseDirection, hit.distance) >= 0.0f)
+        m_stack.push_back(0);
+    while (!m_stack.empty())
+    {
+        const Node& node = m_tree.nodes[m_stack.back()];
+        m_stack.pop_back();
+        // The node was entered before a closer hit was found; check it still matters.
+        if (intersectRay(node.box, origin, inverseDirection, hit.distance) < 0.0f)
+            continue;
+        if (node.isLeaf())
+        {
+            for (unsigned int i = 0; i < node.count; i++)
+            {
+                unsigned int object = m_tree.objectIndices[node.leftOrFirst + i];
+                float distance = intersectRay(m_bounds[object], origin, inverseDirection, hit.distance);
+                if (distance >= 0.0f && (distance < hit.distance || hit.object == INVALID))
+                    hit = { object, distance };
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so the farther one is usually rejected by its hit.
+        unsigned int closer = node.leftOrFirst;
+        unsigned int farther = node.leftOrFirst + 1;
+        float closerDistance = intersectRay(m_tree.nodes[closer].box, origin, inverseDirection, hit.distance);
+        float fartherDistance = intersectRay(m_tree.nodes[farther].box, origin, inverseDirection, hit.distance);
+        if (fartherDistance >= 0.0f && (closerDistance < 0.0f || fartherDistance < closerDistance))
+        {
+            std::swap(closer, farther);
+            std::swap(closerDistance, fartherDistance);
+        }
+        if (fartherDistance >= 0.0f)
+            m_stack.push_back(farther);
+        if (closerDistance >= 0.0f)
+            m_stack.push_back(closer);
+    }
+    return hit;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <future>
+#include <vector>
+#include "Bounds.h"
+#include "Frustum.h"
+
+// A bounding volume hierarchy over object boxes, built top-down with binned SAH splits.
+// Moving objects refit the tree: only the nodes above a changed leaf are recomputed, and the
+// walk up stops at the first node whose box does not change. Refitting loosens the tree over
+// time, so its SAH cost is tracked and, once it degrades past a threshold, a new tree is built
+// on a background thread from a snapshot of the bounds and swapped in when it is ready.
+class BVH
+{
+public:
+	static const unsigned int INVALID = 0xFFFFFFFF;
+
+	struct Node
+	{
+		AABB box;
+		// Interior nodes: index of the left child, the right one follows it. Leaves: first
+		// entry in the object index array.
+		unsigned int leftOrFirst;
+		// Number of objects in a leaf, 0 for interior nodes.
+		unsigned int count;
+
+		inline bool isLeaf() const { return count > 0; }
+	};
+
+	struct RayHit
+	{
+		unsigned int object;
+		float distance;
+	};
+private:
+	struct Tree
+	{
+		std::vector<Node> nodes;
+		std::vector<unsigned int> objectIndices;
+		std::vector<unsigned int> parents;
+		std::vector<unsigned int> objectLeaves;
+		// Unnormalized SAH cost: node surface areas, leaves weighted by their object count.
+		float cost;
+	};
+
+	Tree m_tree;
+	std::vector<AABB> m_bounds;
+	std::vector<unsigned int> m_dirtyLeaves;
+	std::vector<unsigned char> m_leafDirty;
+	// SAH cost relative to the root's area when the current tree was built.
+	float m_builtCost;
+	float m_rebuildThreshold;
+	std::future<Tree> m_rebuild;
+	std::vector<unsigned int> m_stack;
+public:
+	BVH();
+	~BVH();
+
+	// Builds the tree over these boxes; object i is reported as i by the queries.
+	void build(const std::vector<AABB>& bounds);
+
+	// Records that an object moved. The tree only changes at the next refit.
+	void update(unsigned int object, const AABB& box);
+	// Refits the nodes above every leaf that changed since the last refit, swaps in a finished
+	// background rebuild, and starts one when the tree has degraded past the threshold.
+	void refit();
+
+	// Starts building a replacement tree on another thread. Does nothing if one is running.
+	void rebuildAsync();
+	// Swaps in the background tree if it is finished. Returns true if it was.
+	bool pollRebuild();
+	// Blocks until a running background rebuild is swapped in.
+	void finishRebuild();
+
+	// Appends every object whose box intersects the frustum. Subtrees that are fully inside
+	// are added without testing their objects.
+	void queryFrustum(const Frustum& frustum, std::vector<unsigned int>& objects);
+	// Appends every object whose box overlaps the box or the sphere.
+	void queryRange(const AABB& box, std::vector<unsigned int>& objects);
+	void queryRange(const BoundingSphere& sphere, std::vector<unsigned int>& objects);
+	// The nearest object box the ray enters within maxDistance, or object INVALID.
+	RayHit raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
+
+	// SAH cost relative to the cost the tree had when it was built; 1 for a fresh tree.
+	float getDegradation() const;
+	// Degradation at which refit starts a background rebuild; 0 disables it.
+	inline void setRebuildThreshold(float threshold) { m_rebuildThreshold = threshold; }
+	inline bool isRebuilding() const { return m_rebuild.valid(); }
+	inline unsigned int getNodeCount() const { return (unsigned int)m_tree.nodes.size(); }
+	inline unsigned int getObjectCount() const { return (unsigned int)m_bounds.size(); }
+	inline const AABB& getBounds(unsigned int object) const { return m_bounds[object]; }
+private:
+	static Tree buildTree(const std::vector<AABB>& bounds);
+	static float nodeCost(const Node& node);
+	float getRelativeCost() const;
+	void swapIn(Tree& tree);
+	void refitAll();
+	void addSubtree(unsigned int node, std::vector<unsigned int>& objects) const;
+};
@@ -0,0 +1,84 @@
+#include "Benchmark.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "FrameTimer.h"
+#include "FrameStats.h"
+#include "ShaderLibrary.h"
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+volatile unsigned long long Benchmark::s_sink = 0;
+
+struct BenchmarkEntry
+{
+    const char* name;
+    const char* description;
+    Benchmark::Function function;
+};
+
+// Function-local so registrations from other translation units never see it uninitialized.
+static std::vector<BenchmarkEntry>& getRegistry()
+{
+    static std::vector<BenchmarkEntry> registry;
+    return registry;
+}
+
+Benchmark::Registration::Registration(const char* name, const char* description, Function function)
+{
+    getRegistry().push_back({ name, description, function });
+}
+
+int Benchmark::run(const std::string& name)
+{
+    for (const BenchmarkEntry& entry : getRegistry())
+    {
+        if (name == entry.name)
+        {
+            std::cout << "Benchmark '" << entry.name << "': " << entry.description << "\n\n";
+            return entry.function();
+        }
+    }
+    std::cout << "Unknown benchmark '" << name << "'!\n";
+    list(std::cout);
+    return -1;
+}
+
+void Benchmark::list(std::ostream& os)
+{
+    os << "Benchmarks:\n";
+    for (const BenchmarkEntry& entry : getRegistry())
+        os << "  " << std::left << std::setw(20) << entry.name << std::right << entry.description << "\n";
+}
+
+void Benchmark::renderFrames(Scene& scene, const Camera& camera, unsigned int frames, FrameTimer& timer, SoftwareRasterizer* software)
+{
+    ShaderLibrary::finish();
+    Renderer renderer;
+    renderer.setSoftwareRasterizer(software);
+    renderer.beginFrame();
+    renderer.clear();
+    scene.onRender(renderer, camera);
+    renderer.endFrame();
+    GLCall(glFinish());
+    FrameStats::reset();
+
+    timer.beginRun();
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        timer.beginFrame();
+        renderer.beginFrame();
+        renderer.clear();
+        scene.onRender(renderer, camera);
+        renderer.endFrame();
+        GLCall(glFinish());
+        timer.endFrame();
+    }
+    timer.endRun();
+}
+
+void Benchmark::printResult(const char* label, double value, const char* unit)
+{
+    std::cout << "  " << std::left << std::setw(44) << label << std::right << std::fixed << std::setprecision(2)
+        << std::setw(12) << value << " " << unit << "\n" << std::defaultfloat;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+class Scene;
+class FrameTimer;
+class SoftwareRasterizer;
+struct Camera;
+
+// Micro-benchmarks that run inside a headless GL context (Render3D --bench NAME). Each one
+// lives in src/bench and registers itself with REGISTER_BENCHMARK.
+class Benchmark
+{
+public:
+	typedef int (*Function)();
+
+	struct Registration
+	{
+		Registration(const char* name, const char* description, Function function);
+	};
+
+	static int run(const std::string& name);
+	static void list(std::ostream& os);
+
+	// Returns the average nanoseconds one call of fn takes over the given number of iterations.
+	template<typename F>
+	static double timeNs(unsigned int iterations, F&& fn)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned int i = 0; i < iterations; i++)
+			fn(i);
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+	}
+
+	// Keeps a computed value alive so the optimizer cannot drop the work that produced it.
+	template<typename T>
+	static void consume(const T& value)
+	{
+		s_sink = s_sink + (unsigned long long)value;
+	}
+
+	// Renders a warm-up frame and then the given number of frames of the scene into the bound
+	// framebuffer, with glFinish after each so the times cover submission and the GPU work.
+	// The scene's programs are waited for first, and frame stats are reset after the warm-up,
+	// so they describe the timed frames. With a software rasterizer the frames are drawn by it
+	// instead.
+	static void renderFrames(Scene& scene, const Camera& camera, unsigned int frames, FrameTimer& timer, SoftwareRasterizer* software = nullptr);
+
+	static void printResult(const char* label, double value, const char* unit);
+private:
+	static volatile unsigned long long s_sink;
+};
+
+#define REGISTER_BENCHMARK(name, description, function) \
+	static Benchmark::Registration s_registration_##function(name, description, function)
@@ -0,0 +1,572 @@
+#include "BlockCompression.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define BLOCK_SSE 1
+#endif
+
+// BC7's interpolation weights out of 64, for 2, 3 and 4-bit indices.
+static const int WEIGHTS2[4] = { 0, 21, 43, 64 };
+static const int WEIGHTS3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const int WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// A block's fields from its lowest bit up, which is how BC7 lays them out.
+struct BitReader
+{
+    const unsigned char* data;
+    unsigned int position;
+
+    unsigned int read(unsigned int count)
+    {
+        unsigned int value = 0;
+        for (unsigned int i = 0; i < count; i++, position++)
+            value |= (unsigned int)(data[position >> 3] >> (position & 7) & 1) << i;
+        return value;
+    }
+};
+
+// Writes into a zeroed block.
+struct BitWriter
+{
+    unsigned char* data;
+    unsigned int position;
+
+    void write(unsigned int value, unsigned int count)
+    {
+        for (unsigned int i = 0; i < count; i++, position++)
+            data[position >> 3] |= (unsigned char)((value >> i & 1) << (position & 7));
+    }
+};
+
+// The corners of the block's bounding box on the diagonal its texels spread along: a channel
+// that falls while the widest one rises has its ends swapped. Both ends are pulled in by 1/16
+// of the range, where a least-squares line through evenly spread texels ends.
+static void findEndpoints(const unsigned char* texels, int channels, int start[4], int end[4])
+{
+    int low[4], high[4];
+#if BLOCK_SSE
+    __m128i t0 = _mm_loadu_si128((const __m128i*)texels), t1 = _mm_loadu_si128((const __m128i*)(texels + 16));
+    __m128i t2 = _mm_loadu_si128((const __m128i*)(texels + 32)), t3 = _mm_loadu_si128((const __m128i*)(texels + 48));
+    __m128i lows = _mm_min_epu8(_mm_min_epu8(t0, t1), _mm_min_epu8(t2, t3));
+    __m128i highs = _mm_max_epu8(_mm_max_epu8(t0, t1), _mm_max_epu8(t2, t3));
+    lows = _mm_min_epu8(lows, _mm_shuffle_epi32(lows, _MM_SHUFFLE(1, 0, 3, 2)));
+    lows = _mm_min_epu8(lows, _mm_shuffle_epi32(lows, _MM_SHUFFLE(2, 3, 0, 1)));
+    highs = _mm_max_epu8(highs, _mm_shuffle_epi32(highs, _MM_SHUFFLE(1, 0, 3, 2)));
+    highs = _mm_max_epu8(highs, _mm_shuffle_epi32(highs, _MM_SHUFFLE(2, 3, 0, 1)));
+    unsigned int lowTexel = (unsigned int)_mm_cvtsi128_si32(lows), highTexel = (unsigned int)_mm_cvtsi128_si32(highs);
+    for (int c = 0; c < 4; c++)
+    {
+        low[c] = lowTexel >> (8 * c) & 0xFF;
+        high[c] = highTexel >> (8 * c) & 0xFF;
+    }
+#else
+    for (int c = 0; c < 4; c++)
+    {
+        low[c] = 255;
+        high[c] = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            low[c] = std::min(low[c], (int)texels[i * 4 + c]);
+            high[c] = std::max(high[c], (int)texels[i * 4 + c]);
+        }
+    }
+#endif
+
+    int widest = 0;
+    for (int c = 1; c < channels; c++)
+    {
+        if (high[c] - low[c] > high[widest] - low[widest])
+            widest = c;
+    }
+    int sum[4] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < channels; c++)
+            sum[c] += texels[i * 4 + c];
+    }
+    for (int c = 0; c < channels; c++)
+    {
+        // The sign of the covariance with the widest channel, in units of 1/16 to stay in integers.
+        int covariance = 0;
+        for (int i = 0; i < 16; i++)
+            covariance += (texels[i * 4 + c] * 16 - sum[c]) * (texels[i * 4 + widest] * 16 - sum[widest]) >> 8;
+        int inset = (high[c] - low[c]) >> 4;
+        int lowEnd = low[c] + inset, highEnd = high[c] - inset;
+        start[c] = covariance >= 0 ? highEnd : lowEnd;
+        end[c] = covariance >= 0 ? lowEnd : highEnd;
+    }
+}
+
+static unsigned short packColor565(const int color[3])
+{
+    return (unsigned short)((color[0] * 31 + 127) / 255 << 11 | (color[1] * 63 + 127) / 255 << 5 | (color[2] * 31 + 127) / 255);
+}
+
+static void unpackColor565(unsigned short packed, int color[3])
+{
+    int r = packed >> 11 & 31, g = packed >> 5 & 63, b = packed & 31;
+    color[0] = r << 3 | r >> 2;
+    color[1] = g << 2 | g >> 4;
+    color[2] = b << 3 | b >> 2;
+}
+
+// The nearest of the four palette colors to each texel, by squared distance, 2 bits each.
+static unsigned int findColorIndices(const unsigned char* texels, const int palette[4][3])
+{
+    unsigned int indices = 0;
+#if BLOCK_SSE
+    __m128i zero = _mm_setzero_si128();
+    __m128i colors[4];
+    for (int k = 0; k < 4; k++)
+        colors[k] = _mm_setr_epi16((short)palette[k][0], (short)palette[k][1], (short)palette[k][2], 0, (short)palette[k][0], (short)palette[k][1], (short)palette[k][2], 0);
+    for (int group = 0; group < 4; group++)
+    {
+        // Four texels with alpha cleared, widened to 16 bits two at a time.
+        __m128i texels4 = _mm_and_si128(_mm_loadu_si128((const __m128i*)(texels + group * 16)), _mm_set1_epi32(0x00FFFFFF));
+        __m128i low = _mm_unpacklo_epi8(texels4, zero), high = _mm_unpackhi_epi8(texels4, zero);
+        __m128i best = _mm_set1_epi32(INT_MAX), bestIndex = zero;
+        for (int k = 0; k < 4; k++)
+        {
+            // madd sums r*r + g*g and b*b per texel; the shuffles line the two sums up per texel.
+            __m128i lowDelta = _mm_sub_epi16(low, colors[k]), highDelta = _mm_sub_epi16(high, colors[k]);
+            __m128 lowSums = _mm_castsi128_ps(_mm_madd_epi16(lowDelta, lowDelta)), highSums = _mm_castsi128_ps(_mm_madd_epi16(highDelta, highDelta));
+            __m128i distance = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(lowSums, highSums, _MM_SHUFFLE(2, 0, 2, 0))),
+                _mm_castps_si128(_mm_shuffle_ps(lowSums, highSums, _MM_SHUFFLE(3, 1, 3, 1))));
+            __m128i closer = _mm_cmplt_epi32(distance, best);
+            best = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, best));
+            bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, bestIndex));
+        }
+        alignas(16) int lanes[4];
+        _mm_store_si128((__m128i*)lanes, bestIndex);
+        for (int lane = 0; lane < 4; lane++)
+            indices |= (unsigned int)lanes[lane] << (2 * (group * 4 + lane));
+    }
+#else
+    for (int i = 0; i < 16; i++)
+    {
+        int best = INT_MAX, bestIndex = 0;
+        for (int k = 0; k < 4; k++)
+        {
+            int distance = 0;
+            for (int c = 0; c < 3; c++)
+                distance += (texels[i * 4 + c] - palette[k][c]) * (texels[i * 4 + c] - palette[k][c]);
+            if (distance < best)
+            {
+                best = distance;
+                bestIndex = k;
+            }
+        }
+        indices |= (unsigned int)bestIndex << (2 * i);
+    }
+#endif
+    return indices;
+}
+
+// Always in four-level mode, which BC3's color half requires and keeps BC1 opaque.
+static void encodeColorBlock(const unsigned char* texels, unsigned char* block)
+{
+    int start[4], end[4];
+    findEndpoints(texels, 3, start, end);
+    unsigned short color0 = packColor565(start), color1 = packColor565(end);
+    if (color0 < color1)
+        std::swap(color0, color1);
+    unsigned int indices = 0;
+    // With equal endpoints every index is 0; four levels need color0 > color1.
+    if (color0 != color1)
+    {
+        int palette[4][3];
+        unpackColor565(color0, palette[0]);
+        unpackColor565(color1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        indices = findColorIndices(texels, palette);
+    }
+    block[0] = (unsigned char)color0;
+    block[1] = (unsigned char)(color0 >> 8);
+    block[2] = (unsigned char)color1;
+    block[3] = (unsigned char)(color1 >> 8);
+    memcpy(block + 4, &indices, 4);
+}
+
+// Eight levels from the largest alpha down to the smallest.
+static void encodeAlphaBlock(const unsigned char* texels, unsigned char* block)
+{
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        low = std::min(low, (int)texels[i * 4 + 3]);
+        high = std::max(high, (int)texels[i * 4 + 3]);
+    }
+    unsigned long long bits = 0;
+    if (high > low)
+    {
+        // The level as (high - alpha) * 7 / (high - low), rounded half up by adding 0.5 and
+        // truncating in both paths, so they pick the same indices; level 0 is index 0, level 7
+        // index 1, and the ones between are indices 2 to 7.
+#if BLOCK_SSE
+        __m128 scale = _mm_set1_ps(7.0f / (high - low));
+        for (int group = 0; group < 4; group++)
+        {
+            __m128i alphas = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(texels + group * 16)), 24);
+            __m128 scaled = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_set1_epi32(high), alphas)), scale);
+            __m128i level = _mm_cvttps_epi32(_mm_add_ps(scaled, _mm_set1_ps(0.5f)));
+            __m128i index = _mm_add_epi32(level, _mm_set1_epi32(1));
+            index = _mm_sub_epi32(index, _mm_and_si128(_mm_cmpeq_epi32(level, _mm_set1_epi32(7)), _mm_set1_epi32(7)));
+            index = _mm_andnot_si128(_mm_cmpeq_epi32(level, _mm_setzero_si128()), index);
+            alignas(16) int lanes[4];
+            _mm_store_si128((__m128i*)lanes, index);
+            for (int lane = 0; lane < 4; lane++)
+                bits |= (unsigned long long)lanes[lane] << (3 * (group * 4 + lane));
+        }
+#else
+        float scale = 7.0f / (high - low);
+        for (int i = 0; i < 16; i++)
+        {
+            int level = (int)((high - texels[i * 4 + 3]) * scale + 0.5f);
+            int index = level == 0 ? 0 : level == 7 ? 1 : level + 1;
+            bits |= (unsigned long long)index << (3 * i);
+        }
+#endif
+    }
+    block[0] = (unsigned char)high;
+    block[1] = (unsigned char)low;
+    for (int i = 0; i < 6; i++)
+        block[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// Mode 6: 7-bit RGBA endpoints with a p-bit each, and a 4-bit index per texel.
+static void encodeBC7Block(const unsigned char* texels, unsigned char* block)
+{
+    int fitted[2][4];
+    findEndpoints(texels, 4, fitted[0], fitted[1]);
+
+    // An endpoint's channels share its p-bit as their lowest bit; keep whichever lands closer.
+    int quantized[2][4], endpoints[2][4], pbits[2];
+    for (int e = 0; e < 2; e++)
+    {
+        int bestError = INT_MAX;
+        for (int p = 0; p < 2; p++)
+        {
+            int candidate[4], error = 0;
+            for (int c = 0; c < 4; c++)
+            {
+                candidate[c] = std::max(0, std::min(127, (fitted[e][c] - p + 1) >> 1));
+                int value = candidate[c] << 1 | p;
+                error += (value - fitted[e][c]) * (value - fitted[e][c]);
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                pbits[e] = p;
+                for (int c = 0; c < 4; c++)
+                {
+                    quantized[e][c] = candidate[c];
+                    endpoints[e][c] = candidate[c] << 1 | p;
+                }
+            }
+        }
+    }
+
+    int palette[16][4];
+    for (int k = 0; k < 16; k++)
+    {
+        for (int c = 0; c < 4; c++)
+            palette[k][c] = ((64 - WEIGHTS4[k]) * endpoints[0][c] + WEIGHTS4[k] * endpoints[1][c] + 32) >> 6;
+    }
+    int indices[16];
+    for (int i = 0; i < 16; i++)
+    {
+        int best = INT_MAX;
+        for (int k = 0; k < 16; k++)
+        {
+            int distance = 0;
+            for (int c = 0; c < 4; c++)
+                distance += (texels[i * 4 + c] - palette[k][c]) * (texels[i * 4 + c] - palette[k][c]);
+            if (distance < best)
+            {
+                best = distance;
+                indices[i] = k;
+            }
+        }
+    }
+    // The first texel's index is stored without its top bit, so it has to be below 8.
+    if (indices[0] & 8)
+    {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(pbits[0], pbits[1]);
+        for (int i = 0; i < 16; i++)
+            indices[i] = 15 - indices[i];
+    }
+
+    memset(block, 0, 16);
+    BitWriter bits = { block, 0 };
+    bits.write(1 << 6, 7);
+    for (int c = 0; c < 4; c++)
+    {
+        bits.write(quantized[0][c], 7);
+        bits.write(quantized[1][c], 7);
+    }
+    bits.write(pbits[0], 1);
+    bits.write(pbits[1], 1);
+    for (int i = 0; i < 16; i++)
+        bits.write(indices[i], i == 0 ? 3 : 4);
+}
+
+static void decodeColorBlock(const unsigned char* block, unsigned char* texels, bool fourLevels)
+{
+    unsigned short color0 = (unsigned short)(block[0] | block[1] << 8), color1 = (unsigned short)(block[2] | block[3] << 8);
+    int palette[4][4];
+    unpackColor565(color0, palette[0]);
+    unpackColor565(color1, palette[1]);
+    palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+    for (int c = 0; c < 3; c++)
+    {
+        // BC1 blocks with color0 <= color1 have three levels and transparent black.
+        if (fourLevels || color0 > color1)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    if (!fourLevels && color0 <= color1)
+        palette[3][3] = 0;
+    unsigned int indices;
+    memcpy(&indices, block + 4, 4);
+    for (int i = 0; i < 16; i++)
+    {
+        const int* color = palette[indices >> (2 * i) & 3];
+        for (int c = 0; c < 4; c++)
+            texels[i * 4 + c] = (unsigned char)color[c];
+    }
+}
+
+static void decodeAlphaBlock(const unsigned char* block, unsigned char* texels)
+{
+    int levels[8] = { block[0], block[1] };
+    if (levels[0] > levels[1])
+    {
+        for (int k = 1; k < 7; k++)
+            levels[k + 1] = ((7 - k) * levels[0] + k * levels[1]) / 7;
+    }
+    else
+    {
+        for (int k = 1; k < 5; k++)
+            levels[k + 1] = ((5 - k) * levels[0] + k * levels[1]) / 5;
+        levels[6] = 0;
+        levels[7] = 255;
+    }
+    unsigned long long bits = 0;
+    for (int i = 0; i < 6; i++)
+        bits |= (unsigned long long)block[2 + i] << (8 * i);
+    for (int i = 0; i < 16; i++)
+        texels[i * 4 + 3] = (unsigned char)levels[bits >> (3 * i) & 7];
+}
+
+static bool decodeBC7Block(const unsigned char* block, unsigned char* texels)
+{
+    int mode = 0;
+    while (mode < 8 && !(block[0] >> mode & 1))
+        mode++;
+    if (mode < 4 || mode > 6)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            texels[i * 4] = texels[i * 4 + 2] = texels[i * 4 + 3] = 255;
+            texels[i * 4 + 1] = 0;
+        }
+        return false;
+    }
+
+    BitReader bits = { block, (unsigned int)mode + 1 };
+    int rotation = 0, indexSelection = 0, colorBits = 7, alphaBits = 7;
+    if (mode == 4)
+    {
+        rotation = bits.read(2);
+        indexSelection = bits.read(1);
+        colorBits = 5;
+        alphaBits = 6;
+    }
+    else if (mode == 5)
+    {
+        rotation = bits.read(2);
+        alphaBits = 8;
+    }
+    int endpoints[2][4];
+    for (int c = 0; c < 3; c++)
+    {
+        endpoints[0][c] = bits.read(colorBits);
+        endpoints[1][c] = bits.read(colorBits);
+    }
+    endpoints[0][3] = bits.read(alphaBits);
+    endpoints[1][3] = bits.read(alphaBits);
+    if (mode == 6)
+    {
+        for (int e = 0; e < 2; e++)
+        {
+            int p = bits.read(1);
+            for (int c = 0; c < 4; c++)
+                endpoints[e][c] = endpoints[e][c] << 1 | p;
+        }
+    }
+    else
+    {
+        // Widening by repeating the top bits, so 0 and the maximum stay 0 and 255.
+        for (int e = 0; e < 2; e++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                int count = c < 3 ? colorBits : alphaBits;
+                int value = endpoints[e][c] << (8 - count);
+                endpoints[e][c] = value | value >> count;
+            }
+        }
+    }
+
+    // Every mode here has a first set of indices and all but mode 6 a second, each starting
+    // with the first texel's index less its top bit.
+    int firstBits = mode == 6 ? 4 : 2, secondBits = mode == 4 ? 3 : 2;
+    int first[16], second[16];
+    for (int i = 0; i < 16; i++)
+        first[i] = bits.read(i == 0 ? firstBits - 1 : firstBits);
+    if (mode != 6)
+    {
+        for (int i = 0; i < 16; i++)
+            second[i] = bits.read(i == 0 ? secondBits - 1 : secondBits);
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        int colorWeight, alphaWeight;
+        if (mode == 6)
+            colorWeight = alphaWeight = WEIGHTS4[first[i]];
+        else if (mode == 5)
+        {
+            colorWeight = WEIGHTS2[first[i]];
+            alphaWeight = WEIGHTS2[second[i]];
+        }
+        else
+        {
+            colorWeight = indexSelection ? WEIGHTS3[second[i]] : WEIGHTS2[first[i]];
+            alphaWeight = indexSelection ? WEIGHTS2[first[i]] : WEIGHTS3[second[i]];
+        }
+        unsigned char* texel = texels + i * 4;
+        for (int c = 0; c < 4; c++)
+        {
+            int weight = c < 3 ? colorWeight : alphaWeight;
+            texel[c] = (unsigned char)(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+        }
+        if (rotation)
+            std::swap(texel[3], texel[rotation - 1]);
+    }
+    return true;
+}
+
+unsigned int BlockCompression::getBlockSize(BlockFormat format)
+{
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+size_t BlockCompression::getImageSize(BlockFormat format, int width, int height)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+}
+
+const char* BlockCompression::getName(BlockFormat format)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        return "BC1";
+    case BlockFormat::BC3:
+        return "BC3";
+    default:
+        return "BC7";
+    }
+}
+
+void BlockCompression::encodeBlock(BlockFormat format, const unsigned char* texels, unsigned char* block)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        encodeColorBlock(texels, block);
+        break;
+    case BlockFormat::BC3:
+        encodeAlphaBlock(texels, block);
+        encodeColorBlock(texels, block + 8);
+        break;
+    case BlockFormat::BC7:
+        encodeBC7Block(texels, block);
+        break;
+    }
+}
+
+bool BlockCompression::decodeBlock(BlockFormat format, const unsigned char* block, unsigned char* texels)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        decodeColorBlock(block, texels, false);
+        return true;
+    case BlockFormat::BC3:
+        decodeColorBlock(block + 8, texels, true);
+        decodeAlphaBlock(block, texels);
+        return true;
+    default:
+        return decodeBC7Block(block, texels);
+    }
+}
+
+void BlockCompression::encodeImage(BlockFormat format, int width, int height, const unsigned char* pixels, unsigned char* blocks)
+{
+    unsigned int blockSize = getBlockSize(format);
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    unsigned char texels[64];
+    for (int blockY = 0; blockY < blocksY; blockY++)
+    {
+        for (int blockX = 0; blockX < blocksX; blockX++)
+        {
+            for (int y = 0; y < 4; y++)
+            {
+                int sourceY = std::min(blockY * 4 + y, height - 1);
+                for (int x = 0; x < 4; x++)
+                {
+                    int sourceX = std::min(blockX * 4 + x, width - 1);
+                    memcpy(texels + (y * 4 + x) * 4, pixels + ((size_t)sourceY * width + sourceX) * 4, 4);
+                }
+            }
+            encodeBlock(format, texels, blocks + ((size_t)blockY * blocksX + blockX) * blockSize);
+        }
+    }
+}
+
+bool BlockCompression::decodeImage(BlockFormat format, int width, int height, const unsigned char* blocks, unsigned char* pixels)
+{
+    unsigned int blockSize = getBlockSize(format);
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    unsigned char texels[64];
+    bool decoded = true;
+    for (int blockY = 0; blockY < blocksY; blockY++)
+    {
+        for (int blockX = 0; blockX < blocksX; blockX++)
+        {
+            decoded &= decodeBlock(format, blocks + ((size_t)blockY * blocksX + blockX) * blockSize, texels);
+            for (int y = 0; y < 4 && blockY * 4 + y < height; y++)
+            {
+                int columns = std::min(4, width - blockX * 4);
+                memcpy(pixels + ((size_t)(blockY * 4 + y) * width + blockX * 4) * 4, texels + y * 16, columns * 4);
+            }
+        }
+    }
+    return decoded;
+}
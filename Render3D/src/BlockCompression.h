@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+// The block-compressed formats textures can be stored in. Each 4x4 block of texels takes 8
+// bytes in BC1 and 16 in BC3 and BC7, against 64 in RGBA8.
+enum class BlockFormat
+{
+	// RGB from two 565 endpoints and 2-bit indices; opaque.
+	BC1,
+	// BC1's colors plus alpha from two 8-bit endpoints and 3-bit indices.
+	BC3,
+	// RGBA with endpoints and index precision chosen per block; the best quality of the three.
+	BC7
+};
+
+// Encodes and decodes single blocks and whole images, texels in RGBA8 row by row.
+//
+// The encoders favour speed over the last decibel, so textures can be converted at load time
+// if need be. BC1 and BC3 take endpoints from the block's bounding box, along the diagonal its
+// colors spread over and inset as a least-squares fit would, and pick every index with SSE2.
+// BC7 uses mode 6 only: one RGBA line with 16 levels, fitted the same way. The decoders read
+// BC1 and BC3 fully and BC7 in its single-subset modes 4 to 6; the partitioned modes 0 to 3
+// and 7, which the encoder never writes, decode as opaque magenta.
+class BlockCompression
+{
+public:
+	static unsigned int getBlockSize(BlockFormat format);
+	// Bytes of an image of this size, partial blocks at the edges included.
+	static size_t getImageSize(BlockFormat format, int width, int height);
+	static const char* getName(BlockFormat format);
+
+	// texels holds 16 RGBA8 texels, 4 rows of 4.
+	static void encodeBlock(BlockFormat format, const unsigned char* texels, unsigned char* block);
+	// Returns false for a block it cannot read, which it fills with magenta.
+	static bool decodeBlock(BlockFormat format, const unsigned char* block, unsigned char* texels);
+
+	// Partial blocks at the edges repeat the last row and column.
+	static void encodeImage(BlockFormat format, int width, int height, const unsigned char* pixels, unsigned char* blocks);
+	static bool decodeImage(BlockFormat format, int width, int height, const unsigned char* blocks, unsigned char* pixels);
+};
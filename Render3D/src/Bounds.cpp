@@ -0,0 +1,51 @@
+#include "Bounds.h"
+#include <cmath>
+
+Bounds Bounds::fromVertices(const void* vertices, unsigned int vertexCount, unsigned int stride)
+{
+    const unsigned char* data = (const unsigned char*)vertices;
+    AABB box = { glm::vec3(0.0f), glm::vec3(0.0f) };
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        const float* position = (const float*)(data + (size_t)i * stride);
+        glm::vec3 point(position[0], position[1], position[2]);
+        box.min = i ? glm::min(box.min, point) : point;
+        box.max = i ? glm::max(box.max, point) : point;
+    }
+
+    // Centered on the box rather than the minimal sphere: it is within a small factor of the
+    // optimum for mesh-like point sets and keeps the sphere and box concentric.
+    Bounds bounds = { box, { box.getCenter(), 0.0f } };
+    float radiusSquared = 0.0f;
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        const float* position = (const float*)(data + (size_t)i * stride);
+        glm::vec3 offset = glm::vec3(position[0], position[1], position[2]) - bounds.sphere.center;
+        radiusSquared = std::fmax(radiusSquared, glm::dot(offset, offset));
+    }
+    bounds.sphere.radius = std::sqrt(radiusSquared);
+    return bounds;
+}
+
+Bounds Bounds::fromBox(const AABB& box)
+{
+    return { box, { box.getCenter(), glm::length(box.getExtent()) } };
+}
+
+Bounds Bounds::transformed(const glm::mat4& transform) const
+{
+    // Arvo's method: each output axis of the box takes the absolute row of the rotation.
+    glm::vec3 center = glm::vec3(transform * glm::vec4(box.getCenter(), 1.0f));
+    glm::vec3 extent = box.getExtent();
+    glm::mat3 rotation(transform);
+    glm::vec3 newExtent(
+        std::fabs(rotation[0][0]) * extent.x + std::fabs(rotation[1][0]) * extent.y + std::fabs(rotation[2][0]) * extent.z,
+        std::fabs(rotation[0][1]) * extent.x + std::fabs(rotation[1][1]) * extent.y + std::fabs(rotation[2][1]) * extent.z,
+        std::fabs(rotation[0][2]) * extent.x + std::fabs(rotation[1][2]) * extent.y + std::fabs(rotation[2][2]) * extent.z);
+
+    float scale = std::sqrt(std::fmax(glm::dot(rotation[0], rotation[0]), std::fmax(glm::dot(rotation[1], rotation[1]), glm::dot(rotation[2], rotation[2]))));
+    Bounds bounds;
+    bounds.box = { center - newExtent, center + newExtent };
+    bounds.sphere = { glm::vec3(transform * glm::vec4(sphere.center, 1.0f)), sphere.radius * scale };
+    return bounds;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+struct AABB
+{
+	glm::vec3 min;
+	glm::vec3 max;
+
+	inline glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+	inline glm::vec3 getExtent() const { return (max - min) * 0.5f; }
+};
+
+struct BoundingSphere
+{
+	glm::vec3 center;
+	float radius;
+};
+
+// The bounding volumes a mesh carries, computed once from its vertices when it is loaded.
+struct Bounds
+{
+	AABB box;
+	BoundingSphere sphere;
+
+	// Reads positions from the first three floats of each vertex; stride is in bytes.
+	static Bounds fromVertices(const void* vertices, unsigned int vertexCount, unsigned int stride);
+	static Bounds fromBox(const AABB& box);
+
+	// Bounds of these bounds moved by transform. The box is the box around the transformed
+	// box, and the sphere is scaled by the transform's largest axis scale.
+	Bounds transformed(const glm::mat4& transform) const;
+};
@@ -0,0 +1,167 @@
+#include "BuildingScene.h"
+#include "ShaderLibrary.h"
+#include "VertexBufferLayout.h"
+#include "Renderer.h"
+#include <glm/ext/matrix_transform.hpp>
+
+static constexpr Uniform<int> u_texture("u_texture");
+
+const float BuildingScene::ROOM_SIZE = 24.0f;
+const float BuildingScene::WALL_HEIGHT = 8.0f;
+const float BuildingScene::DOOR_WIDTH = 4.0f;
+const float BuildingScene::FAR_PLANE = 250.0f;
+
+// A unit wall in the XY plane, scaled to length and height by its transform.
+static const float wallVertices[] = {
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    1.0f, 0.0f, 0.0f, 4.0f, 0.0f,
+    1.0f, 1.0f, 0.0f, 4.0f, 2.0f,
+    0.0f, 1.0f, 0.0f, 0.0f, 2.0f,
+};
+
+static const unsigned int wallIndices[] = {
+    0, 1, 2,
+    2, 3, 0,
+};
+
+static const float crateVertices[] = {
+    -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,    0.5f, -0.5f,  0.5f, 1.0f, 0.0f,    0.5f,  0.5f,  0.5f, 1.0f, 1.0f,   -0.5f,  0.5f,  0.5f, 0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f, 0.0f, 0.0f,   -0.5f, -0.5f, -0.5f, 1.0f, 0.0f,   -0.5f,  0.5f, -0.5f, 1.0f, 1.0f,    0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,   -0.5f, -0.5f,  0.5f, 1.0f, 0.0f,   -0.5f,  0.5f,  0.5f, 1.0f, 1.0f,   -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
+     0.5f, -0.5f,  0.5f, 0.0f, 0.0f,    0.5f, -0.5f, -0.5f, 1.0f, 0.0f,    0.5f,  0.5f, -0.5f, 1.0f, 1.0f,    0.5f,  0.5f,  0.5f, 0.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f, 0.0f, 0.0f,    0.5f,  0.5f,  0.5f, 1.0f, 0.0f,    0.5f,  0.5f, -0.5f, 1.0f, 1.0f,   -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
+};
+
+static const unsigned int crateIndices[] = {
+     0,  1,  2,  2,  3,  0,
+     4,  5,  6,  6,  7,  4,
+     8,  9, 10, 10, 11,  8,
+    12, 13, 14, 14, 15, 12,
+    16, 17, 18, 18, 19, 16,
+};
+
+static const unsigned int WALL_VERTEX_STRIDE = 5 * sizeof(float);
+
+BuildingScene::BuildingScene(bool occlusion)
+    : m_occlusion(occlusion),
+    m_wallVB(wallVertices, sizeof(wallVertices)), m_wallIB(wallIndices, sizeof(wallIndices) / sizeof(unsigned int)),
+    m_crateVB(crateVertices, sizeof(crateVertices)), m_crateIB(crateIndices, sizeof(crateIndices) / sizeof(unsigned int)),
+    m_shader(ShaderLibrary::load("res/shaders/Simple.shader")), m_wallTexture("res/textures/Tile.png"), m_crateTexture("res/textures/whiteTile.png"),
+    m_uniformBuffer(sizeof(CameraBlock) + (4 * (ROOMS_PER_SIDE + 1) * ROOMS_PER_SIDE + CRATES_PER_ROOM * ROOMS_PER_SIDE * ROOMS_PER_SIDE) * sizeof(ObjectBlock))
+{
+    VertexBufferLayout layout;
+    layout.push<float>(3);
+    layout.push<float>(2);
+    m_wallVA.addBuffer(m_wallVB, layout);
+    m_wallVA.bind();
+    m_wallIB.bind();
+    m_crateVA.addBuffer(m_crateVB, layout);
+    m_crateVA.bind();
+    m_crateIB.bind();
+    m_crateVA.unbind();
+
+    m_shader->bindUniformBlock(CameraBlock::getLayout());
+    m_shader->bindUniformBlock(ObjectBlock::getLayout());
+    m_shader->bind();
+    m_shader->setUniform(u_texture, 0);
+
+    // Walls run along the lines between rooms, one per room side, with a doorway in the middle.
+    float half = ROOMS_PER_SIDE * ROOM_SIZE * 0.5f;
+    for (int line = 0; line <= ROOMS_PER_SIDE; line++)
+    {
+        float across = line * ROOM_SIZE - half;
+        for (int room = 0; room < ROOMS_PER_SIDE; room++)
+        {
+            float start = room * ROOM_SIZE - half;
+            float doorStart = start + (ROOM_SIZE - DOOR_WIDTH) * 0.5f;
+            float doorEnd = doorStart + DOOR_WIDTH;
+            float end = start + ROOM_SIZE;
+            addWall(glm::vec3(start, 0.0f, across), glm::vec3(doorStart, 0.0f, across));
+            addWall(glm::vec3(doorEnd, 0.0f, across), glm::vec3(end, 0.0f, across));
+            addWall(glm::vec3(across, 0.0f, start), glm::vec3(across, 0.0f, doorStart));
+            addWall(glm::vec3(across, 0.0f, doorEnd), glm::vec3(across, 0.0f, end));
+        }
+    }
+
+    Bounds crateBounds = Bounds::fromVertices(crateVertices, 20, WALL_VERTEX_STRIDE);
+    unsigned int seed = 12345;
+    auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f; };
+    for (int roomZ = 0; roomZ < ROOMS_PER_SIDE; roomZ++)
+    {
+        for (int roomX = 0; roomX < ROOMS_PER_SIDE; roomX++)
+        {
+            glm::vec3 corner(roomX * ROOM_SIZE - half, 0.0f, roomZ * ROOM_SIZE - half);
+            for (int i = 0; i < CRATES_PER_ROOM; i++)
+            {
+                float size = 1.0f + 1.5f * next();
+                glm::vec3 position = corner + glm::vec3(2.0f + (ROOM_SIZE - 4.0f) * next(), size * 0.5f, 2.0f + (ROOM_SIZE - 4.0f) * next());
+                Object crate;
+                crate.block.u_model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(size));
+                crate.block.u_color = glm::vec4(0.5f + 0.5f * next(), 0.35f + 0.3f * next(), 0.2f, 1.0f);
+                crate.crate = true;
+                m_objects.push_back(crate);
+                m_boxes.push_back(crateBounds.transformed(crate.block.u_model).box);
+            }
+        }
+    }
+
+    m_objectOffsets.resize(m_objects.size());
+    m_frustumCuller.reserve((unsigned int)m_boxes.size());
+    for (const AABB& box : m_boxes)
+        m_frustumCuller.add(box);
+}
+
+void BuildingScene::addWall(const glm::vec3& start, const glm::vec3& end)
+{
+    // The unit wall runs along +x; walls along z are turned to run along +z.
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), start);
+    if (end.z != start.z)
+        model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(glm::length(end - start), WALL_HEIGHT, 1.0f));
+
+    Object wall;
+    wall.block.u_model = model;
+    wall.block.u_color = glm::vec4(0.85f, 0.85f, 0.8f, 1.0f);
+    wall.crate = false;
+    m_objects.push_back(wall);
+    m_boxes.push_back(Bounds::fromVertices(wallVertices, 4, WALL_VERTEX_STRIDE).transformed(model).box);
+    m_occlusionCuller.addOccluder(wallVertices, WALL_VERTEX_STRIDE, wallIndices, 6, model);
+}
+
+void BuildingScene::setJobSystem(JobSystem* jobs)
+{
+    m_frustumCuller.setJobSystem(jobs);
+    m_occlusionCuller.setJobSystem(jobs);
+}
+
+void BuildingScene::onRender(const Renderer& renderer, const Camera& camera)
+{
+    // Start rasterizing the walls on the culler's threads first, so it overlaps frustum
+    // culling here and the GPU's work on the previous frame.
+    glm::mat4 viewProj = camera.proj * camera.view;
+    if (m_occlusion)
+        m_occlusionCuller.beginFrame(viewProj);
+    m_frustumCuller.cull(Frustum::fromMatrix(viewProj), m_visible);
+    if (m_occlusion)
+        m_occlusionCuller.cull(m_boxes, m_visible);
+
+    m_uniformBuffer.beginFrame();
+    unsigned int cameraOffset = m_uniformBuffer.push(CameraBlock{ viewProj, glm::vec4(camera.position, 1.0f) });
+    for (unsigned int i : m_visible)
+        m_objectOffsets[i] = m_uniformBuffer.push(m_objects[i].block);
+    m_uniformBuffer.upload();
+    m_uniformBuffer.bindBlock<CameraBlock>(cameraOffset);
+
+    m_queue.beginFrame(camera, FAR_PLANE);
+    for (unsigned int i : m_visible)
+    {
+        const Object& object = m_objects[i];
+        if (object.crate)
+            m_queue.submit(m_crateVA, m_crateIB, *m_shader, m_crateTexture, m_objectOffsets[i], glm::vec3(object.block.u_model[3]));
+        else
+            m_queue.submit(m_wallVA, m_wallIB, *m_shader, m_wallTexture, m_objectOffsets[i], m_boxes[i].getCenter());
+    }
+    m_queue.execute(renderer, m_uniformBuffer);
+
+    m_uniformBuffer.endFrame();
+}
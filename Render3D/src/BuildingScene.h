@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include "Scene.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "UniformBuffer.h"
+#include "RenderQueue.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+
+// A floor of rooms like the one RoomScene shows, each walled off from its neighbours with a
+// doorway and filled with crates. From inside one room the walls hide nearly everything else,
+// so the walls are the occluders of an OcclusionCuller and every wall and crate inside the view
+// frustum is tested against them before it is submitted. Without occlusion culling, everything
+// inside the frustum is drawn.
+class BuildingScene : public Scene
+{
+private:
+	static const int ROOMS_PER_SIDE = 9;
+	static const int CRATES_PER_ROOM = 16;
+	static const float ROOM_SIZE;
+	static const float WALL_HEIGHT;
+	static const float DOOR_WIDTH;
+	static const float FAR_PLANE;
+
+	struct Object
+	{
+		ObjectBlock block;
+		bool crate;
+	};
+
+	bool m_occlusion;
+	VertexArray m_wallVA;
+	VertexBuffer m_wallVB;
+	IndexBuffer m_wallIB;
+	VertexArray m_crateVA;
+	VertexBuffer m_crateVB;
+	IndexBuffer m_crateIB;
+	std::shared_ptr<Shader> m_shader;
+	Texture m_wallTexture;
+	Texture m_crateTexture;
+	UniformBuffer m_uniformBuffer;
+	RenderQueue m_queue;
+	FrustumCuller m_frustumCuller;
+	OcclusionCuller m_occlusionCuller;
+	std::vector<Object> m_objects;
+	std::vector<AABB> m_boxes;
+	std::vector<unsigned int> m_visible;
+	std::vector<unsigned int> m_objectOffsets;
+public:
+	BuildingScene(bool occlusion = true);
+
+	void onRender(const Renderer& renderer, const Camera& camera) override;
+	void setJobSystem(JobSystem* jobs) override;
+private:
+	void addWall(const glm::vec3& start, const glm::vec3& end);
+};
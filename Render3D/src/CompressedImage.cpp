@@ -0,0 +1,161 @@
+#include "CompressedImage.h"
+#include "ResourcePack.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// The DDS header after the "DDS " magic, as 31 little-endian words, and the fields used here.
+static const unsigned int DDS_HEADER_WORDS = 31;
+static const unsigned int DDS_SIZE = 0, DDS_FLAGS = 1, DDS_HEIGHT = 2, DDS_WIDTH = 3, DDS_LINEAR_SIZE = 4, DDS_MIP_COUNT = 6;
+static const unsigned int DDS_FORMAT_SIZE = 18, DDS_FORMAT_FLAGS = 19, DDS_FOURCC = 20, DDS_CAPS = 26;
+static const unsigned int DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+static const unsigned int DDPF_FOURCC = 0x4;
+static const unsigned int DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+// The DX10 extension's words: DXGI format, dimension, flags, array size and more flags.
+static const unsigned int DX10_HEADER_WORDS = 5;
+static const unsigned int DXGI_FORMAT_BC1_UNORM = 71, DXGI_FORMAT_BC1_UNORM_SRGB = 72, DXGI_FORMAT_BC3_UNORM = 77, DXGI_FORMAT_BC3_UNORM_SRGB = 78;
+static const unsigned int DXGI_FORMAT_BC7_UNORM = 98, DXGI_FORMAT_BC7_UNORM_SRGB = 99;
+static const unsigned int D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+
+static unsigned int makeFourCC(const char* code)
+{
+    return (unsigned int)code[0] | (unsigned int)code[1] << 8 | (unsigned int)code[2] << 16 | (unsigned int)code[3] << 24;
+}
+
+CompressedImage::CompressedImage(const MipChain& mips, BlockFormat format) : m_format(format), m_mappedBlocks(nullptr), m_mappedSize(0)
+{
+    size_t size = 0;
+    for (unsigned int level = 0; level < mips.getLevelCount(); level++)
+        size += BlockCompression::getImageSize(format, mips.getLevel(level).width, mips.getLevel(level).height);
+    m_blocks.resize(size);
+
+    size_t offset = 0;
+    for (unsigned int level = 0; level < mips.getLevelCount(); level++)
+    {
+        int width = mips.getLevel(level).width, height = mips.getLevel(level).height;
+        size_t levelSize = BlockCompression::getImageSize(format, width, height);
+        BlockCompression::encodeImage(format, width, height, mips.getPixels(level), m_blocks.data() + offset);
+        m_levels.push_back({ width, height, offset, levelSize });
+        offset += levelSize;
+    }
+}
+
+MipChain CompressedImage::decode() const
+{
+    MipChain mips;
+    std::vector<unsigned char> pixels;
+    for (unsigned int i = 0; i < m_levels.size(); i++)
+    {
+        const Level& level = m_levels[i];
+        pixels.resize((size_t)level.width * level.height * 4);
+        BlockCompression::decodeImage(m_format, level.width, level.height, getBlocks(i), pixels.data());
+        mips.appendLevel(level.width, level.height, pixels.data());
+    }
+    return mips;
+}
+
+bool CompressedImage::writeDDS(const std::string& path) const
+{
+    if (m_levels.empty())
+        return false;
+    unsigned int header[DDS_HEADER_WORDS] = {};
+    header[DDS_SIZE] = DDS_HEADER_WORDS * 4;
+    header[DDS_FLAGS] = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header[DDS_HEIGHT] = getHeight();
+    header[DDS_WIDTH] = getWidth();
+    header[DDS_LINEAR_SIZE] = (unsigned int)m_levels[0].size;
+    header[DDS_MIP_COUNT] = getLevelCount();
+    header[DDS_FORMAT_SIZE] = 32;
+    header[DDS_FORMAT_FLAGS] = DDPF_FOURCC;
+    header[DDS_FOURCC] = makeFourCC(m_format == BlockFormat::BC1 ? "DXT1" : m_format == BlockFormat::BC3 ? "DXT5" : "DX10");
+    header[DDS_CAPS] = DDSCAPS_TEXTURE | (getLevelCount() > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+    std::ofstream file(path, std::ios::binary);
+    file.write("DDS ", 4);
+    file.write((const char*)header, sizeof(header));
+    if (m_format == BlockFormat::BC7)
+    {
+        unsigned int extension[DX10_HEADER_WORDS] = { DXGI_FORMAT_BC7_UNORM, D3D10_RESOURCE_DIMENSION_TEXTURE2D, 0, 1, 0 };
+        file.write((const char*)extension, sizeof(extension));
+    }
+    file.write((const char*)getBlocks(), getSize());
+    return (bool)file;
+}
+
+bool CompressedImage::readDDS(const std::string& path, CompressedImage& image)
+{
+    Resource data = ResourcePack::load(path);
+    unsigned int header[DDS_HEADER_WORDS];
+    if (data.getSize() < 4 + sizeof(header) || memcmp(data.getData(), "DDS ", 4) != 0)
+    {
+        std::cout << "Warning: '" << path << "' is not a DDS file\n";
+        return false;
+    }
+    memcpy(header, data.getData() + 4, sizeof(header));
+    size_t offset = 4 + sizeof(header);
+
+    BlockFormat format;
+    unsigned int fourCC = header[DDS_FORMAT_FLAGS] & DDPF_FOURCC ? header[DDS_FOURCC] : 0;
+    if (fourCC == makeFourCC("DXT1"))
+        format = BlockFormat::BC1;
+    else if (fourCC == makeFourCC("DXT5"))
+        format = BlockFormat::BC3;
+    else if (fourCC == makeFourCC("DX10") && data.getSize() >= offset + DX10_HEADER_WORDS * 4)
+    {
+        unsigned int extension[DX10_HEADER_WORDS];
+        memcpy(extension, data.getData() + offset, sizeof(extension));
+        offset += sizeof(extension);
+        if (extension[1] != D3D10_RESOURCE_DIMENSION_TEXTURE2D || extension[3] != 1)
+        {
+            std::cout << "Warning: '" << path << "' is not a single 2D texture\n";
+            return false;
+        }
+        if (extension[0] == DXGI_FORMAT_BC1_UNORM || extension[0] == DXGI_FORMAT_BC1_UNORM_SRGB)
+            format = BlockFormat::BC1;
+        else if (extension[0] == DXGI_FORMAT_BC3_UNORM || extension[0] == DXGI_FORMAT_BC3_UNORM_SRGB)
+            format = BlockFormat::BC3;
+        else if (extension[0] == DXGI_FORMAT_BC7_UNORM || extension[0] == DXGI_FORMAT_BC7_UNORM_SRGB)
+            format = BlockFormat::BC7;
+        else
+        {
+            std::cout << "Warning: '" << path << "' has DXGI format " << extension[0] << ", not BC1, BC3 or BC7\n";
+            return false;
+        }
+    }
+    else
+    {
+        std::cout << "Warning: '" << path << "' is not BC1, BC3 or BC7\n";
+        return false;
+    }
+
+    CompressedImage result;
+    result.m_format = format;
+    int width = (int)header[DDS_WIDTH], height = (int)header[DDS_HEIGHT];
+    unsigned int levelCount = header[DDS_FLAGS] & DDSD_MIPMAPCOUNT ? std::max(1u, header[DDS_MIP_COUNT]) : 1;
+    levelCount = std::min(levelCount, MipChain::getFullLevelCount(width, height));
+    size_t size = 0;
+    for (unsigned int level = 0; level < levelCount; level++)
+    {
+        int levelWidth = std::max(1, width >> level), levelHeight = std::max(1, height >> level);
+        size_t levelSize = BlockCompression::getImageSize(format, levelWidth, levelHeight);
+        result.m_levels.push_back({ levelWidth, levelHeight, size, levelSize });
+        size += levelSize;
+    }
+    if (width <= 0 || height <= 0 || data.getSize() < offset + size)
+    {
+        std::cout << "Warning: '" << path << "' is truncated\n";
+        return false;
+    }
+    if (data.isMapped())
+    {
+        result.m_mappedBlocks = data.getData() + offset;
+        result.m_mappedSize = size;
+    }
+    else
+    {
+        result.m_blocks.assign(data.getData() + offset, data.getData() + offset + size);
+    }
+    image = std::move(result);
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "BlockCompression.h"
+#include "MipChain.h"
+
+// A block-compressed image and its mip levels, stored one after another like MipChain's so a
+// texture uploads from a single buffer.
+//
+// Files are DDS: the legacy DXT1 and DXT5 headers for BC1 and BC3, which every tool reads, and
+// the DX10 extension for BC7. Block rows run bottom first, the order GL reads them in, so the
+// blocks go to glCompressedTexSubImage2D as they are; flipping compressed blocks means
+// rewriting their indices. Other tools write top row first, and their files load upside down.
+class CompressedImage
+{
+public:
+	struct Level
+	{
+		int width, height;
+		size_t offset, size;
+	};
+private:
+	BlockFormat m_format;
+	std::vector<unsigned char> m_blocks;
+	// Blocks read from a mapped ResourcePack entry stay in the mapping, and m_blocks is empty.
+	const unsigned char* m_mappedBlocks;
+	size_t m_mappedSize;
+	std::vector<Level> m_levels;
+public:
+	CompressedImage() : m_format(BlockFormat::BC1), m_mappedBlocks(nullptr), m_mappedSize(0) {}
+	// Encodes every level of the chain.
+	CompressedImage(const MipChain& mips, BlockFormat format);
+
+	// Every level back in RGBA8, for drivers without the format and the software rasterizer.
+	MipChain decode() const;
+
+	inline BlockFormat getFormat() const { return m_format; }
+	inline unsigned int getLevelCount() const { return (unsigned int)m_levels.size(); }
+	inline const Level& getLevel(unsigned int level) const { return m_levels[level]; }
+	inline int getWidth() const { return m_levels.empty() ? 0 : m_levels[0].width; }
+	inline int getHeight() const { return m_levels.empty() ? 0 : m_levels[0].height; }
+	inline const unsigned char* getBlocks(unsigned int level = 0) const { return (m_mappedBlocks ? m_mappedBlocks : m_blocks.data()) + m_levels[level].offset; }
+	// Bytes of every level together.
+	inline size_t getSize() const { return m_mappedBlocks ? m_mappedSize : m_blocks.size(); }
+	inline bool isMapped() const { return m_mappedBlocks != nullptr; }
+
+	bool writeDDS(const std::string& path) const;
+	// Reads a 2D DDS file of BC1, BC3 or BC7 blocks, printing why it cannot otherwise. A file in
+	// the mounted ResourcePack is not copied: the image refers to its blocks in the mapping.
+	static bool readDDS(const std::string& path, CompressedImage& image);
+};
@@ -0,0 +1,73 @@
+#include "FrameStats.h"
+#include <iomanip>
+
+unsigned long long FrameStats::s_current[(unsigned int)Stat::Count] = {};
+unsigned long long FrameStats::s_last[(unsigned int)Stat::Count] = {};
+unsigned long long FrameStats::s_total[(unsigned int)Stat::Count] = {};
+unsigned int FrameStats::s_frameCount = 0;
+
+static const char* const statNames[] = {
+    "draw calls",
+    "glGetError calls",
+    "bind cache hits",
+    "bind cache misses",
+    "texture binds",
+    "uniform uploads",
+    "state changes, submit order",
+    "state changes, sorted",
+    "objects culled",
+    "draws occluded",
+    "triangles binned, software",
+    "texture bytes streamed",
+    "texture bytes resident",
+    "textures evicted",
+    "texture levels dropped",
+    "draws skipped, not ready",
+};
+static_assert(sizeof(statNames) / sizeof(statNames[0]) == (unsigned int)Stat::Count, "Every Stat needs a name");
+
+void FrameStats::endFrame()
+{
+    for (unsigned int i = 0; i < (unsigned int)Stat::Count; i++)
+    {
+        s_last[i] = s_current[i];
+        s_total[i] += s_current[i];
+        s_current[i] = 0;
+    }
+    s_frameCount++;
+}
+
+void FrameStats::reset()
+{
+    for (unsigned int i = 0; i < (unsigned int)Stat::Count; i++)
+    {
+        s_current[i] = 0;
+        s_last[i] = 0;
+        s_total[i] = 0;
+    }
+    s_frameCount = 0;
+}
+
+unsigned long long FrameStats::getLast(Stat stat)
+{
+    return s_last[(unsigned int)stat];
+}
+
+double FrameStats::getAverage(Stat stat)
+{
+    return s_frameCount ? (double)s_total[(unsigned int)stat] / s_frameCount : 0.0;
+}
+
+const char* FrameStats::getName(Stat stat)
+{
+    return statNames[(unsigned int)stat];
+}
+
+void FrameStats::printReport(std::ostream& os)
+{
+    os << "Per-frame averages over " << s_frameCount << " frames:\n";
+    os << std::fixed << std::setprecision(2);
+    for (unsigned int i = 0; i < (unsigned int)Stat::Count; i++)
+        os << "  " << std::left << std::setw(28) << statNames[i] << std::right << getAverage((Stat)i) << "\n";
+    os << std::defaultfloat;
+}
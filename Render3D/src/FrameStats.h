@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ostream>
+
+enum class Stat : unsigned int
+{
+	DrawCalls,
+	GLGetErrorCalls,
+	BindHits,
+	BindMisses,
+	TextureBinds,
+	UniformUploads,
+	StateChangesSubmitted,
+	StateChangesSorted,
+	ObjectsCulled,
+	DrawsOccluded,
+	TrianglesBinned,
+	TextureBytesStreamed,
+	TextureMemory,
+	TexturesEvicted,
+	TextureLevelsDropped,
+	DrawsSkipped,
+	Count
+};
+
+// Counters that the renderer and its helpers bump while a frame is being built.
+// Renderer::endFrame closes the frame so the last frame and the running averages can be read.
+class FrameStats
+{
+private:
+	static unsigned long long s_current[(unsigned int)Stat::Count];
+	static unsigned long long s_last[(unsigned int)Stat::Count];
+	static unsigned long long s_total[(unsigned int)Stat::Count];
+	static unsigned int s_frameCount;
+public:
+	static inline void add(Stat stat, unsigned long long amount = 1) { s_current[(unsigned int)stat] += amount; }
+
+	static void endFrame();
+	static void reset();
+
+	static unsigned long long getLast(Stat stat);
+	static double getAverage(Stat stat);
+	static const char* getName(Stat stat);
+
+	static void printReport(std::ostream& os);
+};
@@ -0,0 +1,66 @@
+#include "FrameTimer.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+FrameTimer::FrameTimer(unsigned int expectedFrames) : m_runTimeMs(0.0)
+{
+    m_frameTimesMs.reserve(expectedFrames);
+}
+
+void FrameTimer::beginRun()
+{
+    m_frameTimesMs.clear();
+    m_runTimeMs = 0.0;
+    m_runStart = Clock::now();
+}
+
+void FrameTimer::endRun()
+{
+    m_runTimeMs = std::chrono::duration<double, std::milli>(Clock::now() - m_runStart).count();
+}
+
+void FrameTimer::beginFrame()
+{
+    m_frameStart = Clock::now();
+}
+
+void FrameTimer::endFrame()
+{
+    m_frameTimesMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - m_frameStart).count());
+}
+
+double FrameTimer::percentile(double p) const
+{
+    if (m_frameTimesMs.empty())
+        return 0.0;
+    std::vector<double> sorted(m_frameTimesMs);
+    std::sort(sorted.begin(), sorted.end());
+    // Nearest-rank percentile, so p99 of 100 frames is the slowest frame rather than an interpolation.
+    size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+    return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+double FrameTimer::mean() const
+{
+    if (m_frameTimesMs.empty())
+        return 0.0;
+    double sum = 0.0;
+    for (double t : m_frameTimesMs)
+        sum += t;
+    return sum / m_frameTimesMs.size();
+}
+
+void FrameTimer::printReport(std::ostream& os) const
+{
+    double minTime = m_frameTimesMs.empty() ? 0.0 : *std::min_element(m_frameTimesMs.begin(), m_frameTimesMs.end());
+    double maxTime = m_frameTimesMs.empty() ? 0.0 : *std::max_element(m_frameTimesMs.begin(), m_frameTimesMs.end());
+
+    os << std::fixed << std::setprecision(3);
+    os << "Frames:     " << m_frameTimesMs.size() << "\n";
+    os << "CPU ms:     mean " << mean() << "  min " << minTime << "  max " << maxTime << "\n";
+    os << "            p50 " << percentile(50.0) << "  p95 " << percentile(95.0) << "  p99 " << percentile(99.0) << "\n";
+    os << "Total ms:   " << m_runTimeMs << "\n";
+    os << "Throughput: " << (m_runTimeMs > 0.0 ? m_frameTimesMs.size() * 1000.0 / m_runTimeMs : 0.0) << " frames/s\n";
+    os << std::defaultfloat;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+// Records the CPU time spent on each frame of a run and summarizes it as percentiles and throughput.
+class FrameTimer
+{
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	std::vector<double> m_frameTimesMs;
+	Clock::time_point m_runStart;
+	Clock::time_point m_frameStart;
+	double m_runTimeMs;
+public:
+	FrameTimer(unsigned int expectedFrames = 0);
+
+	void beginRun();
+	void endRun();
+	void beginFrame();
+	void endFrame();
+
+	double percentile(double p) const;
+	double mean() const;
+
+	void printReport(std::ostream& os) const;
+
+	inline unsigned int getFrameCount() const { return (unsigned int)m_frameTimesMs.size(); }
+	inline const std::vector<double>& getFrameTimes() const { return m_frameTimesMs; }
+	inline double getRunTime() const { return m_runTimeMs; }
+};
@@ -0,0 +1,55 @@
+#include "Framebuffer.h"
+#include "Renderer.h"
+
+Framebuffer::Framebuffer(int width, int height) : m_rendererId(0), m_colorAttachment(0), m_depthAttachment(0), m_width(width), m_height(height)
+{
+    GLCall(glGenFramebuffers(1, &m_rendererId));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_rendererId));
+
+    GLCall(glGenRenderbuffers(1, &m_colorAttachment));
+    GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_colorAttachment));
+    GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height));
+    GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorAttachment));
+
+    GLCall(glGenRenderbuffers(1, &m_depthAttachment));
+    GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_depthAttachment));
+    GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height));
+    GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthAttachment));
+
+    GLCall(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+Framebuffer::~Framebuffer()
+{
+    GLCall(glDeleteRenderbuffers(1, &m_depthAttachment));
+    GLCall(glDeleteRenderbuffers(1, &m_colorAttachment));
+    GLCall(glDeleteFramebuffers(1, &m_rendererId));
+}
+
+void Framebuffer::bind() const
+{
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_rendererId));
+    GLCall(glViewport(0, 0, m_width, m_height));
+}
+
+void Framebuffer::unbind() const
+{
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+bool Framebuffer::isComplete() const
+{
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_rendererId));
+    GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+    return status == GL_FRAMEBUFFER_COMPLETE;
+}
+
+std::vector<unsigned char> Framebuffer::readPixels() const
+{
+    std::vector<unsigned char> pixels((size_t)m_width * m_height * 4);
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_rendererId));
+    GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    GLCall(glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+    return pixels;
+}
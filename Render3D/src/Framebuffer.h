@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+class Framebuffer
+{
+private:
+	unsigned int m_rendererId;
+	unsigned int m_colorAttachment;
+	unsigned int m_depthAttachment;
+	int m_width, m_height;
+public:
+	Framebuffer(int width, int height);
+	~Framebuffer();
+
+	void bind() const;
+	void unbind() const;
+
+	bool isComplete() const;
+	std::vector<unsigned char> readPixels() const;
+
+	inline int getWidth() const { return m_width; }
+	inline int getHeight() const { return m_height; }
+};
@@ -0,0 +1,45 @@
+#include "Frustum.h"
+#include <cmath>
+
+Frustum Frustum::fromMatrix(const glm::mat4& viewProj)
+{
+    glm::vec4 row0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+    glm::vec4 row1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+    glm::vec4 row2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+    glm::vec4 row3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+    Frustum frustum;
+    frustum.planes[LEFT] = row3 + row0;
+    frustum.planes[RIGHT] = row3 - row0;
+    frustum.planes[BOTTOM] = row3 + row1;
+    frustum.planes[TOP] = row3 - row1;
+    frustum.planes[NEAR_PLANE] = row3 + row2;
+    frustum.planes[FAR_PLANE] = row3 - row2;
+    for (glm::vec4& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool Frustum::intersects(const AABB& box) const
+{
+    glm::vec3 center = box.getCenter();
+    glm::vec3 extent = box.getExtent();
+    for (const glm::vec4& plane : planes)
+    {
+        float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        float radius = std::fabs(plane.x) * extent.x + std::fabs(plane.y) * extent.y + std::fabs(plane.z) * extent.z;
+        if (distance + radius < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::intersects(const BoundingSphere& sphere) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w + sphere.radius < 0.0f)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "Bounds.h"
+
+// The six planes of a view frustum, pointing inwards, as (normal, distance) with normalized
+// normals so plane distances are in world units.
+struct Frustum
+{
+	enum PlaneIndex { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+
+	glm::vec4 planes[PLANE_COUNT];
+
+	// Extracts the planes from a combined projection * view matrix (Gribb and Hartmann).
+	static Frustum fromMatrix(const glm::mat4& viewProj);
+
+	bool intersects(const AABB& box) const;
+	bool intersects(const BoundingSphere& sphere) const;
+};
@@ -0,0 +1,221 @@
+#include "FrustumCuller.h"
+#include "FrameStats.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define CULL_SSE 1
+#endif
+#if defined(__AVX__)
+#define CULL_AVX 1
+#endif
+
+FrustumCuller::FrustumCuller()
+    : m_threadCount(0), m_jobs(nullptr)
+{
+}
+
+void FrustumCuller::clear()
+{
+    m_centerX.clear(); m_centerY.clear(); m_centerZ.clear();
+    m_extentX.clear(); m_extentY.clear(); m_extentZ.clear();
+}
+
+void FrustumCuller::reserve(unsigned int count)
+{
+    m_centerX.reserve(count); m_centerY.reserve(count); m_centerZ.reserve(count);
+    m_extentX.reserve(count); m_extentY.reserve(count); m_extentZ.reserve(count);
+}
+
+unsigned int FrustumCuller::add(const AABB& box)
+{
+    unsigned int index = getSize();
+    m_centerX.push_back(0.0f); m_centerY.push_back(0.0f); m_centerZ.push_back(0.0f);
+    m_extentX.push_back(0.0f); m_extentY.push_back(0.0f); m_extentZ.push_back(0.0f);
+    set(index, box);
+    return index;
+}
+
+void FrustumCuller::set(unsigned int index, const AABB& box)
+{
+    glm::vec3 center = box.getCenter();
+    glm::vec3 extent = box.getExtent();
+    m_centerX[index] = center.x; m_centerY[index] = center.y; m_centerZ[index] = center.z;
+    m_extentX[index] = extent.x; m_extentY[index] = extent.y; m_extentZ[index] = extent.z;
+}
+
+FrustumCuller::Kernel FrustumCuller::getBestKernel()
+{
+#if CULL_AVX
+    return Kernel::AVX;
+#elif CULL_SSE
+    return Kernel::SSE;
+#else
+    return Kernel::Scalar;
+#endif
+}
+
+const char* FrustumCuller::getKernelName(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Kernel::Scalar:    return "scalar";
+    case Kernel::SSE:       return "SSE";
+    case Kernel::AVX:       return "AVX";
+    case Kernel::Best:      return getKernelName(getBestKernel());
+    }
+    return "";
+}
+
+void FrustumCuller::cull(const Frustum& frustum, std::vector<unsigned int>& visible, Kernel kernel)
+{
+    if (kernel == Kernel::Best)
+        kernel = getBestKernel();
+
+    unsigned int count = getSize();
+    unsigned int threadCount = m_jobs ? m_jobs->getThreadCount() : m_threadCount ? m_threadCount : std::thread::hardware_concurrency();
+    visible.clear();
+    if (count < PARALLEL_THRESHOLD || threadCount < 2)
+    {
+        cullRange(frustum, 0, count, visible, kernel);
+        FrameStats::add(Stat::ObjectsCulled, count - visible.size());
+        return;
+    }
+
+    if (m_jobs)
+    {
+        // A few chunks per thread for idle threads to steal, each with its own results.
+        unsigned int chunk = (count / (threadCount * 4) + 7) & ~7u;
+        m_threadResults.resize((count + chunk - 1) / chunk);
+        m_jobs->wait(m_jobs->parallelFor("frustum cull", count, chunk, [this, &frustum, chunk, kernel](unsigned int begin, unsigned int end) {
+            std::vector<unsigned int>& results = m_threadResults[begin / chunk];
+            results.clear();
+            cullRange(frustum, begin, end, results, kernel);
+        }));
+        for (const std::vector<unsigned int>& results : m_threadResults)
+            visible.insert(visible.end(), results.begin(), results.end());
+        FrameStats::add(Stat::ObjectsCulled, count - visible.size());
+        return;
+    }
+
+    // Chunks are multiples of eight so every thread runs whole SIMD groups except the last.
+    unsigned int chunk = (((count + threadCount - 1) / threadCount) + 7) & ~7u;
+    m_threadResults.resize(threadCount);
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned int t = 1; t < threadCount; t++)
+    {
+        unsigned int begin = std::min(count, t * chunk);
+        unsigned int end = std::min(count, begin + chunk);
+        std::vector<unsigned int>& results = m_threadResults[t];
+        results.clear();
+        threads.emplace_back([this, &frustum, begin, end, &results, kernel]() { cullRange(frustum, begin, end, results, kernel); });
+    }
+    cullRange(frustum, 0, std::min(count, chunk), visible, kernel);
+    for (unsigned int t = 1; t < threadCount; t++)
+    {
+        threads[t - 1].join();
+        visible.insert(visible.end(), m_threadResults[t].begin(), m_threadResults[t].end());
+    }
+    FrameStats::add(Stat::ObjectsCulled, count - visible.size());
+}
+
+void FrustumCuller::cullRange(const Frustum& frustum, unsigned int begin, unsigned int end, std::vector<unsigned int>& visible, Kernel kernel) const
+{
+    const float* cx = m_centerX.data();
+    const float* cy = m_centerY.data();
+    const float* cz = m_centerZ.data();
+    const float* ex = m_extentX.data();
+    const float* ey = m_extentY.data();
+    const float* ez = m_extentZ.data();
+    const glm::vec4* planes = frustum.planes;
+    unsigned int i = begin;
+
+#if CULL_AVX
+    if (kernel == Kernel::AVX)
+    {
+        // Broadcast the planes once, as (x, y, z, w, |x|, |y|, |z|) per plane.
+        __m256 planeLanes[Frustum::PLANE_COUNT][7];
+        for (unsigned int p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            for (unsigned int c = 0; c < 4; c++)
+                planeLanes[p][c] = _mm256_set1_ps(planes[p][c]);
+            for (unsigned int c = 0; c < 3; c++)
+                planeLanes[p][4 + c] = _mm256_set1_ps(std::fabs(planes[p][c]));
+        }
+
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 centerX = _mm256_loadu_ps(cx + i), centerY = _mm256_loadu_ps(cy + i), centerZ = _mm256_loadu_ps(cz + i);
+            __m256 extentX = _mm256_loadu_ps(ex + i), extentY = _mm256_loadu_ps(ey + i), extentZ = _mm256_loadu_ps(ez + i);
+            __m256 outside = _mm256_setzero_ps();
+            for (unsigned int p = 0; p < Frustum::PLANE_COUNT; p++)
+            {
+                const __m256* plane = planeLanes[p];
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane[0], centerX), _mm256_mul_ps(plane[1], centerY)),
+                    _mm256_add_ps(_mm256_mul_ps(plane[2], centerZ), plane[3]));
+                __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane[4], extentX), _mm256_mul_ps(plane[5], extentY)),
+                    _mm256_mul_ps(plane[6], extentZ));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+            }
+            unsigned int mask = ~(unsigned int)_mm256_movemask_ps(outside) & 0xFF;
+            for (unsigned int bit = 0; mask; bit++, mask >>= 1)
+            {
+                if (mask & 1)
+                    visible.push_back(i + bit);
+            }
+        }
+    }
+#endif
+#if CULL_SSE
+    if (kernel == Kernel::SSE || kernel == Kernel::AVX)
+    {
+        __m128 planeLanes[Frustum::PLANE_COUNT][7];
+        for (unsigned int p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            for (unsigned int c = 0; c < 4; c++)
+                planeLanes[p][c] = _mm_set1_ps(planes[p][c]);
+            for (unsigned int c = 0; c < 3; c++)
+                planeLanes[p][4 + c] = _mm_set1_ps(std::fabs(planes[p][c]));
+        }
+
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 centerX = _mm_loadu_ps(cx + i), centerY = _mm_loadu_ps(cy + i), centerZ = _mm_loadu_ps(cz + i);
+            __m128 extentX = _mm_loadu_ps(ex + i), extentY = _mm_loadu_ps(ey + i), extentZ = _mm_loadu_ps(ez + i);
+            __m128 outside = _mm_setzero_ps();
+            for (unsigned int p = 0; p < Frustum::PLANE_COUNT; p++)
+            {
+                const __m128* plane = planeLanes[p];
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[0], centerX), _mm_mul_ps(plane[1], centerY)),
+                    _mm_add_ps(_mm_mul_ps(plane[2], centerZ), plane[3]));
+                __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[4], extentX), _mm_mul_ps(plane[5], extentY)),
+                    _mm_mul_ps(plane[6], extentZ));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            }
+            unsigned int mask = ~(unsigned int)_mm_movemask_ps(outside) & 0xF;
+            for (unsigned int bit = 0; mask; bit++, mask >>= 1)
+            {
+                if (mask & 1)
+                    visible.push_back(i + bit);
+            }
+        }
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        bool inside = true;
+        for (unsigned int p = 0; p < Frustum::PLANE_COUNT && inside; p++)
+        {
+            const glm::vec4& plane = planes[p];
+            float distance = plane.x * cx[i] + plane.y * cy[i] + plane.z * cz[i] + plane.w;
+            float radius = std::fabs(plane.x) * ex[i] + std::fabs(plane.y) * ey[i] + std::fabs(plane.z) * ez[i];
+            inside = distance + radius >= 0.0f;
+        }
+        if (inside)
+            visible.push_back(i);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include "Bounds.h"
+#include "Frustum.h"
+
+class JobSystem;
+
+// Frustum culling over many objects at once. World-space boxes are kept as structure-of-arrays
+// (centers and extents in separate float arrays), so the kernel tests four or eight objects
+// against a plane per instruction with SSE or AVX. Large object counts are split across threads,
+// or across jobs when the culler is given a JobSystem.
+class FrustumCuller
+{
+public:
+	enum class Kernel
+	{
+		Scalar,
+		SSE,
+		AVX,
+		Best
+	};
+private:
+	std::vector<float> m_centerX, m_centerY, m_centerZ;
+	std::vector<float> m_extentX, m_extentY, m_extentZ;
+	std::vector<std::vector<unsigned int>> m_threadResults;
+	unsigned int m_threadCount;
+	JobSystem* m_jobs;
+public:
+	// Counts below this are culled on the calling thread; starting threads costs more than it saves.
+	static const unsigned int PARALLEL_THRESHOLD = 65536;
+
+	FrustumCuller();
+
+	void clear();
+	void reserve(unsigned int count);
+	// Returns the object's index, which cull reports it by.
+	unsigned int add(const AABB& box);
+	void set(unsigned int index, const AABB& box);
+
+	// Replaces visible with the indices of the objects whose boxes intersect the frustum, in
+	// ascending order. Uses up to threadCount threads (0 for one per core), or the job system's.
+	void cull(const Frustum& frustum, std::vector<unsigned int>& visible, Kernel kernel = Kernel::Best);
+
+	inline void setThreadCount(unsigned int threadCount) { m_threadCount = threadCount; }
+	// Runs large culls as jobs instead of on threads of its own; nullptr goes back to threads.
+	inline void setJobSystem(JobSystem* jobs) { m_jobs = jobs; }
+	inline unsigned int getSize() const { return (unsigned int)m_centerX.size(); }
+
+	static Kernel getBestKernel();
+	static const char* getKernelName(Kernel kernel);
+private:
+	void cullRange(const Frustum& frustum, unsigned int begin, unsigned int end, std::vector<unsigned int>& visible, Kernel kernel) const;
+};
@@ -0,0 +1,92 @@
+#include "GLDebug.h"
+#include "FrameStats.h"
+#include <iostream>
+
+GLErrorPolicy GLDebug::s_policy = GLErrorPolicy::Always;
+unsigned int GLDebug::s_sampleInterval = 1;
+unsigned int GLDebug::s_frameIndex = 0;
+bool GLDebug::s_polling = true;
+const char* GLDebug::s_lastFunction = "";
+const char* GLDebug::s_lastFile = "";
+int GLDebug::s_lastLine = 0;
+
+void GLClearError()
+{
+    FrameStats::add(Stat::GLGetErrorCalls);
+    while (glGetError() != GL_NO_ERROR)
+        FrameStats::add(Stat::GLGetErrorCalls);
+}
+
+bool GLLogCall(const char* function, const char* file, int line)
+{
+    FrameStats::add(Stat::GLGetErrorCalls);
+    while (GLenum error = glGetError())
+    {
+        std::cout << "[OpenGL Error] (" << error << "): " << function << " " << file << ":" << line << "\n";
+        return false;
+    }
+    return true;
+}
+
+GLErrorPolicy GLDebug::init(GLErrorPolicy preferred, unsigned int sampleInterval)
+{
+    s_sampleInterval = sampleInterval ? sampleInterval : 1;
+    s_policy = preferred;
+
+    if (preferred == GLErrorPolicy::DebugOutput)
+    {
+        if (GLEW_VERSION_4_3 || GLEW_KHR_debug)
+        {
+            glEnable(GL_DEBUG_OUTPUT);
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            glDebugMessageCallback(debugCallback, nullptr);
+        }
+        else if (GLEW_ARB_debug_output)
+        {
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+            glDebugMessageCallbackARB(debugCallback, nullptr);
+        }
+        else
+        {
+            s_policy = GLErrorPolicy::Always;
+        }
+    }
+
+    s_frameIndex = 0;
+    s_polling = s_policy == GLErrorPolicy::Always || s_policy == GLErrorPolicy::Sampled;
+    return s_policy;
+}
+
+void GLDebug::beginFrame()
+{
+    s_frameIndex++;
+    if (s_policy == GLErrorPolicy::Sampled)
+        s_polling = s_frameIndex % s_sampleInterval == 0;
+}
+
+const char* GLDebug::getPolicyName(GLErrorPolicy policy)
+{
+    switch (policy)
+    {
+    case GLErrorPolicy::None:           return "none";
+    case GLErrorPolicy::Always:         return "always";
+    case GLErrorPolicy::Sampled:        return "sampled";
+    case GLErrorPolicy::DebugOutput:    return "debug output";
+    }
+    return "";
+}
+
+void GLAPIENTRY GLDebug::debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+{
+    if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+        return;
+
+    std::cout << "[OpenGL Debug] (" << id << "): " << message << "\n";
+    if (type == GL_DEBUG_TYPE_ERROR)
+    {
+        // Synchronous output means the callback runs inside the offending call, so the last
+        // GLCall site is the one that raised the error.
+        std::cout << "  at " << s_lastFunction << " " << s_lastFile << ":" << s_lastLine << "\n";
+        DEBUG_BREAK();
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#if defined(_MSC_VER)
+	#define DEBUG_BREAK() __debugbreak()
+#else
+	#include <csignal>
+	#define DEBUG_BREAK() std::raise(SIGTRAP)
+#endif
+
+#define ASSERT(x) if (!(x)) DEBUG_BREAK();
+
+// GL_CHECKS selects whether GLCall instruments GL calls at all. With 0 GLCall(x) compiles to
+// just x. It defaults to on unless NDEBUG is set; the Release configurations define it to 0.
+#ifndef GL_CHECKS
+	#ifdef NDEBUG
+		#define GL_CHECKS 0
+	#else
+		#define GL_CHECKS 1
+	#endif
+#endif
+
+#if GL_CHECKS
+#define GLCall(x) GLBeginCall(#x, __FILE__, __LINE__);\
+    x;\
+    GLEndCall(#x, __FILE__, __LINE__)
+#else
+#define GLCall(x) x
+#endif
+
+void GLClearError();
+bool GLLogCall(const char* function, const char* file, int line);
+
+// How instrumented builds find GL errors at runtime.
+enum class GLErrorPolicy
+{
+	None,        // never poll
+	Always,      // poll glGetError around every GLCall
+	Sampled,     // poll around every GLCall, but only on every Nth frame
+	DebugOutput  // let the driver report errors through KHR_debug / ARB_debug_output, never poll
+};
+
+class GLDebug
+{
+private:
+	static GLErrorPolicy s_policy;
+	static unsigned int s_sampleInterval;
+	static unsigned int s_frameIndex;
+	static bool s_polling;
+	static const char* s_lastFunction;
+	static const char* s_lastFile;
+	static int s_lastLine;
+public:
+	// Installs the debug output callback when the driver supports it and falls back to
+	// polling every call otherwise. Must be called with a current context after glewInit.
+	static GLErrorPolicy init(GLErrorPolicy preferred = GLErrorPolicy::DebugOutput, unsigned int sampleInterval = 60);
+	static void beginFrame();
+
+	static inline bool isPolling() { return s_polling; }
+	static inline void setCallSite(const char* function, const char* file, int line) { s_lastFunction = function; s_lastFile = file; s_lastLine = line; }
+
+	static inline GLErrorPolicy getPolicy() { return s_policy; }
+	static const char* getPolicyName(GLErrorPolicy policy);
+private:
+	static void GLAPIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+};
+
+inline void GLBeginCall(const char* function, const char* file, int line)
+{
+	GLDebug::setCallSite(function, file, line);
+	if (GLDebug::isPolling())
+		GLClearError();
+}
+
+inline void GLEndCall(const char* function, const char* file, int line)
+{
+	if (GLDebug::isPolling())
+		ASSERT(GLLogCall(function, file, line));
+}
@@ -0,0 +1,284 @@
+#include "GLState.h"
+#include "GLDebug.h"
+#include "FrameStats.h"
+
+const unsigned int GLState::UNKNOWN;
+
+unsigned int GLState::s_program = GLState::UNKNOWN;
+unsigned int GLState::s_vertexArray = GLState::UNKNOWN;
+unsigned int GLState::s_buffers[GLState::BUFFER_TARGET_COUNT] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+std::vector<unsigned int> GLState::s_elementBuffers;
+unsigned int GLState::s_activeTextureUnit = GLState::UNKNOWN;
+unsigned int GLState::s_textures[GLState::TEXTURE_TARGET_COUNT][GLState::MAX_TEXTURE_UNITS];
+GLState::BufferRange GLState::s_uniformRanges[GLState::MAX_UNIFORM_BINDINGS];
+unsigned int GLState::s_blending = GLState::UNKNOWN;
+unsigned int GLState::s_depthTest = GLState::UNKNOWN;
+unsigned int GLState::s_depthWrite = GLState::UNKNOWN;
+unsigned int GLState::s_depthFunc = GLState::UNKNOWN;
+unsigned int GLState::s_colorWrite = GLState::UNKNOWN;
+
+static int bufferTargetIndex(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER:           return 0;
+    case GL_UNIFORM_BUFFER:         return 1;
+    case GL_DRAW_INDIRECT_BUFFER:   return 2;
+    case GL_PIXEL_UNPACK_BUFFER:    return 3;
+    case GL_PIXEL_PACK_BUFFER:      return 4;
+    case GL_COPY_READ_BUFFER:       return 5;
+    case GL_COPY_WRITE_BUFFER:      return 6;
+    }
+    return -1;
+}
+
+static int textureTargetIndex(GLenum target)
+{
+    switch (target)
+    {
+    case GL_TEXTURE_2D:         return 0;
+    case GL_TEXTURE_2D_ARRAY:   return 1;
+    }
+    return -1;
+}
+
+static inline bool cacheHit(unsigned int cached, unsigned int id)
+{
+    if (cached == id)
+    {
+        FrameStats::add(Stat::BindHits);
+        return true;
+    }
+    FrameStats::add(Stat::BindMisses);
+    return false;
+}
+
+void GLState::bindProgram(unsigned int id)
+{
+    if (cacheHit(s_program, id))
+        return;
+    GLCall(glUseProgram(id));
+    s_program = id;
+}
+
+void GLState::bindVertexArray(unsigned int id)
+{
+    if (cacheHit(s_vertexArray, id))
+        return;
+    GLCall(glBindVertexArray(id));
+    s_vertexArray = id;
+}
+
+void GLState::bindBuffer(GLenum target, unsigned int id)
+{
+    if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        if (s_vertexArray == UNKNOWN)
+        {
+            FrameStats::add(Stat::BindMisses);
+            GLCall(glBindBuffer(target, id));
+            return;
+        }
+        unsigned int& cached = elementBufferOf(s_vertexArray);
+        if (cacheHit(cached, id))
+            return;
+        GLCall(glBindBuffer(target, id));
+        cached = id;
+        return;
+    }
+
+    int index = bufferTargetIndex(target);
+    if (index < 0)
+    {
+        FrameStats::add(Stat::BindMisses);
+        GLCall(glBindBuffer(target, id));
+        return;
+    }
+    if (cacheHit(s_buffers[index], id))
+        return;
+    GLCall(glBindBuffer(target, id));
+    s_buffers[index] = id;
+}
+
+void GLState::bindBufferRange(GLenum target, unsigned int index, unsigned int id, unsigned int offset, unsigned int size)
+{
+    if (target != GL_UNIFORM_BUFFER || index >= MAX_UNIFORM_BINDINGS)
+    {
+        FrameStats::add(Stat::BindMisses);
+        GLCall(glBindBufferRange(target, index, id, offset, size));
+        return;
+    }
+
+    BufferRange& cached = s_uniformRanges[index];
+    if (cached.id == id && cached.offset == offset && cached.size == size)
+    {
+        FrameStats::add(Stat::BindHits);
+        return;
+    }
+    FrameStats::add(Stat::BindMisses);
+    GLCall(glBindBufferRange(target, index, id, offset, size));
+    cached = { id, offset, size };
+    // Binding a range also replaces the generic binding point.
+    s_buffers[bufferTargetIndex(target)] = id;
+}
+
+void GLState::bindTexture(GLenum target, unsigned int unit, unsigned int id)
+{
+    int index = textureTargetIndex(target);
+    if (index < 0 || unit >= MAX_TEXTURE_UNITS)
+    {
+        FrameStats::add(Stat::BindMisses);
+        FrameStats::add(Stat::TextureBinds);
+        setActiveTextureUnit(unit);
+        GLCall(glBindTexture(target, id));
+        return;
+    }
+    if (cacheHit(s_textures[index][unit], id))
+        return;
+    FrameStats::add(Stat::TextureBinds);
+    setActiveTextureUnit(unit);
+    GLCall(glBindTexture(target, id));
+    s_textures[index][unit] = id;
+}
+
+void GLState::bindTexture(GLenum target, unsigned int id)
+{
+    if (s_activeTextureUnit == UNKNOWN)
+        setActiveTextureUnit(0);
+    bindTexture(target, s_activeTextureUnit, id);
+}
+
+void GLState::setBlending(bool enabled)
+{
+    setCapability(GL_BLEND, s_blending, enabled);
+}
+
+void GLState::setDepthTest(bool enabled)
+{
+    setCapability(GL_DEPTH_TEST, s_depthTest, enabled);
+}
+
+void GLState::setDepthWrite(bool enabled)
+{
+    if (cacheHit(s_depthWrite, enabled))
+        return;
+    GLCall(glDepthMask(enabled ? GL_TRUE : GL_FALSE));
+    s_depthWrite = enabled;
+}
+
+void GLState::setDepthFunc(GLenum func)
+{
+    if (cacheHit(s_depthFunc, func))
+        return;
+    GLCall(glDepthFunc(func));
+    s_depthFunc = func;
+}
+
+void GLState::setColorWrite(bool enabled)
+{
+    if (cacheHit(s_colorWrite, enabled))
+        return;
+    GLboolean mask = enabled ? GL_TRUE : GL_FALSE;
+    GLCall(glColorMask(mask, mask, mask, mask));
+    s_colorWrite = enabled;
+}
+
+void GLState::onProgramDeleted(unsigned int id)
+{
+    // A deleted program stays in use until something else is bound, and its name can be
+    // handed out again, so forget it rather than assume 0.
+    if (s_program == id)
+        s_program = UNKNOWN;
+}
+
+void GLState::onVertexArrayDeleted(unsigned int id)
+{
+    if (s_vertexArray == id)
+        s_vertexArray = 0;
+    if (id < s_elementBuffers.size())
+        s_elementBuffers[id] = UNKNOWN;
+}
+
+void GLState::onBufferDeleted(unsigned int id)
+{
+    for (unsigned int& buffer : s_buffers)
+    {
+        if (buffer == id)
+            buffer = 0;
+    }
+    for (BufferRange& range : s_uniformRanges)
+    {
+        if (range.id == id)
+            range = { 0, 0, 0 };
+    }
+    // Other vertex arrays keep the deleted buffer attached under a name that may be reused.
+    for (unsigned int& buffer : s_elementBuffers)
+    {
+        if (buffer == id)
+            buffer = UNKNOWN;
+    }
+}
+
+void GLState::onTextureDeleted(unsigned int id)
+{
+    for (unsigned int target = 0; target < TEXTURE_TARGET_COUNT; target++)
+    {
+        for (unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+        {
+            if (s_textures[target][unit] == id)
+                s_textures[target][unit] = 0;
+        }
+    }
+}
+
+void GLState::invalidate()
+{
+    s_program = UNKNOWN;
+    s_vertexArray = UNKNOWN;
+    for (unsigned int& buffer : s_buffers)
+        buffer = UNKNOWN;
+    s_elementBuffers.clear();
+    for (BufferRange& range : s_uniformRanges)
+        range = { UNKNOWN, 0, 0 };
+    s_activeTextureUnit = UNKNOWN;
+    s_blending = UNKNOWN;
+    s_depthTest = UNKNOWN;
+    s_depthWrite = UNKNOWN;
+    s_depthFunc = UNKNOWN;
+    s_colorWrite = UNKNOWN;
+    for (unsigned int target = 0; target < TEXTURE_TARGET_COUNT; target++)
+    {
+        for (unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+            s_textures[target][unit] = UNKNOWN;
+    }
+}
+
+void GLState::setActiveTextureUnit(unsigned int unit)
+{
+    if (s_activeTextureUnit == unit)
+        return;
+    GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+    s_activeTextureUnit = unit;
+}
+
+unsigned int& GLState::elementBufferOf(unsigned int vertexArray)
+{
+    if (vertexArray >= s_elementBuffers.size())
+        s_elementBuffers.resize(vertexArray + 1, UNKNOWN);
+    return s_elementBuffers[vertexArray];
+}
+
+void GLState::setCapability(GLenum capability, unsigned int& cached, bool enabled)
+{
+    if (cacheHit(cached, enabled))
+        return;
+    if (enabled)
+    {
+        GLCall(glEnable(capability));
+    }
+    else
+    {
+        GLCall(glDisable(capability));
+    }
+    cached = enabled;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <GL/glew.h>
+
+// Remembers what is bound on the current context so bind calls that would not change
+// anything skip the driver entirely. Every bind in the engine goes through here, as do the
+// blend, depth and color write switches the render passes flip; code that calls glBind* or
+// changes those directly must call invalidate() afterwards.
+class GLState
+{
+private:
+	static const unsigned int UNKNOWN = 0xFFFFFFFF;
+	static const unsigned int MAX_TEXTURE_UNITS = 32;
+	static const unsigned int BUFFER_TARGET_COUNT = 7;
+	static const unsigned int TEXTURE_TARGET_COUNT = 2;
+	static const unsigned int MAX_UNIFORM_BINDINGS = 16;
+
+	struct BufferRange
+	{
+		unsigned int id;
+		unsigned int offset;
+		unsigned int size;
+	};
+
+	static unsigned int s_program;
+	static unsigned int s_vertexArray;
+	static unsigned int s_buffers[BUFFER_TARGET_COUNT];
+	// The element array binding is vertex array state, so it is remembered per vertex array.
+	static std::vector<unsigned int> s_elementBuffers;
+	static unsigned int s_activeTextureUnit;
+	static unsigned int s_textures[TEXTURE_TARGET_COUNT][MAX_TEXTURE_UNITS];
+	static BufferRange s_uniformRanges[MAX_UNIFORM_BINDINGS];
+	static unsigned int s_blending;
+	static unsigned int s_depthTest;
+	static unsigned int s_depthWrite;
+	static unsigned int s_depthFunc;
+	static unsigned int s_colorWrite;
+public:
+	static void bindProgram(unsigned int id);
+	static void bindVertexArray(unsigned int id);
+	static void bindBuffer(GLenum target, unsigned int id);
+	static void bindBufferRange(GLenum target, unsigned int index, unsigned int id, unsigned int offset, unsigned int size);
+	static void bindTexture(GLenum target, unsigned int unit, unsigned int id);
+	// Binds to the active unit, for creating and editing textures without caring about the unit.
+	static void bindTexture(GLenum target, unsigned int id);
+
+	static void setBlending(bool enabled);
+	static void setDepthTest(bool enabled);
+	static void setDepthWrite(bool enabled);
+	static void setDepthFunc(GLenum func);
+	static void setColorWrite(bool enabled);
+
+	static void onProgramDeleted(unsigned int id);
+	static void onVertexArrayDeleted(unsigned int id);
+	static void onBufferDeleted(unsigned int id);
+	static void onTextureDeleted(unsigned int id);
+
+	static void invalidate();
+private:
+	static void setActiveTextureUnit(unsigned int unit);
+	static unsigned int& elementBufferOf(unsigned int vertexArray);
+	static void setCapability(GLenum capability, unsigned int& cached, bool enabled);
+};
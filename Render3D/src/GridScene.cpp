@@ -0,0 +1,157 @@
+#include "GridScene.h"
+#include "ShaderLibrary.h"
+#include "VertexBufferLayout.h"
+#include "Renderer.h"
+#include "FrameStats.h"
+#include "JobSystem.h"
+#include <glm/ext/matrix_transform.hpp>
+
+static constexpr Uniform<int> u_texture("u_texture");
+
+const float GridScene::FAR_PLANE = 100.0f;
+
+static const float tileVertices[] = {
+    -0.45f,  0.0f, -0.45f,  0.0f,  0.0f,
+     0.45f,  0.0f, -0.45f,  1.0f,  0.0f,
+     0.45f,  0.0f,  0.45f,  1.0f,  1.0f,
+    -0.45f,  0.0f,  0.45f,  0.0f,  1.0f,
+};
+
+static const float diamondVertices[] = {
+     0.0f,  0.0f, -0.5f,  0.5f,  0.0f,
+     0.5f,  0.0f,  0.0f,  1.0f,  0.5f,
+     0.0f,  0.0f,  0.5f,  0.5f,  1.0f,
+    -0.5f,  0.0f,  0.0f,  0.0f,  0.5f,
+};
+
+static const unsigned int tileIndices[] = {
+    0, 1, 2,
+    2, 3, 0,
+};
+
+GridScene::GridScene(bool sorted, bool packed)
+    : m_tileVB(tileVertices, sizeof(tileVertices)), m_tileIB(tileIndices, sizeof(tileIndices) / sizeof(unsigned int)),
+    m_diamondVB(diamondVertices, sizeof(diamondVertices)), m_diamondIB(tileIndices, sizeof(tileIndices) / sizeof(unsigned int)),
+    m_shader(ShaderLibrary::load("res/shaders/Simple.shader", packed ? static_cast<unsigned int>(SIMPLE_ATLAS) : 0u)),
+    m_uniformBuffer(sizeof(CameraBlock) + GRID_SIZE * GRID_SIZE * sizeof(ObjectBlock)),
+    m_tileBounds(Bounds::fromVertices(tileVertices, 4, 5 * sizeof(float))), m_diamondBounds(Bounds::fromVertices(diamondVertices, 4, 5 * sizeof(float))),
+    m_picked(BVH::INVALID), m_jobs(nullptr), m_time(0.0f)
+{
+    VertexBufferLayout layout;
+    layout.push<float>(3);
+    layout.push<float>(2);
+    m_tileVA.addBuffer(m_tileVB, layout);
+    m_tileVA.bind();
+    m_tileIB.bind();
+    m_diamondVA.addBuffer(m_diamondVB, layout);
+    m_diamondVA.bind();
+    m_diamondIB.bind();
+    m_diamondVA.unbind();
+
+    m_shader->bindUniformBlock(CameraBlock::getLayout());
+    m_shader->bindUniformBlock(ObjectBlock::getLayout());
+    m_shader->bind();
+    m_shader->setUniform(u_texture, 0);
+
+    m_queue.setSorting(sorted);
+
+    TextureAtlas::Region regions[2] = {};
+    if (packed)
+    {
+        unsigned int plain = m_atlas.add("res/textures/whiteTile.png"), pattern = m_atlas.add("res/textures/Tile.png");
+        m_atlas.build();
+        regions[0] = m_atlas.getRegion(plain);
+        regions[1] = m_atlas.getRegion(pattern);
+    }
+    else
+    {
+        m_texture.reset(new Texture("res/textures/whiteTile.png"));
+        m_patternTexture.reset(new Texture("res/textures/Tile.png"));
+    }
+
+    m_tiles.resize(GRID_SIZE * GRID_SIZE);
+    m_objectOffsets.resize(m_tiles.size());
+    m_tileBoxes.resize(m_tiles.size());
+    for (int z = 0; z < GRID_SIZE; z++)
+    {
+        for (int x = 0; x < GRID_SIZE; x++)
+        {
+            Tile& tile = m_tiles[z * GRID_SIZE + x];
+            tile.diamond = (x * 7 + z * 3) % 5 == 0;
+            tile.translucent = (x + z * 5) % 7 == 0;
+            bool pattern = (x / 2 + z) % 3 == 0;
+            if (packed)
+            {
+                tile.texture = regions[pattern].texture;
+                tile.object.u_texRect = regions[pattern].rect;
+                tile.object.u_texLayer = regions[pattern].layer;
+            }
+            else
+                tile.texture = pattern ? m_patternTexture.get() : m_texture.get();
+            tile.object.u_model = glm::translate(glm::mat4(1.0f), glm::vec3(x - GRID_SIZE / 2, 0.0f, z - GRID_SIZE / 2));
+            tile.object.u_color = (x + z) % 2 ? glm::vec4(0.9f, 0.9f, 0.9f, 1.0f) : glm::vec4(0.3f, 0.4f, 0.8f, 1.0f);
+            if (tile.translucent)
+                tile.object.u_color = glm::vec4(0.9f, 0.5f, 0.2f, 0.5f);
+            m_tileBoxes[z * GRID_SIZE + x] = (tile.diamond ? m_diamondBounds : m_tileBounds).transformed(tile.object.u_model).box;
+        }
+    }
+    m_bvh.build(m_tileBoxes);
+}
+
+void GridScene::onUpdate(float deltaTime)
+{
+    m_time += deltaTime;
+    // Bob the tiles so every object's block really changes each frame. Tiles move and transform
+    // their bounds independently, so that is split into jobs; the tree takes the boxes here.
+    auto moveTiles = [this](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            Tile& tile = m_tiles[i];
+            tile.object.u_model[3][1] = 0.25f * glm::sin(m_time * 2.0f + i * 0.1f);
+            m_tileBoxes[i] = (tile.diamond ? m_diamondBounds : m_tileBounds).transformed(tile.object.u_model).box;
+        }
+    };
+    if (m_jobs)
+        m_jobs->wait(m_jobs->parallelFor("move tiles", (unsigned int)m_tiles.size(), 0, moveTiles));
+    else
+        moveTiles(0, (unsigned int)m_tiles.size());
+    for (unsigned int i = 0; i < m_tiles.size(); i++)
+        m_bvh.update(i, m_tileBoxes[i]);
+    m_bvh.refit();
+}
+
+void GridScene::onRender(const Renderer& renderer, const Camera& camera)
+{
+    glm::mat4 viewProj = camera.proj * camera.view;
+    m_visible.clear();
+    m_bvh.queryFrustum(Frustum::fromMatrix(viewProj), m_visible);
+    FrameStats::add(Stat::ObjectsCulled, m_tiles.size() - m_visible.size());
+
+    // Highlight the tile under the center of the view.
+    glm::vec3 forward(-camera.view[0][2], -camera.view[1][2], -camera.view[2][2]);
+    m_picked = m_bvh.raycast(camera.position, forward, FAR_PLANE).object;
+
+    m_uniformBuffer.beginFrame();
+    unsigned int cameraOffset = m_uniformBuffer.push(CameraBlock{ viewProj, glm::vec4(camera.position, 1.0f) });
+    for (unsigned int i : m_visible)
+    {
+        ObjectBlock object = m_tiles[i].object;
+        if (i == m_picked)
+            object.u_color = glm::vec4(1.0f, 0.85f, 0.1f, object.u_color.a);
+        m_objectOffsets[i] = m_uniformBuffer.push(object);
+    }
+    m_uniformBuffer.upload();
+    m_uniformBuffer.bindBlock<CameraBlock>(cameraOffset);
+
+    m_queue.beginFrame(camera, FAR_PLANE);
+    for (unsigned int i : m_visible)
+    {
+        const Tile& tile = m_tiles[i];
+        const VertexArray& va = tile.diamond ? m_diamondVA : m_tileVA;
+        const IndexBuffer& ib = tile.diamond ? m_diamondIB : m_tileIB;
+        m_queue.submit(va, ib, *m_shader, *tile.texture, m_objectOffsets[i], glm::vec3(tile.object.u_model[3]), tile.translucent);
+    }
+    m_queue.execute(renderer, m_uniformBuffer);
+
+    m_uniformBuffer.endFrame();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include "Scene.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "TextureAtlas.h"
+#include "UniformBuffer.h"
+#include "RenderQueue.h"
+#include "BVH.h"
+
+// A field of separately drawn floor tiles, each with its own transform and color, for
+// measuring how the per-draw path scales with the number of objects. Tiles mix two meshes,
+// two textures and some translucency; the ones inside the view frustum go through a
+// RenderQueue, which can be told to keep submission order to show what sorting saves. A BVH
+// over the tiles is refit as they bob, culls them and picks the tile under the view center.
+// Packed, both images come from one TextureAtlas page and the ATLAS variant of Simple.shader,
+// so the tiles differ only in their blocks and no draw rebinds the texture.
+class GridScene : public Scene
+{
+private:
+	static const int GRID_SIZE = 64;
+	static const float FAR_PLANE;
+
+	struct Tile
+	{
+		ObjectBlock object;
+		bool diamond;
+		bool translucent;
+		const Texture* texture;
+	};
+
+	VertexArray m_tileVA;
+	VertexBuffer m_tileVB;
+	IndexBuffer m_tileIB;
+	VertexArray m_diamondVA;
+	VertexBuffer m_diamondVB;
+	IndexBuffer m_diamondIB;
+	std::shared_ptr<Shader> m_shader;
+	// Loaded only when not packed; the atlas holds both images otherwise.
+	std::unique_ptr<Texture> m_texture;
+	std::unique_ptr<Texture> m_patternTexture;
+	TextureAtlas m_atlas;
+	UniformBuffer m_uniformBuffer;
+	RenderQueue m_queue;
+	Bounds m_tileBounds;
+	Bounds m_diamondBounds;
+	BVH m_bvh;
+	std::vector<unsigned int> m_visible;
+	unsigned int m_picked;
+	std::vector<Tile> m_tiles;
+	std::vector<unsigned int> m_objectOffsets;
+	std::vector<AABB> m_tileBoxes;
+	JobSystem* m_jobs;
+	float m_time;
+public:
+	GridScene(bool sorted = true, bool packed = true);
+
+	void onUpdate(float deltaTime) override;
+	void onRender(const Renderer& renderer, const Camera& camera) override;
+	void setJobSystem(JobSystem* jobs) override { m_jobs = jobs; }
+};
@@ -0,0 +1,132 @@
+#include "HeadlessContext.h"
+#include <iostream>
+
+#ifdef _WIN32
+
+#include <GLFW/glfw3.h>
+
+HeadlessContext::HeadlessContext(int majorVersion, int minorVersion, bool debug) : m_display(nullptr), m_context(nullptr), m_valid(false)
+{
+    if (!glfwInit())
+        return;
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, majorVersion);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minorVersion);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, debug ? GLFW_TRUE : GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(1, 1, "Render 3D (headless)", NULL, NULL);
+    if (!window)
+    {
+        std::cout << "Failed to create hidden window for headless context!\n";
+        glfwTerminate();
+        return;
+    }
+
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    m_context = window;
+    m_valid = true;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    if (m_context)
+        glfwDestroyWindow((GLFWwindow*)m_context);
+    glfwTerminate();
+}
+
+#else
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <algorithm>
+#include <cstring>
+
+static EGLDisplay getSurfacelessDisplay()
+{
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions && strstr(extensions, "EGL_MESA_platform_surfaceless"))
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+            return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+HeadlessContext::HeadlessContext(int majorVersion, int minorVersion, bool debug) : m_display(nullptr), m_context(nullptr), m_valid(false)
+{
+    EGLDisplay display = getSurfacelessDisplay();
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+    {
+        std::cout << "Failed to initialize EGL display!\n";
+        return;
+    }
+    m_display = display;
+
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context"))
+    {
+        std::cout << "EGL_KHR_surfaceless_context is not supported!\n";
+        return;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cout << "Failed to bind the desktop OpenGL API!\n";
+        return;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint numConfigs = 0;
+    eglChooseConfig(display, configAttribs, &config, 1, &numConfigs);
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_DEBUG, debug ? EGL_TRUE : EGL_FALSE,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, numConfigs > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT && debug)
+    {
+        // EGL 1.4 drivers reject the debug attribute, so retry without it.
+        EGLint fallbackAttribs[sizeof(contextAttribs) / sizeof(EGLint)];
+        std::copy(contextAttribs, contextAttribs + 6, fallbackAttribs);
+        fallbackAttribs[6] = EGL_NONE;
+        context = eglCreateContext(display, numConfigs > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, fallbackAttribs);
+    }
+    if (context == EGL_NO_CONTEXT)
+    {
+        std::cout << "Failed to create EGL context (error 0x" << std::hex << eglGetError() << std::dec << ")!\n";
+        return;
+    }
+    m_context = context;
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    {
+        std::cout << "Failed to make EGL context current!\n";
+        return;
+    }
+
+    m_valid = true;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    if (!m_display)
+        return;
+    eglMakeCurrent((EGLDisplay)m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_context)
+        eglDestroyContext((EGLDisplay)m_display, (EGLContext)m_context);
+    eglTerminate((EGLDisplay)m_display);
+}
+
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+
+// Creates an OpenGL context that has no window attached to it. On Linux this uses an
+// EGL surfaceless context (Mesa llvmpipe works fine), so no display server or GPU is needed.
+// On Windows it falls back to a hidden GLFW window. Rendering must go to a Framebuffer.
+class HeadlessContext
+{
+private:
+	void* m_display;
+	void* m_context;
+	bool m_valid;
+public:
+	HeadlessContext(int majorVersion, int minorVersion, bool debug = false);
+	~HeadlessContext();
+
+	inline bool isValid() const { return m_valid; }
+};
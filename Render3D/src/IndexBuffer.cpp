@@ -1,26 +1,48 @@
 #include "IndexBuffer.h"
 #include "Renderer.h"
+#include "GLState.h"
+#include <cstring>
 
-IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) : m_count(count)
+IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count, GLenum usage) : m_count(count), m_indices(count)
 {
     ASSERT(sizeof(unsigned int) == sizeof(GLuint));
 
+    // Filled through the copy target: binding it as the element buffer here would silently
+    // attach it to whichever vertex array happens to be bound.
     GLCall(glGenBuffers(1, &m_rendererID));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_rendererID));
-    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, m_rendererID);
+    GLCall(glBufferData(GL_COPY_WRITE_BUFFER, count * sizeof(unsigned int), data, usage));
+    if (data)
+        memcpy(m_indices.data(), data, count * sizeof(unsigned int));
 }
 
 IndexBuffer::~IndexBuffer()
 {
     GLCall(glDeleteBuffers(1, &m_rendererID));
+    GLState::onBufferDeleted(m_rendererID);
 }
 
 void IndexBuffer::bind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_rendererID));
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_rendererID);
 }
 
 void IndexBuffer::unbind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void IndexBuffer::setData(const unsigned int* data, unsigned int first, unsigned int count)
+{
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_rendererID);
+    GLCall(glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, first * sizeof(unsigned int), count * sizeof(unsigned int), data));
+    memcpy(m_indices.data() + first, data, count * sizeof(unsigned int));
+}
+
+void IndexBuffer::copyFrom(const IndexBuffer& source, unsigned int count)
+{
+    GLState::bindBuffer(GL_COPY_READ_BUFFER, source.m_rendererID);
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, m_rendererID);
+    GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, count * sizeof(unsigned int)));
+    memcpy(m_indices.data(), source.m_indices.data(), count * sizeof(unsigned int));
 }
\ No newline at end of file
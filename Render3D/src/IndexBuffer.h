@@ -1,17 +1,30 @@
 #pragma once
 
+#include <vector>
+#include <GL/glew.h>
+
+// Keeps a CPU copy of its indices next to the GL buffer, for the software rasterizer.
 class IndexBuffer
 {
 private:
 	unsigned int m_rendererID;
 	unsigned int m_count;
+	std::vector<unsigned int> m_indices;
 public:
 	IndexBuffer() : m_rendererID(0), m_count(0) {}
-	IndexBuffer(const unsigned int* data, unsigned int count);
+	IndexBuffer(const unsigned int* data, unsigned int count, GLenum usage = GL_STATIC_DRAW);
 	~IndexBuffer();
 
 	void bind() const;
 	void unbind() const;
 
+	// Overwrites count indices starting at index first. The buffer is bound to the current vertex array.
+	void setData(const unsigned int* data, unsigned int first, unsigned int count);
+	// Copies the first count indices of source to the start of this buffer.
+	void copyFrom(const IndexBuffer& source, unsigned int count);
+
+	inline unsigned int getRendererId() const { return m_rendererID; }
+
 	inline unsigned int getCount() const { return m_count; }
+	inline const unsigned int* getIndices() const { return m_indices.data(); }
 };
\ No newline at end of file
@@ -0,0 +1,277 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <fstream>
+
+struct Job
+{
+    const char* name;
+    std::function<void()> work;
+    // Unfinished dependencies, plus one while schedule is still registering them.
+    std::atomic<unsigned int> pending;
+    std::atomic<bool> finished;
+    // Guards continuations against a dependency finishing while a job registers with it.
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Job>> continuations;
+};
+
+// The system a thread works for and its deque there. Threads that are not one of the system's
+// own use the main thread's deque.
+struct ThreadSlot
+{
+    const JobSystem* system;
+    unsigned int index;
+};
+static thread_local ThreadSlot t_slot = { nullptr, 0 };
+
+bool JobHandle::isFinished() const
+{
+    return !m_job || m_job->finished;
+}
+
+JobSystem::JobSystem(unsigned int threadCount)
+    : m_mainThread(std::this_thread::get_id()), m_epoch(Clock::now()), m_queued(0), m_sleeping(0), m_stopping(false), m_timelineEnabled(false)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < threadCount; i++)
+        m_workers.emplace_back(new Worker());
+    for (unsigned int i = 1; i < threadCount; i++)
+        m_threads.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads)
+        thread.join();
+}
+
+JobHandle JobSystem::schedule(const char* name, std::function<void()> work, const std::vector<JobHandle>& dependencies)
+{
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->name = name;
+    job->work = std::move(work);
+    job->pending = 1;
+    job->finished = false;
+    for (const JobHandle& dependency : dependencies)
+    {
+        Job* parent = dependency.getJob().get();
+        if (!parent)
+            continue;
+        std::lock_guard<std::mutex> lock(parent->mutex);
+        if (!parent->finished)
+        {
+            parent->continuations.push_back(job);
+            job->pending++;
+        }
+    }
+    if (--job->pending == 0)
+        push(job);
+    return JobHandle(job);
+}
+
+JobHandle JobSystem::parallelFor(const char* name, unsigned int count, unsigned int grain, std::function<void(unsigned int begin, unsigned int end)> work,
+    const std::vector<JobHandle>& dependencies)
+{
+    // A few ranges per thread, so threads that finish early have something left to steal.
+    if (grain == 0)
+        grain = std::max(1u, count / (getThreadCount() * 4));
+    if (count <= grain)
+        return schedule(name, [work, count]() { work(0, count); }, dependencies);
+
+    std::shared_ptr<std::function<void(unsigned int, unsigned int)>> shared = std::make_shared<std::function<void(unsigned int, unsigned int)>>(std::move(work));
+    std::vector<JobHandle> ranges;
+    ranges.reserve((count + grain - 1) / grain);
+    for (unsigned int begin = 0; begin < count; begin += grain)
+    {
+        unsigned int end = std::min(count, begin + grain);
+        ranges.push_back(schedule(name, [shared, begin, end]() { (*shared)(begin, end); }, dependencies));
+    }
+    return schedule(name, []() {}, ranges);
+}
+
+void JobSystem::wait(const JobHandle& job)
+{
+    unsigned int index = getThreadIndex();
+    bool mainThread = isMainThread();
+    while (!job.isFinished())
+    {
+        if (std::shared_ptr<Job> next = findJob(index))
+        {
+            execute(next, index);
+            continue;
+        }
+        if (mainThread)
+            runMainThreadJobs();
+        std::this_thread::yield();
+    }
+}
+
+void JobSystem::runOnMainThread(std::function<void()> work)
+{
+    std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+    m_mainThreadJobs.push_back(std::move(work));
+}
+
+void JobSystem::runMainThreadJobs()
+{
+    std::vector<std::function<void()>> jobs;
+    {
+        std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+        jobs.swap(m_mainThreadJobs);
+    }
+    for (std::function<void()>& work : jobs)
+    {
+        Clock::time_point start = Clock::now();
+        work();
+        if (m_timelineEnabled)
+        {
+            Worker& worker = *m_workers[0];
+            std::lock_guard<std::mutex> lock(worker.timelineMutex);
+            worker.timeline.push_back({ "main thread", 0, std::chrono::duration<double, std::micro>(start - m_epoch).count(),
+                std::chrono::duration<double, std::micro>(Clock::now() - start).count() });
+        }
+    }
+}
+
+void JobSystem::clearTimeline()
+{
+    for (std::unique_ptr<Worker>& worker : m_workers)
+    {
+        std::lock_guard<std::mutex> lock(worker->timelineMutex);
+        worker->timeline.clear();
+    }
+}
+
+std::vector<JobSystem::TimelineEvent> JobSystem::getTimeline()
+{
+    std::vector<TimelineEvent> events;
+    for (std::unique_ptr<Worker>& worker : m_workers)
+    {
+        std::lock_guard<std::mutex> lock(worker->timelineMutex);
+        events.insert(events.end(), worker->timeline.begin(), worker->timeline.end());
+    }
+    std::sort(events.begin(), events.end(), [](const TimelineEvent& a, const TimelineEvent& b) { return a.start < b.start; });
+    return events;
+}
+
+bool JobSystem::writeTimeline(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+        return false;
+    file << "{\"traceEvents\":[\n";
+    std::vector<TimelineEvent> events = getTimeline();
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const TimelineEvent& event = events[i];
+        file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+            << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}" << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    file << "]}\n";
+    return (bool)file;
+}
+
+bool JobSystem::isMainThread() const
+{
+    return std::this_thread::get_id() == m_mainThread;
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+    t_slot = { this, index };
+    while (true)
+    {
+        if (std::shared_ptr<Job> job = findJob(index))
+        {
+            execute(job, index);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        if (m_stopping)
+            return;
+        m_sleeping++;
+        m_wake.wait(lock, [this]() { return m_stopping || m_queued > 0; });
+        m_sleeping--;
+    }
+}
+
+void JobSystem::push(std::shared_ptr<Job> job)
+{
+    Worker& worker = *m_workers[getThreadIndex()];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_back(std::move(job));
+    }
+    // A thread that counted itself asleep after this increment sees it before it sleeps.
+    m_queued++;
+    if (m_sleeping > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wake.notify_one();
+    }
+}
+
+std::shared_ptr<Job> JobSystem::findJob(unsigned int index)
+{
+    std::shared_ptr<Job> job;
+    {
+        Worker& own = *m_workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+        }
+    }
+    for (unsigned int i = 1; !job && i < m_workers.size(); i++)
+    {
+        Worker& victim = *m_workers[(index + i) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+        }
+    }
+    if (job)
+        m_queued--;
+    return job;
+}
+
+void JobSystem::execute(const std::shared_ptr<Job>& job, unsigned int index)
+{
+    bool recording = m_timelineEnabled;
+    Clock::time_point start = recording ? Clock::now() : Clock::time_point();
+    job->work();
+    // Drop what the work captured before anyone waiting on the job can go on.
+    job->work = nullptr;
+    if (recording)
+    {
+        Worker& worker = *m_workers[index];
+        std::lock_guard<std::mutex> lock(worker.timelineMutex);
+        worker.timeline.push_back({ job->name, index, std::chrono::duration<double, std::micro>(start - m_epoch).count(),
+            std::chrono::duration<double, std::micro>(Clock::now() - start).count() });
+    }
+
+    std::vector<std::shared_ptr<Job>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->finished = true;
+        continuations.swap(job->continuations);
+    }
+    for (std::shared_ptr<Job>& continuation : continuations)
+    {
+        if (--continuation->pending == 0)
+            push(std::move(continuation));
+    }
+}
+
+unsigned int JobSystem::getThreadIndex() const
+{
+    return t_slot.system == this ? t_slot.index : 0;
+}
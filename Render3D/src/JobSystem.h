@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Job;
+
+// A scheduled job, to wait on or to make later jobs depend on. An empty handle counts as finished.
+class JobHandle
+{
+private:
+	std::shared_ptr<Job> m_job;
+public:
+	JobHandle() {}
+	JobHandle(std::shared_ptr<Job> job) : m_job(std::move(job)) {}
+
+	bool isFinished() const;
+	inline const std::shared_ptr<Job>& getJob() const { return m_job; }
+};
+
+// Runs frame work on a pool of threads. Every thread, the one that created the system
+// included, has its own deque of jobs: it pushes and pops the newest end, so a job's children
+// run while their data is still in cache, and idle threads steal the oldest job from another
+// thread's deque, which is usually the biggest piece of work left there. Threads with nothing
+// to run or steal sleep until a job is pushed.
+//
+// A job can depend on others; it is pushed once the last of them finishes, by the thread that
+// finished it. Waiting on a job runs other jobs meanwhile instead of blocking, so jobs may wait
+// on jobs they scheduled. GL calls have to stay on the thread that owns the context, so jobs
+// hand them to runOnMainThread and the main loop runs them with runMainThreadJobs.
+class JobSystem
+{
+public:
+	// One finished job on the timeline, in microseconds since the system started.
+	struct TimelineEvent
+	{
+		const char* name;
+		unsigned int thread;
+		double start;
+		double duration;
+	};
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<std::shared_ptr<Job>> jobs;
+		std::mutex timelineMutex;
+		std::vector<TimelineEvent> timeline;
+	};
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::vector<std::thread> m_threads;
+	std::thread::id m_mainThread;
+	Clock::time_point m_epoch;
+
+	// Jobs pushed and not yet taken, which is what sleeping threads wait for. Pushing only
+	// takes m_sleepMutex to wake a thread when one is asleep.
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::atomic<unsigned int> m_queued;
+	std::atomic<unsigned int> m_sleeping;
+	bool m_stopping;
+
+	std::mutex m_mainThreadMutex;
+	std::vector<std::function<void()>> m_mainThreadJobs;
+
+	std::atomic<bool> m_timelineEnabled;
+public:
+	// Runs jobs on threadCount threads, the calling one included (0 for one per core).
+	JobSystem(unsigned int threadCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Runs work once every dependency has finished. The name labels it on the timeline and
+	// must outlive the system, a string literal in practice.
+	JobHandle schedule(const char* name, std::function<void()> work, const std::vector<JobHandle>& dependencies = {});
+	// Runs work over [0, count) in ranges of up to grain items (0 to split into a few ranges
+	// per thread), each range a job. The returned job finishes after the last range.
+	JobHandle parallelFor(const char* name, unsigned int count, unsigned int grain, std::function<void(unsigned int begin, unsigned int end)> work,
+		const std::vector<JobHandle>& dependencies = {});
+	// Returns once the job has finished, running other jobs until then, and on the main
+	// thread the main-thread jobs too.
+	void wait(const JobHandle& job);
+
+	// Queues work for the next runMainThreadJobs; safe from any thread.
+	void runOnMainThread(std::function<void()> work);
+	// Runs the queued main-thread jobs. Call it from the main thread once a frame.
+	void runMainThreadJobs();
+
+	// Records every job run while enabled. clearTimeline starts a new frame's record.
+	inline void setTimelineEnabled(bool enabled) { m_timelineEnabled = enabled; }
+	void clearTimeline();
+	std::vector<TimelineEvent> getTimeline();
+	// Writes the timeline in the Chrome trace event format, for chrome://tracing or Perfetto.
+	bool writeTimeline(const std::string& path);
+
+	inline unsigned int getThreadCount() const { return (unsigned int)m_workers.size(); }
+	bool isMainThread() const;
+private:
+	void workerLoop(unsigned int index);
+	void push(std::shared_ptr<Job> job);
+	std::shared_ptr<Job> findJob(unsigned int index);
+	void execute(const std::shared_ptr<Job>& job, unsigned int index);
+	unsigned int getThreadIndex() const;
+};
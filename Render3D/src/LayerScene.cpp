@@ -0,0 +1,79 @@
+#include "LayerScene.h"
+#include "ShaderLibrary.h"
+#include "VertexBufferLayout.h"
+#include "Renderer.h"
+#include <glm/ext/matrix_transform.hpp>
+
+static constexpr Uniform<int> u_texture("u_texture");
+
+const float LayerScene::FAR_PLANE = 100.0f;
+
+static const float wallVertices[] = {
+    -8.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+     8.0f, -1.0f,  0.0f,  4.0f,  0.0f,
+     8.0f,  9.0f,  0.0f,  4.0f,  2.5f,
+    -8.0f,  9.0f,  0.0f,  0.0f,  2.5f,
+};
+
+static const unsigned int wallIndices[] = {
+    0, 1, 2,
+    2, 3, 0,
+};
+
+LayerScene::LayerScene(bool sorted)
+    : m_wallVB(wallVertices, sizeof(wallVertices)), m_wallIB(wallIndices, sizeof(wallIndices) / sizeof(unsigned int)),
+    m_shader(ShaderLibrary::load("res/shaders/Simple.shader")), m_texture("res/textures/whiteTile.png"), m_patternTexture("res/textures/Tile.png"),
+    m_uniformBuffer(sizeof(CameraBlock) + LAYER_COUNT * sizeof(ObjectBlock))
+{
+    VertexBufferLayout layout;
+    layout.push<float>(3);
+    layout.push<float>(2);
+    m_wallVA.addBuffer(m_wallVB, layout);
+    m_wallVA.bind();
+    m_wallIB.bind();
+    m_wallVA.unbind();
+
+    m_shader->bindUniformBlock(CameraBlock::getLayout());
+    m_shader->bindUniformBlock(ObjectBlock::getLayout());
+    m_shader->bind();
+    m_shader->setUniform(u_texture, 0);
+
+    m_queue.setSorting(sorted);
+
+    // Farthest first, alternating textures so sorting by state alone would not give depth order.
+    m_layers.resize(LAYER_COUNT);
+    m_objectOffsets.resize(LAYER_COUNT);
+    for (int i = 0; i < LAYER_COUNT; i++)
+    {
+        Layer& layer = m_layers[i];
+        float depth = 2.0f + (LAYER_COUNT - i) * 0.5f;
+        float offset = ((i * 37) % 11 - 5) * 0.6f;
+        float shade = 0.4f + 0.6f * i / LAYER_COUNT;
+        layer.object.u_model = glm::translate(glm::mat4(1.0f), glm::vec3(offset, 0.0f, depth));
+        layer.object.u_color = glm::vec4(shade, shade * 0.8f, 1.0f - shade * 0.5f, 1.0f);
+        layer.texture = i % 2 ? &m_patternTexture : &m_texture;
+        layer.translucent = i % 16 == 15;
+        if (layer.translucent)
+            layer.object.u_color.a = 0.4f;
+    }
+}
+
+void LayerScene::onRender(const Renderer& renderer, const Camera& camera)
+{
+    m_uniformBuffer.beginFrame();
+    unsigned int cameraOffset = m_uniformBuffer.push(CameraBlock{ camera.proj * camera.view, glm::vec4(camera.position, 1.0f) });
+    for (size_t i = 0; i < m_layers.size(); i++)
+        m_objectOffsets[i] = m_uniformBuffer.push(m_layers[i].object);
+    m_uniformBuffer.upload();
+    m_uniformBuffer.bindBlock<CameraBlock>(cameraOffset);
+
+    m_queue.beginFrame(camera, FAR_PLANE);
+    for (size_t i = 0; i < m_layers.size(); i++)
+    {
+        const Layer& layer = m_layers[i];
+        m_queue.submit(m_wallVA, m_wallIB, *m_shader, *layer.texture, m_objectOffsets[i], glm::vec3(layer.object.u_model[3]), layer.translucent);
+    }
+    m_queue.execute(renderer, m_uniformBuffer);
+
+    m_uniformBuffer.endFrame();
+}
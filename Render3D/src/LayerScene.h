@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include "Scene.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "UniformBuffer.h"
+#include "RenderQueue.h"
+
+// Dozens of overlapping walls in front of the camera, submitted back to front like a painter
+// would. Nearly every pixel is covered many times over, which makes it the scene for
+// measuring depth testing, queue sorting and the depth prepass with the overdraw view.
+class LayerScene : public Scene
+{
+private:
+	static const int LAYER_COUNT = 64;
+	static const float FAR_PLANE;
+
+	struct Layer
+	{
+		ObjectBlock object;
+		const Texture* texture;
+		bool translucent;
+	};
+
+	VertexArray m_wallVA;
+	VertexBuffer m_wallVB;
+	IndexBuffer m_wallIB;
+	std::shared_ptr<Shader> m_shader;
+	Texture m_texture;
+	Texture m_patternTexture;
+	UniformBuffer m_uniformBuffer;
+	RenderQueue m_queue;
+	std::vector<Layer> m_layers;
+	std::vector<unsigned int> m_objectOffsets;
+public:
+	LayerScene(bool sorted = true);
+
+	void onRender(const Renderer& renderer, const Camera& camera) override;
+};
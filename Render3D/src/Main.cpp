@@ -1,12 +1,28 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
-#include "VertexArray.h"
-#include "VertexBuffer.h"
-#include "VertexBufferLayout.h"
-#include "IndexBuffer.h"
-#include "Texture.h"
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <chrono>
 #include "Renderer.h"
+#include "Scene.h"
+#include "HeadlessContext.h"
+#include "Framebuffer.h"
+#include "FrameTimer.h"
+#include "FrameStats.h"
+#include "Benchmark.h"
+#include "OverdrawView.h"
+#include "SoftwareRasterizer.h"
+#include "JobSystem.h"
+#include "Texture.h"
+#include "CompressedImage.h"
+#include "ProgramCache.h"
+#include "MeshCache.h"
+#include "ShaderLibrary.h"
+#include "ResourcePack.h"
+#include "stb_image/stb_image.h"
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
@@ -17,14 +33,225 @@ glm::vec3 camVel(0.0f, 0.0f, 0.0f);
 glm::vec2 camRotVel(0.0f, 0.0f);
 glm::vec2 camFacing(0.0f, 0.0f);
 
-int main(void)
+const int WIDTH = 800;
+const int HEIGHT = 600;
+const float FOV = 120.0f;
+const float Z_NEAR = 1.0f;
+const float Z_FAR = 1000.0f;
+
+struct LaunchOptions
+{
+    GLErrorPolicy glErrors = GL_CHECKS ? GLErrorPolicy::DebugOutput : GLErrorPolicy::None;
+    unsigned int glErrorSampleInterval = 60;
+    bool headless = false;
+    bool finish = false;
+    bool depthPrepass = false;
+    bool overdraw = false;
+    bool software = false;
+    unsigned int frames = 1000;
+    unsigned int jobThreads = 0;
+    int width = WIDTH;
+    int height = HEIGHT;
+    std::string scene = "room";
+    std::string benchmark;
+    std::string image;
+    std::string reference;
+    std::string timeline;
+    std::string shaderCache = ProgramCache::getDirectory();
+    std::string meshCache = MeshCache::getDirectory();
+    std::string pack = "res.pack";
+    std::string buildPack;
+    Texture::Options textures = Texture::getDefaultOptions();
+    bool compress = false;
+    BlockFormat compressFormat = BlockFormat::BC7;
+    std::vector<std::string> compressFiles;
+};
+
+bool parseOptions(int argc, char** argv, LaunchOptions* options);
+int runWindowed(const LaunchOptions& options);
+int runHeadless(const LaunchOptions& options);
+int runBenchmark(const LaunchOptions& options);
+int runCompress(const LaunchOptions& options);
+int runBuildPack(const LaunchOptions& options);
+
+int main(int argc, char** argv)
+{
+    LaunchOptions options;
+    if (!parseOptions(argc, argv, &options))
+        return -1;
+    Texture::setDefaultOptions(options.textures);
+    ProgramCache::setDirectory(options.shaderCache);
+    MeshCache::setDirectory(options.meshCache);
+
+    if (options.compress)
+        return runCompress(options);
+    if (!options.buildPack.empty())
+        return runBuildPack(options);
+    if (options.pack != "off")
+    {
+        if (ResourcePack::mount(options.pack))
+            std::cout << "Resource pack: " << options.pack << ", " << ResourcePack::getMounted()->getEntryCount() << " entries mapped\n";
+        else
+            std::cout << "Resource pack: " << options.pack << " not found, loading loose files\n";
+    }
+    if (!options.benchmark.empty())
+        return runBenchmark(options);
+    if (options.headless)
+        return runHeadless(options);
+    return runWindowed(options);
+}
+
+bool parseErrorPolicy(const char* name, GLErrorPolicy* policy)
+{
+    const GLErrorPolicy policies[] = { GLErrorPolicy::None, GLErrorPolicy::Always, GLErrorPolicy::Sampled, GLErrorPolicy::DebugOutput };
+    const char* names[] = { "none", "always", "sampled", "debug" };
+    for (int i = 0; i < 4; i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *policy = policies[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseMips(const char* name, Texture::Mips* mips)
+{
+    const Texture::Mips modes[] = { Texture::Mips::None, Texture::Mips::Driver, Texture::Mips::Box, Texture::Mips::Kaiser };
+    const char* names[] = { "none", "driver", "box", "kaiser" };
+    for (int i = 0; i < 4; i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *mips = modes[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseBlockFormat(const char* name, BlockFormat* format)
+{
+    const BlockFormat formats[] = { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC7 };
+    const char* names[] = { "bc1", "bc3", "bc7" };
+    for (int i = 0; i < 3; i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *format = formats[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseOptions(int argc, char** argv, LaunchOptions* options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--headless") == 0)
+            options->headless = true;
+        else if (strcmp(arg, "--finish") == 0)
+            options->finish = true;
+        else if (strcmp(arg, "--depth-prepass") == 0)
+            options->depthPrepass = true;
+        else if (strcmp(arg, "--overdraw") == 0)
+            options->overdraw = true;
+        else if (strcmp(arg, "--software") == 0)
+            options->software = options->headless = true;
+        else if (strcmp(arg, "--frames") == 0 && hasValue)
+            options->frames = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--width") == 0 && hasValue)
+            options->width = std::atoi(argv[++i]);
+        else if (strcmp(arg, "--height") == 0 && hasValue)
+            options->height = std::atoi(argv[++i]);
+        else if (strcmp(arg, "--scene") == 0 && hasValue)
+            options->scene = argv[++i];
+        else if (strcmp(arg, "--bench") == 0 && hasValue)
+            options->benchmark = argv[++i];
+        else if (strcmp(arg, "--jobs") == 0 && hasValue)
+            options->jobThreads = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--timeline") == 0 && hasValue)
+            options->timeline = argv[++i];
+        else if (strcmp(arg, "--shader-cache") == 0 && hasValue)
+        {
+            options->shaderCache = argv[++i];
+            if (options->shaderCache == "off")
+                options->shaderCache.clear();
+        }
+        else if (strcmp(arg, "--mesh-cache") == 0 && hasValue)
+        {
+            options->meshCache = argv[++i];
+            if (options->meshCache == "off")
+                options->meshCache.clear();
+        }
+        else if (strcmp(arg, "--pack") == 0 && hasValue)
+            options->pack = argv[++i];
+        else if (strcmp(arg, "--build-pack") == 0 && hasValue)
+            options->buildPack = argv[++i];
+        else if (strcmp(arg, "--image") == 0 && hasValue)
+            options->image = argv[++i];
+        else if (strcmp(arg, "--reference") == 0 && hasValue)
+            options->reference = argv[++i];
+        else if (strcmp(arg, "--mips") == 0 && hasValue && parseMips(argv[i + 1], &options->textures.mips))
+            i++;
+        else if (strcmp(arg, "--anisotropy") == 0 && hasValue)
+            options->textures.anisotropy = (float)std::atof(argv[++i]);
+        else if (strcmp(arg, "--compress") == 0 && i + 2 < argc && parseBlockFormat(argv[i + 1], &options->compressFormat))
+        {
+            options->compress = true;
+            options->compressFiles.assign(argv + i + 2, argv + argc);
+            break;
+        }
+        else if (strcmp(arg, "--gl-errors") == 0 && hasValue && parseErrorPolicy(argv[i + 1], &options->glErrors))
+            i++;
+        else if (strcmp(arg, "--gl-sample-interval") == 0 && hasValue)
+            options->glErrorSampleInterval = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        else
+        {
+            std::cout << "Usage: Render3D [--headless] [--frames N] [--width W] [--height H] [--scene NAME] [--finish]\n"
+                "                [--depth-prepass] [--overdraw] [--software] [--image FILE] [--reference FILE]\n"
+                "                [--jobs N] [--timeline FILE] [--mips none|driver|box|kaiser] [--anisotropy N] [--shader-cache DIR|off]\n"
+                "                [--mesh-cache DIR|off] [--pack FILE|off]\n"
+                "                [--gl-errors none|always|sampled|debug] [--gl-sample-interval N] [--bench NAME|list]\n"
+                "       Render3D [--mips none|box|kaiser] --compress bc1|bc3|bc7 IMAGE...\n"
+                "       Render3D --build-pack FILE\n"
+                "  --headless  render offscreen without a window or vsync and print frame timings\n"
+                "  --frames    number of frames to render in headless mode (default 1000)\n"
+                "  --finish    call glFinish after every headless frame so timings include GPU work\n"
+                "  --bench     run a micro-benchmark in a headless context, 'list' shows them all\n"
+                "  --depth-prepass  lay down depth before shading opaque draws that go through the render queue\n"
+                "  --overdraw  show a heatmap of shaded fragments per pixel and report the average\n"
+                "  --software  rasterize on the CPU instead of the GPU; implies --headless\n"
+                "  --image     write the last headless frame to a binary PPM file\n"
+                "  --reference compare the last headless frame with a PPM written by --image and fail if any pixel differs\n"
+                "  --jobs      threads the job system runs frame work on, the main one included (default one per core)\n"
+                "  --timeline  write the jobs of the last headless frame as a Chrome trace (chrome://tracing, Perfetto)\n"
+                "  --mips      how textures get their mip levels: none, by the driver, or on the CPU with a box or Kaiser filter (default box)\n"
+                "  --anisotropy  most samples anisotropic filtering takes, 1 to turn it off (default 1)\n"
+                "  --shader-cache  directory that keeps linked shader programs between runs, or 'off' (default shadercache)\n"
+                "  --mesh-cache  directory that keeps imported meshes as mappable binary files, or 'off' (default meshcache)\n"
+                "  --pack      resource pack to map at startup, falling back to loose files under res/ (default res.pack)\n"
+                "  --build-pack  pack every file under res/ into FILE\n"
+                "  --compress  write each image and its mips, made as --mips says, block-compressed to a .dds file beside it\n"
+                "  --gl-errors how GLCall finds errors; 'sampled' polls every Nth frame (default 60),\n"
+                "              'debug' uses the driver's debug output callback (has no effect when built with GL_CHECKS=0)\n"
+                "  --scene     scene to render, one of:";
+            for (const std::string& name : Scene::getNames())
+                std::cout << " " << name;
+            std::cout << "\n";
+            return false;
+        }
+    }
+    return options->width > 0 && options->height > 0;
+}
+
+int runWindowed(const LaunchOptions& options)
 {
-    const int WIDTH = 800;
-    const int HEIGHT = 600;
-    const float FOV = 120.0f;
-    const float Z_NEAR = 1.0f;
-    const float Z_FAR = 1000.0f;
-    const float ASPECT_RATIO = (float)WIDTH / HEIGHT;
+    const float ASPECT_RATIO = (float)options.width / options.height;
 
     GLFWwindow* window;
 
@@ -34,8 +261,9 @@ int main(void)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, options.glErrors == GLErrorPolicy::DebugOutput ? GLFW_TRUE : GLFW_FALSE);
 
-    window = glfwCreateWindow(WIDTH, HEIGHT, "Render 3D", NULL, NULL);
+    window = glfwCreateWindow(options.width, options.height, "Render 3D", NULL, NULL);
     if (!window)
     {
         glfwTerminate();
@@ -51,83 +279,31 @@ int main(void)
 
     std::cout << glGetString(GL_VERSION) << "\n\n";
 
+    GLDebug::init(options.glErrors, options.glErrorSampleInterval);
+
     std::cout << "Welcome to Render3D, A Developmental Home-Made 3D Rendering Engine Using OpenGL\n";
     std::cout << " [Controls]:\n   W\t  - FORWARD\n   A\t  - LEFT\n   S\t  - BACKWARDS\n   D\t  - RIGHT\n   SPACE  - UP\n   LSHIFT - DOWN\n"
         "   Q\t  - TURN LEFT\n   E\t  - TURN RIGHT\n   R\t  - LOOK UP\n   F\t  - LOOK DOWN\n";
 
-    GLCall(glEnable(GL_BLEND));
-    GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
-
-    {
-        float wallVertices[] = {
-            -25.0f,  0.0f,  25.0f, -5.0f, -3.0f,
-             25.0f,  0.0f,  25.0f,  5.0f, -3.0f,
-             25.0f, 15.0f,  25.0f,  5.0f,  3.0f,
-            -25.0f, 15.0f,  25.0f, -5.0f,  3.0f,
-             25.0f,  0.0f, -25.0f, -5.0f, -3.0f,
-            -25.0f,  0.0f, -25.0f,  5.0f, -3.0f,
-            -25.0f, 15.0f, -25.0f,  5.0f,  3.0f,
-             25.0f, 15.0f, -25.0f, -5.0f,  3.0f,
-        };
-
-        unsigned int wallIndices[] = {
-             1,  4,  7,
-             7,  2,  1,
-             5,  0,  3,
-             3,  6,  5,
-             0,  1,  2,
-             2,  3,  0,
-             4,  5,  6,
-             6,  7,  4,
-        };
-
-        float floorVertices[] = {
-            -25.0f,  0.0f, -25.0f, -5.0f, -5.0f,
-             25.0f,  0.0f, -25.0f,  5.0f, -5.0f,
-             25.0f,  0.0f,  25.0f,  5.0f,  5.0f,
-            -25.0f,  0.0f,  25.0f, -5.0f,  5.0f,
-        };
-
-        unsigned int floorIndices[] = {
-            0, 1, 2,
-            2, 3, 0,
-        };
-
-        VertexBufferLayout layout;
-        layout.push<float>(3);
-        layout.push<float>(2);
-
-        VertexArray wallVA;
-        VertexBuffer wallVB(wallVertices, sizeof(wallVertices));
-        wallVA.addBuffer(wallVB, layout);
-        IndexBuffer wallIB(wallIndices, sizeof(wallIndices) / sizeof(unsigned int));
-        
-        VertexArray floorVA;
-        VertexBuffer floorVB(floorVertices, sizeof(floorVertices));
-        floorVA.addBuffer(floorVB, layout);
-        IndexBuffer floorIB(floorIndices, sizeof(floorIndices) / sizeof(unsigned int));
-        
-        glm::mat4 model = glm::rotate(glm::mat4(1.0f), glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        glm::mat4 proj = glm::perspective(glm::radians(FOV / 2), ASPECT_RATIO, Z_NEAR, Z_FAR);
-
-        Shader shader("res/shaders/Simple.shader");
-        shader.bind();
-
-        Texture wallTexture("res/textures/Tile.png");
-        wallTexture.bind(0);
-
-        wallVA.unbind();
-        floorVA.unbind();
-        shader.unbind();
-        wallVB.unbind();
-        wallIB.unbind();
-        floorVB.unbind();
-        floorIB.unbind();
-        
+    {
+        JobSystem jobs(options.jobThreads);
+        std::unique_ptr<Scene> scene = Scene::create(options.scene);
+        if (!scene)
+        {
+            std::cout << "Unknown scene '" << options.scene << "'!\n";
+            glfwTerminate();
+            return -1;
+        }
+        scene->setJobSystem(&jobs);
+
         Renderer renderer;
+        renderer.setDepthPrepass(options.depthPrepass);
+        std::unique_ptr<OverdrawView> overdraw;
+        if (options.overdraw)
+            overdraw.reset(new OverdrawView(options.width, options.height));
 
-        float gi = 0.5;
-        float inc = 0.01;
+        Camera camera;
+        camera.proj = glm::perspective(glm::radians(FOV / 2), ASPECT_RATIO, Z_NEAR, Z_FAR);
 
         glm::vec3 camPos( 0.0f,  4.0f,  -5.0f);
         glm::vec3 centeredPoint( 0.0f,  0.0f,  0.0f);
@@ -135,28 +311,35 @@ int main(void)
 
         glfwSetKeyCallback(window, keyCallback);
 
+        // The scene's programs finish compiling while the first frames run without them.
+        bool programsReady = false;
+        double lastTime = glfwGetTime();
         while (!glfwWindowShouldClose(window))
         {
-            renderer.clear();
-
-            glm::mat4 view = glm::lookAt(camPos, centeredPoint, upVect);
-            glm::mat4 mvp = proj * view * model;
-
-            shader.bind();
-            shader.setUniform4f("u_color", 1.0f * gi, 1.0f * gi, 1.0f * gi, 1.0f);
-            shader.setUniformMat4f("u_mvp", mvp);
-            shader.setUniform1i("u_texture", 0);
-            renderer.draw(floorVA, floorIB, shader);
+            double time = glfwGetTime();
+            if (!programsReady && ShaderLibrary::update() == 0)
+            {
+                ShaderLibrary::printReport(std::cout);
+                ProgramCache::printReport(std::cout);
+                ResourcePack::printReport(std::cout);
+                MeshCache::printReport(std::cout);
+                programsReady = true;
+            }
+            jobs.runMainThreadJobs();
+            scene->onUpdate((float)(time - lastTime));
+            lastTime = time;
 
-            shader.bind();
-            shader.setUniform4f("u_color", 1.0f * gi, 1.0f * gi, 1.0f * gi, 1.0f);
-            shader.setUniformMat4f("u_mvp", mvp);
-            shader.setUniform1i("u_texture", 0);
-            renderer.draw(wallVA, wallIB, shader);
+            renderer.beginFrame();
+            renderer.clear();
 
-            if (gi > 0.9 || gi < 0.5)
-                inc *= -1;
-            gi += inc;
+            camera.view = glm::lookAt(camPos, centeredPoint, upVect);
+            camera.position = camPos;
+            if (overdraw)
+                overdraw->begin();
+            scene->onRender(renderer, camera);
+            if (overdraw)
+                overdraw->end();
+            renderer.endFrame();
 
             glfwSwapBuffers(window);
 
@@ -165,7 +348,7 @@ int main(void)
             camPos += camVel;
             camFacing = camFacing + camRotVel;
             camFacing[0] = fmod(camFacing[0], 360.0f);
-            camFacing[0] = abs(camFacing[0]) > 180.0f ? camFacing[0] - 360.0f * abs(camFacing[0]) / camFacing[0] : camFacing[0];
+            camFacing[0] = std::abs(camFacing[0]) > 180.0f ? camFacing[0] - 360.0f * std::abs(camFacing[0]) / camFacing[0] : camFacing[0];
             camFacing[1] = std::fmaxf(-90.0f, std::fminf(90.0, camFacing[1]));
             centeredPoint = camPos + glm::vec3(-glm::sin(glm::radians(camFacing[0])), glm::sin(glm::radians(camFacing[1])), glm::cos(glm::radians(camFacing[0])));
         }
@@ -175,6 +358,271 @@ int main(void)
     return 0;
 }
 
+// Writes RGBA pixels with the bottom row first, as glReadPixels returns them, as a binary PPM.
+bool writeImage(const std::string& path, int width, int height, const unsigned char* pixels)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    file << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<char> row(width * 3);
+    for (int y = height - 1; y >= 0; y--)
+    {
+        const unsigned char* source = pixels + (size_t)y * width * 4;
+        for (int x = 0; x < width; x++)
+        {
+            row[x * 3] = source[x * 4];
+            row[x * 3 + 1] = source[x * 4 + 1];
+            row[x * 3 + 2] = source[x * 4 + 2];
+        }
+        file.write(row.data(), row.size());
+    }
+    return (bool)file;
+}
+
+// Counts the pixels whose RGB differs from a PPM written by writeImage, or returns -1 when the
+// file cannot be read or has another size.
+long long compareImage(const std::string& path, int width, int height, const unsigned char* pixels)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    int fileWidth = 0, fileHeight = 0, maxValue = 0;
+    file >> magic >> fileWidth >> fileHeight >> maxValue;
+    file.get();
+    if (!file || magic != "P6" || fileWidth != width || fileHeight != height || maxValue != 255)
+        return -1;
+
+    std::vector<char> row(width * 3);
+    long long different = 0;
+    for (int y = height - 1; y >= 0 && file.read(row.data(), row.size()); y--)
+    {
+        const unsigned char* source = pixels + (size_t)y * width * 4;
+        for (int x = 0; x < width; x++)
+        {
+            different += (unsigned char)row[x * 3] != source[x * 4] || (unsigned char)row[x * 3 + 1] != source[x * 4 + 1]
+                || (unsigned char)row[x * 3 + 2] != source[x * 4 + 2];
+        }
+    }
+    return file ? different : -1;
+}
+
+bool initHeadlessGL(const LaunchOptions& options)
+{
+    // Without a GLX display GLEW reports an error after it has already loaded the core and
+    // extension entry points, which is all we need when rendering through EGL.
+    GLenum glewStatus = glewInit();
+    if (glewStatus != GLEW_OK && glewStatus != GLEW_ERROR_NO_GLX_DISPLAY)
+    {
+        std::cout << "Error: " << glewGetErrorString(glewStatus) << "\n";
+        return false;
+    }
+
+    std::cout << glGetString(GL_VERSION) << " (" << glGetString(GL_RENDERER) << ")\n";
+    GLErrorPolicy errorPolicy = GLDebug::init(options.glErrors, options.glErrorSampleInterval);
+    std::cout << "GL error checks: " << (GL_CHECKS ? GLDebug::getPolicyName(errorPolicy) : "compiled out") << "\n";
+    return true;
+}
+
+int runBenchmark(const LaunchOptions& options)
+{
+    if (options.benchmark == "list")
+    {
+        Benchmark::list(std::cout);
+        return 0;
+    }
+
+    HeadlessContext context(3, 3, options.glErrors == GLErrorPolicy::DebugOutput);
+    if (!context.isValid() || !initHeadlessGL(options))
+        return -1;
+    std::cout << "\n";
+
+    return Benchmark::run(options.benchmark);
+}
+
+int runCompress(const LaunchOptions& options)
+{
+    // Same orientation and mips as Texture gives the PNG, so the .dds can stand in for it.
+    // Driver mips are made with the box filter, since the file has to carry every level.
+    stbi_set_flip_vertically_on_load(1);
+    int failed = 0;
+    for (const std::string& path : options.compressFiles)
+    {
+        int width, height, bpp;
+        unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &bpp, 4);
+        if (!pixels)
+        {
+            std::cout << "Could not read '" << path << "'!\n";
+            failed++;
+            continue;
+        }
+        MipChain mips(width, height, pixels);
+        stbi_image_free(pixels);
+        if (options.textures.mips != Texture::Mips::None)
+            mips.generate(options.textures.mips == Texture::Mips::Kaiser ? MipChain::Filter::Kaiser : MipChain::Filter::Box, options.textures.srgb, options.textures.repeat);
+
+        auto start = std::chrono::steady_clock::now();
+        CompressedImage image(mips, options.compressFormat);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::string output = path.substr(0, path.find_last_of('.')) + ".dds";
+        if (!image.writeDDS(output))
+        {
+            std::cout << "Could not write '" << output << "'!\n";
+            failed++;
+            continue;
+        }
+        std::cout << output << ": " << width << "x" << height << ", " << mips.getLevelCount() << (mips.getLevelCount() == 1 ? " level, " : " levels, ")
+            << mips.getData().size() / 1024 << " KB as RGBA8, " << image.getSize() / 1024 << " KB as " << BlockCompression::getName(options.compressFormat)
+            << ", encoded in " << milliseconds << " ms\n";
+    }
+    return failed ? -1 : 0;
+}
+
+int runBuildPack(const LaunchOptions& options)
+{
+    if (!ResourcePack::build("res", options.buildPack, std::cout))
+        return -1;
+    ResourcePack pack(options.buildPack);
+    if (!pack.isValid() || !pack.verify())
+    {
+        std::cout << "'" << options.buildPack << "' does not read back as it was written!\n";
+        return -1;
+    }
+    return 0;
+}
+
+int runHeadless(const LaunchOptions& options)
+{
+    HeadlessContext context(3, 3, options.glErrors == GLErrorPolicy::DebugOutput);
+    if (!context.isValid() || !initHeadlessGL(options))
+        return -1;
+
+    std::cout << "Headless: scene '" << options.scene << "', " << options.width << "x" << options.height << ", " << options.frames << " frames\n\n";
+
+    {
+        Framebuffer framebuffer(options.width, options.height);
+        if (!framebuffer.isComplete())
+        {
+            std::cout << "Offscreen framebuffer is incomplete!\n";
+            return -1;
+        }
+        framebuffer.bind();
+
+        JobSystem jobs(options.jobThreads);
+        std::unique_ptr<Scene> scene = Scene::create(options.scene);
+        if (!scene)
+        {
+            std::cout << "Unknown scene '" << options.scene << "'!\n";
+            return -1;
+        }
+        scene->setJobSystem(&jobs);
+        // Every frame is measured and compared, so none may skip draws.
+        ShaderLibrary::finish();
+        ShaderLibrary::printReport(std::cout);
+        ProgramCache::printReport(std::cout);
+        ResourcePack::printReport(std::cout);
+        MeshCache::printReport(std::cout);
+        std::cout << "Job system: " << jobs.getThreadCount() << (jobs.getThreadCount() == 1 ? " thread" : " threads") << "\n\n";
+
+        Renderer renderer;
+        renderer.setDepthPrepass(options.depthPrepass);
+        std::unique_ptr<SoftwareRasterizer> software;
+        if (options.software)
+        {
+            software.reset(new SoftwareRasterizer(options.width, options.height));
+            software->setJobSystem(&jobs);
+            renderer.setSoftwareRasterizer(software.get());
+            std::cout << "Rasterizing on the CPU with the " << SoftwareRasterizer::getKernelName(SoftwareRasterizer::Kernel::Best) << " kernel\n\n";
+        }
+        std::unique_ptr<OverdrawView> overdraw;
+        if (options.overdraw && software)
+            std::cout << "--overdraw needs the GPU and is ignored with --software\n\n";
+        else if (options.overdraw)
+            overdraw.reset(new OverdrawView(options.width, options.height));
+
+        Camera camera;
+        camera.proj = glm::perspective(glm::radians(FOV / 2), (float)options.width / options.height, Z_NEAR, Z_FAR);
+        camera.position = glm::vec3(0.0f, 4.0f, -5.0f);
+        camera.view = glm::lookAt(camera.position, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        // Warm up once so shader compilation and first-use driver work is not counted.
+        scene->onUpdate(0.0f);
+        renderer.beginFrame();
+        renderer.clear();
+        scene->onRender(renderer, camera);
+        renderer.endFrame();
+        GLCall(glFinish());
+        FrameStats::reset();
+
+        // Each frame starts a new timeline, so what is left at the end is the last frame's.
+        jobs.setTimelineEnabled(!options.timeline.empty());
+        FrameTimer timer(options.frames);
+        timer.beginRun();
+        for (unsigned int frame = 0; frame < options.frames; frame++)
+        {
+            timer.beginFrame();
+            jobs.clearTimeline();
+            jobs.runMainThreadJobs();
+            scene->onUpdate(1.0f / 60.0f);
+            renderer.beginFrame();
+            renderer.clear();
+            if (overdraw)
+                overdraw->begin();
+            scene->onRender(renderer, camera);
+            if (overdraw)
+                overdraw->end();
+            renderer.endFrame();
+            if (options.finish)
+            {
+                GLCall(glFinish());
+            }
+            timer.endFrame();
+        }
+        GLCall(glFinish());
+        timer.endRun();
+
+        timer.printReport(std::cout);
+        FrameStats::printReport(std::cout);
+        if (overdraw)
+            overdraw->printReport(std::cout);
+        if (!options.timeline.empty())
+        {
+            if (!jobs.writeTimeline(options.timeline))
+            {
+                std::cout << "Could not write '" << options.timeline << "'!\n";
+                return -1;
+            }
+            std::cout << "\nWrote the last frame's " << jobs.getTimeline().size() << " jobs to '" << options.timeline << "'\n";
+        }
+
+        if (!options.image.empty() || !options.reference.empty())
+        {
+            std::vector<unsigned char> pixels = software
+                ? std::vector<unsigned char>(software->getPixels(), software->getPixels() + (size_t)options.width * options.height * 4)
+                : framebuffer.readPixels();
+            if (!options.image.empty() && !writeImage(options.image, options.width, options.height, pixels.data()))
+            {
+                std::cout << "Could not write '" << options.image << "'!\n";
+                return -1;
+            }
+            if (!options.reference.empty())
+            {
+                long long different = compareImage(options.reference, options.width, options.height, pixels.data());
+                if (different < 0)
+                {
+                    std::cout << "Could not read '" << options.reference << "' as a " << options.width << "x" << options.height << " PPM!\n";
+                    return -1;
+                }
+                std::cout << "\n" << different << " pixels differ from '" << options.reference << "'\n";
+                if (different > 0)
+                    return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
 void setCamVel(glm::vec3* currCamVel, const glm::vec3& camVel)
 {
     *currCamVel = camVel;
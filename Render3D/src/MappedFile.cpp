@@ -0,0 +1,79 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+    : m_data(nullptr), m_size(0), m_valid(false), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+{
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+    if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size))
+        return;
+    m_size = (size_t)size.QuadPart;
+    if (m_size == 0)
+    {
+        m_valid = true;
+        return;
+    }
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping)
+        m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    m_valid = m_data != nullptr;
+    if (!m_valid)
+        m_size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+    : m_data(nullptr), m_size(0), m_valid(false)
+{
+    int file = open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (file < 0 || fstat(file, &status) != 0)
+    {
+        if (file >= 0)
+            close(file);
+        return;
+    }
+    m_size = (size_t)status.st_size;
+    if (m_size > 0)
+    {
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data != MAP_FAILED)
+            m_data = (const unsigned char*)data;
+        else
+            m_size = 0;
+    }
+    // The mapping keeps the file's pages; the descriptor is not needed for it.
+    close(file);
+    m_valid = m_data != nullptr || status.st_size == 0;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        munmap((void*)m_data, m_size);
+}
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A file mapped read-only into the address space. Pages are read in by the OS when first
+// touched and stay shared with its file cache, so nothing is copied to get at the bytes.
+class MappedFile
+{
+private:
+	const unsigned char* m_data;
+	size_t m_size;
+	bool m_valid;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#endif
+public:
+	// Maps the whole file. An empty file is valid and maps to nothing.
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	inline bool isValid() const { return m_valid; }
+	inline const unsigned char* getData() const { return m_data; }
+	inline size_t getSize() const { return m_size; }
+};
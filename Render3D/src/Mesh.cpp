@@ -0,0 +1,104 @@
+#include "Mesh.h"
+#include "MeshCache.h"
+#include <algorithm>
+#include <cmath>
+
+// Cells across the longest side of the mesh at the first level of detail.
+static const unsigned int LOD_FIRST_RESOLUTION = 128;
+
+VertexBufferLayout MeshData::getLayout()
+{
+    VertexBufferLayout layout;
+    layout.push<float>(3);
+    layout.push<float>(2);
+    layout.push<float>(3);
+    return layout;
+}
+
+void MeshData::buildLods(unsigned int count)
+{
+    lods.clear();
+    size_t fullIndices = 0;
+    for (const Submesh& submesh : submeshes)
+        fullIndices = std::max(fullIndices, (size_t)submesh.firstIndex + submesh.indexCount);
+    indices.resize(fullIndices);
+
+    glm::vec3 size = bounds.box.max - bounds.box.min;
+    float longest = std::max(size.x, std::max(size.y, size.z));
+    if (longest <= 0.0f || vertices.empty())
+        return;
+
+    // Vertices sorted by cell, so each cell's first vertex is found in one pass.
+    std::vector<unsigned long long> cells(vertices.size());
+    std::vector<unsigned int> order(vertices.size());
+    std::vector<unsigned int> merged(vertices.size());
+    size_t previousIndices = fullIndices;
+    unsigned int resolution = LOD_FIRST_RESOLUTION;
+    for (unsigned int level = 0; level < count && resolution >= 2; level++, resolution /= 2)
+    {
+        float cellSize = longest / resolution;
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            glm::vec3 cell = glm::floor((vertices[i].position - bounds.box.min) / cellSize);
+            cell = glm::clamp(cell, glm::vec3(0.0f), glm::vec3((float)resolution));
+            cells[i] = (unsigned long long)cell.x << 42 | (unsigned long long)cell.y << 21 | (unsigned long long)cell.z;
+            order[i] = (unsigned int)i;
+        }
+        std::sort(order.begin(), order.end(), [&cells](unsigned int a, unsigned int b) {
+            return cells[a] != cells[b] ? cells[a] < cells[b] : a < b;
+        });
+        for (size_t i = 0; i < order.size(); i++)
+            merged[order[i]] = i > 0 && cells[order[i]] == cells[order[i - 1]] ? merged[order[i - 1]] : order[i];
+
+        MeshLod lod = { {}, cellSize * std::sqrt(3.0f) };
+        size_t firstIndex = indices.size();
+        for (const Submesh& submesh : submeshes)
+        {
+            size_t first = indices.size();
+            for (unsigned int i = submesh.firstIndex; i + 2 < submesh.firstIndex + submesh.indexCount; i += 3)
+            {
+                unsigned int a = merged[indices[i]], b = merged[indices[i + 1]], c = merged[indices[i + 2]];
+                if (a != b && b != c && c != a)
+                {
+                    indices.push_back(a);
+                    indices.push_back(b);
+                    indices.push_back(c);
+                }
+            }
+            if (indices.size() > first)
+                lod.submeshes.push_back({ (unsigned int)first, (unsigned int)(indices.size() - first), submesh.material });
+        }
+        size_t lodIndices = indices.size() - firstIndex;
+        if (lodIndices == 0 || lodIndices * 10 > previousIndices * 9)
+        {
+            indices.resize(firstIndex);
+            break;
+        }
+        lods.push_back(std::move(lod));
+        previousIndices = lodIndices;
+    }
+}
+
+Mesh::Mesh(const MeshData& data)
+    : Mesh(data.vertices.data(), data.vertices.size(), data.indices.data(), data.indices.size(), data.submeshes, data.lods, data.bounds)
+{
+}
+
+Mesh::Mesh(const CachedMesh& mesh)
+    : Mesh(mesh.getVertices(), mesh.getVertexCount(), mesh.getIndices(), mesh.getIndexCount(), mesh.getSubmeshes(), mesh.getLods(), mesh.getBounds())
+{
+}
+
+Mesh::Mesh(const void* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+    const std::vector<Submesh>& submeshes, const std::vector<MeshLod>& lods, const Bounds& bounds)
+    : m_vb(vertices, (unsigned int)(vertexCount * sizeof(MeshData::Vertex))), m_ib(indices, (unsigned int)indexCount),
+    m_submeshes(submeshes), m_lods(lods), m_bounds(bounds)
+{
+    m_va.addBuffer(m_vb, MeshData::getLayout());
+
+    // The index buffer was created before the vertex array was bound, so attach it now.
+    m_va.bind();
+    m_ib.bind();
+    m_va.unbind();
+    m_vb.unbind();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "Bounds.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "VertexBufferLayout.h"
+
+// A range of a mesh's indices drawn with one material.
+struct Submesh
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	std::string material;
+};
+
+// A coarser level of a mesh, drawn from the same vertices with indices of its own.
+struct MeshLod
+{
+	std::vector<Submesh> submeshes;
+	// How far a vertex may have moved from where the full mesh has it, in the mesh's units.
+	float error;
+};
+
+// A mesh on the CPU, as the importers produce it: vertices in the layout getLayout describes,
+// 32-bit indices into them, and the index range of each material in the order they appear.
+// Levels of detail, when built, follow with their indices after the full mesh's.
+struct MeshData
+{
+	struct Vertex
+	{
+		glm::vec3 position;
+		glm::vec2 texCoord;
+		glm::vec3 normal;
+	};
+
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<Submesh> submeshes;
+	std::vector<MeshLod> lods;
+	Bounds bounds;
+
+	// Replaces the levels of detail with up to count coarser ones. Each merges the vertices in
+	// a grid of cells into the first of them, with cells twice as large as the level before
+	// starting from 1/128 of the mesh's longest side, and drops the triangles that collapse.
+	// Levels stop once one removes less than a tenth of the triangles left.
+	void buildLods(unsigned int count);
+
+	// Position, texture coordinate and normal at locations 0, 1 and 2.
+	static VertexBufferLayout getLayout();
+};
+
+class CachedMesh;
+
+// A mesh in GL buffers, ready for Renderer::draw, or for a MeshArena through its MeshData.
+class Mesh
+{
+private:
+	VertexArray m_va;
+	VertexBuffer m_vb;
+	IndexBuffer m_ib;
+	std::vector<Submesh> m_submeshes;
+	std::vector<MeshLod> m_lods;
+	Bounds m_bounds;
+public:
+	explicit Mesh(const MeshData& data);
+	// Uploads straight from the cache file's mapping.
+	explicit Mesh(const CachedMesh& mesh);
+
+	inline const VertexArray& getVertexArray() const { return m_va; }
+	inline const IndexBuffer& getIndexBuffer() const { return m_ib; }
+	inline const std::vector<Submesh>& getSubmeshes() const { return m_submeshes; }
+	inline const std::vector<MeshLod>& getLods() const { return m_lods; }
+	inline const Bounds& getBounds() const { return m_bounds; }
+private:
+	Mesh(const void* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+		const std::vector<Submesh>& submeshes, const std::vector<MeshLod>& lods, const Bounds& bounds);
+};
@@ -0,0 +1,75 @@
+#include "MeshArena.h"
+#include "Renderer.h"
+
+MeshArena::MeshArena(const VertexBufferLayout& layout, unsigned int vertexCapacity, unsigned int indexCapacity)
+    : m_layout(layout), m_vertices(0), m_indices(0)
+{
+    grow(vertexCapacity, indexCapacity);
+}
+
+MeshRange MeshArena::addMesh(const void* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount)
+{
+    ASSERT(vertexCount > 0 && indexCount > 0);
+
+    MeshRange mesh = { m_vertices.allocate(vertexCount), vertexCount, m_indices.allocate(indexCount), indexCount };
+    if (mesh.baseVertex == OffsetAllocator::INVALID || mesh.firstIndex == OffsetAllocator::INVALID)
+    {
+        // Growing by more than the mesh leaves a free range at the end that is large enough,
+        // however fragmented the rest of the buffer is.
+        unsigned int vertexCapacity = m_vertices.getCapacity();
+        unsigned int indexCapacity = m_indices.getCapacity();
+        if (mesh.baseVertex == OffsetAllocator::INVALID)
+            vertexCapacity = vertexCapacity * 2 + vertexCount;
+        else
+            m_vertices.free(mesh.baseVertex, vertexCount);
+        if (mesh.firstIndex == OffsetAllocator::INVALID)
+            indexCapacity = indexCapacity * 2 + indexCount;
+        else
+            m_indices.free(mesh.firstIndex, indexCount);
+
+        grow(vertexCapacity, indexCapacity);
+        return addMesh(vertices, vertexCount, indices, indexCount);
+    }
+
+    unsigned int stride = m_layout.getStride();
+    m_vb->setData(vertices, mesh.baseVertex * stride, vertexCount * stride);
+    bind();
+    m_ib->setData(indices, mesh.firstIndex, indexCount);
+    return mesh;
+}
+
+void MeshArena::removeMesh(const MeshRange& mesh)
+{
+    m_vertices.free(mesh.baseVertex, mesh.vertexCount);
+    m_indices.free(mesh.firstIndex, mesh.indexCount);
+}
+
+void MeshArena::bind() const
+{
+    m_va->bind();
+    m_ib->bind();
+}
+
+void MeshArena::grow(unsigned int vertexCapacity, unsigned int indexCapacity)
+{
+    unsigned int stride = m_layout.getStride();
+
+    // The vertex array remembers the buffers it was built with, so a new one is made for the
+    // new buffers.
+    std::unique_ptr<VertexArray> va(new VertexArray());
+    std::unique_ptr<VertexBuffer> vb(new VertexBuffer(nullptr, vertexCapacity * stride, GL_DYNAMIC_DRAW));
+    std::unique_ptr<IndexBuffer> ib(new IndexBuffer(nullptr, indexCapacity, GL_DYNAMIC_DRAW));
+    va->addBuffer(*vb, m_layout);
+    ib->bind();
+
+    if (m_vb && m_vertices.getCapacity() > 0)
+        vb->copyFrom(*m_vb, m_vertices.getCapacity() * stride);
+    if (m_ib && m_indices.getCapacity() > 0)
+        ib->copyFrom(*m_ib, m_indices.getCapacity());
+
+    m_va = std::move(va);
+    m_vb = std::move(vb);
+    m_ib = std::move(ib);
+    m_vertices.grow(vertexCapacity);
+    m_indices.grow(indexCapacity);
+}
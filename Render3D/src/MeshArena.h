@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "OffsetAllocator.h"
+
+// Where a mesh lives inside a MeshArena. Indices are stored relative to the mesh's first
+// vertex, so drawing it needs baseVertex as well as the index range.
+struct MeshRange
+{
+	unsigned int baseVertex;
+	unsigned int vertexCount;
+	unsigned int firstIndex;
+	unsigned int indexCount;
+};
+
+// One vertex buffer and one index buffer shared by every mesh of a vertex format. Meshes are
+// ranges handed out by offset allocators, so drawing any number of them needs a single vertex
+// array bind and can be merged into multi-draw calls. Both buffers double when they run out.
+class MeshArena
+{
+private:
+	VertexBufferLayout m_layout;
+	std::unique_ptr<VertexArray> m_va;
+	std::unique_ptr<VertexBuffer> m_vb;
+	std::unique_ptr<IndexBuffer> m_ib;
+	OffsetAllocator m_vertices;
+	OffsetAllocator m_indices;
+public:
+	MeshArena(const VertexBufferLayout& layout, unsigned int vertexCapacity, unsigned int indexCapacity);
+
+	// vertices holds vertexCount vertices in the arena's layout; indices count from 0 within the mesh.
+	MeshRange addMesh(const void* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount);
+	void removeMesh(const MeshRange& mesh);
+
+	void bind() const;
+
+	inline const VertexBufferLayout& getLayout() const { return m_layout; }
+	inline const VertexArray& getVertexArray() const { return *m_va; }
+	inline const IndexBuffer& getIndexBuffer() const { return *m_ib; }
+	inline const OffsetAllocator& getVertexAllocator() const { return m_vertices; }
+	inline const OffsetAllocator& getIndexAllocator() const { return m_indices; }
+private:
+	void grow(unsigned int vertexCapacity, unsigned int indexCapacity);
+};
@@ -0,0 +1,81 @@
+#include "MeshBatch.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include <algorithm>
+#include <functional>
+
+MeshBatch::MeshBatch(const MeshArena& arena, bool allowIndirect)
+    : m_arena(arena), m_indirect(allowIndirect && isIndirectSupported()), m_indirectBuffer(0)
+{
+    if (m_indirect)
+    {
+        GLCall(glGenBuffers(1, &m_indirectBuffer));
+    }
+}
+
+MeshBatch::~MeshBatch()
+{
+    if (m_indirectBuffer)
+    {
+        GLCall(glDeleteBuffers(1, &m_indirectBuffer));
+        GLState::onBufferDeleted(m_indirectBuffer);
+    }
+}
+
+bool MeshBatch::isIndirectSupported()
+{
+    return GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+}
+
+void MeshBatch::clear()
+{
+    m_entries.clear();
+    m_groups.clear();
+}
+
+void MeshBatch::add(const Shader& shader, const Texture& texture, const MeshRange& mesh)
+{
+    m_entries.push_back({ &shader, &texture, mesh });
+}
+
+void MeshBatch::build()
+{
+    std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {
+        if (a.shader != b.shader)
+            return std::less<const Shader*>()(a.shader, b.shader);
+        return std::less<const Texture*>()(a.texture, b.texture);
+    });
+
+    m_groups.clear();
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+    {
+        const Entry& entry = m_entries[i];
+        if (m_groups.empty() || m_groups.back().shader != entry.shader || m_groups.back().texture != entry.texture)
+            m_groups.push_back({ entry.shader, entry.texture, i, 0 });
+        m_groups.back().count++;
+    }
+
+    if (m_indirect)
+    {
+        std::vector<DrawElementsIndirectCommand> commands(m_entries.size());
+        for (size_t i = 0; i < m_entries.size(); i++)
+        {
+            const MeshRange& mesh = m_entries[i].mesh;
+            commands[i] = { mesh.indexCount, 1, mesh.firstIndex, (int)mesh.baseVertex, 0 };
+        }
+        GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+        GLCall(glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STATIC_DRAW));
+        return;
+    }
+
+    m_counts.resize(m_entries.size());
+    m_indexOffsets.resize(m_entries.size());
+    m_baseVertices.resize(m_entries.size());
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        const MeshRange& mesh = m_entries[i].mesh;
+        m_counts[i] = (int)mesh.indexCount;
+        m_indexOffsets[i] = (const void*)(size_t)(mesh.firstIndex * sizeof(unsigned int));
+        m_baseVertices[i] = (int)mesh.baseVertex;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include "MeshArena.h"
+
+class Shader;
+class Texture;
+
+// Collects draws of meshes from one MeshArena and merges the ones that share a shader and a
+// texture into a single multi-draw. Where GL 4.3 or ARB_multi_draw_indirect is available the
+// draws are written to an indirect buffer for glMultiDrawElementsIndirect; otherwise they are
+// submitted with glMultiDrawElementsBaseVertex. Build once for static content and draw it
+// every frame with Renderer::drawBatch.
+class MeshBatch
+{
+public:
+	struct Group
+	{
+		const Shader* shader;
+		const Texture* texture;
+		unsigned int first;
+		unsigned int count;
+	};
+private:
+	struct Entry
+	{
+		const Shader* shader;
+		const Texture* texture;
+		MeshRange mesh;
+	};
+
+	// Layout fixed by glMultiDrawElementsIndirect.
+	struct DrawElementsIndirectCommand
+	{
+		unsigned int count;
+		unsigned int instanceCount;
+		unsigned int firstIndex;
+		int baseVertex;
+		unsigned int baseInstance;
+	};
+
+	const MeshArena& m_arena;
+	bool m_indirect;
+	unsigned int m_indirectBuffer;
+	std::vector<Entry> m_entries;
+	std::vector<Group> m_groups;
+	std::vector<int> m_counts;
+	std::vector<const void*> m_indexOffsets;
+	std::vector<int> m_baseVertices;
+public:
+	MeshBatch(const MeshArena& arena, bool allowIndirect = true);
+	~MeshBatch();
+
+	void clear();
+	void add(const Shader& shader, const Texture& texture, const MeshRange& mesh);
+	// Sorts the draws into groups and prepares the multi-draw arguments or indirect buffer.
+	void build();
+
+	inline const MeshArena& getArena() const { return m_arena; }
+	inline const std::vector<Group>& getGroups() const { return m_groups; }
+	// The mesh of a draw, in group order once built.
+	inline const MeshRange& getMesh(unsigned int draw) const { return m_entries[draw].mesh; }
+	inline bool isIndirect() const { return m_indirect; }
+	inline unsigned int getIndirectBuffer() const { return m_indirectBuffer; }
+	inline const int* getCounts() const { return m_counts.data(); }
+	inline const void* const* getIndexOffsets() const { return m_indexOffsets.data(); }
+	inline const int* getBaseVertices() const { return m_baseVertices.data(); }
+	// Byte offset of a group's first command in the indirect buffer.
+	inline unsigned int getIndirectOffset(const Group& group) const { return group.first * sizeof(DrawElementsIndirectCommand); }
+
+	static bool isIndirectSupported();
+};
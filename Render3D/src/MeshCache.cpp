@@ -0,0 +1,355 @@
+#include "MeshCache.h"
+#include "MeshImporter.h"
+#include "ResourcePack.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Bumped whenever the file layout changes, so old files are rebuilt.
+static const unsigned int FILE_VERSION = 1;
+static const char FILE_MAGIC[4] = { 'R', '3', 'M', 'C' };
+// Vertices and indices start on a page, so their spans of the mapping are page-aligned.
+static const size_t PAGE_ALIGNMENT = 4096;
+// Levels of detail built for every mesh that goes into the cache.
+static const unsigned int LOD_COUNT = 3;
+
+struct FileHeader
+{
+    char magic[4];
+    unsigned int version;
+    unsigned long long sourceHash;
+    unsigned long long vertexCount;
+    unsigned long long indexCount;
+    unsigned int stride;
+    unsigned int layoutCount;
+    unsigned int submeshCount;
+    unsigned int lodCount;
+    unsigned int namesSize;
+    unsigned int reserved;
+    Bounds bounds;
+    unsigned long long vertexOffset;
+    unsigned long long indexOffset;
+};
+
+struct LayoutEntry
+{
+    unsigned int type;
+    unsigned int count;
+    unsigned int normalized;
+};
+
+// Submeshes of every level, the full mesh's first.
+struct SubmeshEntry
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    unsigned int nameOffset;
+    unsigned int nameLength;
+};
+
+struct LodEntry
+{
+    unsigned int firstSubmesh;
+    unsigned int submeshCount;
+    float error;
+    unsigned int reserved;
+};
+
+static_assert(sizeof(FileHeader) == 112 && sizeof(LayoutEntry) == 12 && sizeof(SubmeshEntry) == 16 && sizeof(LodEntry) == 16,
+    "Cache files are read in place and must not change layout");
+static_assert(sizeof(MeshData::Vertex) == 32, "Cached vertices are stored as MeshData::Vertex");
+
+std::string MeshCache::s_directory = "meshcache";
+MeshCache::Stats MeshCache::s_stats = {};
+
+static double getMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void makeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+static size_t alignUp(size_t offset)
+{
+    return (offset + PAGE_ALIGNMENT - 1) / PAGE_ALIGNMENT * PAGE_ALIGNMENT;
+}
+
+MeshData CachedMesh::toMeshData() const
+{
+    if (!isMapped())
+        return m_data;
+    MeshData data;
+    data.vertices.assign(m_vertices, m_vertices + m_vertexCount);
+    data.indices.assign(m_indices, m_indices + m_indexCount);
+    data.submeshes = m_submeshes;
+    data.lods = m_lods;
+    data.bounds = m_bounds;
+    return data;
+}
+
+void CachedMesh::setData(MeshData&& data)
+{
+    m_data = std::move(data);
+    m_vertices = m_data.vertices.data();
+    m_vertexCount = m_data.vertices.size();
+    m_indices = m_data.indices.data();
+    m_indexCount = m_data.indices.size();
+    m_submeshes = m_data.submeshes;
+    m_lods = m_data.lods;
+    m_bounds = m_data.bounds;
+}
+
+void MeshCache::setDirectory(const std::string& directory)
+{
+    s_directory = directory;
+}
+
+std::string MeshCache::getPath(const std::string& sourcePath)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.mesh", ResourcePack::hash((const unsigned char*)sourcePath.data(), sourcePath.size()));
+    return s_directory + name;
+}
+
+std::unique_ptr<CachedMesh> MeshCache::load(const std::string& sourcePath, JobSystem* jobs)
+{
+    if (s_directory.empty())
+    {
+        auto start = std::chrono::steady_clock::now();
+        MeshData data;
+        if (!MeshImporter::import(sourcePath, data, jobs))
+            return nullptr;
+        data.buildLods(LOD_COUNT);
+        std::unique_ptr<CachedMesh> mesh(new CachedMesh());
+        mesh->setData(std::move(data));
+        s_stats.buildMs += getMs(start);
+        s_stats.built++;
+        return mesh;
+    }
+
+    // A mounted pack has the hash in its index; a loose source has to be read for it.
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long sourceHash = ResourcePack::getContentHash(sourcePath);
+    if (!sourceHash)
+    {
+        Resource source = ResourcePack::map(sourcePath);
+        if (!source.isValid())
+        {
+            std::cout << "Could not open the mesh '" << sourcePath << "'\n";
+            return nullptr;
+        }
+        sourceHash = ResourcePack::hash(source.getData(), source.getSize());
+    }
+    s_stats.hashMs += getMs(start);
+
+    start = std::chrono::steady_clock::now();
+    std::string path = getPath(sourcePath);
+    bool existed;
+    {
+        std::ifstream file(path, std::ios::binary);
+        existed = (bool)file;
+    }
+    if (existed)
+    {
+        if (std::unique_ptr<CachedMesh> cached = open(path, sourceHash))
+        {
+            s_stats.loadMs += getMs(start);
+            s_stats.hits++;
+            return cached;
+        }
+    }
+
+    start = std::chrono::steady_clock::now();
+    MeshData data;
+    if (!MeshImporter::import(sourcePath, data, jobs))
+        return nullptr;
+    data.buildLods(LOD_COUNT);
+    makeDirectory(s_directory);
+    std::unique_ptr<CachedMesh> cached;
+    if (write(path, data, sourceHash))
+        cached = open(path, sourceHash);
+    if (!cached)
+    {
+        // An unwritable directory: use the import this once.
+        cached.reset(new CachedMesh());
+        cached->setData(std::move(data));
+    }
+    s_stats.buildMs += getMs(start);
+    (existed ? s_stats.rebuilt : s_stats.built)++;
+    return cached;
+}
+
+bool MeshCache::write(const std::string& path, const MeshData& mesh, unsigned long long sourceHash)
+{
+    VertexBufferLayout layout = MeshData::getLayout();
+    std::vector<LayoutEntry> layoutEntries;
+    for (const VertexBufferElement& element : layout.getElements())
+        layoutEntries.push_back({ element.type, element.count, element.normalized });
+
+    std::vector<SubmeshEntry> submeshEntries;
+    std::vector<LodEntry> lodEntries;
+    std::string names;
+    auto addSubmeshes = [&](const std::vector<Submesh>& submeshes) {
+        for (const Submesh& submesh : submeshes)
+        {
+            submeshEntries.push_back({ submesh.firstIndex, submesh.indexCount, (unsigned int)names.size(), (unsigned int)submesh.material.size() });
+            names += submesh.material;
+        }
+    };
+    addSubmeshes(mesh.submeshes);
+    for (const MeshLod& lod : mesh.lods)
+    {
+        lodEntries.push_back({ (unsigned int)submeshEntries.size(), (unsigned int)lod.submeshes.size(), lod.error, 0 });
+        addSubmeshes(lod.submeshes);
+    }
+
+    FileHeader header = {};
+    memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.sourceHash = sourceHash;
+    header.vertexCount = mesh.vertices.size();
+    header.indexCount = mesh.indices.size();
+    header.stride = layout.getStride();
+    header.layoutCount = (unsigned int)layoutEntries.size();
+    header.submeshCount = (unsigned int)submeshEntries.size();
+    header.lodCount = (unsigned int)lodEntries.size();
+    header.namesSize = (unsigned int)names.size();
+    header.bounds = mesh.bounds;
+    size_t tablesEnd = sizeof(header) + layoutEntries.size() * sizeof(LayoutEntry) + submeshEntries.size() * sizeof(SubmeshEntry)
+        + lodEntries.size() * sizeof(LodEntry) + names.size();
+    header.vertexOffset = alignUp(tablesEnd);
+    header.indexOffset = alignUp(header.vertexOffset + mesh.vertices.size() * sizeof(MeshData::Vertex));
+
+    // Written aside and renamed, so a run that stops halfway leaves no truncated file behind.
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        static const char padding[PAGE_ALIGNMENT] = {};
+        file.write((const char*)&header, sizeof(header));
+        file.write((const char*)layoutEntries.data(), layoutEntries.size() * sizeof(LayoutEntry));
+        file.write((const char*)submeshEntries.data(), submeshEntries.size() * sizeof(SubmeshEntry));
+        file.write((const char*)lodEntries.data(), lodEntries.size() * sizeof(LodEntry));
+        file.write(names.data(), names.size());
+        file.write(padding, header.vertexOffset - tablesEnd);
+        file.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(MeshData::Vertex));
+        file.write(padding, header.indexOffset - header.vertexOffset - mesh.vertices.size() * sizeof(MeshData::Vertex));
+        file.write((const char*)mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+        if (!file)
+        {
+            std::cout << "Warning: could not write the mesh cache file '" << temporaryPath << "'\n";
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+
+std::unique_ptr<CachedMesh> MeshCache::open(const std::string& path, unsigned long long sourceHash)
+{
+    std::unique_ptr<MappedFile> file(new MappedFile(path));
+    if (!file->isValid() || file->getSize() < sizeof(FileHeader))
+        return nullptr;
+    const unsigned char* data = file->getData();
+    size_t size = file->getSize();
+    const FileHeader& header = *(const FileHeader*)data;
+    if (memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION || header.sourceHash != sourceHash)
+        return nullptr;
+
+    // The tables, and then the vertex and index spans, have to lie inside the file. Offsets are
+    // compared with the space left after them, since adding a size to one could wrap.
+    VertexBufferLayout layout = MeshData::getLayout();
+    const std::vector<VertexBufferElement>& elements = layout.getElements();
+    unsigned long long tablesEnd = sizeof(FileHeader) + (unsigned long long)header.layoutCount * sizeof(LayoutEntry)
+        + (unsigned long long)header.submeshCount * sizeof(SubmeshEntry) + (unsigned long long)header.lodCount * sizeof(LodEntry) + header.namesSize;
+    unsigned long long vertexBytes = header.vertexCount * sizeof(MeshData::Vertex);
+    unsigned long long indexBytes = header.indexCount * sizeof(unsigned int);
+    if (header.stride != layout.getStride() || header.layoutCount != elements.size() || tablesEnd > header.vertexOffset
+        || header.vertexOffset % PAGE_ALIGNMENT || header.indexOffset % PAGE_ALIGNMENT || header.vertexCount > size || header.indexCount > size
+        || header.indexOffset > size || indexBytes > size - header.indexOffset
+        || header.vertexOffset > header.indexOffset || vertexBytes > header.indexOffset - header.vertexOffset)
+        return nullptr;
+
+    const LayoutEntry* layoutEntries = (const LayoutEntry*)(data + sizeof(FileHeader));
+    for (size_t i = 0; i < elements.size(); i++)
+    {
+        if (layoutEntries[i].type != elements[i].type || layoutEntries[i].count != elements[i].count || layoutEntries[i].normalized != elements[i].normalized)
+            return nullptr;
+    }
+    const SubmeshEntry* submeshEntries = (const SubmeshEntry*)(layoutEntries + header.layoutCount);
+    const LodEntry* lodEntries = (const LodEntry*)(submeshEntries + header.submeshCount);
+    const char* names = (const char*)(lodEntries + header.lodCount);
+
+    std::unique_ptr<CachedMesh> mesh(new CachedMesh());
+    auto readSubmeshes = [&](unsigned int first, unsigned int count, std::vector<Submesh>& submeshes) {
+        if ((unsigned long long)first + count > header.submeshCount)
+            return false;
+        for (unsigned int i = first; i < first + count; i++)
+        {
+            const SubmeshEntry& entry = submeshEntries[i];
+            if ((unsigned long long)entry.firstIndex + entry.indexCount > header.indexCount
+                || (unsigned long long)entry.nameOffset + entry.nameLength > header.namesSize)
+                return false;
+            submeshes.push_back({ entry.firstIndex, entry.indexCount, std::string(names + entry.nameOffset, entry.nameLength) });
+        }
+        return true;
+    };
+    unsigned int fullSubmeshes = header.lodCount ? lodEntries[0].firstSubmesh : header.submeshCount;
+    if (!readSubmeshes(0, fullSubmeshes, mesh->m_submeshes))
+        return nullptr;
+    for (unsigned int i = 0; i < header.lodCount; i++)
+    {
+        MeshLod lod = { {}, lodEntries[i].error };
+        if (!readSubmeshes(lodEntries[i].firstSubmesh, lodEntries[i].submeshCount, lod.submeshes))
+            return nullptr;
+        mesh->m_lods.push_back(std::move(lod));
+    }
+
+    // An index past the vertices would have GL read outside the buffer.
+    const unsigned int* indices = (const unsigned int*)(data + header.indexOffset);
+    for (size_t i = 0; i < header.indexCount; i++)
+    {
+        if (indices[i] >= header.vertexCount)
+            return nullptr;
+    }
+
+    mesh->m_vertices = (const MeshData::Vertex*)(data + header.vertexOffset);
+    mesh->m_vertexCount = (size_t)header.vertexCount;
+    mesh->m_indices = indices;
+    mesh->m_indexCount = (size_t)header.indexCount;
+    mesh->m_bounds = header.bounds;
+    mesh->m_file = std::move(file);
+    return mesh;
+}
+
+void MeshCache::resetStats()
+{
+    s_stats = {};
+}
+
+void MeshCache::printReport(std::ostream& os)
+{
+    os << "Meshes: " << s_stats.hits << " from the cache in " << std::fixed << std::setprecision(2) << s_stats.loadMs << " ms, "
+        << s_stats.built + s_stats.rebuilt << " imported in " << s_stats.buildMs << " ms";
+    if (s_stats.rebuilt)
+        os << " (" << s_stats.rebuilt << " out of date)";
+    if (s_stats.hits + s_stats.built + s_stats.rebuilt)
+        os << ", sources hashed in " << s_stats.hashMs << " ms";
+    if (s_directory.empty())
+        os << ", cache off";
+    os << std::defaultfloat << "\n";
+}
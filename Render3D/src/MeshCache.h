@@ -0,0 +1,95 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Mesh.h"
+#include "MappedFile.h"
+
+class JobSystem;
+
+// A mesh as the cache holds it. When it comes from a cache file, the vertices, already in
+// MeshData::getLayout, and the indices are spans of the file's mapping, each starting on a page,
+// so they can go to glBufferData or a staging buffer as they are. With the cache off it holds
+// the imported MeshData instead.
+class CachedMesh
+{
+private:
+	std::unique_ptr<MappedFile> m_file;
+	MeshData m_data;
+	const MeshData::Vertex* m_vertices;
+	size_t m_vertexCount;
+	const unsigned int* m_indices;
+	size_t m_indexCount;
+	std::vector<Submesh> m_submeshes;
+	std::vector<MeshLod> m_lods;
+	Bounds m_bounds;
+public:
+	CachedMesh() : m_vertices(nullptr), m_vertexCount(0), m_indices(nullptr), m_indexCount(0), m_bounds() {}
+	CachedMesh(const CachedMesh&) = delete;
+	CachedMesh& operator=(const CachedMesh&) = delete;
+
+	inline bool isMapped() const { return m_file != nullptr; }
+	inline const MeshData::Vertex* getVertices() const { return m_vertices; }
+	inline size_t getVertexCount() const { return m_vertexCount; }
+	inline const unsigned int* getIndices() const { return m_indices; }
+	// Every level's indices, the full mesh's first.
+	inline size_t getIndexCount() const { return m_indexCount; }
+	inline const std::vector<Submesh>& getSubmeshes() const { return m_submeshes; }
+	inline const std::vector<MeshLod>& getLods() const { return m_lods; }
+	inline const Bounds& getBounds() const { return m_bounds; }
+
+	// A copy, for code that edits the mesh or hands it to a MeshArena.
+	MeshData toMeshData() const;
+private:
+	void setData(MeshData&& data);
+
+	friend class MeshCache;
+};
+
+// Keeps imported meshes on disk in a binary form that is mapped and used in place, so a launch
+// reads no text. Each source file has one cache file, named by a hash of its path, that records
+// a 64-bit FNV-1a hash of the source's contents. That hash is taken from the mounted
+// ResourcePack's index when the pack has the source, and otherwise computed from the mapped
+// source. A cache file whose hash, version or vertex layout does not match is rebuilt: the
+// source is imported, levels of detail are built, and the file is replaced.
+//
+// The file has a header with the counts and bounds, then the vertex layout, the submesh and
+// level-of-detail tables and the material names, and then the vertices and the indices, each
+// padded to start on a page.
+class MeshCache
+{
+public:
+	struct Stats
+	{
+		unsigned int hits;
+		// Sources imported because they had no cache file, and because theirs was out of date
+		// or unreadable.
+		unsigned int built;
+		unsigned int rebuilt;
+		double hashMs;
+		double loadMs;
+		double buildMs;
+	};
+private:
+	static std::string s_directory;
+	static Stats s_stats;
+public:
+	// Where the files go, "meshcache" by default. Empty turns the cache off.
+	static void setDirectory(const std::string& directory);
+	static inline const std::string& getDirectory() { return s_directory; }
+
+	static std::string getPath(const std::string& sourcePath);
+	// The mesh in the source file, from its cache file when that is up to date. Returns
+	// nullptr when the source cannot be imported.
+	static std::unique_ptr<CachedMesh> load(const std::string& sourcePath, JobSystem* jobs = nullptr);
+	// Writes a mesh, levels of detail included, as the cache file of a source with this hash.
+	static bool write(const std::string& path, const MeshData& mesh, unsigned long long sourceHash);
+	// Maps a cache file, checking it against the hash and the current vertex layout.
+	static std::unique_ptr<CachedMesh> open(const std::string& path, unsigned long long sourceHash);
+
+	static inline const Stats& getStats() { return s_stats; }
+	static void resetStats();
+	static void printReport(std::ostream& os);
+};
@@ -0,0 +1,156 @@
+#include "MeshFieldScene.h"
+#include "ShaderLibrary.h"
+#include "Renderer.h"
+
+static constexpr Uniform<int> u_texture("u_texture");
+
+struct MeshVertex
+{
+    glm::vec3 position;
+    glm::vec2 texCoord;
+    unsigned char color[4];
+};
+
+static VertexBufferLayout getMeshLayout()
+{
+    VertexBufferLayout layout;
+    layout.push<float>(3);
+    layout.push<float>(2);
+    layout.push<unsigned char>(4);
+    return layout;
+}
+
+static unsigned int hash(unsigned int x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static void addQuad(std::vector<MeshVertex>& vertices, std::vector<unsigned int>& indices, const glm::vec3 corners[4], float shade, const glm::vec3& color)
+{
+    static const glm::vec2 texCoords[4] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+    unsigned int first = (unsigned int)vertices.size();
+    glm::vec3 shaded = color * shade * 255.0f;
+    for (int i = 0; i < 4; i++)
+        vertices.push_back({ corners[i], texCoords[i], { (unsigned char)shaded.r, (unsigned char)shaded.g, (unsigned char)shaded.b, 255 } });
+    const unsigned int quad[] = { 0, 1, 2, 2, 3, 0 };
+    for (unsigned int index : quad)
+        indices.push_back(first + index);
+}
+
+// A box standing on the floor at center, with its faces shaded by direction.
+static void buildBox(std::vector<MeshVertex>& vertices, std::vector<unsigned int>& indices, const glm::vec3& center, const glm::vec3& size, const glm::vec3& color)
+{
+    glm::vec3 low = center - glm::vec3(size.x, 0.0f, size.z) * 0.5f;
+    glm::vec3 high = center + glm::vec3(size.x * 0.5f, size.y, size.z * 0.5f);
+    const glm::vec3 faces[6][4] = {
+        { { low.x, high.y, low.z }, { high.x, high.y, low.z }, { high.x, high.y, high.z }, { low.x, high.y, high.z } },
+        { { low.x, low.y, low.z }, { high.x, low.y, low.z }, { high.x, high.y, low.z }, { low.x, high.y, low.z } },
+        { { high.x, low.y, high.z }, { low.x, low.y, high.z }, { low.x, high.y, high.z }, { high.x, high.y, high.z } },
+        { { low.x, low.y, high.z }, { low.x, low.y, low.z }, { low.x, high.y, low.z }, { low.x, high.y, high.z } },
+        { { high.x, low.y, low.z }, { high.x, low.y, high.z }, { high.x, high.y, high.z }, { high.x, high.y, low.z } },
+        { { low.x, low.y, high.z }, { high.x, low.y, high.z }, { high.x, low.y, low.z }, { low.x, low.y, low.z } },
+    };
+    const float shades[6] = { 1.0f, 0.8f, 0.8f, 0.65f, 0.65f, 0.5f };
+    for (int i = 0; i < 6; i++)
+        addQuad(vertices, indices, faces[i], shades[i], color);
+}
+
+// A four-sided pyramid standing on the floor at center.
+static void buildPyramid(std::vector<MeshVertex>& vertices, std::vector<unsigned int>& indices, const glm::vec3& center, const glm::vec3& size, const glm::vec3& color)
+{
+    glm::vec3 low = center - glm::vec3(size.x, 0.0f, size.z) * 0.5f;
+    glm::vec3 high = center + glm::vec3(size.x, 0.0f, size.z) * 0.5f;
+    glm::vec3 apex = center + glm::vec3(0.0f, size.y, 0.0f);
+    const glm::vec3 base[4] = { { low.x, low.y, high.z }, { high.x, low.y, high.z }, { high.x, low.y, low.z }, { low.x, low.y, low.z } };
+    addQuad(vertices, indices, base, 0.5f, color);
+
+    glm::vec3 shaded = color * 255.0f;
+    for (int i = 0; i < 4; i++)
+    {
+        unsigned int first = (unsigned int)vertices.size();
+        float shade = i % 2 ? 0.9f : 0.7f;
+        unsigned char r = (unsigned char)(shaded.r * shade), g = (unsigned char)(shaded.g * shade), b = (unsigned char)(shaded.b * shade);
+        vertices.push_back({ base[(i + 1) % 4], { 0.0f, 0.0f }, { r, g, b, 255 } });
+        vertices.push_back({ base[i], { 1.0f, 0.0f }, { r, g, b, 255 } });
+        vertices.push_back({ apex, { 0.5f, 1.0f }, { r, g, b, 255 } });
+        indices.push_back(first);
+        indices.push_back(first + 1);
+        indices.push_back(first + 2);
+    }
+}
+
+MeshFieldScene::MeshFieldScene(MeshSubmission submission)
+    : m_submission(submission), m_shader(ShaderLibrary::load("res/shaders/Batched.shader")),
+    m_tileTexture("res/textures/Tile.png"), m_whiteTexture("res/textures/whiteTile.png"),
+    m_uniformBuffer(sizeof(CameraBlock)), m_arena(getMeshLayout(), 1 << 16, 1 << 16),
+    m_batch(m_arena, submission == MeshSubmission::Indirect)
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<unsigned int> indices;
+    for (int z = 0; z < FIELD_DEPTH; z++)
+    {
+        for (int x = 0; x < FIELD_WIDTH; x++)
+        {
+            unsigned int random = hash(z * FIELD_WIDTH + x);
+            glm::vec3 center((x - FIELD_WIDTH / 2) * 1.5f, 0.0f, (z - FIELD_DEPTH / 2) * 1.5f);
+            glm::vec3 size(0.4f + (random & 0xFF) / 512.0f, 0.3f + ((random >> 8) & 0xFF) / 128.0f, 0.4f + ((random >> 16) & 0xFF) / 512.0f);
+            glm::vec3 color(0.4f + (random >> 24 & 0x3) * 0.2f, 0.5f, 0.9f - (random >> 26 & 0x3) * 0.2f);
+
+            vertices.clear();
+            indices.clear();
+            if (random >> 31)
+                buildPyramid(vertices, indices, center, size, color);
+            else
+                buildBox(vertices, indices, center, size, color);
+            const Texture& texture = (x + z) % 2 ? m_whiteTexture : m_tileTexture;
+
+            if (m_submission == MeshSubmission::Separate)
+            {
+                SeparateMesh mesh;
+                mesh.va.reset(new VertexArray());
+                mesh.va->bind();
+                mesh.vb.reset(new VertexBuffer(vertices.data(), (unsigned int)(vertices.size() * sizeof(MeshVertex))));
+                mesh.ib.reset(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+                mesh.va->addBuffer(*mesh.vb, getMeshLayout());
+                mesh.texture = &texture;
+                m_separateMeshes.push_back(std::move(mesh));
+            }
+            else
+            {
+                MeshRange range = m_arena.addMesh(vertices.data(), (unsigned int)vertices.size(), indices.data(), (unsigned int)indices.size());
+                m_batch.add(*m_shader, texture, range);
+            }
+        }
+    }
+    m_batch.build();
+
+    m_shader->bindUniformBlock(CameraBlock::getLayout());
+    m_shader->bind();
+    m_shader->setUniform(u_texture, 0);
+}
+
+void MeshFieldScene::onRender(const Renderer& renderer, const Camera& camera)
+{
+    m_uniformBuffer.beginFrame();
+    unsigned int cameraOffset = m_uniformBuffer.push(CameraBlock{ camera.proj * camera.view, glm::vec4(camera.position, 1.0f) });
+    m_uniformBuffer.upload();
+    m_uniformBuffer.bindBlock<CameraBlock>(cameraOffset);
+
+    if (m_submission == MeshSubmission::Separate)
+    {
+        for (const SeparateMesh& mesh : m_separateMeshes)
+        {
+            mesh.texture->bind(0);
+            renderer.draw(*mesh.va, *mesh.ib, *m_shader);
+        }
+    }
+    else
+        renderer.drawBatch(m_batch);
+
+    m_uniformBuffer.endFrame();
+}
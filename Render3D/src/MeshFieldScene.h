@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include "Scene.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "UniformBuffer.h"
+#include "MeshArena.h"
+#include "MeshBatch.h"
+
+enum class MeshSubmission
+{
+	Separate,
+	MultiDraw,
+	Indirect
+};
+
+// 20,000 small static meshes with their transforms baked into the vertices. Separate gives
+// every mesh its own vertex array and draw; the other modes keep them all in one MeshArena and
+// draw them with one multi-draw per texture.
+class MeshFieldScene : public Scene
+{
+private:
+	static const int FIELD_WIDTH = 200;
+	static const int FIELD_DEPTH = 100;
+
+	struct SeparateMesh
+	{
+		std::unique_ptr<VertexArray> va;
+		std::unique_ptr<VertexBuffer> vb;
+		std::unique_ptr<IndexBuffer> ib;
+		const Texture* texture;
+	};
+
+	MeshSubmission m_submission;
+	std::shared_ptr<Shader> m_shader;
+	Texture m_tileTexture;
+	Texture m_whiteTexture;
+	UniformBuffer m_uniformBuffer;
+	MeshArena m_arena;
+	MeshBatch m_batch;
+	std::vector<SeparateMesh> m_separateMeshes;
+public:
+	MeshFieldScene(MeshSubmission submission);
+
+	void onRender(const Renderer& renderer, const Camera& camera) override;
+
+	inline unsigned int getMeshCount() const { return FIELD_WIDTH * FIELD_DEPTH; }
+	inline const MeshArena& getArena() const { return m_arena; }
+	inline const MeshBatch& getBatch() const { return m_batch; }
+};
@@ -0,0 +1,1007 @@
+#include "MeshImporter.h"
+#include "JobSystem.h"
+#include "ResourcePack.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// OBJ text is parsed in chunks of about this size, each a job.
+static const size_t OBJ_CHUNK_SIZE = 1 << 20;
+// Absolute corner indices are below OBJ_MAX_INDEX; relative ones are stored around OBJ_RELATIVE.
+static const int OBJ_MAX_INDEX = 1 << 29;
+static const int OBJ_RELATIVE = 1 << 30;
+
+static const unsigned int GLB_MAGIC = 0x46546C67;
+static const unsigned int GLB_JSON = 0x4E4F534A;
+static const unsigned int GLB_BIN = 0x004E4942;
+static const int GLTF_TRIANGLES = 4;
+
+static const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isDigit(char c)
+{
+    return (unsigned char)(c - '0') < 10;
+}
+
+static inline const char* skipSpaces(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    return p;
+}
+
+static inline unsigned int read32(const unsigned char* data)
+{
+    unsigned int value;
+    memcpy(&value, data, 4);
+    return value;
+}
+
+const char* MeshImporter::parseFloat(const char* text, const char* end, float& value)
+{
+    const char* p = text;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    // Up to 19 significant digits fit the mantissa; later ones only scale it.
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    for (; p < end && isDigit(*p); p++, any = true)
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        }
+        else
+            exponent++;
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && isDigit(*p); p++, any = true)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+    if (!any)
+        return text;
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* e = p + 1;
+        bool negativeExponent = false;
+        if (e < end && (*e == '-' || *e == '+'))
+            negativeExponent = *e++ == '-';
+        if (e < end && isDigit(*e))
+        {
+            int power = 0;
+            for (; e < end && isDigit(*e); e++)
+                power = std::min(power * 10 + (*e - '0'), 100000);
+            exponent += negativeExponent ? -power : power;
+            p = e;
+        }
+    }
+
+    // A mantissa of at most 53 bits and a power of ten up to 1e22 are both exact doubles, so
+    // one multiplication or division rounds the result once.
+    double result = (double)mantissa;
+    if (mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+        result = exponent < 0 ? result / POWERS_OF_TEN[-exponent] : result * POWERS_OF_TEN[exponent];
+    else if (mantissa != 0)
+        result *= std::pow(10.0, exponent);
+    value = (float)(negative ? -result : result);
+    return p;
+}
+
+// An OBJ index, 1-based or negative to count back from the last element so far. Returns
+// text when there is none.
+static const char* parseIndex(const char* text, const char* end, int& value)
+{
+    const char* p = text;
+    bool negative = p < end && *p == '-';
+    p += negative;
+    const char* digits = p;
+    long long number = 0;
+    for (; p < end && isDigit(*p); p++)
+        number = std::min(number * 10 + (*p - '0'), (long long)OBJ_MAX_INDEX);
+    if (p == digits)
+        return text;
+    value = (int)(negative ? -number : number);
+    return p;
+}
+
+struct ObjCorner
+{
+    int position;
+    int texCoord;
+    int normal;
+
+    inline bool operator==(const ObjCorner& other) const { return position == other.position && texCoord == other.texCoord && normal == other.normal; }
+};
+
+struct ObjMaterial
+{
+    size_t corner;
+    std::string name;
+};
+
+// One chunk's share of an OBJ file, with three corners per triangle. A corner's indices are
+// 0-based, -1 when it has none. Relative indices count back from the chunk's own lists and
+// may reach into an earlier chunk's, whose lengths are not known while chunks are parsed, so
+// they are stored as OBJ_RELATIVE plus the position in the chunk's list, and resolved once
+// every chunk is done.
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners;
+    std::vector<ObjMaterial> materials;
+    unsigned int malformed;
+    bool outOfRange;
+};
+
+static inline int encodeIndex(int value, size_t count)
+{
+    return value > 0 ? value - 1 : OBJ_RELATIVE + (int)count + value;
+}
+
+static inline int resolveIndex(int index, size_t base, size_t count, bool& outOfRange)
+{
+    if (index >= OBJ_MAX_INDEX)
+        index = (int)base + (index - OBJ_RELATIVE);
+    else if (index < 0)
+        return -1;
+    outOfRange |= index < 0 || (size_t)index >= count;
+    return index;
+}
+
+// Reads up to count numbers; returns false when the line has fewer than required. Missing
+// ones are left at 0.
+static bool parseFloats(const char* p, const char* end, float* values, int count, int required)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const char* start = skipSpaces(p, end);
+        p = MeshImporter::parseFloat(start, end, values[i]);
+        if (p == start)
+            return i >= required;
+    }
+    return true;
+}
+
+static void parseObjChunk(ObjChunk& chunk)
+{
+    std::vector<ObjCorner> face;
+    const char* next = chunk.begin;
+    for (const char* line = chunk.begin; line < chunk.end; line = next)
+    {
+        const char* end = (const char*)memchr(line, '\n', chunk.end - line);
+        end = end ? end : chunk.end;
+        next = end < chunk.end ? end + 1 : chunk.end;
+        const char* p = skipSpaces(line, end);
+        if (end - p < 2)
+            continue;
+
+        bool separated = p[1] == ' ' || p[1] == '\t';
+        bool attributeSeparated = end - p > 2 && (p[2] == ' ' || p[2] == '\t');
+        if (p[0] == 'v' && separated)
+        {
+            glm::vec3 position(0.0f);
+            chunk.malformed += !parseFloats(p + 2, end, &position.x, 3, 3);
+            chunk.positions.push_back(position);
+        }
+        else if (p[0] == 'v' && p[1] == 't' && attributeSeparated)
+        {
+            glm::vec2 texCoord(0.0f);
+            chunk.malformed += !parseFloats(p + 3, end, &texCoord.x, 2, 1);
+            chunk.texCoords.push_back(texCoord);
+        }
+        else if (p[0] == 'v' && p[1] == 'n' && attributeSeparated)
+        {
+            glm::vec3 normal(0.0f);
+            chunk.malformed += !parseFloats(p + 3, end, &normal.x, 3, 3);
+            chunk.normals.push_back(normal);
+        }
+        else if (p[0] == 'f' && separated)
+        {
+            // position, position/texCoord, position//normal or position/texCoord/normal
+            face.clear();
+            bool malformed = false;
+            for (const char* q = skipSpaces(p + 2, end); q < end && *q != '\r'; q = skipSpaces(q, end))
+            {
+                ObjCorner corner = { -1, -1, -1 };
+                int value = 0;
+                const char* r = parseIndex(q, end, value);
+                if (r == q || value == 0)
+                {
+                    malformed = true;
+                    break;
+                }
+                corner.position = encodeIndex(value, chunk.positions.size());
+                q = r;
+                if (q < end && *q == '/')
+                {
+                    r = parseIndex(++q, end, value);
+                    if (r != q && value != 0)
+                        corner.texCoord = encodeIndex(value, chunk.texCoords.size());
+                    q = r;
+                    if (q < end && *q == '/')
+                    {
+                        r = parseIndex(++q, end, value);
+                        if (r != q && value != 0)
+                            corner.normal = encodeIndex(value, chunk.normals.size());
+                        q = r;
+                    }
+                }
+                if (q < end && *q != ' ' && *q != '\t' && *q != '\r')
+                {
+                    malformed = true;
+                    break;
+                }
+                face.push_back(corner);
+            }
+            if (malformed || face.size() < 3)
+            {
+                chunk.malformed++;
+                continue;
+            }
+            // Polygons are fanned from their first corner, which is right for the convex ones
+            // OBJ exporters write.
+            for (size_t i = 2; i < face.size(); i++)
+            {
+                chunk.corners.push_back(face[0]);
+                chunk.corners.push_back(face[i - 1]);
+                chunk.corners.push_back(face[i]);
+            }
+        }
+        else if (end - p > 7 && memcmp(p, "usemtl", 6) == 0 && (p[6] == ' ' || p[6] == '\t'))
+        {
+            const char* name = skipSpaces(p + 7, end);
+            const char* nameEnd = end;
+            while (nameEnd > name && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t' || nameEnd[-1] == '\r'))
+                nameEnd--;
+            chunk.materials.push_back({ chunk.corners.size(), std::string(name, nameEnd) });
+        }
+    }
+}
+
+static inline size_t hashCorner(const ObjCorner& corner)
+{
+    unsigned long long hash = (unsigned int)corner.position * 0x9E3779B97F4A7C15ull;
+    hash ^= (unsigned int)corner.texCoord * 0xC2B2AE3D27D4EB4Full;
+    hash ^= (unsigned int)corner.normal * 0x165667B19E3779F9ull;
+    return (size_t)(hash ^ (hash >> 29));
+}
+
+// Gives each vertex flagged in missing the area-weighted average of the normals of the
+// triangles indices[firstIndex...] it is part of.
+static void computeNormals(MeshData& mesh, size_t firstIndex, const std::vector<bool>& missing)
+{
+    std::vector<glm::vec3> sums(mesh.vertices.size(), glm::vec3(0.0f));
+    for (size_t i = firstIndex; i + 2 < mesh.indices.size(); i += 3)
+    {
+        const unsigned int* triangle = &mesh.indices[i];
+        glm::vec3 a = mesh.vertices[triangle[0]].position;
+        glm::vec3 normal = glm::cross(mesh.vertices[triangle[1]].position - a, mesh.vertices[triangle[2]].position - a);
+        for (int corner = 0; corner < 3; corner++)
+            sums[triangle[corner]] += normal;
+    }
+    for (size_t i = 0; i < mesh.vertices.size(); i++)
+    {
+        if (missing[i])
+        {
+            float length = glm::length(sums[i]);
+            mesh.vertices[i].normal = length > 0.0f ? sums[i] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+    }
+}
+
+static void addSubmesh(MeshData& mesh, unsigned int firstIndex, unsigned int indexCount, const std::string& material)
+{
+    if (indexCount == 0)
+        return;
+    if (!mesh.submeshes.empty())
+    {
+        Submesh& last = mesh.submeshes.back();
+        if (last.material == material && last.firstIndex + last.indexCount == firstIndex)
+        {
+            last.indexCount += indexCount;
+            return;
+        }
+    }
+    mesh.submeshes.push_back({ firstIndex, indexCount, material });
+}
+
+static void runChunks(JobSystem* jobs, const char* name, unsigned int count, const std::function<void(unsigned int)>& work)
+{
+    if (jobs && count > 1)
+    {
+        jobs->wait(jobs->parallelFor(name, count, 1, [&work](unsigned int begin, unsigned int end) {
+            for (unsigned int i = begin; i < end; i++)
+                work(i);
+        }));
+    }
+    else
+    {
+        for (unsigned int i = 0; i < count; i++)
+            work(i);
+    }
+}
+
+bool MeshImporter::parseOBJ(const char* text, size_t size, MeshData& mesh, JobSystem* jobs, const std::string& name)
+{
+    mesh = MeshData();
+
+    // Chunks end after a newline, so no line is split between two.
+    std::vector<ObjChunk> chunks;
+    const char* textEnd = text + size;
+    for (const char* begin = text; begin < textEnd;)
+    {
+        const char* end = begin + std::min(OBJ_CHUNK_SIZE, (size_t)(textEnd - begin));
+        if (end < textEnd)
+        {
+            const char* newline = (const char*)memchr(end, '\n', textEnd - end);
+            end = newline ? newline + 1 : textEnd;
+        }
+        chunks.emplace_back();
+        chunks.back().begin = begin;
+        chunks.back().end = end;
+        chunks.back().malformed = 0;
+        chunks.back().outOfRange = false;
+        begin = end;
+    }
+    runChunks(jobs, "Parse OBJ", (unsigned int)chunks.size(), [&](unsigned int i) { parseObjChunk(chunks[i]); });
+
+    // Where each chunk's elements start in the joined lists.
+    struct Offsets
+    {
+        size_t positions, texCoords, normals, corners;
+    };
+    std::vector<Offsets> offsets(chunks.size() + 1, Offsets{ 0, 0, 0, 0 });
+    unsigned int malformed = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        offsets[i + 1].positions = offsets[i].positions + chunks[i].positions.size();
+        offsets[i + 1].texCoords = offsets[i].texCoords + chunks[i].texCoords.size();
+        offsets[i + 1].normals = offsets[i].normals + chunks[i].normals.size();
+        offsets[i + 1].corners = offsets[i].corners + chunks[i].corners.size();
+        malformed += chunks[i].malformed;
+    }
+    const Offsets& total = offsets.back();
+    if (malformed)
+        std::cout << "Warning: '" << name << "' has " << malformed << " malformed lines, which were skipped\n";
+    if (total.corners == 0)
+    {
+        std::cout << "Warning: '" << name << "' has no faces\n";
+        return false;
+    }
+    if (std::max({ total.positions, total.texCoords, total.normals, total.corners }) >= (size_t)OBJ_MAX_INDEX)
+    {
+        std::cout << "Warning: '" << name << "' is too large to import\n";
+        return false;
+    }
+
+    std::vector<glm::vec3> positions(total.positions);
+    std::vector<glm::vec2> texCoords(total.texCoords);
+    std::vector<glm::vec3> normals(total.normals);
+    std::vector<ObjCorner> corners(total.corners);
+    runChunks(jobs, "Join OBJ", (unsigned int)chunks.size(), [&](unsigned int i) {
+        ObjChunk& chunk = chunks[i];
+        const Offsets& offset = offsets[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + offset.positions);
+        std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + offset.texCoords);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + offset.normals);
+        for (size_t c = 0; c < chunk.corners.size(); c++)
+        {
+            const ObjCorner& corner = chunk.corners[c];
+            ObjCorner& resolved = corners[offset.corners + c];
+            resolved.position = resolveIndex(corner.position, offset.positions, total.positions, chunk.outOfRange);
+            resolved.texCoord = resolveIndex(corner.texCoord, offset.texCoords, total.texCoords, chunk.outOfRange);
+            resolved.normal = resolveIndex(corner.normal, offset.normals, total.normals, chunk.outOfRange);
+        }
+        std::vector<glm::vec3>().swap(chunk.positions);
+        std::vector<glm::vec2>().swap(chunk.texCoords);
+        std::vector<glm::vec3>().swap(chunk.normals);
+        std::vector<ObjCorner>().swap(chunk.corners);
+    });
+    for (const ObjChunk& chunk : chunks)
+    {
+        if (chunk.outOfRange)
+        {
+            std::cout << "Warning: '" << name << "' has faces naming vertices it does not have\n";
+            return false;
+        }
+    }
+
+    // Open addressing over the distinct corners. A slot keeps the corner next to its vertex
+    // index plus one, so a probe touches one cache line, and the table doubles when half full.
+    struct Slot
+    {
+        ObjCorner corner;
+        unsigned int vertex;
+    };
+    std::vector<ObjCorner> unique;
+    unique.reserve(total.positions);
+    size_t tableSize = 1024;
+    while (tableSize < total.positions * 2)
+        tableSize *= 2;
+    std::vector<Slot> table(tableSize, Slot{ { 0, 0, 0 }, 0 });
+    mesh.indices.resize(corners.size());
+    for (size_t i = 0; i < corners.size(); i++)
+    {
+        const ObjCorner& corner = corners[i];
+        size_t mask = table.size() - 1;
+        size_t slot = hashCorner(corner) & mask;
+        while (table[slot].vertex && !(table[slot].corner == corner))
+            slot = (slot + 1) & mask;
+        if (table[slot].vertex)
+        {
+            mesh.indices[i] = table[slot].vertex - 1;
+            continue;
+        }
+        unique.push_back(corner);
+        table[slot] = { corner, (unsigned int)unique.size() };
+        mesh.indices[i] = (unsigned int)unique.size() - 1;
+        if (unique.size() * 2 > table.size())
+        {
+            table.assign(table.size() * 2, Slot{ { 0, 0, 0 }, 0 });
+            mask = table.size() - 1;
+            for (size_t v = 0; v < unique.size(); v++)
+            {
+                slot = hashCorner(unique[v]) & mask;
+                while (table[slot].vertex)
+                    slot = (slot + 1) & mask;
+                table[slot] = { unique[v], (unsigned int)v + 1 };
+            }
+        }
+    }
+    std::vector<Slot>().swap(table);
+    std::vector<ObjCorner>().swap(corners);
+
+    mesh.vertices.resize(unique.size());
+    std::vector<bool> missingNormals(unique.size(), false);
+    bool anyMissing = false;
+    for (size_t i = 0; i < unique.size(); i++)
+    {
+        const ObjCorner& corner = unique[i];
+        MeshData::Vertex& vertex = mesh.vertices[i];
+        vertex.position = positions[corner.position];
+        vertex.texCoord = corner.texCoord >= 0 ? texCoords[corner.texCoord] : glm::vec2(0.0f);
+        vertex.normal = corner.normal >= 0 ? normals[corner.normal] : glm::vec3(0.0f);
+        missingNormals[i] = corner.normal < 0;
+        anyMissing |= corner.normal < 0;
+    }
+    if (anyMissing)
+        computeNormals(mesh, 0, missingNormals);
+
+    // Faces before the first usemtl have no material.
+    size_t runStart = 0;
+    std::string material;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        for (const ObjMaterial& change : chunks[i].materials)
+        {
+            size_t corner = offsets[i].corners + change.corner;
+            addSubmesh(mesh, (unsigned int)runStart, (unsigned int)(corner - runStart), material);
+            runStart = corner;
+            material = change.name;
+        }
+    }
+    addSubmesh(mesh, (unsigned int)runStart, (unsigned int)(total.corners - runStart), material);
+
+    mesh.bounds = Bounds::fromVertices(mesh.vertices.data(), (unsigned int)mesh.vertices.size(), sizeof(MeshData::Vertex));
+    return true;
+}
+
+// Just enough JSON for a glTF file's structure. Objects keep their keys in order next to
+// their values.
+struct JsonValue
+{
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    double number = 0.0;
+    std::string string;
+    std::vector<std::string> keys;
+    std::vector<JsonValue> values;
+
+    const JsonValue* get(const char* key) const
+    {
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            if (keys[i] == key)
+                return &values[i];
+        }
+        return nullptr;
+    }
+
+    // The index-th element of an array, or nullptr.
+    const JsonValue* at(double index) const
+    {
+        return type == Type::Array && index >= 0.0 && index < values.size() ? &values[(size_t)index] : nullptr;
+    }
+
+    double getNumber(const char* key, double fallback) const
+    {
+        const JsonValue* value = get(key);
+        return value && value->type == Type::Number ? value->number : fallback;
+    }
+
+    const JsonValue* getArrayItem(const char* key, double index) const
+    {
+        const JsonValue* array = get(key);
+        return array ? array->at(index) : nullptr;
+    }
+};
+
+static bool parseJsonString(const char*& p, const char* end, std::string& string)
+{
+    for (p++; p < end && *p != '"'; p++)
+    {
+        if (*p != '\\')
+        {
+            string += *p;
+            continue;
+        }
+        if (++p >= end)
+            return false;
+        switch (*p)
+        {
+        case 'b': string += '\b'; break;
+        case 'f': string += '\f'; break;
+        case 'n': string += '\n'; break;
+        case 'r': string += '\r'; break;
+        case 't': string += '\t'; break;
+        case 'u':
+        {
+            // Surrogate pairs come out as two sequences, which names never need.
+            if (end - p < 5)
+                return false;
+            unsigned int code = (unsigned int)strtoul(std::string(p + 1, p + 5).c_str(), nullptr, 16);
+            if (code < 0x80)
+                string += (char)code;
+            else if (code < 0x800)
+            {
+                string += (char)(0xC0 | code >> 6);
+                string += (char)(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                string += (char)(0xE0 | code >> 12);
+                string += (char)(0x80 | (code >> 6 & 0x3F));
+                string += (char)(0x80 | (code & 0x3F));
+            }
+            p += 4;
+            break;
+        }
+        default: string += *p; break;
+        }
+    }
+    if (p >= end)
+        return false;
+    p++;
+    return true;
+}
+
+static const char* skipJsonSpaces(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        p++;
+    return p;
+}
+
+static bool parseJson(const char*& p, const char* end, JsonValue& value, int depth)
+{
+    p = skipJsonSpaces(p, end);
+    if (p >= end || depth > 64)
+        return false;
+    if (*p == '{' || *p == '[')
+    {
+        bool object = *p == '{';
+        char close = object ? '}' : ']';
+        value.type = object ? JsonValue::Type::Object : JsonValue::Type::Array;
+        p = skipJsonSpaces(p + 1, end);
+        if (p < end && *p == close)
+        {
+            p++;
+            return true;
+        }
+        while (true)
+        {
+            if (object)
+            {
+                p = skipJsonSpaces(p, end);
+                value.keys.emplace_back();
+                if (p >= end || *p != '"' || !parseJsonString(p, end, value.keys.back()))
+                    return false;
+                p = skipJsonSpaces(p, end);
+                if (p >= end || *p++ != ':')
+                    return false;
+            }
+            value.values.emplace_back();
+            if (!parseJson(p, end, value.values.back(), depth + 1))
+                return false;
+            p = skipJsonSpaces(p, end);
+            if (p < end && *p == ',')
+            {
+                p++;
+                continue;
+            }
+            if (p < end && *p == close)
+            {
+                p++;
+                return true;
+            }
+            return false;
+        }
+    }
+    if (*p == '"')
+    {
+        value.type = JsonValue::Type::String;
+        return parseJsonString(p, end, value.string);
+    }
+    if (end - p >= 4 && memcmp(p, "true", 4) == 0)
+    {
+        value.type = JsonValue::Type::Bool;
+        value.number = 1.0;
+        p += 4;
+        return true;
+    }
+    if (end - p >= 5 && memcmp(p, "false", 5) == 0)
+    {
+        value.type = JsonValue::Type::Bool;
+        p += 5;
+        return true;
+    }
+    if (end - p >= 4 && memcmp(p, "null", 4) == 0)
+    {
+        p += 4;
+        return true;
+    }
+    // Offsets and counts can need more digits than a float holds.
+    const char* start = p;
+    while (p < end && (isDigit(*p) || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E'))
+        p++;
+    if (p == start)
+        return false;
+    value.type = JsonValue::Type::Number;
+    value.number = strtod(std::string(start, p).c_str(), nullptr);
+    return true;
+}
+
+// Where an accessor's elements lie in the binary chunk.
+struct AccessorView
+{
+    const unsigned char* data;
+    size_t stride;
+    unsigned int count;
+    unsigned int componentType;
+    unsigned int components;
+    bool normalized;
+};
+
+static unsigned int getComponentSize(unsigned int componentType)
+{
+    switch (componentType)
+    {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:  return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT: return 2;
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:          return 4;
+    }
+    return 0;
+}
+
+static unsigned int getComponentCount(const std::string& type)
+{
+    if (type == "SCALAR")
+        return 1;
+    if (type == "VEC2")
+        return 2;
+    if (type == "VEC3")
+        return 3;
+    if (type == "VEC4")
+        return 4;
+    return 0;
+}
+
+// Reads a byte count, offset or element count, which has to be a whole number from 0 to limit;
+// anything else cast to size_t would be undefined or wrap around.
+static bool getSize(const JsonValue& object, const char* key, double fallback, size_t limit, size_t& value)
+{
+    double number = object.getNumber(key, fallback);
+    if (!std::isfinite(number) || number < 0.0 || number != std::floor(number) || number > (double)limit)
+        return false;
+    value = (size_t)number;
+    return true;
+}
+
+// Fails, with the reason in error, for accessors that are sparse, have no buffer view, or run
+// past their view or the binary chunk.
+static bool getAccessor(const JsonValue& root, double index, const unsigned char* bin, size_t binSize, AccessorView& view, std::string& error)
+{
+    const JsonValue* accessor = root.getArrayItem("accessors", index);
+    const JsonValue* bufferView = accessor ? root.getArrayItem("bufferViews", accessor->getNumber("bufferView", -1.0)) : nullptr;
+    const JsonValue* type = accessor ? accessor->get("type") : nullptr;
+    if (!accessor || !bufferView || !type || accessor->get("sparse"))
+    {
+        error = "an accessor without a buffer view";
+        return false;
+    }
+    if (bufferView->getNumber("buffer", 0.0) != 0.0 || !bin)
+    {
+        error = "a buffer outside the file";
+        return false;
+    }
+    size_t componentType = 0;
+    view.components = getComponentCount(type->string);
+    size_t elementSize = getSize(*accessor, "componentType", 0.0, GL_FLOAT, componentType) ? (size_t)getComponentSize((unsigned int)componentType) * view.components : 0;
+    if (elementSize == 0)
+    {
+        error = "an accessor of an unknown type";
+        return false;
+    }
+    view.componentType = (unsigned int)componentType;
+    const JsonValue* normalized = accessor->get("normalized");
+    view.normalized = normalized && normalized->number != 0.0;
+
+    // Every value is bounded by the chunk before it is added or multiplied, so none can wrap.
+    size_t viewOffset, viewLength, accessorOffset, count;
+    if (!getSize(*bufferView, "byteOffset", 0.0, binSize, viewOffset) || !getSize(*bufferView, "byteLength", 0.0, binSize, viewLength)
+        || !getSize(*accessor, "byteOffset", 0.0, binSize, accessorOffset) || !getSize(*bufferView, "byteStride", (double)elementSize, binSize, view.stride)
+        || !getSize(*accessor, "count", 0.0, binSize, count) || view.stride < elementSize)
+    {
+        error = "an accessor with an invalid offset, length, stride or count";
+        return false;
+    }
+    view.count = (unsigned int)count;
+    size_t available = viewLength - std::min(viewLength, accessorOffset);
+    if (viewOffset > binSize - viewLength || accessorOffset > viewLength
+        || (count && (elementSize > available || (count - 1) > (available - elementSize) / view.stride)))
+    {
+        error = "an accessor past the end of its data";
+        return false;
+    }
+    view.data = bin + viewOffset + accessorOffset;
+    return true;
+}
+
+static float readComponent(const AccessorView& view, unsigned int element, unsigned int component)
+{
+    const unsigned char* data = view.data + view.stride * element;
+    switch (view.componentType)
+    {
+    case GL_FLOAT:
+    {
+        float value;
+        memcpy(&value, data + component * 4, 4);
+        return value;
+    }
+    case GL_UNSIGNED_BYTE:
+        return data[component] / (view.normalized ? 255.0f : 1.0f);
+    case GL_UNSIGNED_SHORT:
+    {
+        unsigned short value;
+        memcpy(&value, data + component * 2, 2);
+        return value / (view.normalized ? 65535.0f : 1.0f);
+    }
+    }
+    return 0.0f;
+}
+
+static unsigned int readIndex(const AccessorView& view, unsigned int element)
+{
+    const unsigned char* data = view.data + view.stride * element;
+    if (view.componentType == GL_UNSIGNED_BYTE)
+        return data[0];
+    if (view.componentType == GL_UNSIGNED_SHORT)
+    {
+        unsigned short value;
+        memcpy(&value, data, 2);
+        return value;
+    }
+    unsigned int value;
+    memcpy(&value, data, 4);
+    return value;
+}
+
+// Appends one triangle primitive; returns false with the reason in error.
+static bool addPrimitive(const JsonValue& root, const JsonValue& primitive, const unsigned char* bin, size_t binSize, MeshData& mesh, std::string& error)
+{
+    const JsonValue* attributes = primitive.get("attributes");
+    const JsonValue* positionIndex = attributes ? attributes->get("POSITION") : nullptr;
+    AccessorView positions, texCoords, normals, indices;
+    if (!positionIndex || !getAccessor(root, positionIndex->number, bin, binSize, positions, error))
+    {
+        error = positionIndex ? error : "a primitive without positions";
+        return false;
+    }
+    if (positions.componentType != GL_FLOAT || positions.components != 3)
+    {
+        error = "positions that are not three floats";
+        return false;
+    }
+    const JsonValue* normalIndex = attributes->get("NORMAL");
+    bool hasNormals = normalIndex != nullptr;
+    if (hasNormals && (!getAccessor(root, normalIndex->number, bin, binSize, normals, error) || normals.count != positions.count
+        || normals.componentType != GL_FLOAT || normals.components != 3))
+    {
+        error = "normals that do not match the positions";
+        return false;
+    }
+    const JsonValue* texCoordIndex = attributes->get("TEXCOORD_0");
+    bool hasTexCoords = texCoordIndex != nullptr;
+    if (hasTexCoords && (!getAccessor(root, texCoordIndex->number, bin, binSize, texCoords, error) || texCoords.count != positions.count
+        || texCoords.components != 2 || (texCoords.componentType != GL_FLOAT && !texCoords.normalized)))
+    {
+        error = "texture coordinates that do not match the positions";
+        return false;
+    }
+    const JsonValue* indicesIndex = primitive.get("indices");
+    if (indicesIndex && (!getAccessor(root, indicesIndex->number, bin, binSize, indices, error) || indices.components != 1
+        || (indices.componentType != GL_UNSIGNED_BYTE && indices.componentType != GL_UNSIGNED_SHORT && indices.componentType != GL_UNSIGNED_INT)))
+    {
+        error = "indices that are not unsigned integers";
+        return false;
+    }
+
+    // glTF puts texture coordinate (0, 0) at the top left of the image and GL at the bottom
+    // left, where Texture loads the first row.
+    size_t baseVertex = mesh.vertices.size();
+    size_t firstIndex = mesh.indices.size();
+    mesh.vertices.resize(baseVertex + positions.count);
+    for (unsigned int i = 0; i < positions.count; i++)
+    {
+        MeshData::Vertex& vertex = mesh.vertices[baseVertex + i];
+        memcpy(&vertex.position, positions.data + positions.stride * i, sizeof(glm::vec3));
+        if (hasNormals)
+            memcpy(&vertex.normal, normals.data + normals.stride * i, sizeof(glm::vec3));
+        else
+            vertex.normal = glm::vec3(0.0f);
+        if (hasTexCoords)
+            vertex.texCoord = glm::vec2(readComponent(texCoords, i, 0), 1.0f - readComponent(texCoords, i, 1));
+        else
+            vertex.texCoord = glm::vec2(0.0f);
+    }
+    unsigned int indexCount = indicesIndex ? indices.count : positions.count;
+    mesh.indices.resize(firstIndex + indexCount / 3 * 3);
+    for (size_t i = 0; i < indexCount / 3 * 3; i++)
+    {
+        unsigned int index = indicesIndex ? readIndex(indices, (unsigned int)i) : (unsigned int)i;
+        if (index >= positions.count)
+        {
+            error = "indices past the end of the positions";
+            return false;
+        }
+        mesh.indices[firstIndex + i] = (unsigned int)baseVertex + index;
+    }
+
+    if (!hasNormals)
+    {
+        std::vector<bool> missing(mesh.vertices.size(), false);
+        std::fill(missing.begin() + baseVertex, missing.end(), true);
+        computeNormals(mesh, firstIndex, missing);
+    }
+
+    // An index that is not a whole number in range leaves the submesh without a material.
+    std::string material;
+    size_t materialIndex;
+    if (primitive.get("material") && getSize(primitive, "material", 0.0, 0xFFFFFFFFu, materialIndex))
+    {
+        const JsonValue* materialValue = root.getArrayItem("materials", (double)materialIndex);
+        const JsonValue* name = materialValue ? materialValue->get("name") : nullptr;
+        material = name ? name->string : "material " + std::to_string(materialIndex);
+    }
+    addSubmesh(mesh, (unsigned int)firstIndex, (unsigned int)(mesh.indices.size() - firstIndex), material);
+    return true;
+}
+
+bool MeshImporter::parseGLB(const unsigned char* data, size_t size, MeshData& mesh, const std::string& name)
+{
+    mesh = MeshData();
+    if (size < 20 || read32(data) != GLB_MAGIC || read32(data + 4) != 2 || read32(data + 16) != GLB_JSON || 20 + (size_t)read32(data + 12) > size)
+    {
+        std::cout << "Warning: '" << name << "' is not a binary glTF 2.0 file\n";
+        return false;
+    }
+    const char* json = (const char*)data + 20;
+    const char* jsonEnd = json + read32(data + 12);
+    const unsigned char* bin = nullptr;
+    size_t binSize = 0;
+    size_t binHeader = (size_t)(jsonEnd - (const char*)data);
+    if (binHeader + 8 <= size && read32(data + binHeader + 4) == GLB_BIN)
+    {
+        bin = data + binHeader + 8;
+        binSize = std::min((size_t)read32(data + binHeader), size - binHeader - 8);
+    }
+
+    JsonValue root;
+    if (!parseJson(json, jsonEnd, root, 0) || root.type != JsonValue::Type::Object)
+    {
+        std::cout << "Warning: '" << name << "' has malformed JSON\n";
+        return false;
+    }
+
+    unsigned int skipped = 0;
+    const JsonValue* meshes = root.get("meshes");
+    for (size_t m = 0; meshes && m < meshes->values.size(); m++)
+    {
+        const JsonValue* primitives = meshes->values[m].get("primitives");
+        for (size_t p = 0; primitives && p < primitives->values.size(); p++)
+        {
+            const JsonValue& primitive = primitives->values[p];
+            if (primitive.getNumber("mode", GLTF_TRIANGLES) != GLTF_TRIANGLES)
+            {
+                skipped++;
+                continue;
+            }
+            std::string error;
+            if (!addPrimitive(root, primitive, bin, binSize, mesh, error))
+            {
+                std::cout << "Warning: '" << name << "' has " << error << "\n";
+                return false;
+            }
+        }
+    }
+    if (skipped)
+        std::cout << "Warning: '" << name << "' has " << skipped << " primitives of points or lines, which were skipped\n";
+    if (mesh.indices.empty())
+    {
+        std::cout << "Warning: '" << name << "' has no triangles\n";
+        return false;
+    }
+    mesh.bounds = Bounds::fromVertices(mesh.vertices.data(), (unsigned int)mesh.vertices.size(), sizeof(MeshData::Vertex));
+    return true;
+}
+
+bool MeshImporter::importOBJ(const std::string& path, MeshData& mesh, JobSystem* jobs)
+{
+    Resource file = ResourcePack::map(path);
+    if (!file.isValid())
+    {
+        std::cout << "Warning: could not read '" << path << "'\n";
+        return false;
+    }
+    return parseOBJ(file.getText(), file.getSize(), mesh, jobs, path);
+}
+
+bool MeshImporter::importGLB(const std::string& path, MeshData& mesh)
+{
+    Resource file = ResourcePack::map(path);
+    if (!file.isValid())
+    {
+        std::cout << "Warning: could not read '" << path << "'\n";
+        return false;
+    }
+    return parseGLB(file.getData(), file.getSize(), mesh, path);
+}
+
+bool MeshImporter::import(const std::string& path, MeshData& mesh, JobSystem* jobs)
+{
+    std::string extension = path.substr(std::min(path.size(), path.find_last_of('.')));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+    if (extension == ".obj")
+        return importOBJ(path, mesh, jobs);
+    if (extension == ".glb")
+        return importGLB(path, mesh);
+    std::cout << "Warning: '" << path << "' is neither an OBJ nor a GLB file\n";
+    return false;
+}
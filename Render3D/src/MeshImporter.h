@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include "Mesh.h"
+
+class JobSystem;
+
+// Reads Wavefront OBJ and binary glTF 2.0 files into MeshData. Files are mapped, from the
+// mounted ResourcePack or else on their own, and parsed where they lie.
+//
+// OBJ text over a megabyte is cut at line ends into chunks that jobs parse side by side into
+// their own lists of positions, texture coordinates, normals and face corners. The lists are
+// then joined, and each corner's position, texture coordinate and normal are looked up in a
+// hash table, so corners naming the same three share a vertex. Faces of more than three corners
+// are fanned into triangles, usemtl starts a submesh, and a mesh without normals gets them
+// averaged from its faces. Numbers are read by parseFloat rather than strtof, which checks the
+// locale and copies on every call.
+//
+// GLB files have their JSON chunk parsed for the meshes' accessors, which are read in place from
+// the binary chunk straight into the final vertices and indices. Every triangle primitive of every
+// mesh becomes a submesh named after its material; node transforms are not applied.
+//
+// Failures are printed with the file's path, and the import returns false.
+class MeshImporter
+{
+public:
+	// By the extension, .obj or .glb.
+	static bool import(const std::string& path, MeshData& mesh, JobSystem* jobs = nullptr);
+	static bool importOBJ(const std::string& path, MeshData& mesh, JobSystem* jobs = nullptr);
+	static bool importGLB(const std::string& path, MeshData& mesh);
+
+	// The name is only used in messages.
+	static bool parseOBJ(const char* text, size_t size, MeshData& mesh, JobSystem* jobs = nullptr, const std::string& name = "OBJ");
+	static bool parseGLB(const unsigned char* data, size_t size, MeshData& mesh, const std::string& name = "GLB");
+
+	// Reads a decimal number such as "-1.5e-3" from text, without reading at or past end, and
+	// returns where it ends; returns text, leaving value alone, when there is no number there.
+	// Up to 15 significant digits with an exponent within 22 are rounded once to a double, as
+	// strtod would, and then to the float; longer numbers may be a bit off in the double.
+	static const char* parseFloat(const char* text, const char* end, float& value);
+};
@@ -0,0 +1,284 @@
+#include "MipChain.h"
+#include <algorithm>
+#include <cmath>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define MIP_SSE 1
+#endif
+
+// The Kaiser filter's reach in texels of the smaller level, and the window's shape: higher
+// alpha rings less and blurs more.
+static const float KAISER_RADIUS = 3.0f;
+static const double KAISER_ALPHA = 4.0;
+
+// sRGB decoding per 8-bit value, and encoding from linear light quantized to 12 bits, which
+// keeps every 8-bit value apart even near black.
+struct SrgbTables
+{
+    float toLinear[256];
+    unsigned char fromLinear[4096];
+
+    SrgbTables()
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            float value = i / 255.0f;
+            toLinear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < 4096; i++)
+        {
+            float value = i / 4095.0f;
+            float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            fromLinear[i] = (unsigned char)(encoded * 255.0f + 0.5f);
+        }
+    }
+};
+
+static const SrgbTables& getSrgbTables()
+{
+    static const SrgbTables tables;
+    return tables;
+}
+
+// Which texels of the larger level each texel of the smaller one reads along one axis, and
+// with what weights; every texel reads the same number.
+struct Taps
+{
+    int count;
+    std::vector<int> indices;
+    std::vector<float> weights;
+};
+
+// The modified Bessel function of the first kind, order zero, which shapes the Kaiser window.
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32 && term > sum * 1e-12; k++)
+    {
+        double factor = x / (2.0 * k);
+        term *= factor * factor;
+        sum += term;
+    }
+    return sum;
+}
+
+static float kaiser(float distance)
+{
+    float t = distance / KAISER_RADIUS;
+    if (t * t >= 1.0f)
+        return 0.0f;
+    double sinc = distance == 0.0f ? 1.0 : std::sin(3.14159265358979 * distance) / (3.14159265358979 * distance);
+    return (float)(sinc * besselI0(KAISER_ALPHA * std::sqrt(1.0 - t * t)) / besselI0(KAISER_ALPHA));
+}
+
+static Taps computeTaps(int sourceSize, int size, MipChain::Filter filter, bool wrap)
+{
+    // Texel i of the larger level covers [i, i + 1); texel x of the smaller one covers
+    // [x * scale, (x + 1) * scale) of the same axis.
+    float scale = (float)sourceSize / size;
+    float radius = filter == MipChain::Filter::Box ? 0.5f * scale : KAISER_RADIUS * scale;
+    Taps taps;
+    taps.count = (int)std::ceil(2.0f * radius) + 1;
+    taps.indices.resize((size_t)size * taps.count);
+    taps.weights.resize((size_t)size * taps.count);
+    for (int x = 0; x < size; x++)
+    {
+        float center = (x + 0.5f) * scale;
+        int first = (int)std::floor(center - radius);
+        float sum = 0.0f;
+        for (int k = 0; k < taps.count; k++)
+        {
+            int i = first + k;
+            float weight;
+            if (filter == MipChain::Filter::Box)
+                weight = std::max(0.0f, std::min(i + 1.0f, center + radius) - std::max((float)i, center - radius));
+            else
+                weight = kaiser((i + 0.5f - center) / scale);
+            taps.indices[x * taps.count + k] = wrap ? (i % sourceSize + sourceSize) % sourceSize : std::max(0, std::min(sourceSize - 1, i));
+            taps.weights[x * taps.count + k] = weight;
+            sum += weight;
+        }
+        for (int k = 0; k < taps.count; k++)
+            taps.weights[x * taps.count + k] /= sum;
+    }
+    return taps;
+}
+
+// destination[x] is the weighted sum of the taps' texels of source, four floats per texel.
+static void filterRow(const float* source, float* destination, int width, const Taps& taps)
+{
+    for (int x = 0; x < width; x++)
+    {
+        const int* indices = &taps.indices[x * taps.count];
+        const float* weights = &taps.weights[x * taps.count];
+#if MIP_SSE
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < taps.count; k++)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source + indices[k] * 4), _mm_set1_ps(weights[k])));
+        _mm_storeu_ps(destination + x * 4, sum);
+#else
+        float sum[4] = {};
+        for (int k = 0; k < taps.count; k++)
+        {
+            for (int channel = 0; channel < 4; channel++)
+                sum[channel] += source[indices[k] * 4 + channel] * weights[k];
+        }
+        std::copy(sum, sum + 4, destination + x * 4);
+#endif
+    }
+}
+
+// destination += source * weight over a row of floats, four at a time.
+static void accumulateRow(const float* source, float weight, float* destination, int floatCount)
+{
+#if MIP_SSE
+    __m128 scale = _mm_set1_ps(weight);
+    for (int i = 0; i < floatCount; i += 4)
+        _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i), _mm_mul_ps(_mm_loadu_ps(source + i), scale)));
+#else
+    for (int i = 0; i < floatCount; i++)
+        destination[i] += source[i] * weight;
+#endif
+}
+
+// The common case: both sizes even, so every texel of the smaller level averages a 2x2 block.
+static void boxHalve(const float* source, int width, int height, float* destination)
+{
+    int halfWidth = width / 2, halfHeight = height / 2;
+    for (int y = 0; y < halfHeight; y++)
+    {
+        const float* row0 = source + (size_t)(2 * y) * width * 4;
+        const float* row1 = row0 + (size_t)width * 4;
+        float* out = destination + (size_t)y * halfWidth * 4;
+        for (int x = 0; x < halfWidth; x++)
+        {
+#if MIP_SSE
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row0 + x * 8 + 4)),
+                _mm_add_ps(_mm_loadu_ps(row1 + x * 8), _mm_loadu_ps(row1 + x * 8 + 4)));
+            _mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+            for (int channel = 0; channel < 4; channel++)
+                out[x * 4 + channel] = (row0[x * 8 + channel] + row0[x * 8 + 4 + channel] + row1[x * 8 + channel] + row1[x * 8 + 4 + channel]) * 0.25f;
+#endif
+        }
+    }
+}
+
+// Separable resampling: rows into temporary, then columns of whole rows at a time.
+static void downsample(const std::vector<float>& source, int width, int height, std::vector<float>& destination, int newWidth, int newHeight,
+    MipChain::Filter filter, bool wrap, std::vector<float>& temporary)
+{
+    destination.assign((size_t)newWidth * newHeight * 4, 0.0f);
+    if (filter == MipChain::Filter::Box && width % 2 == 0 && height % 2 == 0)
+    {
+        boxHalve(source.data(), width, height, destination.data());
+        return;
+    }
+
+    Taps horizontal = computeTaps(width, newWidth, filter, wrap);
+    temporary.resize((size_t)newWidth * height * 4);
+    for (int y = 0; y < height; y++)
+        filterRow(source.data() + (size_t)y * width * 4, temporary.data() + (size_t)y * newWidth * 4, newWidth, horizontal);
+
+    Taps vertical = computeTaps(height, newHeight, filter, wrap);
+    for (int y = 0; y < newHeight; y++)
+    {
+        float* out = destination.data() + (size_t)y * newWidth * 4;
+        for (int k = 0; k < vertical.count; k++)
+        {
+            const float* row = temporary.data() + (size_t)vertical.indices[y * vertical.count + k] * newWidth * 4;
+            accumulateRow(row, vertical.weights[y * vertical.count + k], out, newWidth * 4);
+        }
+    }
+}
+
+static void decodeLevel(const unsigned char* pixels, size_t texels, bool srgb, std::vector<float>& linear)
+{
+    const SrgbTables& tables = getSrgbTables();
+    linear.resize(texels * 4);
+    for (size_t i = 0; i < texels * 4; i += 4)
+    {
+        for (int channel = 0; channel < 3; channel++)
+            linear[i + channel] = srgb ? tables.toLinear[pixels[i + channel]] : pixels[i + channel] / 255.0f;
+        linear[i + 3] = pixels[i + 3] / 255.0f;
+    }
+}
+
+// The Kaiser filter's negative lobes can push values past 0 and 1, so they are clamped here.
+static void encodeLevel(const std::vector<float>& linear, bool srgb, unsigned char* pixels)
+{
+    const SrgbTables& tables = getSrgbTables();
+    for (size_t i = 0; i < linear.size(); i += 4)
+    {
+#if MIP_SSE
+        __m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&linear[i]), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        alignas(16) int scaled[4], table[4];
+        _mm_store_si128((__m128i*)scaled, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f))));
+        _mm_store_si128((__m128i*)table, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(4095.0f)), _mm_set1_ps(0.5f))));
+        for (int channel = 0; channel < 3; channel++)
+            pixels[i + channel] = srgb ? tables.fromLinear[table[channel]] : (unsigned char)scaled[channel];
+        pixels[i + 3] = (unsigned char)scaled[3];
+#else
+        for (int channel = 0; channel < 4; channel++)
+        {
+            float value = std::max(0.0f, std::min(1.0f, linear[i + channel]));
+            pixels[i + channel] = srgb && channel < 3 ? tables.fromLinear[(int)(value * 4095.0f + 0.5f)] : (unsigned char)(value * 255.0f + 0.5f);
+        }
+#endif
+    }
+}
+
+MipChain::MipChain(int width, int height, const unsigned char* pixels)
+    : m_pixels(pixels, pixels + (size_t)width * height * 4), m_levels(1, Level{ width, height, 0 })
+{
+}
+
+MipChain::MipChain(int width, int height, std::vector<unsigned char>&& pixels)
+    : m_pixels(std::move(pixels)), m_levels(1, Level{ width, height, 0 })
+{
+}
+
+void MipChain::generate(Filter filter, bool srgb, bool wrap, unsigned int maxLevels)
+{
+    if (m_levels.empty())
+        return;
+    int width = getWidth(), height = getHeight();
+    unsigned int levelCount = getFullLevelCount(width, height);
+    if (maxLevels)
+        levelCount = std::min(levelCount, maxLevels);
+    size_t size = 0;
+    for (unsigned int level = 0; level < levelCount; level++)
+        size += (size_t)std::max(1, width >> level) * std::max(1, height >> level) * 4;
+    m_pixels.resize(size);
+    m_levels.resize(1);
+
+    std::vector<float> level, next, temporary;
+    decodeLevel(m_pixels.data(), (size_t)width * height, srgb, level);
+    size_t offset = (size_t)width * height * 4;
+    for (unsigned int i = 1; i < levelCount; i++)
+    {
+        int newWidth = std::max(1, width / 2), newHeight = std::max(1, height / 2);
+        downsample(level, width, height, next, newWidth, newHeight, filter, wrap, temporary);
+        encodeLevel(next, srgb, m_pixels.data() + offset);
+        m_levels.push_back({ newWidth, newHeight, offset });
+        offset += next.size();
+        level.swap(next);
+        width = newWidth;
+        height = newHeight;
+    }
+}
+
+void MipChain::appendLevel(int width, int height, const unsigned char* pixels)
+{
+    size_t offset = m_pixels.size();
+    m_pixels.insert(m_pixels.end(), pixels, pixels + (size_t)width * height * 4);
+    m_levels.push_back({ width, height, offset });
+}
+
+unsigned int MipChain::getFullLevelCount(int width, int height)
+{
+    unsigned int levels = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2)
+        levels++;
+    return levels;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// An RGBA8 image and the mip levels below it, bottom row first like Texture's texels. Each
+// level is half the size of the one above, rounded down and at least 1, down to 1x1, and the
+// levels are stored one after another so a chain uploads from a single buffer.
+//
+// generate() filters in float and quantizes each level on its own, so errors do not pile up
+// down the chain. Color texels are sRGB-encoded, and averaging them as stored darkens every
+// level (a black and white checker ends up at 128 instead of 188), so with srgb set the color
+// channels are filtered in linear light; alpha is linear either way. Texels are processed four
+// channels at a time with SSE. Nothing here touches GL, so chains can be made on job threads
+// or by tools ahead of time.
+class MipChain
+{
+public:
+	enum class Filter
+	{
+		// Each texel of the next level averages the texels it covers, 2x2 for even sizes.
+		Box,
+		// A sinc windowed by a Kaiser window, 3 texels of the next level either side. Keeps
+		// detail the box blurs away and aliases less, at a few times the cost.
+		Kaiser
+	};
+
+	struct Level
+	{
+		int width, height;
+		size_t offset;
+	};
+private:
+	std::vector<unsigned char> m_pixels;
+	std::vector<Level> m_levels;
+public:
+	MipChain() {}
+	// Holds just the base level until generate is called.
+	MipChain(int width, int height, const unsigned char* pixels);
+	MipChain(int width, int height, std::vector<unsigned char>&& pixels);
+
+	// Replaces the levels below the base one with a full chain, or its first maxLevels levels.
+	// With wrap the filter reads across the edges as GL_REPEAT would, otherwise it clamps to them.
+	void generate(Filter filter, bool srgb, bool wrap, unsigned int maxLevels = 0);
+	// Adds a level below the last one, for chains made elsewhere, like a compressed file's.
+	void appendLevel(int width, int height, const unsigned char* pixels);
+
+	inline unsigned int getLevelCount() const { return (unsigned int)m_levels.size(); }
+	inline const Level& getLevel(unsigned int level) const { return m_levels[level]; }
+	inline int getWidth() const { return m_levels.empty() ? 0 : m_levels[0].width; }
+	inline int getHeight() const { return m_levels.empty() ? 0 : m_levels[0].height; }
+	inline const unsigned char* getPixels(unsigned int level = 0) const { return m_levels.empty() ? nullptr : m_pixels.data() + m_levels[level].offset; }
+	// Every level, in order.
+	inline const std::vector<unsigned char>& getData() const { return m_pixels; }
+
+	// Levels in a full chain for an image of this size, as glTexStorage2D counts them.
+	static unsigned int getFullLevelCount(int width, int height);
+};
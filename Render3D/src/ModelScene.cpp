@@ -0,0 +1,54 @@
+#include "ModelScene.h"
+#include "MeshCache.h"
+#include "ShaderLibrary.h"
+#include "Renderer.h"
+#include <glm/ext/matrix_transform.hpp>
+
+static constexpr Uniform<int> u_texture("u_texture");
+
+static const float MODEL_SIZE = 3.0f;
+
+ModelScene::ModelScene(const std::string& path)
+    : m_shader(ShaderLibrary::load("res/shaders/Simple.shader")), m_texture("res/textures/Tile.png"),
+    m_uniformBuffer(sizeof(CameraBlock) + sizeof(ObjectBlock)), m_fit(1.0f), m_angle(0.0f)
+{
+    if (std::unique_ptr<CachedMesh> cached = MeshCache::load(path))
+    {
+        m_mesh.reset(new Mesh(*cached));
+        // Centered on its bounding sphere and scaled to MODEL_SIZE across it.
+        const BoundingSphere& sphere = cached->getBounds().sphere;
+        float scale = sphere.radius > 0.0f ? MODEL_SIZE * 0.5f / sphere.radius : 1.0f;
+        m_fit = glm::translate(glm::scale(glm::mat4(1.0f), glm::vec3(scale)), -sphere.center);
+    }
+
+    m_shader->bindUniformBlock(CameraBlock::getLayout());
+    m_shader->bindUniformBlock(ObjectBlock::getLayout());
+    m_shader->bind();
+    m_shader->setUniform(u_texture, 0);
+}
+
+void ModelScene::onUpdate(float deltaTime)
+{
+    m_angle += deltaTime * 0.5f;
+}
+
+void ModelScene::onRender(const Renderer& renderer, const Camera& camera)
+{
+    if (!m_mesh)
+        return;
+    glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 3.0f, 6.0f)), m_angle, glm::vec3(0.0f, 1.0f, 0.0f)) * m_fit;
+
+    m_uniformBuffer.beginFrame();
+    unsigned int cameraOffset = m_uniformBuffer.push(CameraBlock{ camera.proj * camera.view, glm::vec4(camera.position, 1.0f) });
+    unsigned int objectOffset = m_uniformBuffer.push(ObjectBlock{ model, glm::vec4(1.0f) });
+    m_uniformBuffer.upload();
+
+    m_uniformBuffer.bindBlock<CameraBlock>(cameraOffset);
+    m_uniformBuffer.bindBlock<ObjectBlock>(objectOffset);
+    m_texture.bind(0);
+    // The full mesh only: its levels of detail follow it in the index buffer.
+    for (const Submesh& submesh : m_mesh->getSubmeshes())
+        renderer.draw(m_mesh->getVertexArray(), m_mesh->getIndexBuffer(), *m_shader, submesh.firstIndex, submesh.indexCount);
+
+    m_uniformBuffer.endFrame();
+}
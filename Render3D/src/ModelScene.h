@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "Scene.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "UniformBuffer.h"
+
+// A mesh imported from an OBJ or GLB file through the MeshCache, scaled to a few units and
+// turning in front of the camera. Nothing is drawn when the file cannot be imported.
+class ModelScene : public Scene
+{
+private:
+	std::unique_ptr<Mesh> m_mesh;
+	std::shared_ptr<Shader> m_shader;
+	Texture m_texture;
+	UniformBuffer m_uniformBuffer;
+	glm::mat4 m_fit;
+	float m_angle;
+public:
+	ModelScene(const std::string& path);
+
+	void onUpdate(float deltaTime) override;
+	void onRender(const Renderer& renderer, const Camera& camera) override;
+
+	inline const Mesh* getMesh() const { return m_mesh.get(); }
+};
@@ -0,0 +1,438 @@
+#include "OcclusionCuller.h"
+#include "FrameStats.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define OCCLUSION_SSE 1
+#endif
+#if defined(__AVX2__)
+#define OCCLUSION_AVX2 1
+#endif
+
+// A vertex of a triangle being set up, with whether the edge that starts at it is shared with
+// another triangle of the same occluder.
+struct ClipVertex
+{
+    glm::vec4 position;
+    bool interiorEdge;
+};
+
+// Clips a triangle against the near plane (z >= -w) and returns the number of vertices of the
+// remaining convex polygon, 0, 3 or 4.
+static unsigned int clipNear(const ClipVertex* triangle, ClipVertex* polygon)
+{
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        const ClipVertex& current = triangle[i];
+        const ClipVertex& next = triangle[(i + 1) % 3];
+        float currentDistance = current.position.z + current.position.w;
+        float nextDistance = next.position.z + next.position.w;
+        if (currentDistance >= 0.0f)
+            polygon[count++] = current;
+        if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+        {
+            float t = currentDistance / (currentDistance - nextDistance);
+            glm::vec4 position = current.position + (next.position - current.position) * t;
+            // Leaving the volume, the new edge runs along the near plane and is an outline;
+            // entering it, the edge continues the original one.
+            polygon[count++] = { position, currentDistance >= 0.0f ? false : current.interiorEdge };
+        }
+    }
+    return count;
+}
+
+OcclusionCuller::OcclusionCuller(unsigned int width, unsigned int height)
+    : m_width((width + TILE_WIDTH - 1) / TILE_WIDTH * TILE_WIDTH), m_height((height + TILE_HEIGHT - 1) / TILE_HEIGHT * TILE_HEIGHT),
+    m_depth(m_width * m_height, 1.0f), m_tileDepth(m_width / TILE_WIDTH * m_height / TILE_HEIGHT, 1.0f),
+    m_viewProj(1.0f), m_kernel(getBestKernel()), m_threadCount(0), m_jobs(nullptr)
+{
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    finishFrame();
+}
+
+void OcclusionCuller::addOccluder(const void* vertices, unsigned int stride, const unsigned int* indices, unsigned int indexCount, const glm::mat4& model)
+{
+    // Edges used by two triangles are inside the mesh outline, like the diagonal of a quad.
+    std::map<std::pair<unsigned int, unsigned int>, unsigned int> edgeUses;
+    for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+    {
+        for (unsigned int e = 0; e < 3; e++)
+        {
+            unsigned int a = indices[i + e], b = indices[i + (e + 1) % 3];
+            edgeUses[std::make_pair(std::min(a, b), std::max(a, b))]++;
+        }
+    }
+
+    const unsigned char* data = (const unsigned char*)vertices;
+    for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+    {
+        unsigned char interiorEdges = 0;
+        for (unsigned int e = 0; e < 3; e++)
+        {
+            unsigned int index = indices[i + e];
+            const float* position = (const float*)(data + (size_t)index * stride);
+            m_occluderVertices.push_back(glm::vec3(model * glm::vec4(position[0], position[1], position[2], 1.0f)));
+            unsigned int next = indices[i + (e + 1) % 3];
+            if (edgeUses[std::make_pair(std::min(index, next), std::max(index, next))] > 1)
+                interiorEdges |= 1 << e;
+        }
+        m_occluderEdges.push_back(interiorEdges);
+    }
+}
+
+void OcclusionCuller::clearOccluders()
+{
+    finishFrame();
+    m_occluderVertices.clear();
+    m_occluderEdges.clear();
+}
+
+OcclusionCuller::Kernel OcclusionCuller::getBestKernel()
+{
+#if OCCLUSION_AVX2
+    return Kernel::AVX2;
+#elif OCCLUSION_SSE
+    return Kernel::SSE;
+#else
+    return Kernel::Scalar;
+#endif
+}
+
+const char* OcclusionCuller::getKernelName(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Kernel::Scalar:    return "scalar";
+    case Kernel::SSE:       return "SSE";
+    case Kernel::AVX2:      return "AVX2";
+    case Kernel::Best:      return getKernelName(getBestKernel());
+    }
+    return "";
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& viewProj, Kernel kernel)
+{
+    finishFrame();
+    m_viewProj = viewProj;
+    m_kernel = kernel == Kernel::Best ? getBestKernel() : kernel;
+
+    // Bands are whole rows of tiles, so each thread also owns the tiles it summarizes.
+    unsigned int threadCount = m_jobs ? m_jobs->getThreadCount() : m_threadCount ? m_threadCount : std::max(1u, std::thread::hardware_concurrency());
+    unsigned int tileRows = m_height / TILE_HEIGHT;
+    unsigned int bandTileRows = (tileRows + threadCount - 1) / threadCount;
+    if (m_jobs)
+    {
+        m_frameJob = m_jobs->parallelFor("occluder raster", tileRows, bandTileRows, [this](unsigned int begin, unsigned int end) {
+            rasterizeBand(begin * TILE_HEIGHT, end * TILE_HEIGHT);
+        });
+        return;
+    }
+    for (unsigned int tileRow = 0; tileRow < tileRows; tileRow += bandTileRows)
+    {
+        unsigned int rowBegin = tileRow * TILE_HEIGHT;
+        unsigned int rowEnd = std::min(tileRows, tileRow + bandTileRows) * TILE_HEIGHT;
+        m_workers.emplace_back([this, rowBegin, rowEnd]() { rasterizeBand(rowBegin, rowEnd); });
+    }
+}
+
+void OcclusionCuller::finishFrame()
+{
+    if (m_jobs)
+    {
+        m_jobs->wait(m_frameJob);
+        m_frameJob = JobHandle();
+    }
+    for (std::thread& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+}
+
+void OcclusionCuller::rasterizeBand(unsigned int rowBegin, unsigned int rowEnd)
+{
+    std::fill(m_depth.begin() + rowBegin * m_width, m_depth.begin() + rowEnd * m_width, 1.0f);
+
+    // Every band sets up every triangle; setup is a few dozen flops and sharing it would cost
+    // the threads a synchronization point.
+    unsigned int triangleCount = getOccluderTriangleCount();
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        ClipVertex triangle[3];
+        unsigned int outside[6] = {};
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            glm::vec4 clip = m_viewProj * glm::vec4(m_occluderVertices[t * 3 + i], 1.0f);
+            triangle[i] = { clip, (m_occluderEdges[t] & (1 << i)) != 0 };
+            outside[0] += clip.x < -clip.w;
+            outside[1] += clip.x > clip.w;
+            outside[2] += clip.y < -clip.w;
+            outside[3] += clip.y > clip.w;
+            outside[4] += clip.z < -clip.w;
+            outside[5] += clip.z > clip.w;
+        }
+        if (std::find(outside, outside + 6, 3u) != outside + 6)
+            continue;
+
+        ClipVertex polygon[4];
+        unsigned int count = clipNear(triangle, polygon);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            glm::vec4& position = polygon[i].position;
+            float inverseW = 1.0f / position.w;
+            position = glm::vec4((position.x * inverseW * 0.5f + 0.5f) * m_width, (position.y * inverseW * 0.5f + 0.5f) * m_height,
+                position.z * inverseW * 0.5f + 0.5f, 1.0f);
+        }
+        // Fan the polygon; the fan's diagonal is inside it.
+        for (unsigned int i = 2; i < count; i++)
+        {
+            glm::vec3 screen[3] = { glm::vec3(polygon[0].position), glm::vec3(polygon[i - 1].position), glm::vec3(polygon[i].position) };
+            unsigned int interiorEdges = (i == 2 ? polygon[0].interiorEdge : 1) | polygon[i - 1].interiorEdge << 1 | (i + 1 == count ? polygon[i].interiorEdge : 1) << 2;
+            rasterizeTriangle(screen, interiorEdges, rowBegin, rowEnd);
+        }
+    }
+
+    updateTiles(rowBegin, rowEnd);
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec3* screen, unsigned int interiorEdges, unsigned int rowBegin, unsigned int rowEnd)
+{
+    glm::vec3 v0 = screen[0], v1 = screen[1], v2 = screen[2];
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (area == 0.0f)
+        return;
+    if (area < 0.0f)
+    {
+        // Walls are seen from both sides; flip clockwise triangles and their edge flags with them.
+        std::swap(v1, v2);
+        area = -area;
+        interiorEdges = (interiorEdges & 2) | (interiorEdges & 1) << 2 | (interiorEdges & 4) >> 2;
+    }
+
+    float minX = std::max(0.0f, std::min(v0.x, std::min(v1.x, v2.x)));
+    float maxX = std::min(m_width - 1.0f, std::max(v0.x, std::max(v1.x, v2.x)));
+    float minY = std::max((float)rowBegin, std::min(v0.y, std::min(v1.y, v2.y)));
+    float maxY = std::min(rowEnd - 1.0f, std::max(v0.y, std::max(v1.y, v2.y)));
+    if (minX > maxX || minY > maxY)
+        return;
+    unsigned int x0 = (unsigned int)minX, x1 = (unsigned int)maxX;
+    unsigned int y0 = (unsigned int)minY, y1 = (unsigned int)maxY;
+
+    // Edge functions, positive inside: edge k runs from vertex k to vertex k + 1.
+    const glm::vec3* vertices[3] = { &v0, &v1, &v2 };
+    float edgeX[3], edgeY[3], edgeC[3];
+    for (unsigned int e = 0; e < 3; e++)
+    {
+        const glm::vec3& a = *vertices[e];
+        const glm::vec3& b = *vertices[(e + 1) % 3];
+        edgeX[e] = a.y - b.y;
+        edgeY[e] = b.x - a.x;
+        edgeC[e] = a.x * b.y - a.y * b.x;
+    }
+
+    // Depth as a plane over the screen, from the barycentric weights, pushed to the farthest
+    // value within each pixel so the buffer never claims an occluder is nearer than it is.
+    float inverseArea = 1.0f / area;
+    float depthX = (edgeX[1] * v0.z + edgeX[2] * v1.z + edgeX[0] * v2.z) * inverseArea;
+    float depthY = (edgeY[1] * v0.z + edgeY[2] * v1.z + edgeY[0] * v2.z) * inverseArea;
+    float depthC = (edgeC[1] * v0.z + edgeC[2] * v1.z + edgeC[0] * v2.z) * inverseArea + 0.5f * (std::fabs(depthX) + std::fabs(depthY));
+
+    // Outline edges are evaluated at the pixel corner farthest outside, so only pixels the
+    // triangle covers completely pass; edges inside the occluder use the pixel center, or a
+    // quad would leave a line of holes along its diagonal.
+    for (unsigned int e = 0; e < 3; e++)
+    {
+        if (!(interiorEdges & (1 << e)))
+            edgeC[e] -= 0.5f * (std::fabs(edgeX[e]) + std::fabs(edgeY[e]));
+    }
+
+    unsigned int x = x0;
+    for (unsigned int y = y0; y <= y1; y++)
+    {
+        float* row = m_depth.data() + y * m_width;
+        float pixelY = y + 0.5f;
+        float rowEdge0 = edgeY[0] * pixelY + edgeC[0];
+        float rowEdge1 = edgeY[1] * pixelY + edgeC[1];
+        float rowEdge2 = edgeY[2] * pixelY + edgeC[2];
+        float rowDepth = depthY * pixelY + depthC;
+        x = x0;
+
+#if OCCLUSION_AVX2
+        if (m_kernel == Kernel::AVX2)
+        {
+            const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+            __m256 stepX0 = _mm256_set1_ps(edgeX[0]), stepX1 = _mm256_set1_ps(edgeX[1]), stepX2 = _mm256_set1_ps(edgeX[2]);
+            __m256 start0 = _mm256_set1_ps(rowEdge0), start1 = _mm256_set1_ps(rowEdge1), start2 = _mm256_set1_ps(rowEdge2);
+            __m256 stepDepth = _mm256_set1_ps(depthX), startDepth = _mm256_set1_ps(rowDepth);
+            for (x = x0 & ~7u; x <= x1; x += 8)
+            {
+                __m256 pixelX = _mm256_add_ps(_mm256_set1_ps((float)x), laneOffsets);
+                __m256 edge0 = _mm256_add_ps(_mm256_mul_ps(stepX0, pixelX), start0);
+                __m256 edge1 = _mm256_add_ps(_mm256_mul_ps(stepX1, pixelX), start1);
+                __m256 edge2 = _mm256_add_ps(_mm256_mul_ps(stepX2, pixelX), start2);
+                __m256 inside = _mm256_cmp_ps(_mm256_min_ps(edge0, _mm256_min_ps(edge1, edge2)), _mm256_setzero_ps(), _CMP_GE_OQ);
+                if (_mm256_testz_ps(inside, inside))
+                    continue;
+                __m256 depth = _mm256_add_ps(_mm256_mul_ps(stepDepth, pixelX), startDepth);
+                __m256 stored = _mm256_loadu_ps(row + x);
+                _mm256_storeu_ps(row + x, _mm256_blendv_ps(stored, _mm256_min_ps(stored, depth), inside));
+            }
+            continue;
+        }
+#endif
+#if OCCLUSION_SSE
+        if (m_kernel == Kernel::SSE || m_kernel == Kernel::AVX2)
+        {
+            const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            __m128 stepX0 = _mm_set1_ps(edgeX[0]), stepX1 = _mm_set1_ps(edgeX[1]), stepX2 = _mm_set1_ps(edgeX[2]);
+            __m128 start0 = _mm_set1_ps(rowEdge0), start1 = _mm_set1_ps(rowEdge1), start2 = _mm_set1_ps(rowEdge2);
+            __m128 stepDepth = _mm_set1_ps(depthX), startDepth = _mm_set1_ps(rowDepth);
+            for (x = x0 & ~3u; x <= x1; x += 4)
+            {
+                __m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+                __m128 edge0 = _mm_add_ps(_mm_mul_ps(stepX0, pixelX), start0);
+                __m128 edge1 = _mm_add_ps(_mm_mul_ps(stepX1, pixelX), start1);
+                __m128 edge2 = _mm_add_ps(_mm_mul_ps(stepX2, pixelX), start2);
+                __m128 inside = _mm_cmpge_ps(_mm_min_ps(edge0, _mm_min_ps(edge1, edge2)), _mm_setzero_ps());
+                if (!_mm_movemask_ps(inside))
+                    continue;
+                __m128 depth = _mm_add_ps(_mm_mul_ps(stepDepth, pixelX), startDepth);
+                __m128 stored = _mm_loadu_ps(row + x);
+                __m128 nearer = _mm_min_ps(stored, depth);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, stored)));
+            }
+            continue;
+        }
+#endif
+
+        for (; x <= x1; x++)
+        {
+            float pixelX = x + 0.5f;
+            float edge = std::min(edgeX[0] * pixelX + rowEdge0, std::min(edgeX[1] * pixelX + rowEdge1, edgeX[2] * pixelX + rowEdge2));
+            if (edge >= 0.0f)
+                row[x] = std::min(row[x], depthX * pixelX + rowDepth);
+        }
+    }
+}
+
+void OcclusionCuller::updateTiles(unsigned int rowBegin, unsigned int rowEnd)
+{
+    unsigned int tilesX = m_width / TILE_WIDTH;
+    for (unsigned int y = rowBegin; y < rowEnd; y += TILE_HEIGHT)
+    {
+        float* tiles = m_tileDepth.data() + (y / TILE_HEIGHT) * tilesX;
+        for (unsigned int tileX = 0; tileX < tilesX; tileX++)
+        {
+            const float* pixels = m_depth.data() + y * m_width + tileX * TILE_WIDTH;
+            float farthest = 0.0f;
+            for (unsigned int row = 0; row < TILE_HEIGHT; row++)
+            {
+                for (unsigned int column = 0; column < TILE_WIDTH; column++)
+                    farthest = std::max(farthest, pixels[row * m_width + column]);
+            }
+            tiles[tileX] = farthest;
+        }
+    }
+}
+
+bool OcclusionCuller::isTileVisible(unsigned int tileX, unsigned int tileY, unsigned int x0, unsigned int x1, unsigned int y0, unsigned int y1, float depth) const
+{
+    unsigned int left = tileX * TILE_WIDTH;
+    unsigned int firstColumn = std::max(x0, left) - left;
+    unsigned int lastColumn = std::min(x1, left + TILE_WIDTH - 1) - left;
+    unsigned int columns = ((2u << lastColumn) - 1) & ~((1u << firstColumn) - 1);
+    unsigned int firstRow = std::max(y0, tileY * TILE_HEIGHT);
+    unsigned int lastRow = std::min(y1, tileY * TILE_HEIGHT + TILE_HEIGHT - 1);
+
+    for (unsigned int y = firstRow; y <= lastRow; y++)
+    {
+        const float* pixels = m_depth.data() + y * m_width + left;
+#if OCCLUSION_AVX2
+        if (m_kernel == Kernel::AVX2)
+        {
+            __m256 farther = _mm256_cmp_ps(_mm256_loadu_ps(pixels), _mm256_set1_ps(depth), _CMP_GE_OQ);
+            if ((unsigned int)_mm256_movemask_ps(farther) & columns)
+                return true;
+            continue;
+        }
+#endif
+#if OCCLUSION_SSE
+        if (m_kernel == Kernel::SSE || m_kernel == Kernel::AVX2)
+        {
+            __m128 reference = _mm_set1_ps(depth);
+            unsigned int farther = _mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(pixels), reference))
+                | _mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(pixels + 4), reference)) << 4;
+            if (farther & columns)
+                return true;
+            continue;
+        }
+#endif
+        for (unsigned int column = firstColumn; column <= lastColumn; column++)
+        {
+            if (pixels[column] >= depth)
+                return true;
+        }
+    }
+    return false;
+}
+
+bool OcclusionCuller::isVisible(const AABB& box) const
+{
+    float minX = (float)m_width, maxX = 0.0f, minY = (float)m_height, maxY = 0.0f, nearest = 1.0f;
+    // The corners are the min corner plus any of the three box edges, transformed once each.
+    glm::vec3 size = box.max - box.min;
+    glm::vec4 base = m_viewProj * glm::vec4(box.min, 1.0f);
+    glm::vec4 edges[3] = { m_viewProj[0] * size.x, m_viewProj[1] * size.y, m_viewProj[2] * size.z };
+    for (unsigned int corner = 0; corner < 8; corner++)
+    {
+        glm::vec4 clip = base;
+        if (corner & 1)
+            clip += edges[0];
+        if (corner & 2)
+            clip += edges[1];
+        if (corner & 4)
+            clip += edges[2];
+        // Part of the box is behind the near plane, where the buffer knows nothing.
+        if (clip.z < -clip.w || clip.w <= 0.0f)
+            return true;
+        float inverseW = 1.0f / clip.w;
+        float x = (clip.x * inverseW * 0.5f + 0.5f) * m_width;
+        float y = (clip.y * inverseW * 0.5f + 0.5f) * m_height;
+        minX = std::min(minX, x); maxX = std::max(maxX, x);
+        minY = std::min(minY, y); maxY = std::max(maxY, y);
+        nearest = std::min(nearest, clip.z * inverseW * 0.5f + 0.5f);
+    }
+    if (maxX < 0.0f || maxY < 0.0f || minX >= m_width || minY >= m_height)
+        return false;
+
+    unsigned int x0 = (unsigned int)std::max(0.0f, minX), x1 = (unsigned int)std::min(m_width - 1.0f, maxX);
+    unsigned int y0 = (unsigned int)std::max(0.0f, minY), y1 = (unsigned int)std::min(m_height - 1.0f, maxY);
+    unsigned int tilesX = m_width / TILE_WIDTH;
+    for (unsigned int tileY = y0 / TILE_HEIGHT; tileY <= y1 / TILE_HEIGHT; tileY++)
+    {
+        for (unsigned int tileX = x0 / TILE_WIDTH; tileX <= x1 / TILE_WIDTH; tileX++)
+        {
+            // A tile whose farthest occluder is nearer than the box hides all of it it covers.
+            if (m_tileDepth[tileY * tilesX + tileX] >= nearest && isTileVisible(tileX, tileY, x0, x1, y0, y1, nearest))
+                return true;
+        }
+    }
+    return false;
+}
+
+void OcclusionCuller::cull(const std::vector<AABB>& boxes, std::vector<unsigned int>& objects)
+{
+    finishFrame();
+    size_t kept = 0;
+    for (unsigned int object : objects)
+    {
+        if (isVisible(boxes[object]))
+            objects[kept++] = object;
+    }
+    FrameStats::add(Stat::DrawsOccluded, objects.size() - kept);
+    objects.resize(kept);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+#include "glm/glm.hpp"
+#include "Bounds.h"
+#include "JobSystem.h"
+
+// Software occlusion culling. A few designated occluder meshes (walls, floors: big and cheap)
+// are rasterized on the CPU into a small depth buffer, and the bounding boxes of the objects
+// about to be drawn are tested against it, so objects hidden behind the occluders are never
+// submitted. The buffer is summarized into 8x4 pixel tiles holding their farthest depth; a
+// box is tested against the tiles first and only against pixels where a tile cannot decide.
+//
+// Rasterization starts on worker threads in beginFrame, each thread filling one band of rows,
+// so it runs while the calling thread does other work and the GPU is still busy with the
+// previous frame. cull waits for it. Rows are filled 8 pixels at a time with AVX2 or 4 with SSE.
+// Given a JobSystem, the bands are jobs on it instead of threads of the culler's own.
+class OcclusionCuller
+{
+public:
+	enum class Kernel
+	{
+		Scalar,
+		SSE,
+		AVX2,
+		Best
+	};
+
+	static const unsigned int TILE_WIDTH = 8;
+	static const unsigned int TILE_HEIGHT = 4;
+private:
+	unsigned int m_width;
+	unsigned int m_height;
+	std::vector<float> m_depth;
+	std::vector<float> m_tileDepth;
+	// World-space occluder triangles, three vertices each.
+	std::vector<glm::vec3> m_occluderVertices;
+	// Per triangle, a bit per edge that is shared with another triangle of its occluder.
+	std::vector<unsigned char> m_occluderEdges;
+	glm::mat4 m_viewProj;
+	Kernel m_kernel;
+	unsigned int m_threadCount;
+	std::vector<std::thread> m_workers;
+	JobSystem* m_jobs;
+	JobHandle m_frameJob;
+public:
+	// The size is rounded up to whole tiles.
+	OcclusionCuller(unsigned int width = 256, unsigned int height = 128);
+	~OcclusionCuller();
+
+	// Adds a static occluder from indexed triangles. Positions are the first three floats of
+	// each vertex, stride is in bytes, and model places the mesh in the world.
+	void addOccluder(const void* vertices, unsigned int stride, const unsigned int* indices, unsigned int indexCount, const glm::mat4& model);
+	void clearOccluders();
+
+	// Clears the depth buffer and starts rasterizing the occluders as seen through viewProj.
+	void beginFrame(const glm::mat4& viewProj, Kernel kernel = Kernel::Best);
+	// Waits for the rasterization started by beginFrame.
+	void finishFrame();
+
+	// Removes the indices of objects whose boxes are hidden behind the occluders from objects,
+	// keeping the order of the rest, and counts them as occluded draws. Waits for the frame's
+	// rasterization first. Boxes that cross the near plane are always kept.
+	void cull(const std::vector<AABB>& boxes, std::vector<unsigned int>& objects);
+	// Tests one box; only valid after finishFrame.
+	bool isVisible(const AABB& box) const;
+
+	// Rasterizes on up to threadCount threads (0 for one per core).
+	inline void setThreadCount(unsigned int threadCount) { m_threadCount = threadCount; }
+	inline void setJobSystem(JobSystem* jobs) { finishFrame(); m_jobs = jobs; }
+	inline unsigned int getWidth() const { return m_width; }
+	inline unsigned int getHeight() const { return m_height; }
+	inline unsigned int getOccluderTriangleCount() const { return (unsigned int)m_occluderVertices.size() / 3; }
+	// Depth in [0, 1] per pixel, rows bottom to top; 1 where no occluder was drawn.
+	inline const float* getDepth() const { return m_depth.data(); }
+
+	static Kernel getBestKernel();
+	static const char* getKernelName(Kernel kernel);
+private:
+	void rasterizeBand(unsigned int rowBegin, unsigned int rowEnd);
+	void rasterizeTriangle(const glm::vec3* screen, unsigned int interiorEdges, unsigned int rowBegin, unsigned int rowEnd);
+	void updateTiles(unsigned int rowBegin, unsigned int rowEnd);
+	bool isTileVisible(unsigned int tileX, unsigned int tileY, unsigned int x0, unsigned int x1, unsigned int y0, unsigned int y1, float depth) const;
+};
@@ -0,0 +1,79 @@
+#include "OffsetAllocator.h"
+#include "GLDebug.h"
+#include <algorithm>
+
+const unsigned int OffsetAllocator::INVALID;
+
+OffsetAllocator::OffsetAllocator(unsigned int capacity)
+    : m_capacity(capacity), m_used(0)
+{
+    if (capacity > 0)
+        m_freeRanges.push_back({ 0, capacity });
+}
+
+unsigned int OffsetAllocator::allocate(unsigned int size)
+{
+    if (size == 0)
+        return INVALID;
+
+    size_t best = m_freeRanges.size();
+    for (size_t i = 0; i < m_freeRanges.size(); i++)
+    {
+        unsigned int rangeSize = m_freeRanges[i].size;
+        if (rangeSize >= size && (best == m_freeRanges.size() || rangeSize < m_freeRanges[best].size))
+        {
+            best = i;
+            if (rangeSize == size)
+                break;
+        }
+    }
+    if (best == m_freeRanges.size())
+        return INVALID;
+
+    Range& range = m_freeRanges[best];
+    unsigned int offset = range.offset;
+    range.offset += size;
+    range.size -= size;
+    if (range.size == 0)
+        m_freeRanges.erase(m_freeRanges.begin() + best);
+    m_used += size;
+    return offset;
+}
+
+void OffsetAllocator::free(unsigned int offset, unsigned int size)
+{
+    ASSERT(offset + size <= m_capacity && size <= m_used);
+
+    std::vector<Range>::iterator next = std::lower_bound(m_freeRanges.begin(), m_freeRanges.end(), offset,
+        [](const Range& range, unsigned int value) { return range.offset < value; });
+    bool mergesPrevious = next != m_freeRanges.begin() && (next - 1)->offset + (next - 1)->size == offset;
+    bool mergesNext = next != m_freeRanges.end() && offset + size == next->offset;
+
+    if (mergesPrevious && mergesNext)
+    {
+        (next - 1)->size += size + next->size;
+        m_freeRanges.erase(next);
+    }
+    else if (mergesPrevious)
+        (next - 1)->size += size;
+    else if (mergesNext)
+    {
+        next->offset = offset;
+        next->size += size;
+    }
+    else
+        m_freeRanges.insert(next, { offset, size });
+    m_used -= size;
+}
+
+void OffsetAllocator::grow(unsigned int capacity)
+{
+    if (capacity <= m_capacity)
+        return;
+    unsigned int added = capacity - m_capacity;
+    if (!m_freeRanges.empty() && m_freeRanges.back().offset + m_freeRanges.back().size == m_capacity)
+        m_freeRanges.back().size += added;
+    else
+        m_freeRanges.push_back({ m_capacity, added });
+    m_capacity = capacity;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+// Hands out ranges of a fixed-size space, such as the vertices or indices of a shared buffer.
+// Free ranges are kept sorted by offset and merged with their neighbours when released, and
+// allocations take the smallest free range that fits to keep large ranges whole.
+class OffsetAllocator
+{
+private:
+	struct Range
+	{
+		unsigned int offset;
+		unsigned int size;
+	};
+
+	std::vector<Range> m_freeRanges;
+	unsigned int m_capacity;
+	unsigned int m_used;
+public:
+	static const unsigned int INVALID = 0xFFFFFFFF;
+
+	OffsetAllocator(unsigned int capacity);
+
+	// Returns the offset of the new range, or INVALID when no free range is large enough.
+	unsigned int allocate(unsigned int size);
+	void free(unsigned int offset, unsigned int size);
+	// Adds the space between the old and the new capacity to the end of the free list.
+	void grow(unsigned int capacity);
+
+	inline unsigned int getCapacity() const { return m_capacity; }
+	inline unsigned int getUsed() const { return m_used; }
+	inline unsigned int getFreeRangeCount() const { return (unsigned int)m_freeRanges.size(); }
+};
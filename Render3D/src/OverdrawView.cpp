@@ -0,0 +1,123 @@
+#include "OverdrawView.h"
+#include "VertexBufferLayout.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include <iomanip>
+
+static constexpr Uniform<int> u_texture("u_texture");
+
+static const float quadVertices[] = {
+    -1.0f, -1.0f,  0.0f,  0.0f,
+     1.0f, -1.0f,  1.0f,  0.0f,
+     1.0f,  1.0f,  1.0f,  1.0f,
+    -1.0f,  1.0f,  0.0f,  1.0f,
+};
+
+static const unsigned int quadIndices[] = {
+    0, 1, 2,
+    2, 3, 0,
+};
+
+// Heat colors for 0 to MAX_COUNT fragments; anything above saturates at the last one.
+static const unsigned char heatColors[][3] = {
+    {   0,   0,   0 },
+    {   0,   0, 160 },
+    {   0, 120, 255 },
+    {   0, 200,  60 },
+    { 160, 230,   0 },
+    { 255, 220,   0 },
+    { 255, 130,   0 },
+    { 255,  30,   0 },
+    { 255, 255, 255 },
+};
+
+OverdrawView::OverdrawView(int width, int height)
+    : m_width(width), m_height(height), m_texture(0),
+    m_quadVB(quadVertices, sizeof(quadVertices)), m_quadIB(quadIndices, sizeof(quadIndices) / sizeof(unsigned int)),
+    m_shader("res/shaders/Heatmap.shader"), m_counts((size_t)width * height), m_heatmap((size_t)width * height * 4),
+    m_lastFragmentsPerPixel(0.0), m_lastFragmentsPerCoveredPixel(0.0),
+    m_totalFragmentsPerPixel(0.0), m_totalFragmentsPerCoveredPixel(0.0), m_frameCount(0)
+{
+    VertexBufferLayout layout;
+    layout.push<float>(2);
+    layout.push<float>(2);
+    m_quadVA.addBuffer(m_quadVB, layout);
+    m_quadVA.bind();
+    m_quadIB.bind();
+    m_quadVA.unbind();
+
+    m_shader.bind();
+    m_shader.setUniform(u_texture, 0);
+
+    GLCall(glGenTextures(1, &m_texture));
+    GLState::bindTexture(GL_TEXTURE_2D, m_texture);
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+}
+
+OverdrawView::~OverdrawView()
+{
+    GLCall(glDeleteTextures(1, &m_texture));
+    GLState::onTextureDeleted(m_texture);
+}
+
+void OverdrawView::begin()
+{
+    GLCall(glStencilMask(0xFF));
+    GLCall(glClear(GL_STENCIL_BUFFER_BIT));
+    GLCall(glEnable(GL_STENCIL_TEST));
+    GLCall(glStencilFunc(GL_ALWAYS, 0, 0xFF));
+    // Only fragments that survive the depth test are shaded into the frame, so only they count.
+    GLCall(glStencilOp(GL_KEEP, GL_KEEP, GL_INCR));
+}
+
+void OverdrawView::end()
+{
+    GLCall(glDisable(GL_STENCIL_TEST));
+    GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    GLCall(glReadPixels(0, 0, m_width, m_height, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, m_counts.data()));
+
+    unsigned long long fragments = 0;
+    unsigned int coveredPixels = 0;
+    for (size_t i = 0; i < m_counts.size(); i++)
+    {
+        unsigned int count = m_counts[i];
+        fragments += count;
+        coveredPixels += count > 0;
+        const unsigned char* color = heatColors[count < MAX_COUNT ? count : MAX_COUNT];
+        m_heatmap[i * 4 + 0] = color[0];
+        m_heatmap[i * 4 + 1] = color[1];
+        m_heatmap[i * 4 + 2] = color[2];
+        m_heatmap[i * 4 + 3] = 255;
+    }
+    m_lastFragmentsPerPixel = (double)fragments / m_counts.size();
+    m_lastFragmentsPerCoveredPixel = coveredPixels ? (double)fragments / coveredPixels : 0.0;
+    m_totalFragmentsPerPixel += m_lastFragmentsPerPixel;
+    m_totalFragmentsPerCoveredPixel += m_lastFragmentsPerCoveredPixel;
+    m_frameCount++;
+
+    GLState::bindTexture(GL_TEXTURE_2D, 0, m_texture);
+    GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, m_heatmap.data()));
+
+    GLState::setDepthTest(false);
+    GLState::setBlending(false);
+    GLState::setColorWrite(true);
+    m_shader.bind();
+    m_quadVA.bind();
+    m_quadIB.bind();
+    GLCall(glDrawElements(GL_TRIANGLES, m_quadIB.getCount(), GL_UNSIGNED_INT, nullptr));
+    GLState::setDepthTest(true);
+}
+
+void OverdrawView::printReport(std::ostream& os) const
+{
+    if (m_frameCount == 0)
+        return;
+    os << "Overdraw over " << m_frameCount << " frames:\n" << std::fixed << std::setprecision(2)
+        << "  shaded fragments per pixel          " << m_totalFragmentsPerPixel / m_frameCount << "\n"
+        << "  shaded fragments per covered pixel  " << m_totalFragmentsPerCoveredPixel / m_frameCount << "\n" << std::defaultfloat;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+
+// Debug view that counts how many fragments pass the depth test at each pixel, using the
+// stencil buffer as the counter, and replaces the frame with a heatmap of the counts:
+// black for none, then blue, green, yellow and red as the pixel is shaded more often.
+class OverdrawView
+{
+private:
+	static const int MAX_COUNT = 8;
+
+	int m_width, m_height;
+	unsigned int m_texture;
+	VertexArray m_quadVA;
+	VertexBuffer m_quadVB;
+	IndexBuffer m_quadIB;
+	Shader m_shader;
+	std::vector<unsigned char> m_counts;
+	std::vector<unsigned char> m_heatmap;
+	double m_lastFragmentsPerPixel;
+	double m_lastFragmentsPerCoveredPixel;
+	double m_totalFragmentsPerPixel;
+	double m_totalFragmentsPerCoveredPixel;
+	unsigned int m_frameCount;
+public:
+	OverdrawView(int width, int height);
+	~OverdrawView();
+
+	// Call after Renderer::clear and before the scene draws.
+	void begin();
+	// Reads the counts back, accumulates them and draws the heatmap over the frame.
+	void end();
+
+	void printReport(std::ostream& os) const;
+
+	inline double getLastFragmentsPerPixel() const { return m_lastFragmentsPerPixel; }
+	inline double getAverageFragmentsPerPixel() const { return m_frameCount ? m_totalFragmentsPerPixel / m_frameCount : 0.0; }
+};
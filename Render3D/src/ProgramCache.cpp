@@ -0,0 +1,188 @@
+#include "ProgramCache.h"
+#include "Renderer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Bumped whenever the file layout changes, so old files miss.
+static const unsigned int FILE_VERSION = 1;
+static const char FILE_MAGIC[4] = { 'R', '3', 'P', 'B' };
+
+struct FileHeader
+{
+    char magic[4];
+    unsigned int version;
+    unsigned int format;
+    unsigned int size;
+    unsigned long long key;
+    double compileMs;
+};
+
+std::string ProgramCache::s_directory = "shadercache";
+ProgramCache::Stats ProgramCache::s_stats = {};
+
+static unsigned long long hashString(unsigned long long hash, const char* string, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)string[i];
+        hash *= 1099511628211ull;
+    }
+    // The terminator too, so "ab" + "c" and "a" + "bc" differ.
+    return (hash ^ 0xff) * 1099511628211ull;
+}
+
+static void makeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+void ProgramCache::setDirectory(const std::string& directory)
+{
+    s_directory = directory;
+}
+
+bool ProgramCache::isEnabled()
+{
+    // Asked once: every program would otherwise query it.
+    static int formatCount = -1;
+    if (formatCount < 0)
+    {
+        formatCount = 0;
+        if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+        {
+            GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount));
+        }
+    }
+    return formatCount > 0 && !s_directory.empty();
+}
+
+unsigned long long ProgramCache::getKey(const std::string& vertexSource, const std::string& fragmentSource)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    hash = hashString(hash, vertexSource.data(), vertexSource.size());
+    hash = hashString(hash, fragmentSource.data(), fragmentSource.size());
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+    {
+        const char* string = (const char*)glGetString(name);
+        if (string)
+            hash = hashString(hash, string, strlen(string));
+    }
+    return hash;
+}
+
+std::string ProgramCache::getPath(unsigned long long key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", key);
+    return s_directory + name;
+}
+
+bool ProgramCache::load(unsigned long long key, unsigned int program)
+{
+    if (!isEnabled())
+    {
+        s_stats.misses++;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream file(getPath(key), std::ios::binary);
+    FileHeader header;
+    if (!file.read((char*)&header, sizeof(header)) || memcmp(header.magic, FILE_MAGIC, 4) != 0 || header.version != FILE_VERSION || header.key != key)
+    {
+        s_stats.misses++;
+        return false;
+    }
+    std::vector<char> binary(header.size);
+    int linked = GL_FALSE;
+    if (file.read(binary.data(), binary.size()))
+    {
+        GLCall(glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size()));
+        GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+    }
+    if (linked != GL_TRUE)
+    {
+        s_stats.misses++;
+        s_stats.rejected++;
+        return false;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    s_stats.hits++;
+    s_stats.loadMs += ms;
+    s_stats.savedMs += header.compileMs - ms;
+    return true;
+}
+
+void ProgramCache::prepare(unsigned int program)
+{
+    if (isEnabled())
+    {
+        GLCall(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+}
+
+void ProgramCache::store(unsigned long long key, unsigned int program, double compileMs)
+{
+    s_stats.compileMs += compileMs;
+    if (!isEnabled())
+        return;
+
+    int size = 0;
+    GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size));
+    if (size <= 0)
+        return;
+    std::vector<char> binary(size);
+    FileHeader header = { { FILE_MAGIC[0], FILE_MAGIC[1], FILE_MAGIC[2], FILE_MAGIC[3] }, FILE_VERSION, 0, 0, key, compileMs };
+    GLCall(glGetProgramBinary(program, size, &size, &header.format, binary.data()));
+    header.size = (unsigned int)size;
+
+    // Written aside and renamed, so a run that stops halfway leaves no truncated file behind.
+    makeDirectory(s_directory);
+    std::string path = getPath(key);
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        file.write((const char*)&header, sizeof(header));
+        file.write(binary.data(), header.size);
+        if (!file)
+        {
+            std::cout << "Warning: could not write the program binary '" << temporaryPath << "'\n";
+            return;
+        }
+    }
+    std::remove(path.c_str());
+    std::rename(temporaryPath.c_str(), path.c_str());
+}
+
+void ProgramCache::resetStats()
+{
+    s_stats = {};
+}
+
+void ProgramCache::printReport(std::ostream& os)
+{
+    os << "Shader programs: " << s_stats.hits << " from the cache in " << std::fixed << std::setprecision(2) << s_stats.loadMs << " ms, "
+        << s_stats.misses << " compiled in " << s_stats.compileMs << " ms";
+    if (s_stats.rejected)
+        os << " (" << s_stats.rejected << " rejected by the driver)";
+    if (s_stats.hits)
+        os << ", " << s_stats.savedMs << " ms saved";
+    if (!isEnabled())
+        os << (s_directory.empty() ? ", cache off" : ", the driver has no binary formats");
+    os << std::defaultfloat << "\n";
+}
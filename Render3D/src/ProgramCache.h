@@ -0,0 +1,52 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+// Keeps linked programs on disk as glGetProgramBinary returns them, so later runs skip the
+// driver's compiler. Files are named by a 64-bit hash of the program's sources and the GL
+// vendor, renderer and version strings, so an edited shader or another driver misses instead
+// of loading a stale binary. The driver may still reject a binary it wrote, for instance after
+// an update that kept the version string; the program is then compiled again and the file
+// replaced. Nothing is cached when the driver offers no binary formats.
+class ProgramCache
+{
+public:
+	struct Stats
+	{
+		unsigned int hits;
+		unsigned int misses;
+		// Misses where a file was found but the driver would not load it.
+		unsigned int rejected;
+		double loadMs;
+		double compileMs;
+		// What the hits took to compile when they were stored, less what loading them took.
+		double savedMs;
+	};
+private:
+	static std::string s_directory;
+	static Stats s_stats;
+public:
+	// Where the binaries go, "shadercache" by default. Empty turns the cache off.
+	static void setDirectory(const std::string& directory);
+	static inline const std::string& getDirectory() { return s_directory; }
+	// Whether the cache is on and the driver can return and load program binaries.
+	static bool isEnabled();
+
+	// The key of a program made of these stages on the current context's driver.
+	static unsigned long long getKey(const std::string& vertexSource, const std::string& fragmentSource);
+	static std::string getPath(unsigned long long key);
+	// Loads the stored binary into a program that has not been linked. Returns false, and
+	// counts a miss, when there is none or the driver rejects it; the program can still be
+	// compiled and linked as usual then.
+	static bool load(unsigned long long key, unsigned int program);
+	// Marks a program about to be linked so the driver keeps its binary retrievable.
+	static void prepare(unsigned int program);
+	// Writes a linked program's binary with the milliseconds spent in the compile and link calls
+	// and waiting for them, which a later hit counts as saved.
+	static void store(unsigned long long key, unsigned int program, double compileMs);
+
+	static inline const Stats& getStats() { return s_stats; }
+	static void resetStats();
+	static void printReport(std::ostream& os);
+};
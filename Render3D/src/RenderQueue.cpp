@@ -0,0 +1,157 @@
+#include "RenderQueue.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "UniformBuffer.h"
+#include "Scene.h"
+#include "FrameStats.h"
+#include <utility>
+
+static const unsigned int DEPTH_BITS = 24;
+static const unsigned int SHADER_BITS = 10;
+static const unsigned int TEXTURE_BITS = 10;
+static const unsigned int VERTEX_ARRAY_BITS = 12;
+
+static inline unsigned long long field(unsigned int value, unsigned int bits)
+{
+    return value & ((1ull << bits) - 1);
+}
+
+RenderQueue::RenderQueue()
+    : m_view(1.0f), m_farPlane(1.0f), m_sorting(true)
+{
+}
+
+void RenderQueue::beginFrame(const Camera& camera, float farPlane)
+{
+    m_commands.clear();
+    m_items.clear();
+    m_view = camera.view;
+    m_farPlane = farPlane;
+}
+
+void RenderQueue::submit(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const Texture& texture,
+    unsigned int objectOffset, const glm::vec3& position, bool translucent, unsigned int pass)
+{
+    ASSERT(pass < MAX_PASSES);
+
+    float viewDepth = -(m_view * glm::vec4(position, 1.0f)).z / m_farPlane;
+    viewDepth = viewDepth < 0.0f ? 0.0f : viewDepth > 1.0f ? 1.0f : viewDepth;
+    unsigned long long depth = (unsigned long long)(viewDepth * ((1u << DEPTH_BITS) - 1));
+
+    // Ids are masked rather than remapped; a collision only makes the order slightly worse.
+    unsigned long long state = field(shader.getRendererId(), SHADER_BITS) << (TEXTURE_BITS + VERTEX_ARRAY_BITS)
+        | field(texture.getRendererId(), TEXTURE_BITS) << VERTEX_ARRAY_BITS
+        | field(va.getRendererId(), VERTEX_ARRAY_BITS);
+    const unsigned int STATE_BITS = SHADER_BITS + TEXTURE_BITS + VERTEX_ARRAY_BITS;
+
+    unsigned long long key = (unsigned long long)pass << 62;
+    if (translucent)
+        key |= 1ull << 61 | (((1ull << DEPTH_BITS) - 1) - depth) << (61 - DEPTH_BITS) | state << 5;
+    else
+        key |= state << (61 - STATE_BITS) | depth << 5;
+
+    m_items.push_back({ key, (unsigned int)m_commands.size() });
+    m_commands.push_back({ &va, &ib, &shader, &texture, objectOffset, translucent });
+}
+
+void RenderQueue::execute(const Renderer& renderer, const UniformBuffer& uniforms)
+{
+    FrameStats::add(Stat::StateChangesSubmitted, countStateChanges());
+    if (m_sorting)
+        radixSort(m_items, m_scratch);
+    FrameStats::add(Stat::StateChangesSorted, countStateChanges());
+
+    bool depthPrepass = renderer.isDepthPrepassEnabled();
+    if (depthPrepass)
+    {
+        renderer.beginDepthPrepass();
+        draw(renderer, uniforms, true);
+    }
+    renderer.beginOpaquePass(depthPrepass);
+    draw(renderer, uniforms, false);
+    renderer.beginOpaquePass();
+}
+
+void RenderQueue::draw(const Renderer& renderer, const UniformBuffer& uniforms, bool opaqueOnly) const
+{
+    const Texture* texture = nullptr;
+    bool translucent = false;
+    for (const SortItem& item : m_items)
+    {
+        const Command& command = m_commands[item.command];
+        if (command.translucent != translucent)
+        {
+            if (opaqueOnly)
+                continue;
+            // Sorted, this happens once per pass; in submission order it follows the draws.
+            if (command.translucent)
+                renderer.beginTranslucentPass();
+            else
+                renderer.beginOpaquePass(renderer.isDepthPrepassEnabled());
+            translucent = command.translucent;
+        }
+        if (command.texture != texture)
+        {
+            command.texture->bind(0);
+            texture = command.texture;
+        }
+        uniforms.bindBlock<ObjectBlock>(command.objectOffset);
+        renderer.draw(*command.va, *command.ib, *command.shader);
+    }
+}
+
+unsigned int RenderQueue::countStateChanges() const
+{
+    unsigned int changes = 0;
+    const Command* previous = nullptr;
+    for (const SortItem& item : m_items)
+    {
+        const Command& command = m_commands[item.command];
+        if (!previous || command.shader != previous->shader)
+            changes++;
+        if (!previous || command.texture != previous->texture)
+            changes++;
+        if (!previous || command.va != previous->va)
+            changes++;
+        previous = &command;
+    }
+    return changes;
+}
+
+void RenderQueue::radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch)
+{
+    const size_t count = items.size();
+    if (count < 2)
+        return;
+    scratch.resize(count);
+
+    unsigned int histograms[8][256] = {};
+    for (const SortItem& item : items)
+    {
+        for (unsigned int digit = 0; digit < 8; digit++)
+            histograms[digit][(item.key >> (digit * 8)) & 0xFF]++;
+    }
+
+    SortItem* source = items.data();
+    SortItem* destination = scratch.data();
+    for (unsigned int digit = 0; digit < 8; digit++)
+    {
+        unsigned int* histogram = histograms[digit];
+        if (histogram[(source[0].key >> (digit * 8)) & 0xFF] == count)
+            continue;
+
+        unsigned int offset = 0;
+        for (unsigned int bucket = 0; bucket < 256; bucket++)
+        {
+            unsigned int bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+        for (size_t i = 0; i < count; i++)
+            destination[histogram[(source[i].key >> (digit * 8)) & 0xFF]++] = source[i];
+        std::swap(source, destination);
+    }
+
+    if (source != items.data())
+        items.swap(scratch);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+
+class Renderer;
+class VertexArray;
+class IndexBuffer;
+class Shader;
+class Texture;
+class UniformBuffer;
+struct Camera;
+
+// Collects a frame's draws instead of issuing them immediately, sorts them by a packed 64-bit
+// key and then executes them, so state changes follow their cost rather than code order.
+//
+// Opaque keys, from the most significant bit:  pass:2 | 0:1 | shader:10 | texture:10 | vertex array:12 | depth:24 | 0:5
+// Translucent keys:                            pass:2 | 1:1 | far-to-near depth:24 | shader:10 | texture:10 | vertex array:12 | 0:5
+//
+// Opaque draws are grouped by state and run front to back within a group; translucent draws
+// run strictly back to front. All storage is kept between frames, so once the queue has seen
+// its largest frame, submitting and sorting allocate nothing.
+class RenderQueue
+{
+public:
+	static const unsigned int MAX_PASSES = 4;
+
+	struct SortItem
+	{
+		unsigned long long key;
+		unsigned int command;
+	};
+private:
+	struct Command
+	{
+		const VertexArray* va;
+		const IndexBuffer* ib;
+		const Shader* shader;
+		const Texture* texture;
+		unsigned int objectOffset;
+		bool translucent;
+	};
+
+	std::vector<Command> m_commands;
+	std::vector<SortItem> m_items;
+	std::vector<SortItem> m_scratch;
+	glm::mat4 m_view;
+	float m_farPlane;
+	bool m_sorting;
+public:
+	RenderQueue();
+
+	// Starts a frame. Depth is measured along the camera's view direction and quantized over [0, farPlane].
+	void beginFrame(const Camera& camera, float farPlane);
+	// objectOffset is where the draw's ObjectBlock lives in the uniform buffer passed to execute.
+	void submit(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const Texture& texture,
+		unsigned int objectOffset, const glm::vec3& position, bool translucent = false, unsigned int pass = 0);
+	// Sorts the frame's draws (unless sorting is disabled), records how many state changes the
+	// submitted and the sorted orders cost, and draws them. Opaque draws run without blending,
+	// after a depth prepass when the renderer asks for one; translucent draws blend.
+	void execute(const Renderer& renderer, const UniformBuffer& uniforms);
+
+	// With sorting disabled draws run in submission order, for comparing the two.
+	inline void setSorting(bool sorting) { m_sorting = sorting; }
+	inline unsigned int getSize() const { return (unsigned int)m_commands.size(); }
+	inline size_t getCapacity() const { return m_commands.capacity(); }
+
+	// Least significant byte first radix sort of the items' keys, using scratch as the second
+	// buffer. Passes over bytes that every key shares are skipped.
+	static void radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch);
+private:
+	unsigned int countStateChanges() const;
+	void draw(const Renderer& renderer, const UniformBuffer& uniforms, bool opaqueOnly) const;
+};
@@ -1,30 +1,174 @@
 #include "Renderer.h"
-#include <iostream>
+#include "FrameStats.h"
+#include "GLState.h"
+#include "MeshBatch.h"
+#include "Texture.h"
+#include "SoftwareRasterizer.h"
 
-void GLClearError()
+Renderer::Renderer() : m_depthPrepass(false), m_software(nullptr)
 {
-    while (glGetError() != GL_NO_ERROR);
 }
 
-bool GLLogCall(const char* function, const char* file, int line)
+void Renderer::beginFrame()
 {
-    while (GLenum error = glGetError())
+    GLDebug::beginFrame();
+    GLState::setDepthTest(true);
+    beginOpaquePass();
+}
+
+void Renderer::endFrame()
+{
+    if (m_software)
+        m_software->resolve();
+    FrameStats::endFrame();
+}
+
+void Renderer::clear() const
+{
+    if (m_software)
     {
-        std::cout << "[OpenGL Error] (" << error << "): " << function << " " << file << ":" << line << "\n";
-        return false;
+        m_software->clear();
+        return;
     }
-    return true;
+    GLState::setColorWrite(true);
+    GLState::setDepthWrite(true);
+    GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 }
 
-void Renderer::clear() const
+void Renderer::beginDepthPrepass() const
 {
-    GLCall(glClear(GL_COLOR_BUFFER_BIT));
+    if (m_software)
+    {
+        m_software->setPassState({ false, true, false, false });
+        return;
+    }
+    GLState::setBlending(false);
+    GLState::setColorWrite(false);
+    GLState::setDepthWrite(true);
+    GLState::setDepthFunc(GL_LESS);
+    // Keeps the overdraw view counting only the fragments that are shaded for color.
+    GLCall(glStencilMask(0x00));
+}
+
+void Renderer::beginOpaquePass(bool afterDepthPrepass) const
+{
+    if (m_software)
+    {
+        m_software->setPassState({ true, !afterDepthPrepass, afterDepthPrepass, false });
+        return;
+    }
+    GLState::setBlending(false);
+    GLState::setColorWrite(true);
+    GLState::setDepthWrite(!afterDepthPrepass);
+    GLState::setDepthFunc(afterDepthPrepass ? GL_LEQUAL : GL_LESS);
+    GLCall(glStencilMask(0xFF));
+}
+
+void Renderer::beginTranslucentPass() const
+{
+    if (m_software)
+    {
+        m_software->setPassState({ true, false, false, true });
+        return;
+    }
+    GLState::setBlending(true);
+    GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    GLState::setColorWrite(true);
+    GLState::setDepthWrite(false);
+    GLState::setDepthFunc(GL_LESS);
+    GLCall(glStencilMask(0xFF));
 }
 
 void Renderer::draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
 {
+    draw(va, ib, shader, 0, ib.getCount());
+}
+
+void Renderer::draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int firstIndex, unsigned int indexCount) const
+{
+    if (!shader.isReady())
+    {
+        FrameStats::add(Stat::DrawsSkipped);
+        return;
+    }
+    if (m_software)
+    {
+        m_software->draw(va, ib, shader, Texture::getBound(0), firstIndex, indexCount);
+        FrameStats::add(Stat::DrawCalls);
+        return;
+    }
     shader.bind();
     va.bind();
     ib.bind();
-    GLCall(glDrawElements(GL_TRIANGLES, ib.getCount(), GL_UNSIGNED_INT, nullptr));
+    GLCall(glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (const void*)((size_t)firstIndex * sizeof(unsigned int))));
+    FrameStats::add(Stat::DrawCalls);
+}
+
+void Renderer::drawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const
+{
+    if (!shader.isReady())
+    {
+        FrameStats::add(Stat::DrawsSkipped);
+        return;
+    }
+    if (m_software)
+    {
+        m_software->draw(va, ib, shader, Texture::getBound(0), 0, ib.getCount(), 0, instanceCount);
+        FrameStats::add(Stat::DrawCalls);
+        return;
+    }
+    shader.bind();
+    va.bind();
+    ib.bind();
+    GLCall(glDrawElementsInstanced(GL_TRIANGLES, ib.getCount(), GL_UNSIGNED_INT, nullptr, instanceCount));
+    FrameStats::add(Stat::DrawCalls);
+}
+
+void Renderer::drawBatch(const MeshBatch& batch) const
+{
+    if (m_software)
+    {
+        const MeshArena& arena = batch.getArena();
+        for (const MeshBatch::Group& group : batch.getGroups())
+        {
+            if (!group.shader->isReady())
+            {
+                FrameStats::add(Stat::DrawsSkipped);
+                continue;
+            }
+            for (unsigned int i = group.first; i < group.first + group.count; i++)
+            {
+                const MeshRange& mesh = batch.getMesh(i);
+                m_software->draw(arena.getVertexArray(), arena.getIndexBuffer(), *group.shader, group.texture, mesh.firstIndex, mesh.indexCount, (int)mesh.baseVertex);
+            }
+            FrameStats::add(Stat::DrawCalls);
+        }
+        return;
+    }
+
+    batch.getArena().bind();
+    if (batch.isIndirect())
+        GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.getIndirectBuffer());
+
+    for (const MeshBatch::Group& group : batch.getGroups())
+    {
+        if (!group.shader->isReady())
+        {
+            FrameStats::add(Stat::DrawsSkipped);
+            continue;
+        }
+        group.shader->bind();
+        group.texture->bind(0);
+        if (batch.isIndirect())
+        {
+            GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)(size_t)batch.getIndirectOffset(group), group.count, 0));
+        }
+        else
+        {
+            // GLEW declares the argument arrays non-const; the driver only reads them.
+            GLCall(glMultiDrawElementsBaseVertex(GL_TRIANGLES, const_cast<int*>(batch.getCounts() + group.first), GL_UNSIGNED_INT,
+                const_cast<void**>(batch.getIndexOffsets() + group.first), group.count, const_cast<int*>(batch.getBaseVertices() + group.first)));
+        }
+        FrameStats::add(Stat::DrawCalls);
+    }
 }
\ No newline at end of file
@@ -1,21 +1,48 @@
 #pragma once
 
 #include <GL/glew.h>
+#include "GLDebug.h"
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
 
-#define ASSERT(x) if (!(x)) __debugbreak();
-#define GLCall(x) GLClearError();\
-    x;\
-    ASSERT(GLLogCall(#x, __FILE__, __LINE__))
-
-void GLClearError();
-bool GLLogCall(const char* function, const char* file, int line);
+class MeshBatch;
+class SoftwareRasterizer;
 
 class Renderer
 {
+private:
+    bool m_depthPrepass;
+    SoftwareRasterizer* m_software;
 public:
+    Renderer();
+
+    // Resets the frame to the opaque pass state: depth test and writes on, blending off.
+    void beginFrame();
+    void endFrame();
+
     void clear() const;
+
+    // Lays down depth only, so the opaque pass that follows shades each pixel once.
+    void beginDepthPrepass() const;
+    // afterDepthPrepass keeps the prepass depth and only shades fragments that match it.
+    void beginOpaquePass(bool afterDepthPrepass = false) const;
+    // Blends over the opaque result and tests against its depth without writing it.
+    void beginTranslucentPass() const;
+
+    // Whether draws that go through a RenderQueue get a depth prepass.
+    inline void setDepthPrepass(bool enabled) { m_depthPrepass = enabled; }
+    inline bool isDepthPrepassEnabled() const { return m_depthPrepass; }
+    // Sends clears, pass state and draws to a CPU rasterizer instead of GL, or back to GL with
+    // nullptr. endFrame resolves the rasterizer's frame.
+    inline void setSoftwareRasterizer(SoftwareRasterizer* rasterizer) { m_software = rasterizer; }
+    inline SoftwareRasterizer* getSoftwareRasterizer() const { return m_software; }
+
+    // Draws with a program that is not ready yet are skipped and counted.
     void draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+    // Draws indexCount indices from firstIndex, such as one submesh or level of detail of a Mesh.
+    void draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int firstIndex, unsigned int indexCount) const;
+    void drawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const;
+    // Issues one multi-draw per shader and texture group of the batch.
+    void drawBatch(const MeshBatch& batch) const;
 };
\ No newline at end of file
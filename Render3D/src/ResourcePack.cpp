@@ -0,0 +1,485 @@
+#include "ResourcePack.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// Bumped whenever the file layout changes, so old packs are not mounted.
+static const unsigned int PACK_VERSION = 1;
+static const char PACK_MAGIC[4] = { 'R', '3', 'R', 'P' };
+static const size_t PAGE_ALIGNMENT = 4096;
+static const size_t SMALL_ALIGNMENT = 16;
+// Entries at least this large start on a page of their own.
+static const size_t PAGE_ALIGNED_SIZE = 64 * 1024;
+
+static const unsigned int LZ_MIN_MATCH = 4;
+static const unsigned int LZ_HASH_BITS = 14;
+static const size_t LZ_MAX_OFFSET = 65535;
+
+static_assert(sizeof(ResourcePack::Header) == 32 && sizeof(ResourcePack::Entry) == 56, "The pack index is read in place and must not change size");
+
+std::unique_ptr<ResourcePack> ResourcePack::s_mounted;
+std::atomic<unsigned int> ResourcePack::s_mapped(0), ResourcePack::s_expanded(0), ResourcePack::s_loose(0);
+std::atomic<unsigned long long> ResourcePack::s_mappedBytes(0), ResourcePack::s_readBytes(0);
+
+static std::vector<unsigned char> readFile(const std::string& path, bool& found)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    found = (bool)file;
+    std::vector<unsigned char> data;
+    if (!found)
+        return data;
+    data.resize((size_t)file.tellg());
+    file.seekg(0);
+    file.read((char*)data.data(), (std::streamsize)data.size());
+    found = (bool)file;
+    return data;
+}
+
+// Every file under the directory, recursively, with '/' between the parts of its path.
+static void listFiles(const std::string& directory, std::vector<std::string>& files)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA((directory + "/*").c_str(), &found);
+    if (search == INVALID_HANDLE_VALUE)
+        return;
+    do
+    {
+        std::string name = found.cFileName;
+        if (name == "." || name == "..")
+            continue;
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            listFiles(directory + "/" + name, files);
+        else
+            files.push_back(directory + "/" + name);
+    } while (FindNextFileA(search, &found));
+    FindClose(search);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (!dir)
+        return;
+    while (dirent* found = readdir(dir))
+    {
+        std::string name = found->d_name;
+        if (name == "." || name == "..")
+            continue;
+        std::string path = directory + "/" + name;
+        struct stat status;
+        if (stat(path.c_str(), &status) != 0)
+            continue;
+        if (S_ISDIR(status.st_mode))
+            listFiles(path, files);
+        else if (S_ISREG(status.st_mode))
+            files.push_back(path);
+    }
+    closedir(dir);
+#endif
+}
+
+ResourcePack::ResourcePack(const std::string& path)
+    : m_file(path), m_header(nullptr), m_entries(nullptr), m_names(nullptr), m_valid(false)
+{
+    const unsigned char* data = m_file.getData();
+    size_t size = m_file.getSize();
+    if (size < sizeof(Header))
+        return;
+    m_header = (const Header*)data;
+    if (memcmp(m_header->magic, PACK_MAGIC, 4) != 0 || m_header->version != PACK_VERSION)
+        return;
+    size_t indexEnd = sizeof(Header) + (size_t)m_header->entryCount * sizeof(Entry);
+    if (indexEnd > size || m_header->namesOffset < indexEnd || m_header->namesOffset > size
+        || m_header->namesSize > size - m_header->namesOffset)
+        return;
+    m_entries = (const Entry*)(data + sizeof(Header));
+    m_names = (const char*)data + m_header->namesOffset;
+    for (unsigned int i = 0; i < m_header->entryCount; i++)
+    {
+        const Entry& entry = m_entries[i];
+        if (entry.storedSize > size || entry.offset > size - entry.storedSize || (unsigned long long)entry.nameOffset + entry.nameLength > m_header->namesSize)
+            return;
+        // A stored entry is read as a span of size bytes, which has to be what is stored.
+        if (entry.compression == Compression::None && entry.size != entry.storedSize)
+            return;
+    }
+    m_valid = true;
+}
+
+std::string ResourcePack::normalize(const std::string& path)
+{
+    std::string name = path;
+    std::replace(name.begin(), name.end(), '\\', '/');
+    while (name.compare(0, 2, "./") == 0)
+        name.erase(0, 2);
+    return name;
+}
+
+const ResourcePack::Entry* ResourcePack::find(const std::string& path) const
+{
+    if (!m_valid)
+        return nullptr;
+    std::string name = normalize(path);
+    unsigned long long nameHash = hash((const unsigned char*)name.data(), name.size());
+    const Entry* end = m_entries + m_header->entryCount;
+    const Entry* entry = std::lower_bound(m_entries, end, nameHash, [](const Entry& entry, unsigned long long value) {
+        return entry.nameHash < value;
+    });
+    // Names that share a hash sit next to each other.
+    for (; entry != end && entry->nameHash == nameHash; entry++)
+    {
+        if (entry->nameLength == name.size() && memcmp(m_names + entry->nameOffset, name.data(), name.size()) == 0)
+            return entry;
+    }
+    return nullptr;
+}
+
+Resource ResourcePack::read(const Entry& entry) const
+{
+    const unsigned char* stored = m_file.getData() + entry.offset;
+    if (entry.compression == Compression::None)
+    {
+        s_mapped++;
+        s_mappedBytes += entry.size;
+        return Resource(stored, (size_t)entry.size);
+    }
+
+    std::vector<unsigned char> data((size_t)entry.size);
+    if (entry.compression != Compression::LZ || !decompressLZ(stored, (size_t)entry.storedSize, data.data(), data.size()))
+    {
+        std::cout << "Warning: the pack entry '" << getName(entry) << "' is corrupt\n";
+        return Resource();
+    }
+    s_expanded++;
+    s_readBytes += entry.size;
+    return Resource(std::move(data));
+}
+
+bool ResourcePack::verify() const
+{
+    bool valid = m_valid;
+    for (unsigned int i = 0; i < getEntryCount(); i++)
+    {
+        Resource resource = read(m_entries[i]);
+        if (!resource.isValid() || hash(resource.getData(), resource.getSize()) != m_entries[i].contentHash)
+        {
+            std::cout << "Warning: the pack entry '" << getName(m_entries[i]) << "' does not match its hash\n";
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+bool ResourcePack::mount(const std::string& path)
+{
+    std::unique_ptr<ResourcePack> pack(new ResourcePack(path));
+    s_mounted.reset(pack->isValid() ? pack.release() : nullptr);
+    return s_mounted != nullptr;
+}
+
+void ResourcePack::unmount()
+{
+    s_mounted.reset();
+}
+
+Resource ResourcePack::load(const std::string& path)
+{
+    if (s_mounted)
+    {
+        if (const Entry* entry = s_mounted->find(path))
+            return s_mounted->read(*entry);
+    }
+
+    bool found = false;
+    std::vector<unsigned char> data = readFile(path, found);
+    if (!found)
+        return Resource();
+    s_loose++;
+    s_readBytes += data.size();
+    return Resource(std::move(data));
+}
+
+Resource ResourcePack::map(const std::string& path)
+{
+    if (s_mounted)
+    {
+        if (const Entry* entry = s_mounted->find(path))
+            return s_mounted->read(*entry);
+    }
+
+    std::unique_ptr<MappedFile> file(new MappedFile(path));
+    if (!file->isValid())
+        return Resource();
+    s_loose++;
+    s_mappedBytes += file->getSize();
+    return Resource(std::move(file));
+}
+
+unsigned long long ResourcePack::getContentHash(const std::string& path)
+{
+    const Entry* entry = s_mounted ? s_mounted->find(path) : nullptr;
+    return entry && entry->size ? entry->contentHash : 0;
+}
+
+unsigned long long ResourcePack::hash(const unsigned char* data, size_t size)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool ResourcePack::build(const std::string& directory, const std::string& output, std::ostream& log)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> paths;
+    listFiles(normalize(directory), paths);
+    if (paths.empty())
+    {
+        log << "No files under '" << directory << "'\n";
+        return false;
+    }
+
+    struct Pending
+    {
+        std::string name;
+        std::vector<unsigned char> stored;
+        Entry entry;
+    };
+    std::vector<Pending> pending(paths.size());
+    std::string names;
+    size_t originalBytes = 0;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        Pending& file = pending[i];
+        bool found = false;
+        std::vector<unsigned char> data = readFile(paths[i], found);
+        if (!found)
+        {
+            log << "Could not read '" << paths[i] << "'\n";
+            return false;
+        }
+        file.name = paths[i];
+        file.entry = {};
+        file.entry.nameHash = hash((const unsigned char*)file.name.data(), file.name.size());
+        file.entry.contentHash = hash(data.data(), data.size());
+        file.entry.size = data.size();
+        file.entry.nameOffset = (unsigned int)names.size();
+        file.entry.nameLength = (unsigned int)file.name.size();
+        file.entry.alignment = (unsigned int)(data.size() >= PAGE_ALIGNED_SIZE ? PAGE_ALIGNMENT : SMALL_ALIGNMENT);
+        names += file.name;
+        originalBytes += data.size();
+
+        std::vector<unsigned char> compressed = compressLZ(data.data(), data.size());
+        if (compressed.size() <= data.size() - data.size() / 4 && !data.empty())
+        {
+            file.entry.compression = Compression::LZ;
+            file.stored.swap(compressed);
+        }
+        else
+        {
+            file.entry.compression = Compression::None;
+            file.stored.swap(data);
+        }
+        file.entry.storedSize = file.stored.size();
+    }
+    std::sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+        return a.entry.nameHash < b.entry.nameHash;
+    });
+
+    Header header = { { PACK_MAGIC[0], PACK_MAGIC[1], PACK_MAGIC[2], PACK_MAGIC[3] }, PACK_VERSION, (unsigned int)pending.size(), 0, 0, names.size() };
+    header.namesOffset = sizeof(Header) + pending.size() * sizeof(Entry);
+    unsigned long long offset = header.namesOffset + names.size();
+    for (Pending& file : pending)
+    {
+        offset = (offset + file.entry.alignment - 1) / file.entry.alignment * file.entry.alignment;
+        file.entry.offset = offset;
+        offset += file.entry.storedSize;
+    }
+
+    // Written aside and renamed, like the program cache, so a failed build leaves no broken pack.
+    std::string temporaryPath = output + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        file.write((const char*)&header, sizeof(header));
+        for (const Pending& entry : pending)
+            file.write((const char*)&entry.entry, sizeof(Entry));
+        file.write(names.data(), names.size());
+        unsigned long long position = header.namesOffset + names.size();
+        const char padding[PAGE_ALIGNMENT] = {};
+        for (const Pending& entry : pending)
+        {
+            file.write(padding, (std::streamsize)(entry.entry.offset - position));
+            file.write((const char*)entry.stored.data(), entry.stored.size());
+            position = entry.entry.offset + entry.entry.storedSize;
+        }
+        if (!file)
+        {
+            log << "Could not write '" << temporaryPath << "'\n";
+            return false;
+        }
+    }
+    std::remove(output.c_str());
+    std::rename(temporaryPath.c_str(), output.c_str());
+
+    unsigned int compressed = 0;
+    for (const Pending& entry : pending)
+        compressed += entry.entry.compression != Compression::None;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    log << "Packed " << pending.size() << " files (" << compressed << " compressed) from '" << directory << "' into '" << output << "': "
+        << originalBytes << " bytes in a file of " << offset << ", in " << std::fixed << std::setprecision(2) << ms << " ms" << std::defaultfloat << "\n";
+    return true;
+}
+
+static inline unsigned int read32(const unsigned char* data)
+{
+    unsigned int value;
+    memcpy(&value, data, 4);
+    return value;
+}
+
+// A length past the token's 4 bits continues in bytes of up to 255.
+static void writeLength(std::vector<unsigned char>& output, size_t length)
+{
+    for (; length >= 255; length -= 255)
+        output.push_back(255);
+    output.push_back((unsigned char)length);
+}
+
+static bool readLength(const unsigned char*& data, const unsigned char* end, size_t& length)
+{
+    unsigned char byte;
+    do
+    {
+        if (data == end)
+            return false;
+        byte = *data++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+static void writeSequence(std::vector<unsigned char>& output, const unsigned char* literals, size_t literalCount, size_t offset, size_t matchLength)
+{
+    size_t matchCode = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+    output.push_back((unsigned char)((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15)));
+    if (literalCount >= 15)
+        writeLength(output, literalCount - 15);
+    output.insert(output.end(), literals, literals + literalCount);
+    if (!matchLength)
+        return;
+    output.push_back((unsigned char)(offset & 0xFF));
+    output.push_back((unsigned char)(offset >> 8));
+    if (matchCode >= 15)
+        writeLength(output, matchCode - 15);
+}
+
+std::vector<unsigned char> ResourcePack::compressLZ(const unsigned char* data, size_t size)
+{
+    std::vector<unsigned char> output;
+    output.reserve(size + size / 255 + 16);
+    // The last position each 4-byte sequence was seen at, plus one so 0 means none.
+    std::vector<size_t> table((size_t)1 << LZ_HASH_BITS, 0);
+    size_t anchor = 0;
+    size_t position = 0;
+    while (position + LZ_MIN_MATCH <= size)
+    {
+        unsigned int sequence = read32(data + position);
+        size_t slot = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        size_t candidate = table[slot];
+        table[slot] = position + 1;
+        if (candidate && position + 1 - candidate <= LZ_MAX_OFFSET && read32(data + candidate - 1) == sequence)
+        {
+            candidate--;
+            size_t length = LZ_MIN_MATCH;
+            while (position + length < size && data[candidate + length] == data[position + length])
+                length++;
+            writeSequence(output, data + anchor, position - anchor, position - candidate, length);
+            position += length;
+            anchor = position;
+        }
+        else
+        {
+            position++;
+        }
+    }
+    // The last sequence is literals only.
+    writeSequence(output, data + anchor, size - anchor, 0, 0);
+    return output;
+}
+
+bool ResourcePack::decompressLZ(const unsigned char* data, size_t dataSize, unsigned char* output, size_t size)
+{
+    const unsigned char* end = data + dataSize;
+    unsigned char* out = output;
+    unsigned char* outEnd = output + size;
+    while (data < end)
+    {
+        unsigned char token = *data++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(data, end, literalCount))
+            return false;
+        if ((size_t)(end - data) < literalCount || (size_t)(outEnd - out) < literalCount)
+            return false;
+        memcpy(out, data, literalCount);
+        data += literalCount;
+        out += literalCount;
+        if (data == end)
+            break;
+
+        if (end - data < 2)
+            return false;
+        size_t offset = data[0] | ((size_t)data[1] << 8);
+        data += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(data, end, length))
+            return false;
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(out - output) || (size_t)(outEnd - out) < length)
+            return false;
+        // Byte by byte, since a match may overlap the bytes it is writing.
+        const unsigned char* match = out - offset;
+        for (size_t i = 0; i < length; i++)
+            out[i] = match[i];
+        out += length;
+    }
+    return out == outEnd;
+}
+
+ResourcePack::Stats ResourcePack::getStats()
+{
+    return { s_mapped.load(), s_expanded.load(), s_loose.load(), s_mappedBytes.load(), s_readBytes.load() };
+}
+
+void ResourcePack::resetStats()
+{
+    s_mapped = 0;
+    s_expanded = 0;
+    s_loose = 0;
+    s_mappedBytes = 0;
+    s_readBytes = 0;
+}
+
+void ResourcePack::printReport(std::ostream& os)
+{
+    Stats stats = getStats();
+    os << "Resources: ";
+    if (s_mounted)
+        os << stats.mapped << " mapped in place (" << stats.mappedBytes / 1024 << " KB), " << stats.expanded << " expanded, ";
+    else
+        os << "no pack mounted, ";
+    os << stats.loose << " loose files read (" << stats.readBytes / 1024 << " KB read or expanded)\n";
+}
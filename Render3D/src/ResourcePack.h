@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// A resource's bytes. Stored entries of a mounted pack are a span of its mapping, which stays
+// valid until the pack is unmounted; loose files and compressed entries are read or expanded
+// into a buffer of the resource's own, or mapped by the resource when asked for with map.
+class Resource
+{
+private:
+	std::vector<unsigned char> m_buffer;
+	std::unique_ptr<MappedFile> m_file;
+	const unsigned char* m_data;
+	size_t m_size;
+	bool m_valid;
+	bool m_mapped;
+public:
+	Resource() : m_data(nullptr), m_size(0), m_valid(false), m_mapped(false) {}
+	Resource(const unsigned char* mapped, size_t size) : m_data(mapped), m_size(size), m_valid(true), m_mapped(true) {}
+	explicit Resource(std::vector<unsigned char>&& buffer)
+		: m_buffer(std::move(buffer)), m_data(m_buffer.data()), m_size(m_buffer.size()), m_valid(true), m_mapped(false) {}
+	explicit Resource(std::unique_ptr<MappedFile> file)
+		: m_file(std::move(file)), m_data(m_file->getData()), m_size(m_file->getSize()), m_valid(true), m_mapped(false) {}
+
+	Resource(Resource&&) = default;
+	Resource& operator=(Resource&&) = default;
+	Resource(const Resource&) = delete;
+	Resource& operator=(const Resource&) = delete;
+
+	// False when there is neither a pack entry nor a file by the name.
+	inline bool isValid() const { return m_valid; }
+	// Whether the bytes are in the mounted pack's mapping, and so outlive the resource.
+	inline bool isMapped() const { return m_mapped; }
+	inline const unsigned char* getData() const { return m_data; }
+	inline const char* getText() const { return (const char*)m_data; }
+	inline size_t getSize() const { return m_size; }
+};
+
+// One file holding every resource under res/, so startup maps a single file instead of
+// opening each by its path. An index of fixed-size entries sorted by name hash follows the
+// header, then the names, then the data. Each entry records its offset, its stored and
+// original sizes, a 64-bit FNV-1a hash of its contents, how it is compressed and the alignment
+// its offset keeps. Large entries start on a page and the rest on 16 bytes, so a mapped entry
+// can be handed to GL, stb_image or a parser in place.
+//
+// Entries are stored as they are unless LZ compression takes at least a quarter off, which in
+// practice means text: images are compressed already. A compressed entry is expanded into a
+// buffer when loaded.
+//
+// Loaders go through load, which looks in the mounted pack and falls back to the loose file,
+// so a development tree without a pack works unchanged and a file missing from the pack is
+// still found. Loads may run on any thread, but not while a pack is mounted or unmounted, and
+// nothing may hold a span of a pack once it is unmounted.
+class ResourcePack
+{
+public:
+	enum class Compression : unsigned int
+	{
+		None,
+		// LZ77 with byte-aligned sequences in the LZ4 block layout: a token of literal and
+		// match lengths, the literals, and a 16-bit offset back into the output.
+		LZ
+	};
+
+	struct Header
+	{
+		char magic[4];
+		unsigned int version;
+		unsigned int entryCount;
+		unsigned int reserved;
+		unsigned long long namesOffset;
+		unsigned long long namesSize;
+	};
+
+	struct Entry
+	{
+		unsigned long long nameHash;
+		unsigned long long contentHash;
+		unsigned long long offset;
+		unsigned long long storedSize;
+		unsigned long long size;
+		unsigned int nameOffset;
+		unsigned int nameLength;
+		Compression compression;
+		unsigned int alignment;
+	};
+
+	struct Stats
+	{
+		// Loads answered by a span of the mapping, by expanding a compressed entry, and by
+		// reading a loose file.
+		unsigned int mapped;
+		unsigned int expanded;
+		unsigned int loose;
+		unsigned long long mappedBytes;
+		unsigned long long readBytes;
+	};
+private:
+	MappedFile m_file;
+	const Header* m_header;
+	const Entry* m_entries;
+	const char* m_names;
+	bool m_valid;
+
+	static std::unique_ptr<ResourcePack> s_mounted;
+	static std::atomic<unsigned int> s_mapped, s_expanded, s_loose;
+	static std::atomic<unsigned long long> s_mappedBytes, s_readBytes;
+public:
+	explicit ResourcePack(const std::string& path);
+
+	// False when the file is missing, is not a pack, or its index runs past its end.
+	inline bool isValid() const { return m_valid; }
+	inline unsigned int getEntryCount() const { return m_valid ? m_header->entryCount : 0; }
+	inline const Entry& getEntry(unsigned int index) const { return m_entries[index]; }
+	inline std::string getName(const Entry& entry) const { return std::string(m_names + entry.nameOffset, entry.nameLength); }
+	inline size_t getFileSize() const { return m_file.getSize(); }
+
+	// The entry named by a path such as "res/shaders/Simple.shader", or nullptr.
+	const Entry* find(const std::string& path) const;
+	Resource read(const Entry& entry) const;
+	// Hashes every entry's contents and compares them with the index.
+	bool verify() const;
+
+	// Maps a pack for load to look in first. Returns false, leaving none mounted, when the
+	// file cannot be used.
+	static bool mount(const std::string& path);
+	static void unmount();
+	static inline const ResourcePack* getMounted() { return s_mounted.get(); }
+
+	// The resource from the mounted pack, or else the loose file at the path.
+	static Resource load(const std::string& path);
+	// As load, but a loose file is mapped instead of read, for large files parsed once in place.
+	static Resource map(const std::string& path);
+	// The 64-bit FNV-1a hash of the resource's contents when the mounted pack has it, without
+	// reading them; 0 otherwise.
+	static unsigned long long getContentHash(const std::string& path);
+	static unsigned long long hash(const unsigned char* data, size_t size);
+
+	// Packs every file under the directory, named by its path from the working directory.
+	static bool build(const std::string& directory, const std::string& output, std::ostream& log);
+
+	static std::vector<unsigned char> compressLZ(const unsigned char* data, size_t size);
+	// Fails on input that does not expand to exactly size bytes.
+	static bool decompressLZ(const unsigned char* data, size_t dataSize, unsigned char* output, size_t size);
+
+	static Stats getStats();
+	static void resetStats();
+	static void printReport(std::ostream& os);
+private:
+	static std::string normalize(const std::string& path);
+};
@@ -0,0 +1,97 @@
+#include "RoomScene.h"
+#include "ShaderLibrary.h"
+#include "VertexBufferLayout.h"
+#include "Renderer.h"
+#include <glm/ext/matrix_transform.hpp>
+
+static constexpr Uniform<int> u_texture("u_texture");
+
+static const float wallVertices[] = {
+    -25.0f,  0.0f,  25.0f, -5.0f, -3.0f,
+     25.0f,  0.0f,  25.0f,  5.0f, -3.0f,
+     25.0f, 15.0f,  25.0f,  5.0f,  3.0f,
+    -25.0f, 15.0f,  25.0f, -5.0f,  3.0f,
+     25.0f,  0.0f, -25.0f, -5.0f, -3.0f,
+    -25.0f,  0.0f, -25.0f,  5.0f, -3.0f,
+    -25.0f, 15.0f, -25.0f,  5.0f,  3.0f,
+     25.0f, 15.0f, -25.0f, -5.0f,  3.0f,
+};
+
+static const unsigned int wallIndices[] = {
+     1,  4,  7,
+     7,  2,  1,
+     5,  0,  3,
+     3,  6,  5,
+     0,  1,  2,
+     2,  3,  0,
+     4,  5,  6,
+     6,  7,  4,
+};
+
+static const float floorVertices[] = {
+    -25.0f,  0.0f, -25.0f, -5.0f, -5.0f,
+     25.0f,  0.0f, -25.0f,  5.0f, -5.0f,
+     25.0f,  0.0f,  25.0f,  5.0f,  5.0f,
+    -25.0f,  0.0f,  25.0f, -5.0f,  5.0f,
+};
+
+static const unsigned int floorIndices[] = {
+    0, 1, 2,
+    2, 3, 0,
+};
+
+RoomScene::RoomScene()
+    : m_wallVB(wallVertices, sizeof(wallVertices)), m_wallIB(wallIndices, sizeof(wallIndices) / sizeof(unsigned int)),
+    m_floorVB(floorVertices, sizeof(floorVertices)), m_floorIB(floorIndices, sizeof(floorIndices) / sizeof(unsigned int)),
+    m_shader(ShaderLibrary::load("res/shaders/Simple.shader")), m_wallTexture("res/textures/Tile.png"), m_uniformBuffer(sizeof(CameraBlock) + 2 * sizeof(ObjectBlock)),
+    m_model(glm::rotate(glm::mat4(1.0f), glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f))), m_gi(0.5f), m_inc(0.01f)
+{
+    VertexBufferLayout layout;
+    layout.push<float>(3);
+    layout.push<float>(2);
+
+    m_wallVA.addBuffer(m_wallVB, layout);
+    m_floorVA.addBuffer(m_floorVB, layout);
+
+    // The index buffers were created before their vertex arrays were bound, so attach them now.
+    m_wallVA.bind();
+    m_wallIB.bind();
+    m_floorVA.bind();
+    m_floorIB.bind();
+
+    m_floorVA.unbind();
+    m_wallVB.unbind();
+    m_floorVB.unbind();
+
+    m_shader->bindUniformBlock(CameraBlock::getLayout());
+    m_shader->bindUniformBlock(ObjectBlock::getLayout());
+    m_shader->bind();
+    m_shader->setUniform(u_texture, 0);
+}
+
+void RoomScene::onUpdate(float deltaTime)
+{
+    if (m_gi > 0.9 || m_gi < 0.5)
+        m_inc *= -1;
+    m_gi += m_inc;
+}
+
+void RoomScene::onRender(const Renderer& renderer, const Camera& camera)
+{
+    m_uniformBuffer.beginFrame();
+    unsigned int cameraOffset = m_uniformBuffer.push(CameraBlock{ camera.proj * camera.view, glm::vec4(camera.position, 1.0f) });
+    unsigned int floorOffset = m_uniformBuffer.push(ObjectBlock{ m_model, glm::vec4(1.0f * m_gi, 1.0f * m_gi, 1.0f * m_gi, 1.0f) });
+    unsigned int wallOffset = m_uniformBuffer.push(ObjectBlock{ m_model, glm::vec4(1.0f * m_gi, 1.0f * m_gi, 1.0f * m_gi, 1.0f) });
+    m_uniformBuffer.upload();
+
+    m_uniformBuffer.bindBlock<CameraBlock>(cameraOffset);
+    m_wallTexture.bind(0);
+
+    m_uniformBuffer.bindBlock<ObjectBlock>(floorOffset);
+    renderer.draw(m_floorVA, m_floorIB, *m_shader);
+
+    m_uniformBuffer.bindBlock<ObjectBlock>(wallOffset);
+    renderer.draw(m_wallVA, m_wallIB, *m_shader);
+
+    m_uniformBuffer.endFrame();
+}
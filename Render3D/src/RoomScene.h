@@ -0,0 +1,33 @@
+#pragma once
+
+#include <memory>
+#include "Scene.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "UniformBuffer.h"
+
+// The textured wall and floor room that Render3D has always shown.
+class RoomScene : public Scene
+{
+private:
+	VertexArray m_wallVA;
+	VertexBuffer m_wallVB;
+	IndexBuffer m_wallIB;
+	VertexArray m_floorVA;
+	VertexBuffer m_floorVB;
+	IndexBuffer m_floorIB;
+	std::shared_ptr<Shader> m_shader;
+	Texture m_wallTexture;
+	UniformBuffer m_uniformBuffer;
+	glm::mat4 m_model;
+	float m_gi;
+	float m_inc;
+public:
+	RoomScene();
+
+	void onUpdate(float deltaTime) override;
+	void onRender(const Renderer& renderer, const Camera& camera) override;
+};
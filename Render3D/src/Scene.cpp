@@ -0,0 +1,49 @@
+#include "Scene.h"
+#include "RoomScene.h"
+#include "GridScene.h"
+#include "TileFieldScene.h"
+#include "MeshFieldScene.h"
+#include "LayerScene.h"
+#include "BuildingScene.h"
+#include "StreamingScene.h"
+#include "ModelScene.h"
+
+std::unique_ptr<Scene> Scene::create(const std::string& name)
+{
+    if (name == "room")
+        return std::unique_ptr<Scene>(new RoomScene());
+    if (name == "grid")
+        return std::unique_ptr<Scene>(new GridScene());
+    if (name == "grid-unsorted")
+        return std::unique_ptr<Scene>(new GridScene(false));
+    if (name == "grid-unpacked")
+        return std::unique_ptr<Scene>(new GridScene(true, false));
+    if (name == "tiles")
+        return std::unique_ptr<Scene>(new TileFieldScene(true));
+    if (name == "tiles-per-object")
+        return std::unique_ptr<Scene>(new TileFieldScene(false));
+    if (name == "meshes")
+        return std::unique_ptr<Scene>(new MeshFieldScene(MeshSubmission::Indirect));
+    if (name == "meshes-separate")
+        return std::unique_ptr<Scene>(new MeshFieldScene(MeshSubmission::Separate));
+    if (name == "layers")
+        return std::unique_ptr<Scene>(new LayerScene());
+    if (name == "layers-unsorted")
+        return std::unique_ptr<Scene>(new LayerScene(false));
+    if (name == "building")
+        return std::unique_ptr<Scene>(new BuildingScene());
+    if (name == "building-unoccluded")
+        return std::unique_ptr<Scene>(new BuildingScene(false));
+    if (name == "streaming")
+        return std::unique_ptr<Scene>(new StreamingScene());
+    if (name == "streaming-blocking")
+        return std::unique_ptr<Scene>(new StreamingScene(false));
+    if (name == "model")
+        return std::unique_ptr<Scene>(new ModelScene("res/models/Crate.obj"));
+    return nullptr;
+}
+
+std::vector<std::string> Scene::getNames()
+{
+    return { "room", "grid", "grid-unsorted", "grid-unpacked", "tiles", "tiles-per-object", "meshes", "meshes-separate", "layers", "layers-unsorted", "building", "building-unoccluded", "streaming", "streaming-blocking", "model" };
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+
+class Renderer;
+class JobSystem;
+
+struct Camera
+{
+	glm::mat4 proj;
+	glm::mat4 view;
+	glm::vec3 position;
+};
+
+// A scene owns its GL resources and knows how to draw itself, so the same content can be
+// driven by the interactive window loop or by the headless benchmark runner.
+class Scene
+{
+public:
+	virtual ~Scene() {}
+
+	virtual void onUpdate(float deltaTime) {}
+	virtual void onRender(const Renderer& renderer, const Camera& camera) = 0;
+	// Lets the scene spread its update and culling work over the job system's threads.
+	virtual void setJobSystem(JobSystem* jobs) {}
+
+	static std::unique_ptr<Scene> create(const std::string& name);
+	static std::vector<std::string> getNames();
+};
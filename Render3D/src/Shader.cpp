@@ -1,49 +1,101 @@
 #include "Shader.h"
+#include <algorithm>
 #include <iostream>
-#include <fstream>
+#include <chrono>
 #include <string>
-#include <sstream>
+#include <vector>
 #include "Renderer.h"
+#include "GLState.h"
+#include "FrameStats.h"
+#include "ProgramCache.h"
 
-Shader::Shader(const std::string& filepath) : m_filePath(filepath), m_renderedId(0)
+static const int EMPTY_SLOT = -2;
+
+Shader::Shader(const std::string& filepath, bool deferLink) : Shader(ShaderFile(filepath), 0, deferLink)
+{
+}
+
+Shader::Shader(const ShaderFile& file, unsigned int variant, bool deferLink)
+    : m_filePath(file.getPath()), m_variant(variant), m_renderedId(0), m_programKey(0), m_uniformCount(0), m_uniformBlocks(0),
+    m_vertexShader(0), m_fragmentShader(0), m_compileMs(0.0), m_ready(false), m_failed(false)
 {
-    ShaderProgramSource source = parseShader(filepath);
+    for (const std::string& define : file.getDefines(variant))
+        m_defines.push_back(fnv1a(define.c_str()));
+    ShaderProgramSource source = file.getVariant(variant);
     m_renderedId = createShader(source.VertexSource, source.FragmentSource);
+    if (!deferLink)
+        waitUntilReady();
 }
 
 Shader::~Shader()
 {
+    GLCall(glDeleteShader(m_vertexShader));
+    GLCall(glDeleteShader(m_fragmentShader));
     GLCall(glDeleteProgram(m_renderedId));
+    GLState::onProgramDeleted(m_renderedId);
 }
 
-ShaderProgramSource Shader::parseShader(const std::string& filepath)
+bool Shader::isCompileParallel()
 {
-    std::ifstream stream(filepath);
-
-    enum class ShaderType
-    {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
-    };
-
-    std::string line;
-    std::stringstream ss[2];
-    ShaderType type = ShaderType::NONE;
-    while (getline(stream, line))
+    static int parallel = -1;
+    if (parallel < 0)
     {
-        if (line.find("$Shader$") != std::string::npos)
+        parallel = GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile ? 1 : 0;
+        if (GLEW_KHR_parallel_shader_compile)
         {
-            if (line.find("%Vertex%") != std::string::npos)
-                type = ShaderType::VERTEX;
-            else if (line.find("%Fragment%") != std::string::npos)
-                type = ShaderType::FRAGMENT;
+            GLCall(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
         }
-        else
+        else if (GLEW_ARB_parallel_shader_compile)
         {
-            ss[(int)type] << line << "\n";
+            GLCall(glMaxShaderCompilerThreadsARB(0xFFFFFFFF));
         }
     }
+    return parallel != 0;
+}
 
-    return { ss[0].str(), ss[1].str() };
+bool Shader::poll()
+{
+    if (!m_ready && !m_failed && isCompileParallel())
+    {
+        int completed = GL_FALSE;
+        GLCall(glGetProgramiv(m_renderedId, GL_COMPLETION_STATUS_KHR, &completed));
+        if (completed == GL_FALSE)
+            return false;
+    }
+    waitUntilReady();
+    return true;
+}
+
+void Shader::waitUntilReady()
+{
+    if (m_ready || m_failed)
+        return;
+    if (!finishLink())
+    {
+        m_failed = true;
+        m_pendingBlocks.clear();
+        m_pendingInts.clear();
+        return;
+    }
+    m_ready = true;
+    reflectUniforms();
+    reflectAttributes();
+
+    for (const UniformBlockLayout* layout : m_pendingBlocks)
+        bindUniformBlock(*layout);
+    if (!m_pendingInts.empty())
+    {
+        bind();
+        for (const std::pair<UniformHandle, int>& uniform : m_pendingInts)
+            setUniform1i(uniform.first, uniform.second);
+    }
+    m_pendingBlocks.clear();
+    m_pendingInts.clear();
+}
+
+bool Shader::isDefined(const char* option) const
+{
+    return std::find(m_defines.begin(), m_defines.end(), fnv1a(option)) != m_defines.end();
 }
 
 unsigned int Shader::compileShader(unsigned int type, const std::string& source)
@@ -52,79 +104,331 @@ unsigned int Shader::compileShader(unsigned int type, const std::string& source)
     const char* src = source.c_str();
     GLCall(glShaderSource(id, 1, &src, nullptr));
     GLCall(glCompileShader(id));
+    return id;
+}
 
+bool Shader::checkCompiled(unsigned int shader, unsigned int type)
+{
     int result;
-    GLCall(glGetShaderiv(id, GL_COMPILE_STATUS, &result));
+    GLCall(glGetShaderiv(shader, GL_COMPILE_STATUS, &result));
     if (result == GL_FALSE)
     {
         int length;
-        GLCall(glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length));
-        char* message = (char*)alloca(length * sizeof(char));
-        GLCall(glGetShaderInfoLog(id, length, &length, message));
+        GLCall(glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length));
+        std::vector<char> message(length + 1);
+        GLCall(glGetShaderInfoLog(shader, length, &length, message.data()));
         std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader!\n";
-        std::cout << message << "\n";
-        GLCall(glDeleteShader(id));
-        return 0;
+        std::cout << message.data() << "\n";
+        return false;
     }
-
-    return id;
+    return true;
 }
 
+// Hands the stages to the driver and links them without asking how either went, since every
+// status query waits for the driver. finishLink asks once the program is wanted.
 unsigned int Shader::createShader(const std::string& vertexShader, const std::string& fragmentShader)
 {
     GLCall(unsigned int program = glCreateProgram());
-    unsigned int vs = compileShader(GL_VERTEX_SHADER, vertexShader);
-    unsigned int fs = compileShader(GL_FRAGMENT_SHADER, fragmentShader);
+    m_programKey = ProgramCache::getKey(vertexShader, fragmentShader);
+    if (ProgramCache::load(m_programKey, program))
+        return program;
+
+    auto start = std::chrono::steady_clock::now();
+    isCompileParallel();
+    m_vertexShader = compileShader(GL_VERTEX_SHADER, vertexShader);
+    m_fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShader);
 
-    GLCall(glAttachShader(program, vs));
-    GLCall(glAttachShader(program, fs));
+    GLCall(glAttachShader(program, m_vertexShader));
+    GLCall(glAttachShader(program, m_fragmentShader));
 
+    ProgramCache::prepare(program);
     GLCall(glLinkProgram(program));
-    GLCall(glValidateProgram(program));
+    m_compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return program;
+}
 
-    GLCall(glDeleteShader(vs));
-    GLCall(glDeleteShader(fs));
+bool Shader::finishLink()
+{
+    // Loaded from the cache, and linked already.
+    if (!m_vertexShader)
+        return true;
 
-    return program;
+    // Asking for the status waits for the driver to finish.
+    auto start = std::chrono::steady_clock::now();
+    int linked = GL_FALSE;
+    GLCall(glGetProgramiv(m_renderedId, GL_LINK_STATUS, &linked));
+    m_compileMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (linked == GL_TRUE)
+    {
+#if GL_CHECKS
+        // Validation waits on the driver and only says anything useful while debugging.
+        GLCall(glValidateProgram(m_renderedId));
+#endif
+        ProgramCache::store(m_programKey, m_renderedId, m_compileMs);
+    }
+    else if (checkCompiled(m_vertexShader, GL_VERTEX_SHADER) && checkCompiled(m_fragmentShader, GL_FRAGMENT_SHADER))
+    {
+        int length;
+        GLCall(glGetProgramiv(m_renderedId, GL_INFO_LOG_LENGTH, &length));
+        std::vector<char> message(length + 1);
+        GLCall(glGetProgramInfoLog(m_renderedId, length, &length, message.data()));
+        std::cout << "Failed to link " << m_filePath << "!\n";
+        std::cout << message.data() << "\n";
+    }
+
+    GLCall(glDeleteShader(m_vertexShader));
+    GLCall(glDeleteShader(m_fragmentShader));
+    m_vertexShader = 0;
+    m_fragmentShader = 0;
+    return linked == GL_TRUE;
 }
 
 void Shader::bind() const
 {
-    GLCall(glUseProgram(m_renderedId));
+    if (m_ready)
+        GLState::bindProgram(m_renderedId);
 }
 
 void Shader::unbind() const
 {
-    GLCall(glUseProgram(0));
+    GLState::bindProgram(0);
+}
+
+// glUniform* sets the current program's uniforms, and a program that was not ready when the
+// caller bound it was not bound at all.
+bool Shader::makeCurrent()
+{
+    waitUntilReady();
+    if (!m_ready)
+        return false;
+    GLState::bindProgram(m_renderedId);
+    return true;
+}
+
+void Shader::setUniform1i(UniformHandle uniform, int value)
+{
+    if (m_failed)
+        return;
+    if (!m_ready)
+    {
+        m_pendingInts.emplace_back(uniform, value);
+        return;
+    }
+    makeCurrent();
+    GLCall(glUniform1i(findUniform(uniform, GL_INT).location, value));
+    FrameStats::add(Stat::UniformUploads);
+}
+
+void Shader::setUniform1f(UniformHandle uniform, float value)
+{
+    if (!makeCurrent())
+        return;
+    GLCall(glUniform1f(findUniform(uniform, GL_FLOAT).location, value));
+    FrameStats::add(Stat::UniformUploads);
+}
+
+void Shader::setUniform4f(UniformHandle uniform, float v0, float v1, float v2, float v3)
+{
+    if (!makeCurrent())
+        return;
+    GLCall(glUniform4f(findUniform(uniform, GL_FLOAT_VEC4).location, v0, v1, v2, v3));
+    FrameStats::add(Stat::UniformUploads);
 }
 
-void Shader::setUniform1i(const std::string& name, int value)
+void Shader::setUniformMat4f(UniformHandle uniform, const glm::mat4& matrix)
 {
-    GLCall(glUniform1i(getUniformLocation(name), value));
+    if (!makeCurrent())
+        return;
+    GLCall(glUniformMatrix4fv(findUniform(uniform, GL_FLOAT_MAT4).location, 1, GL_FALSE, &matrix[0][0]));
+    FrameStats::add(Stat::UniformUploads);
 }
 
-void Shader::setUniform1f(const std::string& name, float value)
+void Shader::setUniform(const Uniform<int>& uniform, int value)
 {
-    GLCall(glUniform1f(getUniformLocation(name), value));
+    setUniform1i(uniform, value);
 }
 
-void Shader::setUniform4f(const std::string& name, float v0, float v1, float v2, float v3)
+void Shader::setUniform(const Uniform<float>& uniform, float value)
 {
-    GLCall(glUniform4f(getUniformLocation(name), v0, v1, v2, v3));
+    setUniform1f(uniform, value);
 }
 
-void Shader::setUniformMat4f(const std::string& name, const glm::mat4& matrix)
+void Shader::setUniform(const Uniform<glm::vec4>& uniform, const glm::vec4& value)
 {
-    GLCall(glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &matrix[0][0]));
+    setUniform4f(uniform, value.x, value.y, value.z, value.w);
 }
 
-int Shader::getUniformLocation(const std::string& name)
+void Shader::setUniform(const Uniform<glm::mat4>& uniform, const glm::mat4& value)
 {
-    if (m_uniformLocationCache.find(name) != m_uniformLocationCache.end())
-        return m_uniformLocationCache[name];
-    GLCall(int location = glGetUniformLocation(m_renderedId, name.c_str()));
-    if (location == -1)
-        std::cout << "Warning: uniform '" << name << "' doesn't exist!\n";
-    m_uniformLocationCache[name] = location;
-    return location;
-}
\ No newline at end of file
+    setUniformMat4f(uniform, value);
+}
+
+bool Shader::bindUniformBlock(const UniformBlockLayout& layout)
+{
+    if (m_failed)
+        return false;
+    if (!m_ready)
+    {
+        m_pendingBlocks.push_back(&layout);
+        return true;
+    }
+
+    GLCall(unsigned int blockIndex = glGetUniformBlockIndex(m_renderedId, layout.name));
+    if (blockIndex == GL_INVALID_INDEX)
+        return false;
+
+    bool matches = true;
+    int dataSize = 0;
+    GLCall(glGetActiveUniformBlockiv(m_renderedId, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize));
+    if ((unsigned int)dataSize != layout.size)
+    {
+        std::cout << "Warning: uniform block '" << layout.name << "' is " << dataSize << " bytes in " << m_filePath << " but " << layout.size << " in C++!\n";
+        matches = false;
+    }
+
+    for (unsigned int i = 0; i < layout.memberCount; i++)
+    {
+        const UniformBlockMember& member = layout.members[i];
+        unsigned int index = GL_INVALID_INDEX;
+        GLCall(glGetUniformIndices(m_renderedId, 1, &member.name, &index));
+        int offset = -1;
+        if (index != GL_INVALID_INDEX)
+        {
+            GLCall(glGetActiveUniformsiv(m_renderedId, 1, &index, GL_UNIFORM_OFFSET, &offset));
+        }
+        if (offset != (int)member.offset)
+        {
+            std::cout << "Warning: " << layout.name << "." << member.name << " is at offset " << offset << " in " << m_filePath << " but " << member.offset << " in C++!\n";
+            matches = false;
+        }
+    }
+
+    GLCall(glUniformBlockBinding(m_renderedId, blockIndex, layout.binding));
+    m_uniformBlocks |= 1u << layout.binding;
+    return matches;
+}
+
+int Shader::getAttributeLocation(const char* name) const
+{
+    unsigned int hash = fnv1a(name);
+    for (const ShaderAttribute& attribute : m_attributes)
+    {
+        if (attribute.hash == hash)
+            return attribute.location;
+    }
+    return -1;
+}
+
+int Shader::getUniformLocation(UniformHandle uniform)
+{
+    waitUntilReady();
+    return m_ready ? findUniform(uniform, GL_NONE).location : -1;
+}
+
+void Shader::reflectUniforms()
+{
+    int count = 0;
+    int maxNameLength = 0;
+    GLCall(glGetProgramiv(m_renderedId, GL_ACTIVE_UNIFORMS, &count));
+    GLCall(glGetProgramiv(m_renderedId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength));
+
+    unsigned int capacity = 8;
+    while (capacity < (unsigned int)count * 2)
+        capacity *= 2;
+    m_uniforms.assign(capacity, { 0, EMPTY_SLOT, GL_NONE, 0 });
+    m_uniformCount = 0;
+
+    std::vector<char> name(maxNameLength + 1);
+    for (int i = 0; i < count; i++)
+    {
+        int size = 0;
+        unsigned int type = GL_NONE;
+        GLCall(glGetActiveUniform(m_renderedId, (unsigned int)i, (int)name.size(), nullptr, &size, &type, name.data()));
+        GLCall(int location = glGetUniformLocation(m_renderedId, name.data()));
+        // Uniform block members have no location and are set through their buffer instead.
+        if (location == -1)
+            continue;
+
+        // Arrays are reported as "name[0]" but are set by their plain name.
+        std::string uniformName(name.data());
+        size_t bracket = uniformName.find('[');
+        if (bracket != std::string::npos)
+            uniformName.erase(bracket);
+
+        insertUniform({ fnv1a(uniformName.c_str()), location, type, size });
+    }
+}
+
+void Shader::reflectAttributes()
+{
+    int count = 0;
+    int maxNameLength = 0;
+    GLCall(glGetProgramiv(m_renderedId, GL_ACTIVE_ATTRIBUTES, &count));
+    GLCall(glGetProgramiv(m_renderedId, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxNameLength));
+
+    std::vector<char> name(maxNameLength + 1);
+    for (int i = 0; i < count; i++)
+    {
+        int size = 0;
+        unsigned int type = GL_NONE;
+        GLCall(glGetActiveAttrib(m_renderedId, (unsigned int)i, (int)name.size(), nullptr, &size, &type, name.data()));
+        GLCall(int location = glGetAttribLocation(m_renderedId, name.data()));
+        // Built-in inputs such as gl_VertexID have no location.
+        if (location != -1)
+            m_attributes.push_back({ fnv1a(name.data()), location });
+    }
+}
+
+const ShaderUniform& Shader::findUniform(UniformHandle uniform, unsigned int expectedType)
+{
+    waitUntilReady();
+    unsigned int mask = (unsigned int)m_uniforms.size() - 1;
+    for (unsigned int index = uniform.hash & mask; m_uniforms[index].location != EMPTY_SLOT; index = (index + 1) & mask)
+    {
+        const ShaderUniform& slot = m_uniforms[index];
+        if (slot.hash == uniform.hash)
+        {
+#if GL_CHECKS
+            bool isSampler = slot.type == GL_SAMPLER_2D || slot.type == GL_SAMPLER_2D_ARRAY;
+            if (slot.location != -1 && expectedType != GL_NONE && slot.type != expectedType && !(expectedType == GL_INT && isSampler))
+                std::cout << "Warning: uniform '" << uniform.name << "' is set with the wrong type!\n";
+#endif
+            return slot;
+        }
+    }
+
+    // Remember names that are not in the program so the warning is only printed once.
+    std::cout << "Warning: uniform '" << uniform.name << "' doesn't exist!\n";
+    insertUniform({ uniform.hash, -1, GL_NONE, 0 });
+    return findUniform(uniform, GL_NONE);
+}
+
+void Shader::insertUniform(const ShaderUniform& uniform)
+{
+    if ((m_uniformCount + 1) * 2 > m_uniforms.size())
+    {
+        std::vector<ShaderUniform> old;
+        old.swap(m_uniforms);
+        m_uniforms.assign(old.size() * 2, { 0, EMPTY_SLOT, GL_NONE, 0 });
+        m_uniformCount = 0;
+        for (const ShaderUniform& slot : old)
+        {
+            if (slot.location != EMPTY_SLOT)
+                insertUniform(slot);
+        }
+    }
+
+    unsigned int mask = (unsigned int)m_uniforms.size() - 1;
+    unsigned int index = uniform.hash & mask;
+    while (m_uniforms[index].location != EMPTY_SLOT)
+    {
+        if (m_uniforms[index].hash == uniform.hash)
+        {
+            std::cout << "Warning: two uniforms in " << m_filePath << " share the name hash " << uniform.hash << "!\n";
+            return;
+        }
+        index = (index + 1) & mask;
+    }
+    m_uniforms[index] = uniform;
+    m_uniformCount++;
+}
@@ -1,35 +1,118 @@
 #pragma once
 
 #include <string>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "glm/glm.hpp"
+#include "Uniform.h"
+#include "UniformBlocks.h"
+#include "ShaderFile.h"
 
-struct ShaderProgramSource
+// One active vertex input of a linked program.
+struct ShaderAttribute
 {
-	std::string VertexSource;
-	std::string FragmentSource;
+	unsigned int hash;
+	int location;
 };
 
 class Shader
 {
 private:
 	std::string m_filePath;
+	unsigned int m_variant;
+	// Name hashes of the options the variant defines.
+	std::vector<unsigned int> m_defines;
 	unsigned int m_renderedId;
-	std::unordered_map<std::string, int> m_uniformLocationCache;
+	// The program's ProgramCache key.
+	unsigned long long m_programKey;
+	// Open-addressed by name hash and kept at most half full, so a lookup is normally one index.
+	std::vector<ShaderUniform> m_uniforms;
+	unsigned int m_uniformCount;
+	std::vector<ShaderAttribute> m_attributes;
+	// A bit per binding point of the uniform blocks bindUniformBlock found in the program.
+	unsigned int m_uniformBlocks;
+	// Stages the driver may still be compiling, kept until the program links so their logs can
+	// be printed if it fails. Both are 0 for a program loaded from the ProgramCache.
+	unsigned int m_vertexShader;
+	unsigned int m_fragmentShader;
+	// Time spent in the compile and link calls and waiting for their status; not the time the
+	// caller spent on other work while the driver compiled.
+	double m_compileMs;
+	bool m_ready;
+	// Finished, but the stages did not compile or the program did not link.
+	bool m_failed;
+	// Setup asked for before the program linked, made once it has.
+	std::vector<const UniformBlockLayout*> m_pendingBlocks;
+	std::vector<std::pair<UniformHandle, int>> m_pendingInts;
 public:
-	Shader(const std::string& filepath);
+	// Compiles and links before returning, unless deferLink is set: the work is then only handed
+	// to the driver, which may do it on its own threads while the caller goes on, and the program
+	// is finished by poll or waitUntilReady.
+	Shader(const std::string& filepath, bool deferLink = false);
+	// A variant of a file read already, with the options set in the mask defined.
+	Shader(const ShaderFile& file, unsigned int variant, bool deferLink = false);
 	~Shader();
 
+	inline const std::string& getFilePath() const { return m_filePath; }
+	inline unsigned int getVariant() const { return m_variant; }
+	// Whether the variant defines the named option, for code that emulates the program.
+	bool isDefined(const char* option) const;
+
+	// Whether the program has linked and can be drawn with. Never waits for the driver.
+	inline bool isReady() const { return m_ready; }
+	// Whether the program is finished but failed to link. It is never ready, so the renderer
+	// skips its draws, and its uniforms and blocks are not set.
+	inline bool hasFailed() const { return m_failed; }
+	// Finishes the program if the driver is done with it and returns whether it is finished,
+	// ready or failed. Only drivers with parallel compile can say so without waiting; on others
+	// this waits.
+	bool poll();
+	void waitUntilReady();
+
+	// Binding a program that is not ready does nothing.
 	void bind() const;
 	void unbind() const;
 
-	void setUniform1i(const std::string& name, int value);
-	void setUniform1f(const std::string& name, float value);
-	void setUniform4f(const std::string& name, float v0, float v1, float f2, float f3);
-	void setUniformMat4f(const std::string& name, const glm::mat4& matrix);
+	// Set on the program, which is finished and bound first if it has to be.
+	void setUniform1i(UniformHandle uniform, int value);
+	void setUniform1f(UniformHandle uniform, float value);
+	void setUniform4f(UniformHandle uniform, float v0, float v1, float f2, float f3);
+	void setUniformMat4f(UniformHandle uniform, const glm::mat4& matrix);
+
+	void setUniform(const Uniform<int>& uniform, int value);
+	void setUniform(const Uniform<float>& uniform, float value);
+	void setUniform(const Uniform<glm::vec4>& uniform, const glm::vec4& value);
+	void setUniform(const Uniform<glm::mat4>& uniform, const glm::mat4& value);
+
+	// Points the named block at its binding and checks the GLSL layout against the C++ struct.
+	// Returns false when the program does not declare the block or the layouts disagree. Before
+	// the program is ready, the block is bound and checked once it is and true is returned.
+	// setUniform1i is kept the same way, for sampler units; other uniforms wait for the program.
+	bool bindUniformBlock(const UniformBlockLayout& layout);
+	inline bool hasUniformBlock(unsigned int binding) const { return (m_uniformBlocks & (1u << binding)) != 0; }
+
+	// Location of the named vertex input, or -1 when the program does not use it. This and
+	// getUniforms need a program that is ready.
+	int getAttributeLocation(const char* name) const;
+
+	int getUniformLocation(UniformHandle uniform);
+	inline const std::vector<ShaderUniform>& getUniforms() const { return m_uniforms; }
+	inline unsigned int getRendererId() const { return m_renderedId; }
+	inline unsigned long long getProgramKey() const { return m_programKey; }
+
+	// Whether the driver compiles and links on threads of its own and can be asked if it is done
+	// (KHR_ or ARB_parallel_shader_compile). The first call lets it use as many threads as it likes.
+	static bool isCompileParallel();
 private:
-	ShaderProgramSource parseShader(const std::string& filepath);
 	unsigned int compileShader(unsigned int type, const std::string& source);
+	bool checkCompiled(unsigned int shader, unsigned int type);
 	unsigned int createShader(const std::string& vertexShader, const std::string& fragmentShader);
-	int getUniformLocation(const std::string& name);
+	// Returns whether the program linked.
+	bool finishLink();
+	// Returns false, binding nothing, when the program failed.
+	bool makeCurrent();
+	void reflectUniforms();
+	void reflectAttributes();
+	const ShaderUniform& findUniform(UniformHandle uniform, unsigned int expectedType);
+	void insertUniform(const ShaderUniform& uniform);
 };
\ No newline at end of file
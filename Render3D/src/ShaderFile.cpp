@@ -0,0 +1,186 @@
+#include "ShaderFile.h"
+#include "ResourcePack.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+enum ShaderStage
+{
+    NO_STAGE = -1, VERTEX_STAGE = 0, FRAGMENT_STAGE = 1
+};
+
+// Where the line starting at begin ends, before its newline and any carriage return, and
+// where the next one starts.
+static const char* findLineEnd(const char* begin, const char* end, const char*& next)
+{
+    const char* newline = (const char*)memchr(begin, '\n', end - begin);
+    next = newline ? newline + 1 : end;
+    const char* lineEnd = newline ? newline : end;
+    if (lineEnd > begin && lineEnd[-1] == '\r')
+        lineEnd--;
+    return lineEnd;
+}
+
+static const char* skipSpaces(const char* begin, const char* end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t'))
+        begin++;
+    return begin;
+}
+
+static bool startsWith(const char* begin, const char* end, const char* prefix)
+{
+    size_t length = strlen(prefix);
+    return (size_t)(end - begin) >= length && memcmp(begin, prefix, length) == 0;
+}
+
+static bool contains(const char* begin, const char* end, const char* text)
+{
+    return std::search(begin, end, text, text + strlen(text)) != end;
+}
+
+static std::string getDirectory(const std::string& path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+ShaderFile::ShaderFile(const std::string& path) : m_path(path), m_valid(true)
+{
+    Resource file = ResourcePack::load(path);
+    if (!file.isValid())
+    {
+        std::cout << "Failed to read shader " << path << "!\n";
+        m_valid = false;
+        return;
+    }
+    // The stages are most of the file.
+    m_stages[VERTEX_STAGE].reserve(file.getSize());
+    m_stages[FRAGMENT_STAGE].reserve(file.getSize());
+
+    std::vector<std::string> included[2];
+    ShaderStage stage = NO_STAGE;
+    const char* text = file.getText();
+    const char* textEnd = text + file.getSize();
+    const char* next = text;
+    for (const char* begin = text; begin < textEnd; begin = next)
+    {
+        const char* end = findLineEnd(begin, textEnd, next);
+        if (contains(begin, end, "$Shader$"))
+        {
+            if (contains(begin, end, "%Vertex%"))
+                stage = VERTEX_STAGE;
+            else if (contains(begin, end, "%Fragment%"))
+                stage = FRAGMENT_STAGE;
+        }
+        else if (stage != NO_STAGE)
+        {
+            appendLine(path, begin, end, m_stages[stage], included[stage]);
+        }
+        else if (startsWith(skipSpaces(begin, end), end, "$Option$"))
+        {
+            const char* name = skipSpaces(skipSpaces(begin, end) + 8, end);
+            const char* nameEnd = name;
+            while (nameEnd < end && *nameEnd != ' ' && *nameEnd != '\t')
+                nameEnd++;
+            if (nameEnd > name)
+                m_options.emplace_back(name, nameEnd);
+        }
+    }
+    if (m_options.size() > 32)
+        std::cout << "Warning: " << path << " has more options than a variant has bits!\n";
+}
+
+// Appends a file an #include names, unless the stage has it already.
+void ShaderFile::appendFile(const std::string& path, std::string& stage, std::vector<std::string>& included)
+{
+    if (std::find(included.begin(), included.end(), path) != included.end())
+        return;
+    included.push_back(path);
+
+    Resource file = ResourcePack::load(path);
+    if (!file.isValid())
+    {
+        std::cout << "Failed to read shader include " << path << "!\n";
+        m_valid = false;
+        return;
+    }
+    const char* textEnd = file.getText() + file.getSize();
+    const char* next = file.getText();
+    for (const char* begin = next; begin < textEnd; begin = next)
+    {
+        const char* end = findLineEnd(begin, textEnd, next);
+        appendLine(path, begin, end, stage, included);
+    }
+}
+
+void ShaderFile::appendLine(const std::string& path, const char* line, const char* end, std::string& stage, std::vector<std::string>& included)
+{
+    const char* directive = skipSpaces(line, end);
+    if (startsWith(directive, end, "#include"))
+    {
+        const char* open = std::find(directive, end, '"');
+        const char* close = open < end ? std::find(open + 1, end, '"') : end;
+        if (close < end)
+        {
+            appendFile(getDirectory(path) + std::string(open + 1, close), stage, included);
+            return;
+        }
+        std::cout << "Warning: malformed #include in " << path << "!\n";
+    }
+    stage.append(line, end);
+    stage += '\n';
+}
+
+unsigned int ShaderFile::getOption(const char* name) const
+{
+    for (size_t i = 0; i < m_options.size() && i < 32; i++)
+    {
+        if (m_options[i] == name)
+            return 1u << i;
+    }
+    return 0;
+}
+
+std::vector<std::string> ShaderFile::getDefines(unsigned int variant) const
+{
+    std::vector<std::string> defines;
+    for (size_t i = 0; i < m_options.size() && i < 32; i++)
+    {
+        if (variant & (1u << i))
+            defines.push_back(m_options[i]);
+    }
+    return defines;
+}
+
+ShaderProgramSource ShaderFile::getVariant(unsigned int variant) const
+{
+    unsigned int declared = m_options.size() >= 32 ? ~0u : (1u << m_options.size()) - 1;
+    if (variant & ~declared)
+        std::cout << "Warning: variant " << variant << " of " << m_path << " sets options the file does not have!\n";
+
+    std::string defines;
+    for (const std::string& define : getDefines(variant))
+        defines += "#define " + define + "\n";
+
+    // #version has to come first, so the defines go after it.
+    ShaderProgramSource source;
+    std::string* outputs[2] = { &source.VertexSource, &source.FragmentSource };
+    for (int stage = 0; stage < 2; stage++)
+    {
+        const std::string& text = m_stages[stage];
+        std::string& output = *outputs[stage];
+        size_t version = text.find("#version");
+        size_t split = 0;
+        if (version != std::string::npos)
+        {
+            split = text.find('\n', version);
+            split = split == std::string::npos ? text.size() : split + 1;
+        }
+        output.reserve(text.size() + defines.size());
+        output.append(text, 0, split);
+        output += defines;
+        output.append(text, split, std::string::npos);
+    }
+    return source;
+}
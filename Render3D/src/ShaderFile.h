@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct ShaderProgramSource
+{
+	std::string VertexSource;
+	std::string FragmentSource;
+};
+
+// Options of Simple.shader, as bits of a variant in the order its $Option$ lines name them.
+enum SimpleShaderOption : unsigned int
+{
+	// The model matrix and color come from per-instance attributes instead of the Object block.
+	SIMPLE_INSTANCED = 1 << 0,
+	// The texture is a TextureAtlas array, sampled in the Object block's region and layer.
+	SIMPLE_ATLAS = 1 << 1,
+	// The texture is drawn as it is, without u_color.
+	SIMPLE_UNTINTED = 1 << 2
+};
+
+// A .shader file read once, its stages split at the "$Shader$ %Vertex%" and "$Shader$ %Fragment%"
+// lines and their #include "file" lines replaced by the files, which are found next to the file
+// including them and included once per stage. "$Option$ NAME" lines before the stages name the
+// file's options. A variant is a mask of them: getVariant defines NAME after each stage's
+// #version line for every bit set, so code under #ifdef NAME is compiled only into the variants
+// that want it and the others pay nothing for it. Files come through ResourcePack and are
+// scanned where they lie, in the pack's mapping when it has them.
+class ShaderFile
+{
+private:
+	std::string m_path;
+	std::vector<std::string> m_options;
+	std::string m_stages[2];
+	bool m_valid;
+public:
+	explicit ShaderFile(const std::string& path);
+
+	// False when the file or one of its includes could not be read.
+	inline bool isValid() const { return m_valid; }
+	inline const std::string& getPath() const { return m_path; }
+	inline const std::vector<std::string>& getOptions() const { return m_options; }
+	// The bit of the named option, or 0 when the file has none by that name.
+	unsigned int getOption(const char* name) const;
+	// The names of the options set in a variant.
+	std::vector<std::string> getDefines(unsigned int variant) const;
+
+	ShaderProgramSource getVariant(unsigned int variant) const;
+private:
+	void appendFile(const std::string& path, std::string& stage, std::vector<std::string>& included);
+	void appendLine(const std::string& path, const char* line, const char* end, std::string& stage, std::vector<std::string>& included);
+};
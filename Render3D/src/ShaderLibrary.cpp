@@ -0,0 +1,88 @@
+#include "ShaderLibrary.h"
+#include <algorithm>
+#include <iomanip>
+
+std::unordered_map<std::string, std::weak_ptr<Shader>> ShaderLibrary::s_shaders;
+std::unordered_map<std::string, std::unique_ptr<ShaderFile>> ShaderLibrary::s_files;
+std::vector<std::weak_ptr<Shader>> ShaderLibrary::s_pending;
+std::chrono::steady_clock::time_point ShaderLibrary::s_firstSubmit;
+ShaderLibrary::Stats ShaderLibrary::s_stats = {};
+
+const ShaderFile& ShaderLibrary::getFile(const std::string& path)
+{
+    std::unique_ptr<ShaderFile>& file = s_files[path];
+    if (!file)
+    {
+        auto start = std::chrono::steady_clock::now();
+        file.reset(new ShaderFile(path));
+        s_stats.files++;
+        s_stats.readMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return *file;
+}
+
+std::shared_ptr<Shader> ShaderLibrary::load(const std::string& path, unsigned int variant)
+{
+    std::weak_ptr<Shader>& entry = s_shaders[path + "#" + std::to_string(variant)];
+    if (std::shared_ptr<Shader> shader = entry.lock())
+        return shader;
+
+    auto start = std::chrono::steady_clock::now();
+    if (s_pending.empty())
+        s_firstSubmit = start;
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>(getFile(path), variant, true);
+    entry = shader;
+    s_pending.push_back(shader);
+    s_stats.programs++;
+    s_stats.pending++;
+    s_stats.submitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return shader;
+}
+
+unsigned int ShaderLibrary::update()
+{
+    if (s_pending.empty())
+        return 0;
+    s_pending.erase(std::remove_if(s_pending.begin(), s_pending.end(), [](const std::weak_ptr<Shader>& pending) {
+        std::shared_ptr<Shader> shader = pending.lock();
+        return !shader || shader->poll();
+    }), s_pending.end());
+    onReady();
+    return s_stats.pending;
+}
+
+void ShaderLibrary::finish()
+{
+    for (const std::weak_ptr<Shader>& pending : s_pending)
+    {
+        if (std::shared_ptr<Shader> shader = pending.lock())
+            shader->waitUntilReady();
+    }
+    s_pending.clear();
+    onReady();
+}
+
+void ShaderLibrary::resetStats()
+{
+    s_stats = {};
+    s_stats.pending = (unsigned int)s_pending.size();
+}
+
+void ShaderLibrary::onReady()
+{
+    bool wasPending = s_stats.pending > 0;
+    s_stats.pending = (unsigned int)s_pending.size();
+    if (wasPending && s_pending.empty())
+        s_stats.readyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - s_firstSubmit).count();
+}
+
+void ShaderLibrary::printReport(std::ostream& os)
+{
+    os << "Shader library: " << s_stats.files << " files read in " << std::fixed << std::setprecision(2) << s_stats.readMs << " ms, "
+        << s_stats.programs << " programs submitted in " << std::fixed << std::setprecision(2) << s_stats.submitMs << " ms, ";
+    if (s_stats.pending)
+        os << s_stats.pending << " still compiling";
+    else
+        os << "all ready after " << s_stats.readyMs << " ms";
+    os << (Shader::isCompileParallel() ? ", compiled in parallel by the driver" : ", the driver cannot compile in parallel") << std::defaultfloat << "\n";
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Shader.h"
+
+// Hands out the programs scenes draw with, one per file and variant while anything holds it. Each
+// file is read once, and its variants are compiled when first asked for. load hands a
+// program's compile and link to the driver and returns at once, so a scene can ask for its
+// programs first and load its meshes and textures while the driver works. update finishes the
+// programs the driver is done with; until then they are not ready and the renderer skips the
+// draws that use them. The library keeps no program alive, so they go with their scenes.
+class ShaderLibrary
+{
+public:
+	struct Stats
+	{
+		// Programs submitted, not counting loads that found one.
+		unsigned int programs;
+		// Shader files read, and the time reading them took.
+		unsigned int files;
+		double readMs;
+		unsigned int pending;
+		// Time spent in load, handing programs to the driver.
+		double submitMs;
+		// From the first load since everything was last ready until everything was again.
+		double readyMs;
+	};
+private:
+	// Keyed by path and variant.
+	static std::unordered_map<std::string, std::weak_ptr<Shader>> s_shaders;
+	static std::unordered_map<std::string, std::unique_ptr<ShaderFile>> s_files;
+	static std::vector<std::weak_ptr<Shader>> s_pending;
+	static std::chrono::steady_clock::time_point s_firstSubmit;
+	static Stats s_stats;
+public:
+	// The program for a variant of the file, submitted the first time it is asked for.
+	static std::shared_ptr<Shader> load(const std::string& path, unsigned int variant = 0);
+	// The file as read for its programs, read now if none has been loaded.
+	static const ShaderFile& getFile(const std::string& path);
+	// Finishes the programs the driver is done with, without waiting for the rest. Returns how
+	// many are still compiling.
+	static unsigned int update();
+	// Waits for every program.
+	static void finish();
+
+	static inline const Stats& getStats() { return s_stats; }
+	static void resetStats();
+	static void printReport(std::ostream& os);
+private:
+	static void onReady();
+};
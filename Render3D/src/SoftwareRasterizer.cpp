@@ -0,0 +1,888 @@
+#include "SoftwareRasterizer.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "UniformBuffer.h"
+#include "UniformBlocks.h"
+#include "VertexBufferLayout.h"
+#include "FrameStats.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define RASTER_SSE 1
+#endif
+#if defined(__AVX2__)
+#define RASTER_AVX2 1
+#endif
+
+// Outcode bits of a clip-space vertex: outside each side of the view volume, and outside the
+// guard band, beyond which snapped coordinates would overflow the edge functions.
+enum Outcode : unsigned char
+{
+    OUTSIDE_LEFT = 1,
+    OUTSIDE_RIGHT = 2,
+    OUTSIDE_BOTTOM = 4,
+    OUTSIDE_TOP = 8,
+    OUTSIDE_NEAR = 16,
+    OUTSIDE_FAR = 32,
+    OUTSIDE_GUARD_BAND = 64
+};
+
+// Triangles reaching further than this, in NDC, are clipped to it; inside it they are only
+// limited to the target by their bounds. It keeps snapped coordinates under 2^17 for targets
+// up to 4096 pixels wide.
+static const float GUARD_BAND = 2.0f;
+static const unsigned int LANE_GROUP = 8;
+static const unsigned int MAX_CLIP_VERTICES = 9;
+
+// Pixel centers sit half a pixel into the 1/16 pixel grid.
+static const int SUBPIXELS = 1 << SoftwareRasterizer::SUBPIXEL_BITS;
+static const int PIXEL_CENTER = SUBPIXELS / 2;
+
+struct ClipVertex
+{
+    glm::vec4 position;
+    float u, v;
+    glm::vec4 color;
+    // The draw's vertex this is, or -1 for a vertex made by clipping.
+    int source;
+};
+
+static void warnOnce(bool& warned, const char* message)
+{
+    if (warned)
+        return;
+    std::cout << "Warning: software rasterizer: " << message << "\n";
+    warned = true;
+}
+
+static glm::vec4 fetchAttribute(const VertexAttribute& attribute, unsigned int element)
+{
+    glm::vec4 value(0.0f, 0.0f, 0.0f, 1.0f);
+    const unsigned char* data = attribute.buffer->getData() + attribute.offset + (size_t)element * attribute.stride;
+    for (unsigned int i = 0; i < attribute.count; i++)
+    {
+        switch (attribute.type)
+        {
+        case GL_FLOAT:
+            memcpy(&value[i], data + i * sizeof(float), sizeof(float));
+            break;
+        case GL_UNSIGNED_INT:
+        {
+            unsigned int integer;
+            memcpy(&integer, data + i * sizeof(unsigned int), sizeof(unsigned int));
+            value[i] = (float)integer;
+            break;
+        }
+        case GL_UNSIGNED_BYTE:
+            value[i] = attribute.normalized ? data[i] / 255.0f : data[i];
+            break;
+        }
+    }
+    return value;
+}
+
+static bool isInBuffer(const VertexAttribute& attribute, unsigned int lastElement)
+{
+    size_t end = attribute.offset + (size_t)lastElement * attribute.stride + attribute.count * VertexBufferElement::getSizeOfType(attribute.type);
+    return end <= attribute.buffer->getSize();
+}
+
+static unsigned int packColor(const glm::vec4& color)
+{
+    glm::vec4 scaled = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+    return (unsigned int)scaled.r | (unsigned int)scaled.g << 8 | (unsigned int)scaled.b << 16 | (unsigned int)scaled.a << 24;
+}
+
+// Rounds toward negative infinity; std::floor is a library call without SSE4.1.
+static inline int floorToInt(float value)
+{
+    int truncated = (int)value;
+    return truncated - (value < (float)truncated);
+}
+
+// The four texels a bilinear sample blends, bottom left, bottom right, top left and top right,
+// and the weights of the right and top ones.
+struct Footprint
+{
+    const unsigned char* texels[4];
+    float fractionS, fractionT;
+};
+
+// GL_LINEAR in one level, with GL_REPEAT or GL_CLAMP_TO_EDGE.
+static Footprint findFootprint(const MipChain& mips, unsigned int level, float u, float v, bool repeat)
+{
+    const MipChain::Level& size = mips.getLevel(level);
+    int width = size.width, height = size.height;
+    // Repeating only needs the fraction, after which the footprint wraps by at most one texel.
+    if (repeat)
+    {
+        u -= floorToInt(u);
+        v -= floorToInt(v);
+    }
+    float s = u * width - 0.5f;
+    float t = v * height - 0.5f;
+    int floorS = floorToInt(s), floorT = floorToInt(t);
+    int x0, x1, y0, y1;
+    if (repeat)
+    {
+        x0 = floorS < 0 ? width - 1 : floorS;
+        x1 = floorS + 1 >= width ? 0 : floorS + 1;
+        y0 = floorT < 0 ? height - 1 : floorT;
+        y1 = floorT + 1 >= height ? 0 : floorT + 1;
+    }
+    else
+    {
+        x0 = std::max(0, std::min(width - 1, floorS)), x1 = std::max(0, std::min(width - 1, floorS + 1));
+        y0 = std::max(0, std::min(height - 1, floorT)), y1 = std::max(0, std::min(height - 1, floorT + 1));
+    }
+    const unsigned char* texels = mips.getPixels(level);
+    const unsigned char* row0 = texels + (size_t)y0 * width * 4;
+    const unsigned char* row1 = texels + (size_t)y1 * width * 4;
+    return { { row0 + x0 * 4, row0 + x1 * 4, row1 + x0 * 4, row1 + x1 * 4 }, s - floorS, t - floorT };
+}
+
+// The exponent plus the mantissa taken as linear, within 0.09 of log2; hardware approximates
+// the level of detail about as coarsely.
+static inline float approximateLog2(float value)
+{
+    int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits - (127 << 23)) * (1.0f / (1 << 23));
+}
+
+#if RASTER_SSE
+// The channels of an RGBA8 pixel as 0..255 floats.
+static inline __m128 loadColor(unsigned int pixel)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)pixel), zero), zero);
+    return _mm_cvtepi32_ps(channels);
+}
+
+// packColor four channels at a time, rounding the same way.
+static inline unsigned int storeColor(__m128 color)
+{
+    __m128 scaled = _mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(color, _mm_setzero_ps()), _mm_set1_ps(1.0f)), _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+    __m128i channels = _mm_cvttps_epi32(scaled);
+    return (unsigned int)_mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(channels, channels), channels));
+}
+
+static inline unsigned int loadTexel(const unsigned char* texel)
+{
+    unsigned int value;
+    memcpy(&value, texel, sizeof(value));
+    return value;
+}
+
+static __m128 sampleBilinear(const Footprint& footprint)
+{
+    __m128 bottomLeft = loadColor(loadTexel(footprint.texels[0])), bottomRight = loadColor(loadTexel(footprint.texels[1]));
+    __m128 topLeft = loadColor(loadTexel(footprint.texels[2])), topRight = loadColor(loadTexel(footprint.texels[3]));
+    __m128 fractionS = _mm_set1_ps(footprint.fractionS);
+    __m128 bottom = _mm_add_ps(bottomLeft, _mm_mul_ps(_mm_sub_ps(bottomRight, bottomLeft), fractionS));
+    __m128 top = _mm_add_ps(topLeft, _mm_mul_ps(_mm_sub_ps(topRight, topLeft), fractionS));
+    __m128 blended = _mm_add_ps(bottom, _mm_mul_ps(_mm_sub_ps(top, bottom), _mm_set1_ps(footprint.fractionT)));
+    return _mm_mul_ps(blended, _mm_set1_ps(1.0f / 255.0f));
+}
+#else
+static glm::vec4 unpackColor(unsigned int pixel)
+{
+    return glm::vec4(pixel & 0xFF, pixel >> 8 & 0xFF, pixel >> 16 & 0xFF, pixel >> 24) / 255.0f;
+}
+
+static glm::vec4 loadTexel(const unsigned char* texel)
+{
+    return glm::vec4(texel[0], texel[1], texel[2], texel[3]);
+}
+
+static glm::vec4 sampleBilinear(const Footprint& footprint)
+{
+    glm::vec4 bottom = glm::mix(loadTexel(footprint.texels[0]), loadTexel(footprint.texels[1]), footprint.fractionS);
+    glm::vec4 top = glm::mix(loadTexel(footprint.texels[2]), loadTexel(footprint.texels[3]), footprint.fractionS);
+    return glm::mix(bottom, top, footprint.fractionT) * (1.0f / 255.0f);
+}
+#endif
+
+SoftwareRasterizer::SoftwareRasterizer(unsigned int width, unsigned int height)
+    : m_width(width), m_height(height), m_tilesX((width + TILE_SIZE - 1) / TILE_SIZE), m_tilesY((height + TILE_SIZE - 1) / TILE_SIZE),
+    m_color(width * height, 0), m_depthPitch((width + LANE_GROUP - 1) / LANE_GROUP * LANE_GROUP), m_clearColor(0.0f), m_clearPending(false),
+    m_pass({ true, true, false, false }), m_kernel(getBestKernel()), m_threadCount(0), m_jobs(nullptr), m_bins(m_tilesX * m_tilesY)
+{
+    m_depth.assign(m_depthPitch * height, 1.0f);
+}
+
+SoftwareRasterizer::Kernel SoftwareRasterizer::getBestKernel()
+{
+#if RASTER_AVX2
+    return Kernel::AVX2;
+#elif RASTER_SSE
+    return Kernel::SSE;
+#else
+    return Kernel::Scalar;
+#endif
+}
+
+const char* SoftwareRasterizer::getKernelName(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Kernel::Scalar:    return "scalar";
+    case Kernel::SSE:       return "SSE";
+    case Kernel::AVX2:      return "AVX2";
+    case Kernel::Best:      return getKernelName(getBestKernel());
+    }
+    return "";
+}
+
+void SoftwareRasterizer::clear(const glm::vec4& color)
+{
+    if (!m_triangles.empty())
+        resolve();
+    // Done per tile by the workers at the next resolve.
+    m_clearColor = color;
+    m_clearPending = true;
+}
+
+void SoftwareRasterizer::draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const Texture* texture,
+    unsigned int firstIndex, unsigned int indexCount, int baseVertex, unsigned int instanceCount)
+{
+    static bool noCamera = false, badPosition = false, badRange = false;
+
+    const CameraBlock* camera = shader.hasUniformBlock(CAMERA_BLOCK_BINDING)
+        ? (const CameraBlock*)UniformBuffer::getBoundData(CAMERA_BLOCK_BINDING, sizeof(CameraBlock)) : nullptr;
+    if (!camera)
+    {
+        warnOnce(noCamera, "draws need a shader with the Camera block and a bound UniformBuffer; skipping them");
+        return;
+    }
+    const ObjectBlock* object = shader.hasUniformBlock(OBJECT_BLOCK_BINDING)
+        ? (const ObjectBlock*)UniformBuffer::getBoundData(OBJECT_BLOCK_BINDING, sizeof(ObjectBlock)) : nullptr;
+
+    const VertexAttribute* position = va.getAttribute(0);
+    if (!position || position->type != GL_FLOAT || position->count < 3 || position->divisor != 0)
+    {
+        warnOnce(badPosition, "location 0 must be a per-vertex vec3 or vec4 position; skipping the draw");
+        return;
+    }
+    int texCoordLocation = shader.getAttributeLocation("texCoord");
+    int colorLocation = shader.getAttributeLocation("a_color");
+    int modelLocation = shader.getAttributeLocation("a_model");
+    const VertexAttribute* texCoord = texCoordLocation >= 0 ? va.getAttribute(texCoordLocation) : nullptr;
+    const VertexAttribute* color = colorLocation >= 0 ? va.getAttribute(colorLocation) : nullptr;
+    const VertexAttribute* model[4] = {};
+    bool tinted = !shader.isDefined("UNTINTED");
+    for (int column = 0; modelLocation >= 0 && column < 4; column++)
+        model[column] = va.getAttribute(modelLocation + column);
+
+    // Only the vertices the indices reach are transformed.
+    if (firstIndex + indexCount > ib.getCount() || indexCount < 3)
+        return;
+    const unsigned int* indices = ib.getIndices() + firstIndex;
+    unsigned int lowest = *std::min_element(indices, indices + indexCount);
+    unsigned int highest = *std::max_element(indices, indices + indexCount);
+    unsigned int firstVertex = lowest + baseVertex;
+    unsigned int vertexCount = highest - lowest + 1;
+    bool inRange = isInBuffer(*position, firstVertex + vertexCount - 1) && (!texCoord || isInBuffer(*texCoord, firstVertex + vertexCount - 1))
+        && (!color || isInBuffer(*color, color->divisor ? (instanceCount - 1) / color->divisor : firstVertex + vertexCount - 1));
+    for (int column = 0; column < 4; column++)
+        inRange = inRange && (!model[column] || (model[column]->divisor && isInBuffer(*model[column], (instanceCount - 1) / model[column]->divisor)));
+    if (!inRange)
+    {
+        warnOnce(badRange, "a draw reads past the end of its vertex buffers; skipping it");
+        return;
+    }
+
+    m_clip.resize(vertexCount);
+    m_screen.resize(vertexCount);
+    m_outcodes.resize(vertexCount);
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        ScreenVertex& vertex = m_screen[i];
+        glm::vec4 coordinates = texCoord ? fetchAttribute(*texCoord, firstVertex + i) : glm::vec4(0.0f);
+        vertex.u = coordinates.x;
+        vertex.v = coordinates.y;
+        vertex.color = color && !color->divisor ? fetchAttribute(*color, firstVertex + i) : glm::vec4(1.0f);
+    }
+
+    // The shaders mirror x in clip space.
+    glm::mat4 flipX(1.0f);
+    flipX[0][0] = -1.0f;
+    glm::mat4 clipFromWorld = flipX * camera->u_viewProj;
+    const unsigned char* positions = position->buffer->getData() + position->offset + (size_t)firstVertex * position->stride;
+    unsigned int binnedBefore = (unsigned int)m_triangles.size();
+
+    for (unsigned int instance = 0; instance < instanceCount; instance++)
+    {
+        DrawState state;
+        state.region = texture && texture->isArray() && object;
+        unsigned int layer = state.region ? (unsigned int)(object->u_texLayer + 0.5f) : 0;
+        state.mips = texture && texture->getMipChain(layer).getPixels() ? &texture->getMipChain(layer) : nullptr;
+        state.rect = state.region ? object->u_texRect : glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        state.repeat = texture && texture->getOptions().repeat;
+        state.trilinear = texture && texture->getOptions().trilinear;
+        state.color = object && tinted ? object->u_color : glm::vec4(1.0f);
+        state.vertexColors = color && !color->divisor;
+        if (color && color->divisor && tinted)
+            state.color = fetchAttribute(*color, instance / color->divisor);
+        state.pass = m_pass;
+        m_draws.push_back(state);
+
+        glm::mat4 objectToWorld = object ? object->u_model : glm::mat4(1.0f);
+        if (model[0] && model[1] && model[2] && model[3])
+        {
+            for (int column = 0; column < 4; column++)
+                objectToWorld[column] = fetchAttribute(*model[column], instance / model[column]->divisor);
+        }
+        transformVertices(clipFromWorld * objectToWorld, positions, position->stride, vertexCount, position->count == 4);
+
+        for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+        {
+            unsigned int triangle[3] = { indices[i] - lowest, indices[i + 1] - lowest, indices[i + 2] - lowest };
+            unsigned char code0 = m_outcodes[triangle[0]], code1 = m_outcodes[triangle[1]], code2 = m_outcodes[triangle[2]];
+            if (code0 & code1 & code2 & ~OUTSIDE_GUARD_BAND)
+                continue;
+            if ((code0 | code1 | code2) & (OUTSIDE_NEAR | OUTSIDE_GUARD_BAND))
+                clipTriangle(triangle, m_draws.back());
+            else
+                setupTriangle(m_screen[triangle[0]], m_screen[triangle[1]], m_screen[triangle[2]], m_draws.back());
+        }
+    }
+    FrameStats::add(Stat::TrianglesBinned, m_triangles.size() - binnedBefore);
+}
+
+void SoftwareRasterizer::transformVertices(const glm::mat4& clipFromObject, const unsigned char* positions, unsigned int stride, unsigned int count, bool hasW)
+{
+    const float scaleX = (float)(m_width * SUBPIXELS), scaleY = (float)(m_height * SUBPIXELS);
+    const glm::mat4& m = clipFromObject;
+    unsigned int i = 0;
+
+#if RASTER_SSE
+    if (m_kernel != Kernel::Scalar)
+    {
+        __m128 matrix[4][4];
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 4; row++)
+                matrix[column][row] = _mm_set1_ps(m[column][row]);
+        }
+        const __m128 half = _mm_set1_ps(0.5f), one = _mm_set1_ps(1.0f);
+        const __m128 guard = _mm_set1_ps(GUARD_BAND);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            // Four vertices at a time, gathered into one register per coordinate.
+            float input[4][4];
+            for (unsigned int lane = 0; lane < 4; lane++)
+            {
+                const float* source = (const float*)(positions + (size_t)(i + lane) * stride);
+                input[0][lane] = source[0];
+                input[1][lane] = source[1];
+                input[2][lane] = source[2];
+                input[3][lane] = hasW ? source[3] : 1.0f;
+            }
+            __m128 x = _mm_loadu_ps(input[0]), y = _mm_loadu_ps(input[1]), z = _mm_loadu_ps(input[2]), w = _mm_loadu_ps(input[3]);
+            __m128 clip[4];
+            for (int row = 0; row < 4; row++)
+            {
+                clip[row] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix[0][row], x), _mm_mul_ps(matrix[1][row], y)),
+                    _mm_mul_ps(matrix[2][row], z)), _mm_mul_ps(matrix[3][row], w));
+            }
+
+            __m128 clipW = clip[3], negativeW = _mm_xor_ps(clip[3], signMask), guardW = _mm_mul_ps(clip[3], guard);
+            int left = _mm_movemask_ps(_mm_cmplt_ps(clip[0], negativeW));
+            int right = _mm_movemask_ps(_mm_cmpgt_ps(clip[0], clipW));
+            int bottom = _mm_movemask_ps(_mm_cmplt_ps(clip[1], negativeW));
+            int top = _mm_movemask_ps(_mm_cmpgt_ps(clip[1], clipW));
+            int nearPlane = _mm_movemask_ps(_mm_cmplt_ps(clip[2], negativeW));
+            int farPlane = _mm_movemask_ps(_mm_cmpgt_ps(clip[2], clipW));
+            int guardBand = _mm_movemask_ps(_mm_or_ps(_mm_cmpgt_ps(_mm_andnot_ps(signMask, clip[0]), guardW),
+                _mm_cmpgt_ps(_mm_andnot_ps(signMask, clip[1]), guardW)));
+
+            __m128 inverseW = _mm_div_ps(one, clipW);
+            __m128 screenX = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[0], inverseW), half), half), _mm_set1_ps(scaleX));
+            __m128 screenY = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[1], inverseW), half), half), _mm_set1_ps(scaleY));
+            __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[2], inverseW), half), half);
+            // Vertices that need clipping get projected again after it, so garbage here is harmless.
+            int snappedX[4], snappedY[4];
+            float depths[4], inverseWs[4], clipValues[4][4];
+            _mm_storeu_si128((__m128i*)snappedX, _mm_cvtps_epi32(screenX));
+            _mm_storeu_si128((__m128i*)snappedY, _mm_cvtps_epi32(screenY));
+            _mm_storeu_ps(depths, depth);
+            _mm_storeu_ps(inverseWs, inverseW);
+            for (int row = 0; row < 4; row++)
+                _mm_storeu_ps(clipValues[row], clip[row]);
+
+            for (unsigned int lane = 0; lane < 4; lane++)
+            {
+                m_clip[i + lane] = glm::vec4(clipValues[0][lane], clipValues[1][lane], clipValues[2][lane], clipValues[3][lane]);
+                m_outcodes[i + lane] = (unsigned char)((left >> lane & 1) * OUTSIDE_LEFT | (right >> lane & 1) * OUTSIDE_RIGHT
+                    | (bottom >> lane & 1) * OUTSIDE_BOTTOM | (top >> lane & 1) * OUTSIDE_TOP | (nearPlane >> lane & 1) * OUTSIDE_NEAR
+                    | (farPlane >> lane & 1) * OUTSIDE_FAR | (guardBand >> lane & 1) * OUTSIDE_GUARD_BAND);
+                ScreenVertex& vertex = m_screen[i + lane];
+                vertex.x = snappedX[lane];
+                vertex.y = snappedY[lane];
+                vertex.depth = depths[lane];
+                vertex.inverseW = inverseWs[lane];
+            }
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        const float* source = (const float*)(positions + (size_t)i * stride);
+        float w = hasW ? source[3] : 1.0f;
+        glm::vec4 clip;
+        for (int row = 0; row < 4; row++)
+            clip[row] = m[0][row] * source[0] + m[1][row] * source[1] + m[2][row] * source[2] + m[3][row] * w;
+        m_clip[i] = clip;
+
+        unsigned char code = 0;
+        code |= clip.x < -clip.w ? OUTSIDE_LEFT : 0;
+        code |= clip.x > clip.w ? OUTSIDE_RIGHT : 0;
+        code |= clip.y < -clip.w ? OUTSIDE_BOTTOM : 0;
+        code |= clip.y > clip.w ? OUTSIDE_TOP : 0;
+        code |= clip.z < -clip.w ? OUTSIDE_NEAR : 0;
+        code |= clip.z > clip.w ? OUTSIDE_FAR : 0;
+        code |= std::fabs(clip.x) > clip.w * GUARD_BAND || std::fabs(clip.y) > clip.w * GUARD_BAND ? OUTSIDE_GUARD_BAND : 0;
+        m_outcodes[i] = code;
+        if (!(code & (OUTSIDE_NEAR | OUTSIDE_GUARD_BAND)))
+        {
+            ScreenVertex projected = project(clip);
+            ScreenVertex& vertex = m_screen[i];
+            vertex.x = projected.x;
+            vertex.y = projected.y;
+            vertex.depth = projected.depth;
+            vertex.inverseW = projected.inverseW;
+        }
+    }
+}
+
+SoftwareRasterizer::ScreenVertex SoftwareRasterizer::project(const glm::vec4& clip) const
+{
+    // The same operations in the same order as the SIMD path, so shared vertices snap alike.
+    ScreenVertex vertex;
+    float inverseW = 1.0f / clip.w;
+    vertex.x = (int)std::nearbyint((clip.x * inverseW * 0.5f + 0.5f) * (float)(m_width * SUBPIXELS));
+    vertex.y = (int)std::nearbyint((clip.y * inverseW * 0.5f + 0.5f) * (float)(m_height * SUBPIXELS));
+    vertex.depth = clip.z * inverseW * 0.5f + 0.5f;
+    vertex.inverseW = inverseW;
+    return vertex;
+}
+
+void SoftwareRasterizer::clipTriangle(const unsigned int* vertices, const DrawState& state)
+{
+    ClipVertex buffers[2][MAX_CLIP_VERTICES];
+    ClipVertex* polygon = buffers[0];
+    ClipVertex* clipped = buffers[1];
+    unsigned int count = 3;
+    unsigned char codes = 0;
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        const ScreenVertex& vertex = m_screen[vertices[i]];
+        polygon[i] = { m_clip[vertices[i]], vertex.u, vertex.v, vertex.color, (int)vertices[i] };
+        codes |= m_outcodes[vertices[i]];
+    }
+
+    // Signed distances to the near plane and the four guard band planes, positive inside.
+    for (unsigned int plane = 0; plane < 5 && count >= 3; plane++)
+    {
+        if (plane == 0 ? !(codes & OUTSIDE_NEAR) : !(codes & OUTSIDE_GUARD_BAND))
+            continue;
+        auto distance = [plane](const glm::vec4& p) {
+            switch (plane)
+            {
+            case 0:     return p.z + p.w;
+            case 1:     return GUARD_BAND * p.w + p.x;
+            case 2:     return GUARD_BAND * p.w - p.x;
+            case 3:     return GUARD_BAND * p.w + p.y;
+            default:    return GUARD_BAND * p.w - p.y;
+            }
+        };
+
+        unsigned int clippedCount = 0;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const ClipVertex& current = polygon[i];
+            const ClipVertex& next = polygon[(i + 1) % count];
+            float currentDistance = distance(current.position), nextDistance = distance(next.position);
+            if (currentDistance >= 0.0f)
+                clipped[clippedCount++] = current;
+            if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+            {
+                float t = currentDistance / (currentDistance - nextDistance);
+                clipped[clippedCount++] = { current.position + (next.position - current.position) * t, current.u + (next.u - current.u) * t,
+                    current.v + (next.v - current.v) * t, current.color + (next.color - current.color) * t, -1 };
+            }
+        }
+        std::swap(polygon, clipped);
+        count = clippedCount;
+    }
+    if (count < 3)
+        return;
+
+    ScreenVertex screen[MAX_CLIP_VERTICES];
+    for (unsigned int i = 0; i < count; i++)
+    {
+        // Corners that survived keep the snapped position their neighbours use.
+        const ClipVertex& vertex = polygon[i];
+        screen[i] = vertex.source >= 0 ? m_screen[vertex.source] : project(vertex.position);
+        screen[i].u = vertex.u;
+        screen[i].v = vertex.v;
+        screen[i].color = vertex.color;
+    }
+    for (unsigned int i = 2; i < count; i++)
+        setupTriangle(screen[0], screen[i - 1], screen[i], state);
+}
+
+void SoftwareRasterizer::setupTriangle(ScreenVertex v0, ScreenVertex v1, ScreenVertex v2, const DrawState& state)
+{
+    long long area = (long long)(v1.x - v0.x) * (v2.y - v0.y) - (long long)(v2.x - v0.x) * (v1.y - v0.y);
+    if (area == 0)
+        return;
+    // Nothing culls back faces, so clockwise triangles are turned around.
+    if (area < 0)
+    {
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    Triangle triangle;
+    // Pixels whose centers fall inside the snapped bounds.
+    triangle.minX = std::max(0, (std::min(v0.x, std::min(v1.x, v2.x)) - PIXEL_CENTER + SUBPIXELS - 1) >> SUBPIXEL_BITS);
+    triangle.minY = std::max(0, (std::min(v0.y, std::min(v1.y, v2.y)) - PIXEL_CENTER + SUBPIXELS - 1) >> SUBPIXEL_BITS);
+    triangle.maxX = std::min((int)m_width - 1, (std::max(v0.x, std::max(v1.x, v2.x)) - PIXEL_CENTER) >> SUBPIXEL_BITS);
+    triangle.maxY = std::min((int)m_height - 1, (std::max(v0.y, std::max(v1.y, v2.y)) - PIXEL_CENTER) >> SUBPIXEL_BITS);
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+        return;
+
+    const ScreenVertex* vertices[3] = { &v0, &v1, &v2 };
+    for (unsigned int e = 0; e < 3; e++)
+    {
+        const ScreenVertex& a = *vertices[e];
+        const ScreenVertex& b = *vertices[(e + 1) % 3];
+        triangle.edgeA[e] = a.y - b.y;
+        triangle.edgeB[e] = b.x - a.x;
+        triangle.edgeC[e] = (long long)a.x * b.y - (long long)a.y * b.x;
+        // Fill rule: a pixel center exactly on an edge belongs to one of the two triangles
+        // sharing it, the one that sees the edge pointing up or, for flat edges, right.
+        if (!(triangle.edgeA[e] > 0 || (triangle.edgeA[e] == 0 && triangle.edgeB[e] > 0)))
+            triangle.edgeC[e] -= 1;
+    }
+
+    triangle.originX = v0.x / (float)SUBPIXELS;
+    triangle.originY = v0.y / (float)SUBPIXELS;
+    float x1 = (v1.x - v0.x) / (float)SUBPIXELS, y1 = (v1.y - v0.y) / (float)SUBPIXELS;
+    float x2 = (v2.x - v0.x) / (float)SUBPIXELS, y2 = (v2.y - v0.y) / (float)SUBPIXELS;
+    float inverseArea = 1.0f / (x1 * y2 - x2 * y1);
+    float values[3][PlaneCount];
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        const ScreenVertex& vertex = *vertices[i];
+        values[i][DepthPlane] = vertex.depth;
+        values[i][InverseWPlane] = vertex.inverseW;
+        values[i][UPlane] = vertex.u * vertex.inverseW;
+        values[i][VPlane] = vertex.v * vertex.inverseW;
+        for (unsigned int c = 0; c < 4; c++)
+            values[i][RedPlane + c] = vertex.color[c] * vertex.inverseW;
+    }
+    unsigned int planeCount = state.vertexColors ? PlaneCount : RedPlane;
+    for (unsigned int p = 0; p < planeCount; p++)
+    {
+        float delta1 = values[1][p] - values[0][p], delta2 = values[2][p] - values[0][p];
+        triangle.planes[p][0] = values[0][p];
+        triangle.planes[p][1] = (delta1 * y2 - delta2 * y1) * inverseArea;
+        triangle.planes[p][2] = (delta2 * x1 - delta1 * x2) * inverseArea;
+    }
+    triangle.draw = (unsigned int)(&state - m_draws.data());
+
+    // Into every tile the bounds touch, except those entirely outside one of the edges.
+    unsigned int index = (unsigned int)m_triangles.size();
+    bool binned = false;
+    const long long tileSpan = (TILE_SIZE - 1) * SUBPIXELS;
+    for (int tileY = triangle.minY / (int)TILE_SIZE; tileY <= triangle.maxY / (int)TILE_SIZE; tileY++)
+    {
+        for (int tileX = triangle.minX / (int)TILE_SIZE; tileX <= triangle.maxX / (int)TILE_SIZE; tileX++)
+        {
+            long long centerX = (long long)tileX * TILE_SIZE * SUBPIXELS + PIXEL_CENTER;
+            long long centerY = (long long)tileY * TILE_SIZE * SUBPIXELS + PIXEL_CENTER;
+            bool outside = false;
+            for (unsigned int e = 0; e < 3 && !outside; e++)
+            {
+                long long highest = triangle.edgeA[e] * centerX + triangle.edgeB[e] * centerY + triangle.edgeC[e]
+                    + std::max(0LL, triangle.edgeA[e] * tileSpan) + std::max(0LL, triangle.edgeB[e] * tileSpan);
+                outside = highest < 0;
+            }
+            if (outside)
+                continue;
+            m_bins[tileY * m_tilesX + tileX].push_back(index);
+            binned = true;
+        }
+    }
+    if (binned)
+        m_triangles.push_back(triangle);
+}
+
+void SoftwareRasterizer::resolve()
+{
+    unsigned int tileCount = m_tilesX * m_tilesY;
+    if (m_jobs)
+    {
+        m_jobs->wait(m_jobs->parallelFor("rasterize tiles", tileCount, 1, [this](unsigned int begin, unsigned int end) {
+            for (unsigned int tile = begin; tile < end; tile++)
+                rasterizeTile(tile);
+        }));
+    }
+    else
+    {
+        unsigned int threadCount = m_threadCount ? m_threadCount : std::max(1u, std::thread::hardware_concurrency());
+        threadCount = std::min(threadCount, tileCount);
+
+        // Tiles go to whichever thread asks next; each tile is drawn by one thread in submission
+        // order, so the result does not depend on which.
+        std::atomic<unsigned int> nextTile(0);
+        auto work = [this, &nextTile, tileCount]() {
+            for (unsigned int tile = nextTile++; tile < tileCount; tile = nextTile++)
+                rasterizeTile(tile);
+        };
+        std::vector<std::thread> workers;
+        for (unsigned int i = 1; i < threadCount; i++)
+            workers.emplace_back(work);
+        work();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    for (std::vector<unsigned int>& bin : m_bins)
+        bin.clear();
+    m_triangles.clear();
+    m_draws.clear();
+    m_clearPending = false;
+}
+
+void SoftwareRasterizer::rasterizeTile(unsigned int tile)
+{
+    int tileX = (int)(tile % m_tilesX) * TILE_SIZE, tileY = (int)(tile / m_tilesX) * TILE_SIZE;
+    int tileRight = std::min(tileX + (int)TILE_SIZE, (int)m_width) - 1, tileTop = std::min(tileY + (int)TILE_SIZE, (int)m_height) - 1;
+    if (m_clearPending)
+    {
+        unsigned int clearColor = packColor(m_clearColor);
+        for (int y = tileY; y <= tileTop; y++)
+        {
+            std::fill(m_color.begin() + y * m_width + tileX, m_color.begin() + y * m_width + tileRight + 1, clearColor);
+            std::fill(m_depth.begin() + y * m_depthPitch + tileX, m_depth.begin() + y * m_depthPitch + tileRight + 1, 1.0f);
+        }
+    }
+
+    for (unsigned int index : m_bins[tile])
+    {
+        const Triangle& triangle = m_triangles[index];
+        const DrawState& state = m_draws[triangle.draw];
+        int minX = std::max(triangle.minX, tileX), maxX = std::min(triangle.maxX, tileRight);
+        int minY = std::max(triangle.minY, tileY), maxY = std::min(triangle.maxY, tileTop);
+
+        // Edge values at the first pixel. An edge the whole rectangle is inside of is dropped,
+        // and the others are small enough here to step in 32 bits.
+        int start[3], stepX[3], stepY[3];
+        bool outside = false;
+        for (unsigned int e = 0; e < 3; e++)
+        {
+            long long a = triangle.edgeA[e] * (long long)SUBPIXELS, b = triangle.edgeB[e] * (long long)SUBPIXELS;
+            long long first = triangle.edgeA[e] * ((long long)minX * SUBPIXELS + PIXEL_CENTER) + triangle.edgeB[e] * ((long long)minY * SUBPIXELS + PIXEL_CENTER) + triangle.edgeC[e];
+            long long lowest = first + std::min(0LL, a * (maxX - minX)) + std::min(0LL, b * (maxY - minY));
+            long long highest = first + std::max(0LL, a * (maxX - minX)) + std::max(0LL, b * (maxY - minY));
+            outside = outside || highest < 0;
+            bool inside = lowest >= 0;
+            start[e] = inside ? 0 : (int)first;
+            stepX[e] = inside ? 0 : (int)a;
+            stepY[e] = inside ? 0 : (int)b;
+        }
+        if (outside)
+            continue;
+
+        const float* depthPlane = triangle.planes[DepthPlane];
+        float firstX = minX + 0.5f - triangle.originX;
+        for (int y = minY; y <= maxY; y++)
+        {
+            int row0 = start[0] + stepY[0] * (y - minY), row1 = start[1] + stepY[1] * (y - minY), row2 = start[2] + stepY[2] * (y - minY);
+            float rowDepth = depthPlane[0] + depthPlane[2] * (y + 0.5f - triangle.originY) + depthPlane[1] * firstX;
+            unsigned int* colorRow = m_color.data() + y * m_width;
+            float* depthRow = m_depth.data() + y * m_depthPitch;
+            int x = minX;
+
+#if RASTER_AVX2
+            if (m_kernel == Kernel::AVX2)
+            {
+                const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+                const __m256 laneOffsets = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+                __m256i laneSteps0 = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(stepX[0]));
+                __m256i laneSteps1 = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(stepX[1]));
+                __m256i laneSteps2 = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(stepX[2]));
+                __m256 depthStep = _mm256_set1_ps(depthPlane[1]), depthStart = _mm256_set1_ps(rowDepth);
+                // Groups start on multiples of 8 from the tile's edge, so they stay in the tile.
+                for (x = minX & ~7; x <= maxX; x += 8)
+                {
+                    int offset = x - minX;
+                    __m256i edge0 = _mm256_add_epi32(_mm256_set1_epi32(row0 + stepX[0] * offset), laneSteps0);
+                    __m256i edge1 = _mm256_add_epi32(_mm256_set1_epi32(row1 + stepX[1] * offset), laneSteps1);
+                    __m256i edge2 = _mm256_add_epi32(_mm256_set1_epi32(row2 + stepX[2] * offset), laneSteps2);
+                    // Inside when no edge value has its sign bit set, and only from minX to maxX.
+                    __m256i inside = _mm256_cmpgt_epi32(_mm256_or_si256(edge0, _mm256_or_si256(edge1, edge2)), _mm256_set1_epi32(-1));
+                    inside = _mm256_and_si256(inside, _mm256_cmpgt_epi32(_mm256_set1_epi32(maxX - x + 1), lanes));
+                    inside = _mm256_and_si256(inside, _mm256_cmpgt_epi32(lanes, _mm256_set1_epi32(minX - x - 1)));
+                    if (_mm256_testz_si256(inside, inside))
+                        continue;
+                    __m256 depth = _mm256_add_ps(depthStart, _mm256_mul_ps(depthStep, _mm256_add_ps(_mm256_set1_ps((float)offset), laneOffsets)));
+                    __m256 stored = _mm256_loadu_ps(depthRow + x);
+                    __m256 passed = _mm256_and_ps(_mm256_castsi256_ps(inside), state.pass.depthEqual ? _mm256_cmp_ps(depth, stored, _CMP_LE_OQ) : _mm256_cmp_ps(depth, stored, _CMP_LT_OQ));
+                    unsigned int mask = (unsigned int)_mm256_movemask_ps(passed);
+                    if (!mask)
+                        continue;
+                    if (state.pass.depthWrite)
+                        _mm256_storeu_ps(depthRow + x, _mm256_blendv_ps(stored, depth, passed));
+                    if (state.pass.colorWrite)
+                    {
+                        for (int lane = 0; lane < 8; lane++)
+                        {
+                            if (mask & (1u << lane))
+                                shadePixel(triangle, state, x + lane, y, colorRow[x + lane]);
+                        }
+                    }
+                }
+                continue;
+            }
+#endif
+#if RASTER_SSE
+            if (m_kernel == Kernel::SSE || m_kernel == Kernel::AVX2)
+            {
+                const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+                const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+                // SSE2 has no 32-bit multiply, but four lanes of steps are quick to write out.
+                __m128i laneSteps0 = _mm_setr_epi32(0, stepX[0], stepX[0] * 2, stepX[0] * 3);
+                __m128i laneSteps1 = _mm_setr_epi32(0, stepX[1], stepX[1] * 2, stepX[1] * 3);
+                __m128i laneSteps2 = _mm_setr_epi32(0, stepX[2], stepX[2] * 2, stepX[2] * 3);
+                __m128 depthStep = _mm_set1_ps(depthPlane[1]), depthStart = _mm_set1_ps(rowDepth);
+                for (x = minX & ~3; x <= maxX; x += 4)
+                {
+                    int offset = x - minX;
+                    __m128i edge0 = _mm_add_epi32(_mm_set1_epi32(row0 + stepX[0] * offset), laneSteps0);
+                    __m128i edge1 = _mm_add_epi32(_mm_set1_epi32(row1 + stepX[1] * offset), laneSteps1);
+                    __m128i edge2 = _mm_add_epi32(_mm_set1_epi32(row2 + stepX[2] * offset), laneSteps2);
+                    __m128i inside = _mm_cmpgt_epi32(_mm_or_si128(edge0, _mm_or_si128(edge1, edge2)), _mm_set1_epi32(-1));
+                    inside = _mm_and_si128(inside, _mm_cmpgt_epi32(_mm_set1_epi32(maxX - x + 1), lanes));
+                    inside = _mm_and_si128(inside, _mm_cmpgt_epi32(lanes, _mm_set1_epi32(minX - x - 1)));
+                    if (!_mm_movemask_epi8(inside))
+                        continue;
+                    __m128 depth = _mm_add_ps(depthStart, _mm_mul_ps(depthStep, _mm_add_ps(_mm_set1_ps((float)offset), laneOffsets)));
+                    __m128 stored = _mm_loadu_ps(depthRow + x);
+                    __m128 passed = _mm_and_ps(_mm_castsi128_ps(inside), state.pass.depthEqual ? _mm_cmple_ps(depth, stored) : _mm_cmplt_ps(depth, stored));
+                    unsigned int mask = (unsigned int)_mm_movemask_ps(passed);
+                    if (!mask)
+                        continue;
+                    if (state.pass.depthWrite)
+                        _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(passed, depth), _mm_andnot_ps(passed, stored)));
+                    if (state.pass.colorWrite)
+                    {
+                        for (int lane = 0; lane < 4; lane++)
+                        {
+                            if (mask & (1u << lane))
+                                shadePixel(triangle, state, x + lane, y, colorRow[x + lane]);
+                        }
+                    }
+                }
+                continue;
+            }
+#endif
+
+            for (; x <= maxX; x++)
+            {
+                int offset = x - minX;
+                if (((row0 + stepX[0] * offset) | (row1 + stepX[1] * offset) | (row2 + stepX[2] * offset)) < 0)
+                    continue;
+                float depth = rowDepth + depthPlane[1] * (float)offset;
+                if (state.pass.depthEqual ? !(depth <= depthRow[x]) : !(depth < depthRow[x]))
+                    continue;
+                if (state.pass.depthWrite)
+                    depthRow[x] = depth;
+                if (state.pass.colorWrite)
+                    shadePixel(triangle, state, x, y, colorRow[x]);
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::shadePixel(const Triangle& triangle, const DrawState& state, int x, int y, unsigned int& pixel) const
+{
+    float dx = x + 0.5f - triangle.originX, dy = y + 0.5f - triangle.originY;
+    auto evaluate = [&triangle, dx, dy](Plane plane) {
+        return triangle.planes[plane][0] + triangle.planes[plane][1] * dx + triangle.planes[plane][2] * dy;
+    };
+
+    // Attributes were interpolated divided by w; dividing by the interpolated 1/w corrects them.
+    float w = 1.0f / evaluate(InverseWPlane);
+    Footprint footprints[2] = {};
+    float levelBlend = 0.0f;
+    if (state.mips)
+    {
+        float u = evaluate(UPlane) * w, v = evaluate(VPlane) * w;
+        unsigned int level = 0;
+        unsigned int lastLevel = state.mips->getLevelCount() - 1;
+        if (lastLevel > 0)
+        {
+            // Screen-space derivatives of u = U / Q are (dU - u dQ) / Q, scaled to texels.
+            float width = state.mips->getWidth() * state.rect.z, height = state.mips->getHeight() * state.rect.w;
+            float dudx = (triangle.planes[UPlane][1] - u * triangle.planes[InverseWPlane][1]) * w * width;
+            float dvdx = (triangle.planes[VPlane][1] - v * triangle.planes[InverseWPlane][1]) * w * height;
+            float dudy = (triangle.planes[UPlane][2] - u * triangle.planes[InverseWPlane][2]) * w * width;
+            float dvdy = (triangle.planes[VPlane][2] - v * triangle.planes[InverseWPlane][2]) * w * height;
+            float rho = std::max(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy);
+            float lod = rho > 1.0f ? std::min(0.5f * approximateLog2(rho), (float)lastLevel) : 0.0f;
+            level = state.trilinear ? (unsigned int)lod : (unsigned int)(lod + 0.5f);
+            levelBlend = state.trilinear ? lod - level : 0.0f;
+        }
+        if (state.region)
+        {
+            u = state.rect.x + (u - floorToInt(u)) * state.rect.z;
+            v = state.rect.y + (v - floorToInt(v)) * state.rect.w;
+        }
+        footprints[0] = findFootprint(*state.mips, level, u, v, state.repeat);
+        if (levelBlend > 0.0f)
+            footprints[1] = findFootprint(*state.mips, level + 1, u, v, state.repeat);
+    }
+
+    // The color math is the same for every kernel, four channels at a time where SSE is available.
+#if RASTER_SSE
+    __m128 color = _mm_loadu_ps(&state.color[0]);
+    if (state.vertexColors)
+        color = _mm_mul_ps(_mm_setr_ps(evaluate(RedPlane), evaluate(GreenPlane), evaluate(BluePlane), evaluate(AlphaPlane)), _mm_set1_ps(w));
+    // Like GL, sampling without a texture reads opaque black.
+    __m128 texel = state.mips ? sampleBilinear(footprints[0]) : _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    if (levelBlend > 0.0f)
+        texel = _mm_add_ps(texel, _mm_mul_ps(_mm_sub_ps(sampleBilinear(footprints[1]), texel), _mm_set1_ps(levelBlend)));
+    __m128 source = _mm_mul_ps(texel, color);
+    if (state.pass.blending)
+    {
+        __m128 alpha = _mm_shuffle_ps(source, source, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128 destination = _mm_mul_ps(loadColor(pixel), _mm_set1_ps(1.0f / 255.0f));
+        source = _mm_add_ps(_mm_mul_ps(source, alpha), _mm_mul_ps(destination, _mm_sub_ps(_mm_set1_ps(1.0f), alpha)));
+    }
+    pixel = storeColor(source);
+#else
+    glm::vec4 color = state.color;
+    if (state.vertexColors)
+        color = glm::vec4(evaluate(RedPlane), evaluate(GreenPlane), evaluate(BluePlane), evaluate(AlphaPlane)) * w;
+    glm::vec4 texel = state.mips ? sampleBilinear(footprints[0]) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    if (levelBlend > 0.0f)
+        texel = glm::mix(texel, sampleBilinear(footprints[1]), levelBlend);
+    glm::vec4 source = texel * color;
+    if (state.pass.blending)
+        source = source * source.a + unpackColor(pixel) * (1.0f - source.a);
+    pixel = packColor(source);
+#endif
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+
+class VertexArray;
+class IndexBuffer;
+class Shader;
+class Texture;
+class MipChain;
+class JobSystem;
+
+// Renders the engine's draws on the CPU, for machines without a GPU and for reference images
+// that do not depend on a driver. Renderer hands draws to it instead of GL once it is set with
+// Renderer::setSoftwareRasterizer.
+//
+// Draws are processed on the calling thread as they come in: vertices are transformed four at
+// a time, triangles are clipped against the near plane and a guard band, snapped to 1/16 pixel
+// and sorted into 64x64 pixel tiles. resolve() then lets worker threads take tiles from a
+// shared counter and rasterize each tile's triangles in submission order with SIMD edge
+// functions, so the image is the same whatever the number of threads. Given a JobSystem, each
+// tile is a job on it instead.
+//
+// It emulates the engine's shaders rather than running them: the position is transformed by
+// the Camera block's u_viewProj and the model matrix from the a_model attribute or the Object
+// block, and the texture in slot 0 is multiplied by the color from the a_color attribute or
+// the Object block unless the program is an UNTINTED variant. Textures are sampled with the
+// wrapping and mip filter their options ask for, at the level of detail GL picks from the
+// texture coordinates' screen-space derivatives. Array textures are read as the ATLAS variant
+// of Simple.shader reads them, at the Object block's u_texLayer with coordinates repeating
+// within u_texRect. Anisotropic filtering is not emulated, and textures whose mips the driver
+// made sample their base level only.
+class SoftwareRasterizer
+{
+public:
+	enum class Kernel
+	{
+		Scalar,
+		SSE,
+		AVX2,
+		Best
+	};
+
+	// The fixed-function state of Renderer's passes.
+	struct PassState
+	{
+		bool colorWrite;
+		bool depthWrite;
+		// GL_LEQUAL instead of GL_LESS, to shade what a depth prepass laid down.
+		bool depthEqual;
+		// Source alpha blending.
+		bool blending;
+	};
+
+	static const unsigned int TILE_SIZE = 64;
+	static const unsigned int SUBPIXEL_BITS = 4;
+private:
+	// One draw's state, shared by its triangles.
+	struct DrawState
+	{
+		// The texture's levels, or nullptr to read opaque black as GL does without one.
+		const MipChain* mips;
+		// An array texture's region as offset and scale, which coordinates repeat within.
+		glm::vec4 rect;
+		bool region;
+		bool repeat;
+		bool trilinear;
+		glm::vec4 color;
+		bool vertexColors;
+		PassState pass;
+	};
+
+	// A vertex after the perspective divide, in 1/16 pixels.
+	struct ScreenVertex
+	{
+		int x, y;
+		float depth, inverseW;
+		float u, v;
+		glm::vec4 color;
+	};
+
+	// Values interpolated across a triangle, divided by w where they need perspective correction.
+	enum Plane
+	{
+		DepthPlane,
+		InverseWPlane,
+		UPlane,
+		VPlane,
+		RedPlane,
+		GreenPlane,
+		BluePlane,
+		AlphaPlane,
+		PlaneCount
+	};
+
+	struct Triangle
+	{
+		// Edge functions in 1/16 pixels, positive inside, with the fill rule folded into c.
+		int edgeA[3], edgeB[3];
+		long long edgeC[3];
+		// Pixel bounds, inclusive and clamped to the target.
+		int minX, minY, maxX, maxY;
+		// Each plane is its value at the origin and its change per pixel in x and y.
+		float originX, originY;
+		float planes[PlaneCount][3];
+		unsigned int draw;
+	};
+
+	unsigned int m_width;
+	unsigned int m_height;
+	unsigned int m_tilesX;
+	unsigned int m_tilesY;
+	// RGBA8 and depth, rows bottom to top like glReadPixels. Depth rows are padded to whole
+	// SIMD groups, so a group never reaches into the next row, which may be another tile's.
+	std::vector<unsigned int> m_color;
+	std::vector<float> m_depth;
+	unsigned int m_depthPitch;
+	glm::vec4 m_clearColor;
+	bool m_clearPending;
+	PassState m_pass;
+	Kernel m_kernel;
+	unsigned int m_threadCount;
+	JobSystem* m_jobs;
+
+	std::vector<DrawState> m_draws;
+	std::vector<Triangle> m_triangles;
+	std::vector<std::vector<unsigned int>> m_bins;
+
+	// Per-vertex scratch of the draw being processed.
+	std::vector<glm::vec4> m_clip;
+	std::vector<ScreenVertex> m_screen;
+	std::vector<unsigned char> m_outcodes;
+public:
+	SoftwareRasterizer(unsigned int width, unsigned int height);
+
+	// Clears color and depth; draws binned before it are resolved first.
+	void clear(const glm::vec4& color = glm::vec4(0.0f));
+	inline void setPassState(const PassState& pass) { m_pass = pass; }
+
+	// Processes indexCount indices from firstIndex, each offset by baseVertex, instanceCount
+	// times. Uniform blocks are read from what UniformBuffer last bound.
+	void draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const Texture* texture,
+		unsigned int firstIndex, unsigned int indexCount, int baseVertex = 0, unsigned int instanceCount = 1);
+	// Rasterizes everything drawn since the last resolve.
+	void resolve();
+
+	// Rasterizes on up to threadCount threads (0 for one per core).
+	inline void setThreadCount(unsigned int threadCount) { m_threadCount = threadCount; }
+	// Rasterizes tiles as jobs instead of on threads of its own; nullptr goes back to threads.
+	inline void setJobSystem(JobSystem* jobs) { m_jobs = jobs; }
+	inline void setKernel(Kernel kernel) { m_kernel = kernel == Kernel::Best ? getBestKernel() : kernel; }
+	inline unsigned int getWidth() const { return m_width; }
+	inline unsigned int getHeight() const { return m_height; }
+	// RGBA8 pixels, rows bottom to top; valid after resolve.
+	inline const unsigned char* getPixels() const { return (const unsigned char*)m_color.data(); }
+
+	static Kernel getBestKernel();
+	static const char* getKernelName(Kernel kernel);
+private:
+	void transformVertices(const glm::mat4& clipFromObject, const unsigned char* positions, unsigned int stride, unsigned int count, bool hasW);
+	void clipTriangle(const unsigned int* vertices, const DrawState& state);
+	void setupTriangle(ScreenVertex v0, ScreenVertex v1, ScreenVertex v2, const DrawState& state);
+	ScreenVertex project(const glm::vec4& clip) const;
+	void rasterizeTile(unsigned int tile);
+	void shadePixel(const Triangle& triangle, const DrawState& state, int x, int y, unsigned int& pixel) const;
+};
@@ -0,0 +1,102 @@
+#include "StreamingScene.h"
+#include "ShaderLibrary.h"
+#include "VertexBufferLayout.h"
+#include "Renderer.h"
+#include <glm/ext/matrix_transform.hpp>
+
+static constexpr Uniform<int> u_texture("u_texture");
+
+const float StreamingScene::FAR_PLANE = 100.0f;
+
+static const float tileVertices[] = {
+    -0.2f,  0.0f, -0.2f,  0.0f,  0.0f,
+     0.2f,  0.0f, -0.2f,  1.0f,  0.0f,
+     0.2f,  0.0f,  0.2f,  1.0f,  1.0f,
+    -0.2f,  0.0f,  0.2f,  0.0f,  1.0f,
+};
+
+static const unsigned int tileIndices[] = {
+    0, 1, 2,
+    2, 3, 0,
+};
+
+static const char* const texturePaths[] = { "res/textures/Tile.png", "res/textures/whiteTile.png" };
+
+StreamingScene::StreamingScene(bool streamed)
+    : m_streamed(streamed), m_tileVB(tileVertices, sizeof(tileVertices)), m_tileIB(tileIndices, sizeof(tileIndices) / sizeof(unsigned int)),
+    m_shader(ShaderLibrary::load("res/shaders/Simple.shader")), m_uniformBuffer(sizeof(CameraBlock) + TILES_X * TILES_Z * sizeof(ObjectBlock)),
+    m_streamer(nullptr), m_frame(0), m_requested(0)
+{
+    VertexBufferLayout layout;
+    layout.push<float>(3);
+    layout.push<float>(2);
+    m_tileVA.addBuffer(m_tileVB, layout);
+    m_tileVA.bind();
+    m_tileIB.bind();
+    m_tileVA.unbind();
+
+    m_shader->bindUniformBlock(CameraBlock::getLayout());
+    m_shader->bindUniformBlock(ObjectBlock::getLayout());
+    m_shader->bind();
+    m_shader->setUniform(u_texture, 0);
+
+    for (int z = 0; z < TILES_Z; z++)
+    {
+        for (int x = 0; x < TILES_X; x++)
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((x - TILES_X / 2 + 0.5f) * 0.5f, 0.0f, (z - TILES_Z / 2 + 0.5f) * 0.5f));
+            glm::vec4 color(0.5f + 0.5f * x / TILES_X, 0.6f, 0.5f + 0.5f * z / TILES_Z, 1.0f);
+            m_tiles.push_back(ObjectBlock{ model, color });
+        }
+    }
+    m_textures.resize(m_tiles.size());
+    m_objectOffsets.resize(m_tiles.size());
+}
+
+void StreamingScene::onUpdate(float deltaTime)
+{
+    // Start over once everything has arrived, dropping the textures so they load again.
+    if (m_requested == m_tiles.size() && getResidentCount() == m_tiles.size())
+    {
+        for (std::shared_ptr<Texture>& texture : m_textures)
+            texture.reset();
+        m_requested = 0;
+    }
+    if (m_frame++ % FRAMES_PER_BURST == 0)
+    {
+        for (int i = 0; i < LOADS_PER_BURST && m_requested < m_tiles.size(); i++, m_requested++)
+        {
+            const char* path = texturePaths[m_requested % 2];
+            m_textures[m_requested] = m_streamed ? m_streamer.load(path) : std::make_shared<Texture>(path);
+        }
+    }
+    m_streamer.update();
+}
+
+void StreamingScene::onRender(const Renderer& renderer, const Camera& camera)
+{
+    m_uniformBuffer.beginFrame();
+    unsigned int cameraOffset = m_uniformBuffer.push(CameraBlock{ camera.proj * camera.view, glm::vec4(camera.position, 1.0f) });
+    for (size_t i = 0; i < m_tiles.size(); i++)
+        m_objectOffsets[i] = m_uniformBuffer.push(m_tiles[i]);
+    m_uniformBuffer.upload();
+    m_uniformBuffer.bindBlock<CameraBlock>(cameraOffset);
+
+    m_queue.beginFrame(camera, FAR_PLANE);
+    for (size_t i = 0; i < m_tiles.size(); i++)
+    {
+        if (m_textures[i])
+            m_queue.submit(m_tileVA, m_tileIB, *m_shader, *m_textures[i], m_objectOffsets[i], glm::vec3(m_tiles[i].u_model[3]));
+    }
+    m_queue.execute(renderer, m_uniformBuffer);
+
+    m_uniformBuffer.endFrame();
+}
+
+unsigned int StreamingScene::getResidentCount() const
+{
+    unsigned int resident = 0;
+    for (const std::shared_ptr<Texture>& texture : m_textures)
+        resident += texture && texture->isResident();
+    return resident;
+}
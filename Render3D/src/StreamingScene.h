@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include "Scene.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "UniformBuffer.h"
+#include "RenderQueue.h"
+#include "TextureStreamer.h"
+
+// A floor of tiles that each load their own texture while the scene runs: a burst of new
+// textures every few frames, and once all of them are resident they are dropped and loaded
+// again, so a run keeps loading. Streamed, tiles show a grey placeholder until their texture
+// arrives through the TextureStreamer; blocking, every texture is loaded in the frame that
+// asks for it, which is the stall streaming avoids.
+class StreamingScene : public Scene
+{
+private:
+	static const int TILES_X = 20;
+	static const int TILES_Z = 15;
+	static const int LOADS_PER_BURST = 100;
+	static const int FRAMES_PER_BURST = 4;
+	static const float FAR_PLANE;
+
+	bool m_streamed;
+	VertexArray m_tileVA;
+	VertexBuffer m_tileVB;
+	IndexBuffer m_tileIB;
+	std::shared_ptr<Shader> m_shader;
+	UniformBuffer m_uniformBuffer;
+	RenderQueue m_queue;
+	TextureStreamer m_streamer;
+	std::vector<ObjectBlock> m_tiles;
+	std::vector<std::shared_ptr<Texture>> m_textures;
+	std::vector<unsigned int> m_objectOffsets;
+	unsigned int m_frame;
+	unsigned int m_requested;
+public:
+	StreamingScene(bool streamed = true);
+
+	void onUpdate(float deltaTime) override;
+	void onRender(const Renderer& renderer, const Camera& camera) override;
+	void setJobSystem(JobSystem* jobs) override { m_streamer.setJobSystem(jobs); }
+
+	inline const TextureStreamer& getStreamer() const { return m_streamer; }
+	// Tiles whose texture is resident.
+	unsigned int getResidentCount() const;
+	inline unsigned int getTileCount() const { return (unsigned int)m_tiles.size(); }
+};
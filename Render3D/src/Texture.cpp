@@ -1,38 +1,344 @@
 #include "Texture.h"
+#include "GLState.h"
+#include "ResourcePack.h"
 #include "stb_image/stb_image.h"
+#include <algorithm>
 
-Texture::Texture(const std::string& path) : m_rendererId(0), m_filePath(path), m_localBuffer(nullptr), m_width(0), m_height(0), m_bpp(0)
+const Texture* Texture::s_bound[MAX_SLOTS] = {};
+Texture::Options Texture::s_defaultOptions = { Texture::Mips::Box, true, 1.0f, true, true };
+bool Texture::s_compressedUpload = true;
+unsigned long long Texture::s_useClock = 0;
+
+static bool hasTextureStorage()
+{
+	return GLEW_VERSION_4_2 || GLEW_ARB_texture_storage;
+}
+
+static unsigned int getInternalFormat(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case BlockFormat::BC3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	default:
+		return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+}
+
+// Fills every level of a texture from createTexture: the chain's levels from firstLevel down,
+// or the base level and what glGenerateMipmap makes of it.
+static void uploadLevels(unsigned int rendererId, const MipChain& mips, const Texture::Options& options, unsigned int firstLevel = 0)
+{
+	if (firstLevel >= mips.getLevelCount())
+		return;
+	GLState::bindTexture(GL_TEXTURE_2D, rendererId);
+	for (unsigned int level = firstLevel; level < mips.getLevelCount(); level++)
+	{
+		const MipChain::Level& size = mips.getLevel(level);
+		GLCall(glTexSubImage2D(GL_TEXTURE_2D, level - firstLevel, 0, 0, size.width, size.height, GL_RGBA, GL_UNSIGNED_BYTE, mips.getPixels(level)));
+	}
+	if (options.mips == Texture::Mips::Driver)
+	{
+		GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+	}
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
+}
+
+static void uploadBlocks(unsigned int rendererId, const CompressedImage& image, unsigned int internalFormat, unsigned int firstLevel = 0)
+{
+	GLState::bindTexture(GL_TEXTURE_2D, rendererId);
+	for (unsigned int level = firstLevel; level < image.getLevelCount(); level++)
+	{
+		const CompressedImage::Level& size = image.getLevel(level);
+		if (hasTextureStorage())
+		{
+			GLCall(glCompressedTexSubImage2D(GL_TEXTURE_2D, level - firstLevel, 0, 0, size.width, size.height, internalFormat, (GLsizei)size.size, image.getBlocks(level)));
+		}
+		else
+		{
+			GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, level - firstLevel, internalFormat, size.width, size.height, 0, (GLsizei)size.size, image.getBlocks(level)));
+		}
+	}
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
+}
+
+Texture::Texture(const std::string& path, const Options& options)
+	: m_rendererId(0), m_target(GL_TEXTURE_2D), m_filePath(path), m_width(0), m_height(0), m_options(options), m_bpp(0), m_resident(true),
+	m_firstLevel(0), m_lastUse(0)
+{
+	if (path.size() > 4 && path.compare(path.size() - 4, 4, ".dds") == 0)
+	{
+		CompressedImage::readDDS(path, m_compressed);
+		m_width = m_compressed.getWidth();
+		m_height = m_compressed.getHeight();
+		m_bpp = 4;
+		m_options.mips = m_compressed.getLevelCount() > 1 ? Mips::Box : Mips::None;
+		if (s_compressedUpload && isFormatSupported(m_compressed.getFormat()))
+		{
+			unsigned int internalFormat = getInternalFormat(m_compressed.getFormat());
+			m_rendererId = createTexture(m_width, m_height, std::max(1u, m_compressed.getLevelCount()), m_options, internalFormat);
+			uploadBlocks(m_rendererId, m_compressed, internalFormat);
+			return;
+		}
+		m_mips = m_compressed.decode();
+		m_compressed = CompressedImage();
+		m_rendererId = createTexture(m_width, m_height, std::max(1u, m_mips.getLevelCount()), m_options);
+		uploadLevels(m_rendererId, m_mips, m_options);
+		return;
+	}
+
+	int width, height;
+	if (unsigned char* pixels = decodeImage(path, &width, &height, &m_bpp))
+	{
+		m_mips = MipChain(width, height, pixels);
+		stbi_image_free(pixels);
+		generateMips(m_mips, options);
+	}
+	m_width = m_mips.getWidth();
+	m_height = m_mips.getHeight();
+	m_rendererId = createTexture(m_width, m_height, getLevelCount(m_width, m_height, options), options);
+	uploadLevels(m_rendererId, m_mips, options);
+}
+
+unsigned char* Texture::decodeImage(const std::string& path, int* width, int* height, int* bpp)
+{
+	Resource file = ResourcePack::load(path);
+	if (!file.isValid() || file.getSize() > 0x7FFFFFFF)
+		return nullptr;
+	// Per thread, since streamed textures decode on job threads at the same time.
+	stbi_set_flip_vertically_on_load_thread(1);
+	return stbi_load_from_memory(file.getData(), (int)file.getSize(), width, height, bpp, 4);
+}
+
+Texture::Texture(int width, int height, const unsigned char* pixels, const Options& options)
+	: m_rendererId(0), m_target(GL_TEXTURE_2D), m_width(width), m_height(height), m_mips(width, height, pixels), m_options(options), m_bpp(4), m_resident(true),
+	m_firstLevel(0), m_lastUse(0)
+{
+	generateMips(m_mips, options);
+	m_rendererId = createTexture(width, height, getLevelCount(width, height, options), options);
+	uploadLevels(m_rendererId, m_mips, options);
+}
+
+Texture::Texture(std::vector<MipChain>&& layers, const Options& options)
+	: m_rendererId(0), m_target(GL_TEXTURE_2D_ARRAY), m_width(0), m_height(0), m_layers(std::move(layers)), m_options(options), m_bpp(4), m_resident(true),
+	m_firstLevel(0), m_lastUse(0)
 {
-	stbi_set_flip_vertically_on_load(1);
-	m_localBuffer = stbi_load(path.c_str(), &m_width, &m_height, &m_bpp, 4);
+	unsigned int levelCount = 1;
+	if (!m_layers.empty())
+	{
+		m_width = m_layers[0].getWidth();
+		m_height = m_layers[0].getHeight();
+		levelCount = std::max(1u, m_layers[0].getLevelCount());
+	}
+	m_options.mips = levelCount > 1 ? Mips::Box : Mips::None;
+	m_rendererId = createTexture(m_width, m_height, levelCount, m_options, GL_RGBA8, std::max(1u, (unsigned int)m_layers.size()));
 
-	GLCall(glGenTextures(1, &m_rendererId));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_rendererId));
+	GLState::bindTexture(GL_TEXTURE_2D_ARRAY, m_rendererId);
+	for (unsigned int layer = 0; layer < m_layers.size(); layer++)
+	{
+		for (unsigned int level = 0; level < m_layers[layer].getLevelCount(); level++)
+		{
+			const MipChain::Level& size = m_layers[layer].getLevel(level);
+			GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size.width, size.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, m_layers[layer].getPixels(level)));
+		}
+	}
+	GLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
 
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+unsigned int Texture::createTexture(int width, int height, unsigned int levelCount, const Options& options, unsigned int internalFormat,
+	unsigned int layerCount)
+{
+	unsigned int target = layerCount ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+	unsigned int rendererId;
+	GLCall(glGenTextures(1, &rendererId));
+	GLState::bindTexture(target, rendererId);
 
-	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_localBuffer));
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	bool mipmapped = levelCount > 1;
+	GLCall(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, !mipmapped ? GL_LINEAR : options.trilinear ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST));
+	GLCall(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(target, GL_TEXTURE_WRAP_S, options.repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(target, GL_TEXTURE_WRAP_T, options.repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levelCount - 1));
+	float anisotropy = std::min(options.anisotropy, getMaxAnisotropy());
+	if (anisotropy > 1.0f)
+	{
+		GLCall(glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy));
+	}
 
-	if (m_localBuffer)
-		stbi_image_free(m_localBuffer);
+	// Immutable storage lets the driver check the texture complete once instead of at every
+	// draw. A failed load leaves no texels, and sampling the incomplete texture reads black.
+	if (width > 0 && height > 0 && layerCount)
+	{
+		if (hasTextureStorage())
+		{
+			GLCall(glTexStorage3D(GL_TEXTURE_2D_ARRAY, levelCount, internalFormat, width, height, layerCount));
+		}
+		else
+		{
+			for (unsigned int level = 0; level < levelCount; level++)
+			{
+				GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, std::max(1, width >> level), std::max(1, height >> level), layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+			}
+		}
+	}
+	else if (width > 0 && height > 0)
+	{
+		if (hasTextureStorage())
+		{
+			GLCall(glTexStorage2D(GL_TEXTURE_2D, levelCount, internalFormat, width, height));
+		}
+		else if (internalFormat == GL_RGBA8)
+		{
+			for (unsigned int level = 0; level < levelCount; level++)
+			{
+				GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, std::max(1, width >> level), std::max(1, height >> level), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+			}
+		}
+	}
+	GLState::bindTexture(target, 0);
+	return rendererId;
+}
+
+unsigned int Texture::getLevelCount(int width, int height, const Options& options)
+{
+	return options.mips == Mips::None ? 1 : MipChain::getFullLevelCount(width, height);
+}
+
+float Texture::getMaxAnisotropy()
+{
+	// Asked once: every texture the streamer makes would otherwise query it.
+	static float maxAnisotropy = 0.0f;
+	if (maxAnisotropy == 0.0f)
+	{
+		maxAnisotropy = 1.0f;
+		if (GLEW_EXT_texture_filter_anisotropic || GLEW_ARB_texture_filter_anisotropic)
+		{
+			GLCall(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy));
+		}
+	}
+	return maxAnisotropy;
+}
+
+bool Texture::isFormatSupported(BlockFormat format)
+{
+	if (format == BlockFormat::BC7)
+		return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+	return GLEW_EXT_texture_compression_s3tc;
+}
+
+const MipChain& Texture::getMipChain(unsigned int layer) const
+{
+	if (isArray())
+		return layer < m_layers.size() ? m_layers[layer] : m_mips;
+	if (!m_mips.getLevelCount() && m_compressed.getLevelCount())
+		m_mips = m_compressed.decode();
+	return m_mips;
+}
+
+size_t Texture::getVideoMemorySize(unsigned int firstLevel) const
+{
+	size_t size = 0;
+	if (isCompressed())
+	{
+		for (unsigned int level = firstLevel; level < m_compressed.getLevelCount(); level++)
+			size += m_compressed.getLevel(level).size;
+		return size;
+	}
+	if (isArray())
+	{
+		for (const MipChain& layer : m_layers)
+			size += layer.getData().size();
+		return size;
+	}
+	// Driver mips exist only in the GL texture; every other level is in the chain.
+	unsigned int levelCount = m_options.mips == Mips::Driver ? getLevelCount(m_width, m_height, m_options) : m_mips.getLevelCount();
+	for (unsigned int level = firstLevel; level < levelCount && m_width > 0 && m_height > 0; level++)
+		size += (size_t)std::max(1, m_width >> level) * std::max(1, m_height >> level) * 4;
+	return size;
+}
+
+bool Texture::setFirstLevel(unsigned int level)
+{
+	if (level == m_firstLevel)
+		return true;
+	unsigned int levelCount = isCompressed() ? m_compressed.getLevelCount() : m_mips.getLevelCount();
+	if (isArray() || !m_resident || m_options.mips == Mips::Driver || level >= levelCount)
+		return false;
+
+	unsigned int rendererId;
+	if (isCompressed())
+	{
+		unsigned int internalFormat = getInternalFormat(m_compressed.getFormat());
+		const CompressedImage::Level& size = m_compressed.getLevel(level);
+		rendererId = createTexture(size.width, size.height, levelCount - level, m_options, internalFormat);
+		uploadBlocks(rendererId, m_compressed, internalFormat, level);
+	}
+	else
+	{
+		const MipChain::Level& size = m_mips.getLevel(level);
+		rendererId = createTexture(size.width, size.height, levelCount - level, m_options);
+		uploadLevels(rendererId, m_mips, m_options, level);
+	}
+	GLCall(glDeleteTextures(1, &m_rendererId));
+	GLState::onTextureDeleted(m_rendererId);
+	m_rendererId = rendererId;
+	m_firstLevel = level;
+	return true;
 }
 
 Texture::~Texture()
 {
+	for (unsigned int slot = 0; slot < MAX_SLOTS; slot++)
+	{
+		if (s_bound[slot] == this)
+			s_bound[slot] = nullptr;
+	}
 	GLCall(glDeleteTextures(1, &m_rendererId));
+	GLState::onTextureDeleted(m_rendererId);
 }
 
 void Texture::bind(unsigned int slot) const
 {
-	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_rendererId));
+	markUsed();
+	GLState::bindTexture(m_target, slot, m_rendererId);
+	if (slot < MAX_SLOTS)
+		s_bound[slot] = this;
 }
 
 void Texture::unbind() const
 {
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	GLState::bindTexture(m_target, 0);
+	for (unsigned int slot = 0; slot < MAX_SLOTS; slot++)
+	{
+		if (s_bound[slot] == this)
+			s_bound[slot] = nullptr;
+	}
+}
+
+void Texture::generateMips(MipChain& mips, const Options& options)
+{
+	if (options.mips == Mips::Box)
+		mips.generate(MipChain::Filter::Box, options.srgb, options.repeat);
+	else if (options.mips == Mips::Kaiser)
+		mips.generate(MipChain::Filter::Kaiser, options.srgb, options.repeat);
+}
+
+void Texture::replace(unsigned int rendererId, MipChain&& mips)
+{
+	GLCall(glDeleteTextures(1, &m_rendererId));
+	GLState::onTextureDeleted(m_rendererId);
+	m_rendererId = rendererId;
+	m_mips = std::move(mips);
+	m_width = m_mips.getWidth();
+	m_height = m_mips.getHeight();
+	m_bpp = 4;
+	m_resident = true;
+	m_firstLevel = 0;
+}
+
+const Texture* Texture::getBound(unsigned int slot)
+{
+	return slot < MAX_SLOTS ? s_bound[slot] : nullptr;
 }
\ No newline at end of file
@@ -1,21 +1,143 @@
 #pragma once
 
+#include <vector>
 #include "Renderer.h"
+#include "MipChain.h"
+#include "CompressedImage.h"
 
 class Texture
 {
+	friend class TextureStreamer;
+public:
+	// Where the levels below the base one come from. Without them a minified surface samples
+	// texels far apart, which aliases and misses the texture cache on every fetch.
+	enum class Mips
+	{
+		None,
+		// glGenerateMipmap: quick, but most drivers box filter the stored sRGB values.
+		Driver,
+		// MipChain on the CPU, filtered in linear light.
+		Box,
+		Kaiser
+	};
+
+	struct Options
+	{
+		Mips mips;
+		// Blends the two nearest levels instead of sampling the nearest one.
+		bool trilinear;
+		// Most samples along the direction of greatest minification, up to what the driver
+		// allows; 1 turns anisotropic filtering off.
+		float anisotropy;
+		// GL_REPEAT rather than GL_CLAMP_TO_EDGE, so texture coordinates can tile a surface.
+		bool repeat;
+		// The texels are sRGB-encoded color rather than data like normals, which MipChain has
+		// to filter in linear light.
+		bool srgb;
+	};
 private:
+	static const unsigned int MAX_SLOTS = 32;
+	// What bind() last put in each slot, so the software rasterizer can sample it.
+	static const Texture* s_bound[MAX_SLOTS];
+	static Options s_defaultOptions;
+	static bool s_compressedUpload;
+	static unsigned long long s_useClock;
+
 	unsigned int m_rendererId;
+	// GL_TEXTURE_2D, or GL_TEXTURE_2D_ARRAY for layered textures.
+	unsigned int m_target;
 	std::string m_filePath;
-	unsigned char* m_localBuffer;
-	int m_width, m_height, m_bpp;
+	int m_width, m_height;
+	// A compressed texture's blocks, kept to decode m_mips from when the software rasterizer
+	// first samples it.
+	CompressedImage m_compressed;
+	mutable MipChain m_mips;
+	// Every layer of a texture array; m_mips is unused for them.
+	std::vector<MipChain> m_layers;
+	Options m_options;
+	int m_bpp;
+	bool m_resident;
+	// The chain level the GL texture's base level holds, above 0 once levels were dropped.
+	unsigned int m_firstLevel;
+	mutable unsigned long long m_lastUse;
 public:
-	Texture(const std::string& path);
+	// Loads and uploads the image before returning; TextureStreamer loads without stalling.
+	// A .dds file uploads its blocks as they are, levels included, so the options' mips become
+	// None or Box to say whether it has any. Drivers without its format get it decoded on the CPU.
+	Texture(const std::string& path, const Options& options = getDefaultOptions());
+	// Uploads width * height RGBA8 texels, bottom row first.
+	Texture(int width, int height, const unsigned char* pixels, const Options& options = getDefaultOptions());
+	// Uploads chains of the same size and level count as the layers of a GL_TEXTURE_2D_ARRAY.
+	// The chains bring their own levels, so the options' mips are not applied.
+	Texture(std::vector<MipChain>&& layers, const Options& options);
 	~Texture();
 
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
 	void bind(unsigned int slot = 0) const;
 	void unbind() const;
 
 	inline int getWidth() const { return m_width; }
 	inline int getHeight() const { return m_height; }
-};
\ No newline at end of file
+	inline unsigned int getRendererId() const { return m_rendererId; }
+	inline unsigned int getTarget() const { return m_target; }
+	inline bool isArray() const { return m_target == GL_TEXTURE_2D_ARRAY; }
+	inline unsigned int getLayerCount() const { return isArray() ? (unsigned int)m_layers.size() : 1; }
+	// RGBA8 texels of the base level, bottom row first; kept after the upload for the software rasterizer.
+	inline const unsigned char* getPixels() const { return getMipChain().getPixels(); }
+	// The base level and, for mips made on the CPU or read from a file, the levels below it.
+	const MipChain& getMipChain(unsigned int layer = 0) const;
+	inline const Options& getOptions() const { return m_options; }
+	// Whether the GL texture holds compressed blocks rather than RGBA8.
+	inline bool isCompressed() const { return m_compressed.getLevelCount() > 0; }
+	// Bytes of every level the GL texture stores, before any padding the driver adds.
+	inline size_t getVideoMemorySize() const { return getVideoMemorySize(m_firstLevel); }
+	// What it would store holding the levels from firstLevel down.
+	size_t getVideoMemorySize(unsigned int firstLevel) const;
+	// False while a streamed texture still shows its placeholder.
+	inline bool isResident() const { return m_resident; }
+
+	// Recreates the GL texture with the levels from this one down, to save video memory or to
+	// take dropped levels back, uploading them from the levels kept on the CPU. The software
+	// rasterizer keeps sampling every level. Returns false for textures without those levels:
+	// driver mips, arrays and streamed textures still loading.
+	bool setFirstLevel(unsigned int level);
+	inline unsigned int getFirstLevel() const { return m_firstLevel; }
+	// Marks the texture as used now; bind does, so the oldest mark is the least recently used.
+	inline void markUsed() const { m_lastUse = ++s_useClock; }
+	inline unsigned long long getLastUse() const { return m_lastUse; }
+	// The mark the next use goes past.
+	static inline unsigned long long getUseClock() { return s_useClock; }
+
+	// The texture last bound to a slot, or nullptr.
+	static const Texture* getBound(unsigned int slot);
+
+	// What textures are made with when no options are given: Box mips, trilinear and
+	// repeating. Anisotropic filtering is off, since software rasterizers pay for every sample.
+	static inline const Options& getDefaultOptions() { return s_defaultOptions; }
+	static inline void setDefaultOptions(const Options& options) { s_defaultOptions = options; }
+	// The driver's anisotropy limit, or 1 without anisotropic filtering.
+	static float getMaxAnisotropy();
+	// Whether the driver samples the format: S3TC for BC1 and BC3, BPTC for BC7.
+	static bool isFormatSupported(BlockFormat format);
+	// Off decodes .dds files on the CPU even where the driver has their format, to measure
+	// the fallback.
+	static inline void setCompressedUpload(bool enabled) { s_compressedUpload = enabled; }
+	// Decodes an image file into RGBA8 rows, bottom row first, straight from the mapping when
+	// the mounted ResourcePack has it. Free the pixels with stbi_image_free; nullptr on failure.
+	static unsigned char* decodeImage(const std::string& path, int* width, int* height, int* bpp);
+private:
+	// A GL texture with immutable storage for levelCount levels where the driver has it, and
+	// the options' sampler state. Its texels are undefined until uploaded; compressed levels
+	// without immutable storage are allocated as they upload. A layer count makes it a
+	// GL_TEXTURE_2D_ARRAY.
+	static unsigned int createTexture(int width, int height, unsigned int levelCount, const Options& options, unsigned int internalFormat = GL_RGBA8,
+		unsigned int layerCount = 0);
+	// The levels the options ask for: 1 without mips, the full chain otherwise.
+	static unsigned int getLevelCount(int width, int height, const Options& options);
+	// Makes the levels below the base one when the options ask for them on the CPU.
+	static void generateMips(MipChain& mips, const Options& options);
+	// Swaps in a GL texture the streamer has finished uploading, deleting the placeholder.
+	void replace(unsigned int rendererId, MipChain&& mips);
+};
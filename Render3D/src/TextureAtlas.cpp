@@ -0,0 +1,137 @@
+#include "TextureAtlas.h"
+#include "stb_image/stb_image.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+static int roundUp(int value, int multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+TextureAtlas::TextureAtlas(int pageSize, const Texture::Options& options)
+    : m_pageSize(roundUp(std::max(pageSize, 8 * PADDING), PADDING)), m_options(options)
+{
+}
+
+unsigned int TextureAtlas::add(const std::string& path)
+{
+    int width, height, bpp;
+    unsigned char* pixels = Texture::decodeImage(path, &width, &height, &bpp);
+    if (!pixels)
+    {
+        std::cout << "Warning: could not read '" << path << "' into the texture atlas\n";
+        const unsigned char black[4] = { 0, 0, 0, 255 };
+        return add(1, 1, black);
+    }
+    unsigned int image = add(width, height, pixels);
+    stbi_image_free(pixels);
+    return image;
+}
+
+unsigned int TextureAtlas::add(int width, int height, const unsigned char* pixels)
+{
+    m_images.push_back({ width, height, std::vector<unsigned char>(pixels, pixels + (size_t)width * height * 4) });
+    return (unsigned int)m_images.size() - 1;
+}
+
+void TextureAtlas::build()
+{
+    m_regions.assign(m_images.size(), Region{ nullptr, 0.0f, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f) });
+    m_textures.clear();
+    bool mipmapped = m_options.mips != Texture::Mips::None;
+
+    // Large images, a layer each, in one array per size.
+    std::map<std::pair<int, int>, std::vector<unsigned int>> sizes;
+    std::vector<unsigned int> small;
+    for (unsigned int i = 0; i < m_images.size(); i++)
+    {
+        const Image& image = m_images[i];
+        if (image.width > m_pageSize / 2 || image.height > m_pageSize / 2)
+            sizes[{ image.width, image.height }].push_back(i);
+        else
+            small.push_back(i);
+    }
+    for (const auto& size : sizes)
+    {
+        std::vector<MipChain> layers;
+        for (unsigned int i : size.second)
+        {
+            Image& image = m_images[i];
+            layers.emplace_back(image.width, image.height, std::move(image.pixels));
+            if (mipmapped)
+                layers.back().generate(m_options.mips == Texture::Mips::Kaiser ? MipChain::Filter::Kaiser : MipChain::Filter::Box, m_options.srgb, m_options.repeat);
+            m_regions[i].layer = (float)(layers.size() - 1);
+        }
+        m_textures.emplace_back(new Texture(std::move(layers), m_options));
+        for (unsigned int i : size.second)
+            m_regions[i].texture = m_textures.back().get();
+    }
+
+    // Small images, tallest first, along shelves as tall as their first slot.
+    std::stable_sort(small.begin(), small.end(), [this](unsigned int a, unsigned int b) { return m_images[a].height > m_images[b].height; });
+    std::vector<std::vector<unsigned char>> pages;
+    int x = 0, y = 0, shelfHeight = 0;
+    for (unsigned int i : small)
+    {
+        const Image& image = m_images[i];
+        int slotWidth = roundUp(image.width + 2 * PADDING, PADDING), slotHeight = roundUp(image.height + 2 * PADDING, PADDING);
+        if (x + slotWidth > m_pageSize)
+        {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        if (pages.empty() || y + slotHeight > m_pageSize)
+        {
+            pages.emplace_back((size_t)m_pageSize * m_pageSize * 4, (unsigned char)0);
+            x = y = shelfHeight = 0;
+        }
+
+        auto source = [this](int value, int size) {
+            return m_options.repeat ? (value % size + size) % size : std::max(0, std::min(size - 1, value));
+        };
+        unsigned char* page = pages.back().data();
+        for (int slotY = 0; slotY < slotHeight; slotY++)
+        {
+            const unsigned char* row = &image.pixels[(size_t)source(slotY - PADDING, image.height) * image.width * 4];
+            unsigned char* destination = page + ((size_t)(y + slotY) * m_pageSize + x) * 4;
+            for (int slotX = 0; slotX < slotWidth; slotX++)
+                memcpy(destination + slotX * 4, row + source(slotX - PADDING, image.width) * 4, 4);
+        }
+        m_regions[i].layer = (float)(pages.size() - 1);
+        m_regions[i].rect = glm::vec4((float)(x + PADDING) / m_pageSize, (float)(y + PADDING) / m_pageSize,
+            (float)image.width / m_pageSize, (float)image.height / m_pageSize);
+        x += slotWidth;
+        shelfHeight = std::max(shelfHeight, slotHeight);
+    }
+    if (!pages.empty())
+    {
+        unsigned int levelCount = 1;
+        for (int padding = PADDING; padding > 1; padding /= 2)
+            levelCount++;
+        std::vector<MipChain> layers;
+        for (std::vector<unsigned char>& page : pages)
+        {
+            layers.emplace_back(m_pageSize, m_pageSize, std::move(page));
+            if (mipmapped)
+                layers.back().generate(MipChain::Filter::Box, m_options.srgb, false, levelCount);
+        }
+        // Shaders repeat images within their rectangles; the page's own edges never wrap.
+        Texture::Options options = m_options;
+        options.repeat = false;
+        m_textures.emplace_back(new Texture(std::move(layers), options));
+        for (unsigned int i : small)
+            m_regions[i].texture = m_textures.back().get();
+    }
+    m_images.clear();
+}
+
+size_t TextureAtlas::getVideoMemorySize() const
+{
+    size_t size = 0;
+    for (const std::unique_ptr<Texture>& texture : m_textures)
+        size += texture->getVideoMemorySize();
+    return size;
+}
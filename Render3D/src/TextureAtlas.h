@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "Texture.h"
+
+// Packs images into texture arrays, so draws that differ only by their image bind the same
+// texture and the image becomes per-draw data: a layer and a rectangle of it, which go into
+// ObjectBlock's u_texLayer and u_texRect for Simple.shader's ATLAS variant to sample.
+//
+// Images larger than half a page either way are grouped by size, and each size becomes an
+// array with one image per layer and a full mip chain. Smaller images are packed on shelves
+// into the layers of one more array, pages of pageSize squared. Each sits in a slot PADDING
+// texels wider on every side, filled with the image repeated (or its edges stretched without
+// Options::repeat), so bilinear samples at the rectangle's edges read what GL_REPEAT would.
+// Slots start on multiples of PADDING and pages keep only the mip levels where the padding is
+// still a texel wide, log2(PADDING) + 1 of them, so the box filter never blends two images.
+class TextureAtlas
+{
+public:
+	static const int PADDING = 8;
+
+	// Where an image ended up. rect holds the offset and scale that take the image's texture
+	// coordinates into its layer.
+	struct Region
+	{
+		const Texture* texture;
+		float layer;
+		glm::vec4 rect;
+	};
+private:
+	struct Image
+	{
+		int width, height;
+		std::vector<unsigned char> pixels;
+	};
+
+	int m_pageSize;
+	Texture::Options m_options;
+	std::vector<Image> m_images;
+	std::vector<Region> m_regions;
+	std::vector<std::unique_ptr<Texture>> m_textures;
+public:
+	// pageSize is rounded up to a multiple of PADDING. The options' mips are made on the CPU,
+	// Driver ones with the box filter, and pages always use the box filter, since the Kaiser
+	// filter reaches further than the padding.
+	TextureAtlas(int pageSize = 256, const Texture::Options& options = Texture::getDefaultOptions());
+
+	// Returns the image's index. An image that cannot be read is packed as one black texel,
+	// which is what sampling a texture without texels reads.
+	unsigned int add(const std::string& path);
+	// width * height RGBA8 texels, bottom row first.
+	unsigned int add(int width, int height, const unsigned char* pixels);
+	// Packs every image added and uploads the arrays. Call it once, after the last add.
+	void build();
+
+	inline const Region& getRegion(unsigned int image) const { return m_regions[image]; }
+	inline unsigned int getTextureCount() const { return (unsigned int)m_textures.size(); }
+	inline const Texture& getTexture(unsigned int index) const { return *m_textures[index]; }
+	// Bytes of every array's levels, padding and unused page space included.
+	size_t getVideoMemorySize() const;
+};
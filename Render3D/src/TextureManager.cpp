@@ -0,0 +1,198 @@
+#include "TextureManager.h"
+#include "FrameStats.h"
+#include "ResourcePack.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+// 64-bit FNV-1a of a file's bytes, or 0 for a file that is empty or cannot be read. The
+// mounted ResourcePack's index has it without reading the file.
+static unsigned long long hashFile(const std::string& path)
+{
+    if (unsigned long long hash = ResourcePack::getContentHash(path))
+        return hash;
+    std::ifstream file(path, std::ios::binary);
+    unsigned long long hash = 14695981039346656037ull;
+    size_t size = 0;
+    char buffer[64 * 1024];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+    {
+        std::streamsize count = file.gcount();
+        for (std::streamsize i = 0; i < count; i++)
+        {
+            hash ^= (unsigned char)buffer[i];
+            hash *= 1099511628211ull;
+        }
+        size += (size_t)count;
+    }
+    return size ? hash : 0;
+}
+
+static std::string getOptionsKey(const Texture::Options& options)
+{
+    char key[64];
+    snprintf(key, sizeof(key), "|%d %d %g %d %d", (int)options.mips, (int)options.trilinear, options.anisotropy, (int)options.repeat, (int)options.srgb);
+    return key;
+}
+
+TextureManager::TextureManager(size_t budgetBytes)
+    : m_budget(budgetBytes), m_stats(), m_updateClock(0)
+{
+}
+
+std::shared_ptr<Texture> TextureManager::load(const std::string& path, const Texture::Options& options)
+{
+    std::string optionsKey = getOptionsKey(options);
+    std::string pathKey = canonicalize(path) + optionsKey;
+    auto found = m_byPath.find(pathKey);
+    if (found != m_byPath.end())
+    {
+        m_stats.pathHits++;
+        found->second->texture->markUsed();
+        return found->second->texture;
+    }
+
+    // Another path may lead to the same file, or to a copy of it.
+    std::string contentKey;
+    if (unsigned long long hash = hashFile(path))
+    {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", hash);
+        contentKey = hex + optionsKey;
+        found = m_byContent.find(contentKey);
+        if (found != m_byContent.end())
+        {
+            m_stats.contentHits++;
+            found->second->pathKeys.push_back(pathKey);
+            m_byPath[pathKey] = found->second;
+            found->second->texture->markUsed();
+            return found->second->texture;
+        }
+    }
+
+    m_stats.loads++;
+    m_entries.emplace_back(new Entry{ std::make_shared<Texture>(path, options), { pathKey }, contentKey });
+    Entry* entry = m_entries.back().get();
+    entry->texture->markUsed();
+    m_byPath[pathKey] = entry;
+    if (!contentKey.empty())
+        m_byContent[contentKey] = entry;
+    return entry->texture;
+}
+
+void TextureManager::update()
+{
+    size_t total = getVideoMemorySize();
+    if (m_budget)
+    {
+        std::vector<Entry*> order = getUseOrder();
+        freeMemory(order, total, m_budget, ~0ull);
+
+        // Textures used since the last update take levels back from the ones that were not.
+        for (auto entry = order.rbegin(); entry != order.rend(); ++entry)
+        {
+            Texture* texture = (*entry)->texture.get();
+            if (!texture || isUnused(**entry))
+                continue;
+            if (texture->getLastUse() <= m_updateClock)
+                break;
+            while (texture->getFirstLevel() > 0)
+            {
+                size_t extra = texture->getVideoMemorySize(texture->getFirstLevel() - 1) - texture->getVideoMemorySize();
+                if (extra > m_budget || (total + extra > m_budget && !freeMemory(order, total, m_budget - extra, m_updateClock)))
+                    break;
+                if (!texture->setFirstLevel(texture->getFirstLevel() - 1))
+                    break;
+                total += extra;
+                m_stats.levelsRestored++;
+            }
+            if (texture->getFirstLevel() > 0)
+                break;
+        }
+        m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [](const std::unique_ptr<Entry>& entry) { return !entry->texture; }), m_entries.end());
+    }
+    m_updateClock = Texture::getUseClock();
+    FrameStats::add(Stat::TextureMemory, total);
+}
+
+bool TextureManager::freeMemory(const std::vector<Entry*>& order, size_t& total, size_t limit, unsigned long long staleClock)
+{
+    for (Entry* entry : order)
+    {
+        if (total <= limit)
+            return true;
+        if (isUnused(*entry))
+        {
+            total -= entry->texture->getVideoMemorySize();
+            release(*entry);
+        }
+    }
+    for (bool dropped = true; dropped && total > limit; )
+    {
+        dropped = false;
+        for (Entry* entry : order)
+        {
+            Texture* texture = entry->texture.get();
+            if (total <= limit || (texture && texture->getLastUse() > staleClock))
+                break;
+            size_t size = texture ? texture->getVideoMemorySize() : 0;
+            if (texture && texture->setFirstLevel(texture->getFirstLevel() + 1))
+            {
+                total -= size - texture->getVideoMemorySize();
+                m_stats.levelsDropped++;
+                FrameStats::add(Stat::TextureLevelsDropped);
+                dropped = true;
+            }
+        }
+    }
+    return total <= limit;
+}
+
+size_t TextureManager::getVideoMemorySize() const
+{
+    size_t size = 0;
+    for (const std::unique_ptr<Entry>& entry : m_entries)
+        size += entry->texture->getVideoMemorySize();
+    return size;
+}
+
+std::string TextureManager::canonicalize(const std::string& path)
+{
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= path.size())
+    {
+        size_t end = std::min(path.find_first_of("/\\", start), path.size());
+        std::string part = path.substr(start, end - start);
+        if (part == ".." && !parts.empty() && parts.back() != "..")
+            parts.pop_back();
+        else if (!part.empty() && part != ".")
+            parts.push_back(part);
+        start = end + 1;
+    }
+
+    std::string canonical = !path.empty() && (path[0] == '/' || path[0] == '\\') ? "/" : "";
+    for (size_t i = 0; i < parts.size(); i++)
+        canonical += (i ? "/" : "") + parts[i];
+    return canonical;
+}
+
+void TextureManager::release(Entry& entry)
+{
+    for (const std::string& pathKey : entry.pathKeys)
+        m_byPath.erase(pathKey);
+    if (!entry.contentKey.empty())
+        m_byContent.erase(entry.contentKey);
+    entry.texture.reset();
+    m_stats.evictions++;
+    FrameStats::add(Stat::TexturesEvicted);
+}
+
+std::vector<TextureManager::Entry*> TextureManager::getUseOrder() const
+{
+    std::vector<Entry*> order;
+    for (const std::unique_ptr<Entry>& entry : m_entries)
+        order.push_back(entry.get());
+    std::sort(order.begin(), order.end(), [](const Entry* a, const Entry* b) { return a->texture->getLastUse() < b->texture->getLastUse(); });
+    return order;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Texture.h"
+
+// Loads each image once and shares it through std::shared_ptr handles. Textures are found
+// again by their canonical path, or by a hash of the file for another path to the same
+// contents, together with the options, since the same image with other options is another GL
+// texture.
+//
+// Textures stay loaded after their last handle goes, so loading them again is free, until
+// update finds the textures over the video memory budget. It then frees memory in least
+// recently used order: textures no handle refers to are deleted, and once none are left, the
+// textures in use give up their top mip level, a pass at a time, which takes three quarters
+// of what each one stores. Textures used since the last update get dropped levels back, most
+// recently used first, in place of unused textures and levels of textures not used since.
+// Textures with driver mips have no levels on the CPU to come back from and are only deleted.
+class TextureManager
+{
+public:
+	struct Stats
+	{
+		// Loads answered by a texture already made for the same path or the same contents.
+		unsigned long long pathHits;
+		unsigned long long contentHits;
+		unsigned long long loads;
+		unsigned long long evictions;
+		unsigned long long levelsDropped;
+		unsigned long long levelsRestored;
+	};
+private:
+	struct Entry
+	{
+		std::shared_ptr<Texture> texture;
+		// Every path it was loaded by, each with the options.
+		std::vector<std::string> pathKeys;
+		std::string contentKey;
+	};
+
+	size_t m_budget;
+	std::vector<std::unique_ptr<Entry>> m_entries;
+	std::unordered_map<std::string, Entry*> m_byPath;
+	std::unordered_map<std::string, Entry*> m_byContent;
+	Stats m_stats;
+	// Texture::getUseClock at the end of the last update.
+	unsigned long long m_updateClock;
+public:
+	// A budget of 0 bytes never frees anything.
+	TextureManager(size_t budgetBytes = 0);
+
+	TextureManager(const TextureManager&) = delete;
+	TextureManager& operator=(const TextureManager&) = delete;
+
+	std::shared_ptr<Texture> load(const std::string& path, const Texture::Options& options = Texture::getDefaultOptions());
+	// Brings the textures within the budget and adds their memory and what was freed to
+	// FrameStats. Call it on the GL thread once a frame, before the frame's draws.
+	void update();
+
+	inline void setBudget(size_t budgetBytes) { m_budget = budgetBytes; }
+	inline size_t getBudget() const { return m_budget; }
+	inline unsigned int getTextureCount() const { return (unsigned int)m_entries.size(); }
+	// Bytes every texture stores in its GL texture, the unused ones included.
+	size_t getVideoMemorySize() const;
+	inline const Stats& getStats() const { return m_stats; }
+
+	// The path with separators made forward slashes and "." and "dir/.." removed, so different
+	// spellings of one relative path match. Links are not followed.
+	static std::string canonicalize(const std::string& path);
+private:
+	// Brings total down to limit: deletes unused textures, then drops a level a pass from the
+	// textures last used at staleClock or before. Returns whether it got there.
+	bool freeMemory(const std::vector<Entry*>& order, size_t& total, size_t limit, unsigned long long staleClock);
+	// Deletes the entry's texture; update removes the entry once it is done with its order.
+	void release(Entry& entry);
+	// Entries from least to most recently used.
+	std::vector<Entry*> getUseOrder() const;
+	static inline bool isUnused(const Entry& entry) { return entry.texture && entry.texture.use_count() == 1; }
+};
@@ -0,0 +1,207 @@
+#include "TextureStreamer.h"
+#include "GLState.h"
+#include "FrameStats.h"
+#include "stb_image/stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+static const unsigned char PLACEHOLDER[] = { 128, 128, 128, 255 };
+
+TextureStreamer::TextureStreamer(JobSystem* jobs, unsigned int budgetBytes)
+    : m_jobs(jobs), m_budget(budgetBytes), m_decodeBudgetMs(2.0), m_frame(0), m_bytesUploaded(0), m_texturesLoaded(0), m_texturesFailed(0)
+{
+    GLCall(glGenBuffers(PIXEL_BUFFER_COUNT, m_pixelBuffers));
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    // Decode jobs write into their requests, so they have to finish first.
+    for (const JobHandle& job : m_decodeJobs)
+        m_jobs->wait(job);
+    for (const std::shared_ptr<Request>& request : m_requests)
+    {
+        if (request->rendererId)
+        {
+            GLCall(glDeleteTextures(1, &request->rendererId));
+            GLState::onTextureDeleted(request->rendererId);
+        }
+    }
+    GLCall(glDeleteBuffers(PIXEL_BUFFER_COUNT, m_pixelBuffers));
+    for (unsigned int buffer : m_pixelBuffers)
+        GLState::onBufferDeleted(buffer);
+}
+
+std::shared_ptr<Texture> TextureStreamer::load(const std::string& path, const Texture::Options& options)
+{
+    std::shared_ptr<Texture> texture = std::make_shared<Texture>(1, 1, PLACEHOLDER, options);
+    texture->m_filePath = path;
+    texture->m_resident = false;
+
+    std::shared_ptr<Request> request = std::make_shared<Request>();
+    request->texture = texture;
+    request->path = path;
+    request->options = options;
+    request->state = State::Pending;
+    request->scheduled = hasDecodeThreads();
+    request->rendererId = 0;
+    request->level = 0;
+    request->rowsUploaded = 0;
+    m_requests.push_back(request);
+
+    if (request->scheduled)
+        m_decodeJobs.push_back(m_jobs->schedule("decode texture", [request]() { decode(*request); }));
+    return texture;
+}
+
+void TextureStreamer::update()
+{
+    m_decodeJobs.erase(std::remove_if(m_decodeJobs.begin(), m_decodeJobs.end(), [](const JobHandle& job) { return job.isFinished(); }),
+        m_decodeJobs.end());
+
+    // Images no job was scheduled for are decoded here, within the time budget.
+    std::chrono::steady_clock::time_point decodeStart = std::chrono::steady_clock::now();
+    unsigned int decoded = 0;
+    for (const std::shared_ptr<Request>& request : m_requests)
+    {
+        if (request->scheduled || request->state != State::Pending)
+            continue;
+        if (decoded > 0 && std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decodeStart).count() >= m_decodeBudgetMs)
+            break;
+        decode(*request);
+        decoded++;
+    }
+
+    // Plan the frame's rows first, in load order but skipping images still being decoded, so
+    // the pixel buffer is mapped once. An image's levels go one after another, base level first.
+    struct Rows
+    {
+        Request* request;
+        unsigned int level;
+        int first, count;
+        unsigned int offset;
+    };
+    std::vector<Rows> rows;
+    unsigned int used = 0;
+    bool full = false;
+    for (const std::shared_ptr<Request>& request : m_requests)
+    {
+        if (request->state != State::Decoded)
+            continue;
+        unsigned int level = request->level;
+        int row = request->rowsUploaded;
+        while (level < request->mips.getLevelCount())
+        {
+            const MipChain::Level& size = request->mips.getLevel(level);
+            unsigned int rowBytes = size.width * 4;
+            int fit = (int)((m_budget - std::min(m_budget, used)) / rowBytes);
+            if (fit == 0 && used > 0)
+            {
+                full = true;
+                break;
+            }
+            int count = std::min(size.height - row, std::max(1, fit));
+            rows.push_back({ request.get(), level, row, count, used });
+            used += count * rowBytes;
+            row += count;
+            if (row == size.height)
+            {
+                level++;
+                row = 0;
+            }
+            if (used >= m_budget)
+            {
+                full = true;
+                break;
+            }
+        }
+        if (full)
+            break;
+    }
+
+    if (!rows.empty())
+    {
+        // Orphaning hands the driver a fresh store if the GPU still reads the old one.
+        GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffers[m_frame++ % PIXEL_BUFFER_COUNT]);
+        GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, used, nullptr, GL_STREAM_DRAW));
+        GLCall(unsigned char* mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, used, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        if (mapped)
+        {
+            for (const Rows& range : rows)
+            {
+                const MipChain& mips = range.request->mips;
+                size_t rowBytes = (size_t)mips.getLevel(range.level).width * 4;
+                memcpy(mapped + range.offset, mips.getPixels(range.level) + range.first * rowBytes, range.count * rowBytes);
+            }
+            GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+
+            for (const Rows& range : rows)
+            {
+                Request& request = *range.request;
+                int width = request.mips.getWidth(), height = request.mips.getHeight();
+                if (!request.rendererId)
+                    request.rendererId = Texture::createTexture(width, height, Texture::getLevelCount(width, height, request.options), request.options);
+                const MipChain::Level& size = request.mips.getLevel(range.level);
+                GLState::bindTexture(GL_TEXTURE_2D, request.rendererId);
+                GLCall(glTexSubImage2D(GL_TEXTURE_2D, range.level, 0, range.first, size.width, range.count, GL_RGBA, GL_UNSIGNED_BYTE,
+                    (const void*)(uintptr_t)range.offset));
+                request.rowsUploaded = range.first + range.count;
+                if (request.rowsUploaded == size.height)
+                {
+                    request.level++;
+                    request.rowsUploaded = 0;
+                }
+            }
+            GLState::bindTexture(GL_TEXTURE_2D, 0);
+            m_bytesUploaded += used;
+            FrameStats::add(Stat::TextureBytesStreamed, used);
+        }
+        GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    // The uploads are queued ahead of any draw that samples them, so a texture can be swapped
+    // in as soon as its last rows are.
+    for (std::deque<std::shared_ptr<Request>>::iterator it = m_requests.begin(); it != m_requests.end();)
+    {
+        Request& request = **it;
+        if (request.state == State::Failed)
+        {
+            std::cout << "Warning: could not load texture '" << request.path << "'\n";
+            m_texturesFailed++;
+            it = m_requests.erase(it);
+        }
+        else if (request.state == State::Decoded && request.level == request.mips.getLevelCount())
+        {
+            if (request.options.mips == Texture::Mips::Driver)
+            {
+                GLState::bindTexture(GL_TEXTURE_2D, request.rendererId);
+                GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+                GLState::bindTexture(GL_TEXTURE_2D, 0);
+            }
+            request.texture->replace(request.rendererId, std::move(request.mips));
+            m_texturesLoaded++;
+            it = m_requests.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+void TextureStreamer::decode(Request& request)
+{
+    int width, height, channels;
+    unsigned char* pixels = Texture::decodeImage(request.path, &width, &height, &channels);
+    if (!pixels || width <= 0 || height <= 0)
+    {
+        if (pixels)
+            stbi_image_free(pixels);
+        request.state = State::Failed;
+        return;
+    }
+    request.mips = MipChain(width, height, pixels);
+    stbi_image_free(pixels);
+    Texture::generateMips(request.mips, request.options);
+    request.state = State::Decoded;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Texture.h"
+#include "JobSystem.h"
+
+// Loads textures without stalling the frame. load returns at once with a texture that shows a
+// 1x1 placeholder; the image is decoded, and its mips made, by a job, and update, called on
+// the GL thread once a frame, copies decoded rows of every level into a pixel buffer object
+// and uploads them from it, no more than the byte budget per frame. With no threads to run
+// jobs on, update decodes images itself, as many as fit in the decode time budget. Once a
+// texture's last row is uploaded its GL texture is swapped in for the placeholder and it
+// reports isResident.
+//
+// Each frame's rows go into the next of a ring of pixel buffers, which is orphaned before it
+// is mapped, so writing never waits for the GPU to finish reading an earlier frame's rows.
+class TextureStreamer
+{
+public:
+	static const unsigned int PIXEL_BUFFER_COUNT = 3;
+private:
+	enum class State
+	{
+		Pending,
+		Decoded,
+		Failed
+	};
+
+	struct Request
+	{
+		std::shared_ptr<Texture> texture;
+		std::string path;
+		Texture::Options options;
+		std::atomic<State> state;
+		bool scheduled;
+		MipChain mips;
+		// The texture being filled, the level being uploaded and its rows uploaded so far.
+		unsigned int rendererId;
+		unsigned int level;
+		int rowsUploaded;
+	};
+
+	JobSystem* m_jobs;
+	unsigned int m_budget;
+	double m_decodeBudgetMs;
+	unsigned int m_pixelBuffers[PIXEL_BUFFER_COUNT];
+	unsigned int m_frame;
+	std::deque<std::shared_ptr<Request>> m_requests;
+	std::vector<JobHandle> m_decodeJobs;
+	unsigned long long m_bytesUploaded;
+	unsigned int m_texturesLoaded;
+	unsigned int m_texturesFailed;
+public:
+	// Uploads up to budgetBytes a frame, and at least one row of a texture.
+	TextureStreamer(JobSystem* jobs, unsigned int budgetBytes = 1 << 20);
+	~TextureStreamer();
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	std::shared_ptr<Texture> load(const std::string& path, const Texture::Options& options = Texture::getDefaultOptions());
+	// Uploads this frame's share of the decoded images. Call it on the GL thread.
+	void update();
+
+	inline void setJobSystem(JobSystem* jobs) { m_jobs = jobs; }
+	inline void setBudget(unsigned int budgetBytes) { m_budget = budgetBytes; }
+	inline unsigned int getBudget() const { return m_budget; }
+	// Time update may spend decoding when there are no job threads; it always decodes one image.
+	inline void setDecodeBudget(double milliseconds) { m_decodeBudgetMs = milliseconds; }
+	// Textures asked for and not yet resident or failed.
+	inline unsigned int getPendingCount() const { return (unsigned int)m_requests.size(); }
+	inline unsigned int getLoadedCount() const { return m_texturesLoaded; }
+	inline unsigned int getFailedCount() const { return m_texturesFailed; }
+	inline unsigned long long getBytesUploaded() const { return m_bytesUploaded; }
+private:
+	// Jobs nobody waits for only run on the system's own threads, and it may have none.
+	inline bool hasDecodeThreads() const { return m_jobs && m_jobs->getThreadCount() > 1; }
+	static void decode(Request& request);
+};
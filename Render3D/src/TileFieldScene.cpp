@@ -0,0 +1,183 @@
+#include "TileFieldScene.h"
+#include "ShaderLibrary.h"
+#include "VertexBufferLayout.h"
+#include "Renderer.h"
+#include <glm/ext/matrix_transform.hpp>
+
+static constexpr Uniform<int> u_texture("u_texture");
+
+static const float tileVertices[] = {
+    -0.45f,  0.0f, -0.45f,  0.0f,  0.0f,
+     0.45f,  0.0f, -0.45f,  1.0f,  0.0f,
+     0.45f,  0.0f,  0.45f,  1.0f,  1.0f,
+    -0.45f,  0.0f,  0.45f,  0.0f,  1.0f,
+};
+
+// A unit wall piece facing -z, one tile wide and three tall.
+static const float wallVertices[] = {
+    -0.5f,  0.0f,  0.0f,  0.0f,  0.0f,
+     0.5f,  0.0f,  0.0f,  1.0f,  0.0f,
+     0.5f,  3.0f,  0.0f,  1.0f,  3.0f,
+    -0.5f,  3.0f,  0.0f,  0.0f,  3.0f,
+};
+
+static const unsigned int quadIndices[] = {
+    0, 1, 2,
+    2, 3, 0,
+};
+
+// Lays one wall piece per tile along the edge from start, stepping by step, rotated by angle degrees.
+static void addWallRun(std::vector<ObjectBlock>& walls, glm::vec3 start, glm::vec3 step, int count, float angle)
+{
+    for (int i = 0; i < count; i++)
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), start + step * (i + 0.5f));
+        model = glm::rotate(model, glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
+        float shade = i % 2 ? 0.7f : 0.6f;
+        walls.push_back(ObjectBlock{ model, glm::vec4(shade, shade, shade, 1.0f) });
+    }
+}
+
+TileFieldScene::TileFieldScene(bool instanced, bool culled)
+    : m_instanced(instanced), m_culled(culled),
+    m_tileVB(tileVertices, sizeof(tileVertices)), m_tileIB(quadIndices, sizeof(quadIndices) / sizeof(unsigned int)),
+    m_wallVB(wallVertices, sizeof(wallVertices)), m_wallIB(quadIndices, sizeof(quadIndices) / sizeof(unsigned int)),
+    m_shader(ShaderLibrary::load("res/shaders/Simple.shader", instanced ? SIMPLE_INSTANCED : 0)), m_texture("res/textures/whiteTile.png"),
+    m_uniformBuffer(sizeof(CameraBlock) + (instanced ? 0 : (FIELD_WIDTH * FIELD_DEPTH + 2 * (FIELD_WIDTH + FIELD_DEPTH)) * sizeof(ObjectBlock)))
+{
+    m_tiles.reserve(FIELD_WIDTH * FIELD_DEPTH);
+    for (int z = 0; z < FIELD_DEPTH; z++)
+    {
+        for (int x = 0; x < FIELD_WIDTH; x++)
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x - FIELD_WIDTH / 2 + 0.5f, 0.0f, z - FIELD_DEPTH / 2 + 0.5f));
+            glm::vec4 color = (x + z) % 2 ? glm::vec4(0.9f, 0.9f, 0.9f, 1.0f) : glm::vec4(0.3f, 0.4f, 0.8f, 1.0f);
+            m_tiles.push_back(ObjectBlock{ model, color });
+        }
+    }
+
+    float halfWidth = FIELD_WIDTH / 2.0f;
+    float halfDepth = FIELD_DEPTH / 2.0f;
+    addWallRun(m_walls, glm::vec3(-halfWidth, 0.0f, -halfDepth), glm::vec3(1.0f, 0.0f, 0.0f), FIELD_WIDTH, 180.0f);
+    addWallRun(m_walls, glm::vec3(-halfWidth, 0.0f, halfDepth), glm::vec3(1.0f, 0.0f, 0.0f), FIELD_WIDTH, 0.0f);
+    addWallRun(m_walls, glm::vec3(-halfWidth, 0.0f, -halfDepth), glm::vec3(0.0f, 0.0f, 1.0f), FIELD_DEPTH, 90.0f);
+    addWallRun(m_walls, glm::vec3(halfWidth, 0.0f, -halfDepth), glm::vec3(0.0f, 0.0f, 1.0f), FIELD_DEPTH, -90.0f);
+
+    VertexBufferLayout layout;
+    layout.push<float>(3);
+    layout.push<float>(2);
+    m_tileVA.addBuffer(m_tileVB, layout);
+    m_wallVA.addBuffer(m_wallVB, layout);
+
+    if (m_instanced)
+    {
+        // ObjectBlock's std140 layout is tightly packed, so the same structs serve as instance data.
+        // The texture region and its padding ride along unused by the instanced Simple.shader.
+        VertexBufferLayout instanceLayout(1);
+        instanceLayout.push<float>(16);
+        instanceLayout.push<float>(4);
+        instanceLayout.push<float>(4);
+        instanceLayout.push<float>(4);
+        GLenum usage = m_culled ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+        m_tileInstances.reset(new VertexBuffer(m_tiles.data(), (unsigned int)(m_tiles.size() * sizeof(ObjectBlock)), usage));
+        m_tileVA.addBuffer(*m_tileInstances, instanceLayout);
+        m_wallInstances.reset(new VertexBuffer(m_walls.data(), (unsigned int)(m_walls.size() * sizeof(ObjectBlock)), usage));
+        m_wallVA.addBuffer(*m_wallInstances, instanceLayout);
+    }
+    else
+    {
+        m_shader->bindUniformBlock(ObjectBlock::getLayout());
+        m_objectOffsets.resize(getObjectCount());
+    }
+
+    m_tileVA.bind();
+    m_tileIB.bind();
+    m_wallVA.bind();
+    m_wallIB.bind();
+    m_wallVA.unbind();
+
+    m_shader->bindUniformBlock(CameraBlock::getLayout());
+    m_shader->bind();
+    m_shader->setUniform(u_texture, 0);
+
+    Bounds tileBounds = Bounds::fromVertices(tileVertices, 4, 5 * sizeof(float));
+    Bounds wallBounds = Bounds::fromVertices(wallVertices, 4, 5 * sizeof(float));
+    m_culler.reserve(getObjectCount());
+    for (const ObjectBlock& tile : m_tiles)
+        m_culler.add(tileBounds.transformed(tile.u_model).box);
+    for (const ObjectBlock& wall : m_walls)
+        m_culler.add(wallBounds.transformed(wall.u_model).box);
+    m_visible.resize(getObjectCount());
+    for (unsigned int i = 0; i < m_visible.size(); i++)
+        m_visible[i] = i;
+}
+
+void TileFieldScene::setJobSystem(JobSystem* jobs)
+{
+    m_culler.setJobSystem(jobs);
+}
+
+void TileFieldScene::onRender(const Renderer& renderer, const Camera& camera)
+{
+    glm::mat4 viewProj = camera.proj * camera.view;
+    if (m_culled)
+        m_culler.cull(Frustum::fromMatrix(viewProj), m_visible);
+
+    m_uniformBuffer.beginFrame();
+    unsigned int cameraOffset = m_uniformBuffer.push(CameraBlock{ viewProj, glm::vec4(camera.position, 1.0f) });
+    if (!m_instanced)
+    {
+        for (unsigned int i : m_visible)
+            m_objectOffsets[i] = m_uniformBuffer.push(i < m_tiles.size() ? m_tiles[i] : m_walls[i - m_tiles.size()]);
+    }
+    m_uniformBuffer.upload();
+
+    m_uniformBuffer.bindBlock<CameraBlock>(cameraOffset);
+    m_texture.bind(0);
+    if (m_instanced)
+        renderInstanced(renderer);
+    else
+        renderPerObject(renderer);
+
+    m_uniformBuffer.endFrame();
+}
+
+void TileFieldScene::renderInstanced(const Renderer& renderer)
+{
+    unsigned int tileCount = (unsigned int)m_tiles.size();
+    unsigned int wallCount = (unsigned int)m_walls.size();
+    if (m_culled)
+    {
+        size_t visible = 0;
+        tileCount = uploadVisibleInstances(*m_tileInstances, m_tiles, 0, visible);
+        wallCount = uploadVisibleInstances(*m_wallInstances, m_walls, (unsigned int)m_tiles.size(), visible);
+    }
+    if (tileCount)
+        renderer.drawInstanced(m_tileVA, m_tileIB, *m_shader, tileCount);
+    if (wallCount)
+        renderer.drawInstanced(m_wallVA, m_wallIB, *m_shader, wallCount);
+}
+
+// Packs the visible objects of one mesh, which start at m_visible[visible], into the front of
+// its instance buffer. Returns how many there were and advances visible past them.
+unsigned int TileFieldScene::uploadVisibleInstances(VertexBuffer& instances, const std::vector<ObjectBlock>& objects, unsigned int first, size_t& visible)
+{
+    m_visibleInstances.clear();
+    for (; visible < m_visible.size() && m_visible[visible] < first + objects.size(); visible++)
+        m_visibleInstances.push_back(objects[m_visible[visible] - first]);
+    if (!m_visibleInstances.empty())
+        instances.setData(m_visibleInstances.data(), 0, (unsigned int)(m_visibleInstances.size() * sizeof(ObjectBlock)));
+    return (unsigned int)m_visibleInstances.size();
+}
+
+void TileFieldScene::renderPerObject(const Renderer& renderer)
+{
+    for (unsigned int i : m_visible)
+    {
+        m_uniformBuffer.bindBlock<ObjectBlock>(m_objectOffsets[i]);
+        if (i < m_tiles.size())
+            renderer.draw(m_tileVA, m_tileIB, *m_shader);
+        else
+            renderer.draw(m_wallVA, m_wallIB, *m_shader);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include "Scene.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "UniformBuffer.h"
+#include "FrustumCuller.h"
+
+// A room built from 100,000 floor tiles and a ring of wall pieces. Instanced, each mesh is one
+// draw with transforms and colors read from a per-instance vertex buffer; per-object, every
+// piece is its own draw with its own uniform block, as GridScene does. When culled, only the
+// pieces inside the view frustum are uploaded and drawn.
+class TileFieldScene : public Scene
+{
+private:
+	static const int FIELD_WIDTH = 400;
+	static const int FIELD_DEPTH = 250;
+
+	bool m_instanced;
+	bool m_culled;
+	VertexArray m_tileVA;
+	VertexBuffer m_tileVB;
+	IndexBuffer m_tileIB;
+	VertexArray m_wallVA;
+	VertexBuffer m_wallVB;
+	IndexBuffer m_wallIB;
+	std::vector<ObjectBlock> m_tiles;
+	std::vector<ObjectBlock> m_walls;
+	std::unique_ptr<VertexBuffer> m_tileInstances;
+	std::unique_ptr<VertexBuffer> m_wallInstances;
+	std::shared_ptr<Shader> m_shader;
+	Texture m_texture;
+	UniformBuffer m_uniformBuffer;
+	std::vector<unsigned int> m_objectOffsets;
+	// Culler indices are the tiles followed by the walls.
+	FrustumCuller m_culler;
+	std::vector<unsigned int> m_visible;
+	std::vector<ObjectBlock> m_visibleInstances;
+public:
+	TileFieldScene(bool instanced, bool culled = true);
+
+	void onRender(const Renderer& renderer, const Camera& camera) override;
+	void setJobSystem(JobSystem* jobs) override;
+
+	inline unsigned int getObjectCount() const { return (unsigned int)(m_tiles.size() + m_walls.size()); }
+private:
+	void renderInstanced(const Renderer& renderer);
+	void renderPerObject(const Renderer& renderer);
+	unsigned int uploadVisibleInstances(VertexBuffer& instances, const std::vector<ObjectBlock>& objects, unsigned int first, size_t& visible);
+};
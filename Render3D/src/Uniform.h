@@ -0,0 +1,42 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+// 32-bit FNV-1a. It is constexpr so uniform names written as literals are hashed by the compiler.
+constexpr unsigned int fnv1a(const char* str)
+{
+	unsigned int hash = 2166136261u;
+	while (*str)
+	{
+		hash ^= (unsigned char)*str++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// Names a uniform by the hash of its name. Declare handles constexpr so the hash is computed
+// at compile time; a handle built from a runtime string hashes it without allocating.
+struct UniformHandle
+{
+	unsigned int hash;
+	const char* name;
+
+	constexpr UniformHandle(const char* uniformName) : hash(fnv1a(uniformName)), name(uniformName) {}
+};
+
+// A handle that also carries the C++ type the uniform is set with, so Shader::setUniform
+// picks the right glUniform* call and checked builds can compare it with the GLSL type.
+template<typename T>
+struct Uniform : UniformHandle
+{
+	constexpr explicit Uniform(const char* uniformName) : UniformHandle(uniformName) {}
+};
+
+// One active uniform of a linked program, as reflected by glGetActiveUniform.
+struct ShaderUniform
+{
+	unsigned int hash;
+	int location;
+	unsigned int type;
+	int size;
+};
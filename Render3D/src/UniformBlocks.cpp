@@ -0,0 +1,25 @@
+#include "UniformBlocks.h"
+
+#define BLOCK_MEMBER(block, member) { #member, (unsigned int)offsetof(block, member) }
+
+const UniformBlockLayout& CameraBlock::getLayout()
+{
+    static const UniformBlockMember members[] = {
+        BLOCK_MEMBER(CameraBlock, u_viewProj),
+        BLOCK_MEMBER(CameraBlock, u_cameraPosition),
+    };
+    static const UniformBlockLayout layout = { "Camera", CAMERA_BLOCK_BINDING, sizeof(CameraBlock), members, 2 };
+    return layout;
+}
+
+const UniformBlockLayout& ObjectBlock::getLayout()
+{
+    static const UniformBlockMember members[] = {
+        BLOCK_MEMBER(ObjectBlock, u_model),
+        BLOCK_MEMBER(ObjectBlock, u_color),
+        BLOCK_MEMBER(ObjectBlock, u_texRect),
+        BLOCK_MEMBER(ObjectBlock, u_texLayer),
+    };
+    static const UniformBlockLayout layout = { "Object", OBJECT_BLOCK_BINDING, sizeof(ObjectBlock), members, 4 };
+    return layout;
+}
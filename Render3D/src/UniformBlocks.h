@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include "glm/glm.hpp"
+
+// Binding points shared by every program that declares these blocks.
+enum UniformBlockBinding : unsigned int
+{
+	CAMERA_BLOCK_BINDING = 0,
+	OBJECT_BLOCK_BINDING = 1
+};
+
+struct UniformBlockMember
+{
+	const char* name;
+	unsigned int offset;
+};
+
+// Describes the C++ side of a std140 block so Shader::bindUniformBlock can check it against
+// the offsets the driver reports for the GLSL side.
+struct UniformBlockLayout
+{
+	const char* name;
+	unsigned int binding;
+	unsigned int size;
+	const UniformBlockMember* members;
+	unsigned int memberCount;
+};
+
+// Mirrors `layout(std140) uniform Camera` and is written once per frame.
+struct CameraBlock
+{
+	glm::mat4 u_viewProj;
+	glm::vec4 u_cameraPosition;
+
+	static const UniformBlockLayout& getLayout();
+};
+
+// Mirrors `layout(std140) uniform Object` and is written once per object per frame.
+struct ObjectBlock
+{
+	glm::mat4 u_model;
+	glm::vec4 u_color;
+	// Where the object's image is in a texture array from TextureAtlas: the offset and scale
+	// that take texture coordinates into its rectangle, and the layer. Shaders sampling plain
+	// textures ignore them.
+	glm::vec4 u_texRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	float u_texLayer = 0.0f;
+	float padding[3] = {};
+
+	static const UniformBlockLayout& getLayout();
+};
+
+// std140 puts mat4 and vec4 members on 16 byte boundaries and rounds the block up to 16 bytes.
+static_assert(offsetof(CameraBlock, u_cameraPosition) == 64 && sizeof(CameraBlock) == 80, "CameraBlock does not match std140");
+static_assert(offsetof(ObjectBlock, u_color) == 64 && offsetof(ObjectBlock, u_texRect) == 80 && offsetof(ObjectBlock, u_texLayer) == 96 && sizeof(ObjectBlock) == 112,
+	"ObjectBlock does not match std140");
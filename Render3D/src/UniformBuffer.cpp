@@ -0,0 +1,122 @@
+#include "UniformBuffer.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "FrameStats.h"
+#include <cstring>
+
+UniformBuffer::BoundRange UniformBuffer::s_bound[MAX_BINDINGS] = {};
+
+UniformBuffer::UniformBuffer(unsigned int frameCapacity)
+    : m_rendererId(0), m_frameCapacity(0), m_alignment(256), m_segment(0), m_stagingSize(0)
+{
+    int alignment = 0;
+    GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    if (alignment > 0)
+        m_alignment = (unsigned int)alignment;
+
+    for (unsigned int i = 0; i < FRAMES_IN_FLIGHT; i++)
+        m_fences[i] = nullptr;
+
+    GLCall(glGenBuffers(1, &m_rendererId));
+    allocate(frameCapacity);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    for (unsigned int i = 0; i < FRAMES_IN_FLIGHT; i++)
+    {
+        if (m_fences[i])
+        {
+            GLCall(glDeleteSync((GLsync)m_fences[i]));
+        }
+    }
+    for (unsigned int i = 0; i < MAX_BINDINGS; i++)
+    {
+        if (s_bound[i].buffer == this)
+            s_bound[i].buffer = nullptr;
+    }
+    GLCall(glDeleteBuffers(1, &m_rendererId));
+    GLState::onBufferDeleted(m_rendererId);
+}
+
+void UniformBuffer::allocate(unsigned int frameCapacity)
+{
+    // Segments start on an offset alignment boundary so every pushed block can be bound by range.
+    m_frameCapacity = (frameCapacity + m_alignment - 1) / m_alignment * m_alignment;
+    for (unsigned int i = 0; i < FRAMES_IN_FLIGHT; i++)
+    {
+        if (m_fences[i])
+        {
+            GLCall(glDeleteSync((GLsync)m_fences[i]));
+        }
+        m_fences[i] = nullptr;
+    }
+
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, m_rendererId);
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)m_frameCapacity * FRAMES_IN_FLIGHT, nullptr, GL_DYNAMIC_DRAW));
+}
+
+void UniformBuffer::beginFrame()
+{
+    m_segment = (m_segment + 1) % FRAMES_IN_FLIGHT;
+    m_stagingSize = 0;
+}
+
+unsigned int UniformBuffer::push(const void* data, unsigned int size)
+{
+    unsigned int offset = (m_stagingSize + m_alignment - 1) / m_alignment * m_alignment;
+    if (offset + size > m_staging.size())
+        m_staging.resize((offset + size) * 2);
+    memcpy(&m_staging[offset], data, size);
+    m_stagingSize = offset + size;
+    return offset;
+}
+
+void UniformBuffer::upload()
+{
+    if (m_stagingSize == 0)
+        return;
+
+    if (m_stagingSize > m_frameCapacity)
+        allocate(m_stagingSize > m_frameCapacity * 2 ? m_stagingSize : m_frameCapacity * 2);
+
+    GLsync fence = (GLsync)m_fences[m_segment];
+    if (fence)
+    {
+        GLCall(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000));
+        GLCall(glDeleteSync(fence));
+        m_fences[m_segment] = nullptr;
+    }
+
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, m_rendererId);
+    GLCall(void* mapped = glMapBufferRange(GL_UNIFORM_BUFFER, getSegmentOffset(), m_stagingSize,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    if (mapped)
+    {
+        memcpy(mapped, m_staging.data(), m_stagingSize);
+        GLCall(glUnmapBuffer(GL_UNIFORM_BUFFER));
+    }
+    FrameStats::add(Stat::UniformUploads);
+}
+
+void UniformBuffer::endFrame()
+{
+    GLCall(m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+void UniformBuffer::bindRange(unsigned int binding, unsigned int offset, unsigned int size) const
+{
+    GLState::bindBufferRange(GL_UNIFORM_BUFFER, binding, m_rendererId, getSegmentOffset() + offset, size);
+    if (binding < MAX_BINDINGS)
+        s_bound[binding] = { this, offset, size };
+}
+
+const void* UniformBuffer::getBoundData(unsigned int binding, unsigned int size)
+{
+    if (binding >= MAX_BINDINGS)
+        return nullptr;
+    const BoundRange& range = s_bound[binding];
+    if (!range.buffer || range.size < size || range.offset + size > range.buffer->m_staging.size())
+        return nullptr;
+    return range.buffer->m_staging.data() + range.offset;
+}
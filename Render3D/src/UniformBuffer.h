@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+// A uniform buffer split into one segment per frame in flight. Blocks for the whole frame are
+// pushed into a CPU staging area, written to the frame's segment in a single upload, and then
+// bound per draw with bindRange. A fence per segment keeps the CPU from overwriting data the
+// GPU has not consumed yet.
+class UniformBuffer
+{
+private:
+	static const unsigned int FRAMES_IN_FLIGHT = 3;
+	static const unsigned int MAX_BINDINGS = 16;
+
+	struct BoundRange
+	{
+		const UniformBuffer* buffer;
+		unsigned int offset;
+		unsigned int size;
+	};
+	// What bindRange last bound to each binding point, so the software rasterizer can read it.
+	static BoundRange s_bound[MAX_BINDINGS];
+
+	unsigned int m_rendererId;
+	unsigned int m_frameCapacity;
+	unsigned int m_alignment;
+	unsigned int m_segment;
+	void* m_fences[FRAMES_IN_FLIGHT];
+	std::vector<unsigned char> m_staging;
+	unsigned int m_stagingSize;
+public:
+	UniformBuffer(unsigned int frameCapacity);
+	~UniformBuffer();
+
+	void beginFrame();
+	// Returns the offset of the block within this frame's data, for bindRange.
+	unsigned int push(const void* data, unsigned int size);
+	template<typename T>
+	unsigned int push(const T& block) { return push(&block, sizeof(T)); }
+	void upload();
+	void endFrame();
+
+	void bindRange(unsigned int binding, unsigned int offset, unsigned int size) const;
+	template<typename T>
+	void bindBlock(unsigned int offset) const { bindRange(T::getLayout().binding, offset, sizeof(T)); }
+
+	// The staged data of the block bound at binding, or nullptr when nothing of at least size
+	// bytes is bound there.
+	static const void* getBoundData(unsigned int binding, unsigned int size);
+
+private:
+	void allocate(unsigned int frameCapacity);
+	inline unsigned int getSegmentOffset() const { return m_segment * m_frameCapacity; }
+};
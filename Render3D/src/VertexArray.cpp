@@ -1,6 +1,7 @@
 #include "VertexArray.h"
 #include "VertexBufferLayout.h"
 #include "Renderer.h"
+#include "GLState.h"
 
 VertexArray::VertexArray()
 {
@@ -10,6 +11,7 @@ VertexArray::VertexArray()
 VertexArray::~VertexArray()
 {
 	GLCall(glDeleteVertexArrays(1, &m_rendererId));
+	GLState::onVertexArrayDeleted(m_rendererId);
 }
 
 void VertexArray::addBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
@@ -21,18 +23,27 @@ void VertexArray::addBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 	for (unsigned int i = 0; i < elements.size(); i++)
 	{
 		const auto& element = elements[i];
-		GLCall(glEnableVertexAttribArray(i));
-		GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.getStride(), (const void*)offset));
-		offset += element.count * VertexBufferElement::getSizeOfType(element.type);
+		// Attributes hold at most four components, so wider elements such as a mat4 take
+		// one location per group of four.
+		for (unsigned int component = 0; component < element.count; component += 4)
+		{
+			unsigned int count = element.count - component < 4 ? element.count - component : 4;
+			unsigned int location = (unsigned int)m_attributes.size();
+			GLCall(glEnableVertexAttribArray(location));
+			GLCall(glVertexAttribPointer(location, count, element.type, element.normalized, layout.getStride(), (const void*)(size_t)offset));
+			GLCall(glVertexAttribDivisor(location, layout.getDivisor()));
+			m_attributes.push_back({ &vb, element.type, count, element.normalized, layout.getStride(), offset, layout.getDivisor() });
+			offset += count * VertexBufferElement::getSizeOfType(element.type);
+		}
 	}
 }
 
 void VertexArray::bind() const
 {
-	GLCall(glBindVertexArray(m_rendererId));
+	GLState::bindVertexArray(m_rendererId);
 }
 
 void VertexArray::unbind() const
 {
-	GLCall(glBindVertexArray(0));
+	GLState::bindVertexArray(0);
 }
\ No newline at end of file
@@ -1,19 +1,39 @@
 #pragma once
 
+#include <vector>
 #include "VertexBuffer.h"
 
 class VertexBufferLayout;
 
+// Where one attribute location reads from, as set up with glVertexAttribPointer.
+struct VertexAttribute
+{
+	const VertexBuffer* buffer;
+	unsigned int type;
+	unsigned int count;
+	unsigned char normalized;
+	unsigned int stride;
+	unsigned int offset;
+	unsigned int divisor;
+};
+
 class VertexArray
 {
 private:
 	unsigned int m_rendererId;
+	std::vector<VertexAttribute> m_attributes;
 public:
 	VertexArray();
 	~VertexArray();
 
+	// Each call continues at the next free attribute location, so a per-vertex buffer and a
+	// per-instance buffer can be added one after the other.
 	void addBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
 
 	void bind() const;
 	void unbind() const;
+
+	inline unsigned int getRendererId() const { return m_rendererId; }
+	// The attribute at a location, or nullptr when the location is not enabled.
+	inline const VertexAttribute* getAttribute(unsigned int location) const { return location < m_attributes.size() ? &m_attributes[location] : nullptr; }
 };
\ No newline at end of file
@@ -1,24 +1,45 @@
 #include "VertexBuffer.h"
 #include "Renderer.h"
+#include "GLState.h"
+#include <cstring>
 
-VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+VertexBuffer::VertexBuffer(const void* data, unsigned int size, GLenum usage) : m_data(size)
 {
+    if (data)
+        memcpy(m_data.data(), data, size);
+
     GLCall(glGenBuffers(1, &m_rendererID));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_rendererID));
-    GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_rendererID);
+    GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, usage));
 }
 
 VertexBuffer::~VertexBuffer()
 {
     GLCall(glDeleteBuffers(1, &m_rendererID));
+    GLState::onBufferDeleted(m_rendererID);
 }
 
 void VertexBuffer::bind() const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_rendererID));
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_rendererID);
 }
 
 void VertexBuffer::unbind() const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VertexBuffer::setData(const void* data, unsigned int offset, unsigned int size)
+{
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_rendererID);
+    GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+    memcpy(m_data.data() + offset, data, size);
+}
+
+void VertexBuffer::copyFrom(const VertexBuffer& source, unsigned int size)
+{
+    GLState::bindBuffer(GL_COPY_READ_BUFFER, source.m_rendererID);
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, m_rendererID);
+    GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size));
+    memcpy(m_data.data(), source.m_data.data(), size);
 }
\ No newline at end of file
@@ -1,14 +1,28 @@
 #pragma once
 
+#include <vector>
+#include <GL/glew.h>
+
+// Keeps a CPU copy of its contents next to the GL buffer, for the software rasterizer.
 class VertexBuffer
 {
 private:
 	unsigned int m_rendererID;
+	std::vector<unsigned char> m_data;
 public:
 	VertexBuffer() : m_rendererID(0) {}
-	VertexBuffer(const void* data, unsigned int size);
+	VertexBuffer(const void* data, unsigned int size, GLenum usage = GL_STATIC_DRAW);
 	~VertexBuffer();
 
 	void bind() const;
 	void unbind() const;
+
+	// Overwrites size bytes starting at offset without reallocating the buffer.
+	void setData(const void* data, unsigned int offset, unsigned int size);
+	// Copies the first size bytes of source to the start of this buffer.
+	void copyFrom(const VertexBuffer& source, unsigned int size);
+
+	inline unsigned int getRendererId() const { return m_rendererID; }
+	inline const unsigned char* getData() const { return m_data.data(); }
+	inline unsigned int getSize() const { return (unsigned int)m_data.size(); }
 };
\ No newline at end of file
@@ -26,36 +26,39 @@ class VertexBufferLayout
 private:
 	std::vector<VertexBufferElement> m_elements;
 	unsigned int m_stride;
+	unsigned int m_divisor;
 public:
-	VertexBufferLayout() : m_stride(0) {};
+	// A divisor of 0 advances the attributes per vertex; N advances them once every N instances.
+	VertexBufferLayout(unsigned int divisor = 0) : m_stride(0), m_divisor(divisor) {};
 
 	template<typename T>
 	void push(unsigned int count)
 	{
-		static_assert(false);
+		static_assert(sizeof(T) == 0, "Unsupported vertex attribute type");
 	}
 
-	template<>
-	void push<float>(unsigned int count)
-	{
-		m_elements.push_back({ GL_FLOAT, count, GL_FALSE });
-		m_stride += count * VertexBufferElement::getSizeOfType(GL_FLOAT);
-	}
+	inline const std::vector<VertexBufferElement>& getElements() const { return m_elements; }
+	inline unsigned int getStride() const { return m_stride; }
+	inline unsigned int getDivisor() const { return m_divisor; }
+};
 
-	template<>
-	void push<unsigned int>(unsigned int count)
-	{
-		m_elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
-		m_stride += count * VertexBufferElement::getSizeOfType(GL_UNSIGNED_INT);
-	}
+template<>
+inline void VertexBufferLayout::push<float>(unsigned int count)
+{
+	m_elements.push_back({ GL_FLOAT, count, GL_FALSE });
+	m_stride += count * VertexBufferElement::getSizeOfType(GL_FLOAT);
+}
 
-	template<>
-	void push<unsigned char>(unsigned int count)
-	{
-		m_elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
-		m_stride += count * VertexBufferElement::getSizeOfType(GL_UNSIGNED_BYTE);
-	}
+template<>
+inline void VertexBufferLayout::push<unsigned int>(unsigned int count)
+{
+	m_elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
+	m_stride += count * VertexBufferElement::getSizeOfType(GL_UNSIGNED_INT);
+}
 
-	inline const std::vector<VertexBufferElement>& getElements() const { return m_elements; }
-	inline unsigned int getStride() const { return m_stride; }
-};
\ No newline at end of file
+template<>
+inline void VertexBufferLayout::push<unsigned char>(unsigned int count)
+{
+	m_elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
+	m_stride += count * VertexBufferElement::getSizeOfType(GL_UNSIGNED_BYTE);
+}
\ No newline at end of file
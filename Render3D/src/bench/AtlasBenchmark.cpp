@@ -0,0 +1,140 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../Framebuffer.h"
+#include "../FrameTimer.h"
+#include "../FrameStats.h"
+#include "../GLState.h"
+#include "../GridScene.h"
+#include "../TextureAtlas.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+
+static const int WIDTH = 800;
+static const int HEIGHT = 600;
+static const unsigned int FRAMES = 100;
+static const unsigned int IMAGE_COUNT = 200;
+static const unsigned int PACK_ITERATIONS = 5;
+// Texels may round differently where the packed pages stop at fewer mip levels than the
+// separate textures have, which only the farthest tiles reach.
+static const double MAX_MEAN_DIFFERENCE = 1.0;
+
+// Images of 8 to 64 texels a side, each one flat color, and a few too large for a page.
+static std::vector<std::vector<unsigned char>> createImages(std::vector<glm::ivec2>& sizes)
+{
+    std::mt19937 random(18);
+    std::vector<std::vector<unsigned char>> images;
+    for (unsigned int i = 0; i < IMAGE_COUNT; i++)
+    {
+        glm::ivec2 size = i % 50 == 0 ? glm::ivec2(256, 256) : glm::ivec2(8 + random() % 57, 8 + random() % 57);
+        unsigned int color = random();
+        std::vector<unsigned char> pixels((size_t)size.x * size.y * 4);
+        for (size_t texel = 0; texel < pixels.size(); texel += 4)
+        {
+            pixels[texel] = (unsigned char)color;
+            pixels[texel + 1] = (unsigned char)(color >> 8);
+            pixels[texel + 2] = (unsigned char)(color >> 16);
+            pixels[texel + 3] = 255;
+        }
+        images.push_back(std::move(pixels));
+        sizes.push_back(size);
+    }
+    return images;
+}
+
+// Whether each image's rectangle in the GL texture holds the image's texels.
+static bool checkRegions(const TextureAtlas& atlas, const std::vector<std::vector<unsigned char>>& images, const std::vector<glm::ivec2>& sizes)
+{
+    for (unsigned int index = 0; index < atlas.getTextureCount(); index++)
+    {
+        const Texture& texture = atlas.getTexture(index);
+        int width = texture.getWidth(), height = texture.getHeight();
+        std::vector<unsigned char> layers((size_t)width * height * 4 * texture.getLayerCount());
+        GLState::bindTexture(GL_TEXTURE_2D_ARRAY, texture.getRendererId());
+        GLCall(glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, GL_UNSIGNED_BYTE, layers.data()));
+        GLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        for (unsigned int i = 0; i < images.size(); i++)
+        {
+            const TextureAtlas::Region& region = atlas.getRegion(i);
+            if (region.texture != &texture)
+                continue;
+            int x = (int)(region.rect.x * width + 0.5f), y = (int)(region.rect.y * height + 0.5f);
+            const unsigned char* layer = &layers[(size_t)region.layer * width * height * 4];
+            for (int row = 0; row < sizes[i].y; row++)
+            {
+                if (memcmp(layer + ((size_t)(y + row) * width + x) * 4, &images[i][(size_t)row * sizes[i].x * 4], (size_t)sizes[i].x * 4) != 0)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+static std::vector<unsigned char> renderGrid(bool packed, const Camera& camera, unsigned int frames, const Framebuffer& framebuffer)
+{
+    GridScene scene(true, packed);
+    FrameTimer timer(frames);
+    Benchmark::renderFrames(scene, camera, frames, timer);
+
+    std::cout << (packed ? "Atlas" : "Separate textures") << ": " << FrameStats::getLast(Stat::DrawCalls) << " draws, "
+        << FrameStats::getLast(Stat::TextureBinds) << " texture binds, "
+        << FrameStats::getLast(Stat::StateChangesSorted) << " state changes\n";
+    Benchmark::printResult("frame time p50", timer.percentile(50.0), "ms");
+    return framebuffer.readPixels();
+}
+
+static int atlasBenchmark()
+{
+    bool correct = true;
+
+    // Packing and upload time, and what the padding costs in video memory.
+    std::vector<glm::ivec2> sizes;
+    std::vector<std::vector<unsigned char>> images = createImages(sizes);
+    size_t separateSize = 0;
+    for (unsigned int i = 0; i < images.size(); i++)
+        separateSize += Texture(sizes[i].x, sizes[i].y, images[i].data()).getVideoMemorySize();
+    std::unique_ptr<TextureAtlas> atlas;
+    double packMs = Benchmark::timeNs(PACK_ITERATIONS, [&](unsigned int) {
+        atlas.reset(new TextureAtlas());
+        for (unsigned int i = 0; i < images.size(); i++)
+            atlas->add(sizes[i].x, sizes[i].y, images[i].data());
+        atlas->build();
+        GLCall(glFinish());
+    }) / 1e6;
+    std::cout << IMAGE_COUNT << " images in " << atlas->getTextureCount() << " array textures:\n";
+    Benchmark::printResult("pack and upload", packMs, "ms");
+    Benchmark::printResult("video memory, separate textures", separateSize / 1024.0, "KB");
+    Benchmark::printResult("video memory, atlas", atlas->getVideoMemorySize() / 1024.0, "KB");
+    bool regionsCorrect = checkRegions(*atlas, images, sizes);
+    std::cout << "Regions hold their images: " << (regionsCorrect ? "yes" : "no") << "\n";
+    correct &= regionsCorrect;
+
+    // The grid's two images as separate textures and from one page.
+    Framebuffer framebuffer(WIDTH, HEIGHT);
+    framebuffer.bind();
+    Camera camera;
+    camera.proj = glm::perspective(glm::radians(45.0f), (float)WIDTH / HEIGHT, 0.1f, 100.0f);
+    camera.position = glm::vec3(0.0f, 20.0f, -40.0f);
+    camera.view = glm::lookAt(camera.position, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    std::cout << "\n";
+    std::vector<unsigned char> separate = renderGrid(false, camera, FRAMES, framebuffer);
+    std::vector<unsigned char> packed = renderGrid(true, camera, FRAMES, framebuffer);
+    // The frame's one bind happens before the first draw.
+    correct &= FrameStats::getLast(Stat::TextureBinds) <= 1;
+
+    double difference = 0.0;
+    for (size_t i = 0; i < separate.size(); i++)
+        difference += std::abs((int)separate[i] - (int)packed[i]);
+    difference /= separate.size();
+    std::cout << "Mean difference between the images: " << difference << "\n";
+    correct &= difference <= MAX_MEAN_DIFFERENCE;
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("atlas", "Packing images into array textures, and the texture binds it saves on the grid scene", atlasBenchmark);
@@ -0,0 +1,175 @@
+#include "../Benchmark.h"
+#include "../BVH.h"
+#include "../FrustumCuller.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+static void benchmarkObjects(unsigned int count, const Frustum& frustum)
+{
+    const unsigned int ITERATIONS = count >= 1000000 ? 3 : count >= 100000 ? 10 : 100;
+    const unsigned int QUERIES = 10000;
+
+    std::mt19937 random(count);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+    std::vector<AABB> boxes(count);
+    FrustumCuller culler;
+    culler.reserve(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        glm::vec3 center(position(random), position(random) * 0.1f, position(random));
+        glm::vec3 extent(size(random), size(random), size(random));
+        boxes[i] = { center - extent, center + extent };
+        culler.add(boxes[i]);
+    }
+
+    std::cout << count << " objects:\n";
+    BVH bvh;
+    bvh.setRebuildThreshold(0.0f);
+    double buildNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        bvh.build(boxes);
+    });
+    Benchmark::printResult("build", buildNs / 1e6, "ms");
+    Benchmark::printResult("nodes per object", (double)bvh.getNodeCount() / count, "");
+
+    // Small steps back and forth, as objects moving between frames would make.
+    std::vector<glm::vec3> offsets(count);
+    for (glm::vec3& offset : offsets)
+        offset = glm::vec3(step(random), step(random) * 0.1f, step(random));
+    const unsigned int fractions[] = { 100, 1 };
+    for (unsigned int divisor : fractions)
+    {
+        unsigned int moved = count / divisor;
+        double refitNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int iteration) {
+            for (unsigned int i = 0; i < moved; i++)
+            {
+                unsigned int object = (i * divisor + iteration) % count;
+                glm::vec3 offset = iteration % 2 ? -offsets[object] : offsets[object];
+                AABB box = bvh.getBounds(object);
+                bvh.update(object, { box.min + offset, box.max + offset });
+            }
+            bvh.refit();
+        });
+        std::string label = std::string("update and refit, ") + (divisor == 1 ? "all" : "1%") + " moved";
+        Benchmark::printResult(label.c_str(), refitNs / 1e6, "ms");
+    }
+    Benchmark::printResult("SAH cost after refits", bvh.getDegradation(), "x built");
+
+    std::vector<unsigned int> visible;
+    visible.reserve(count);
+    const unsigned int CULL_ITERATIONS = ITERATIONS * 10;
+    double bvhNs = Benchmark::timeNs(CULL_ITERATIONS, [&](unsigned int) {
+        visible.clear();
+        bvh.queryFrustum(frustum, visible);
+        Benchmark::consume(visible.size());
+    });
+    std::size_t bvhVisible = visible.size();
+    culler.setThreadCount(1);
+    for (unsigned int i = 0; i < count; i++)
+        culler.set(i, bvh.getBounds(i));
+    double linearNs = Benchmark::timeNs(CULL_ITERATIONS, [&](unsigned int) {
+        culler.cull(frustum, visible);
+        Benchmark::consume(visible.size());
+    });
+    if (visible.size() != bvhVisible)
+        std::cout << "  BVH found " << bvhVisible << " visible objects, FrustumCuller " << visible.size() << "\n";
+    Benchmark::printResult("frustum query, BVH", bvhNs / 1e6, "ms");
+    std::string label = std::string("frustum query, FrustumCuller ") + FrustumCuller::getKernelName(FrustumCuller::Kernel::Best) + ", 1 thread";
+    Benchmark::printResult(label.c_str(), linearNs / 1e6, "ms");
+
+    std::vector<glm::vec3> origins(QUERIES);
+    std::vector<glm::vec3> directions(QUERIES);
+    for (unsigned int i = 0; i < QUERIES; i++)
+    {
+        origins[i] = glm::vec3(position(random), 60.0f, position(random));
+        directions[i] = glm::normalize(glm::vec3(step(random), -1.0f, step(random)));
+    }
+    unsigned int hits = 0;
+    double rayNs = Benchmark::timeNs(QUERIES, [&](unsigned int i) {
+        if (bvh.raycast(origins[i], directions[i], 1000.0f).object != BVH::INVALID)
+            hits++;
+    });
+    Benchmark::printResult("raycast", 1000.0 / rayNs, "M rays/s");
+    Benchmark::printResult("rays that hit", 100.0 * hits / QUERIES, "%");
+
+    std::vector<unsigned int> found;
+    double boxNs = Benchmark::timeNs(QUERIES, [&](unsigned int i) {
+        found.clear();
+        glm::vec3 center(origins[i].x, 0.0f, origins[i].z);
+        bvh.queryRange(AABB{ center - glm::vec3(10.0f), center + glm::vec3(10.0f) }, found);
+        Benchmark::consume(found.size());
+    });
+    Benchmark::printResult("box range query, 20 units", 1000.0 / boxNs, "M queries/s");
+    double sphereNs = Benchmark::timeNs(QUERIES, [&](unsigned int i) {
+        found.clear();
+        bvh.queryRange(BoundingSphere{ glm::vec3(origins[i].x, 0.0f, origins[i].z), 10.0f }, found);
+        Benchmark::consume(found.size());
+    });
+    Benchmark::printResult("sphere range query, radius 10", 1000.0 / sphereNs, "M queries/s");
+
+    // Scatter every object so refitting cannot keep the tree tight, then let a background
+    // rebuild replace it while frames keep moving 1% of the objects and refitting.
+    for (unsigned int i = 0; i < count; i++)
+    {
+        glm::vec3 center(position(random), position(random) * 0.1f, position(random));
+        glm::vec3 extent = bvh.getBounds(i).getExtent();
+        bvh.update(i, { center - extent, center + extent });
+    }
+    bvh.refit();
+    Benchmark::printResult("SAH cost after scattering", bvh.getDegradation(), "x built");
+    double scatteredNs = Benchmark::timeNs(CULL_ITERATIONS, [&](unsigned int) {
+        visible.clear();
+        bvh.queryFrustum(frustum, visible);
+        Benchmark::consume(visible.size());
+    });
+    bvh.setRebuildThreshold(1.3f);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bvh.refit();
+    unsigned int frames = 0;
+    double slowestNs = 0.0;
+    while (bvh.isRebuilding())
+    {
+        double ns = Benchmark::timeNs(1, [&](unsigned int) {
+            for (unsigned int i = frames % 100; i < count; i += 100)
+            {
+                glm::vec3 offset = frames % 2 ? -offsets[i] : offsets[i];
+                AABB box = bvh.getBounds(i);
+                bvh.update(i, { box.min + offset, box.max + offset });
+            }
+            bvh.refit();
+        });
+        slowestNs = std::fmax(slowestNs, ns);
+        frames++;
+    }
+    double rebuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    double rebuiltNs = Benchmark::timeNs(CULL_ITERATIONS, [&](unsigned int) {
+        visible.clear();
+        bvh.queryFrustum(frustum, visible);
+        Benchmark::consume(visible.size());
+    });
+    Benchmark::printResult("frustum query, scattered", scatteredNs / 1e6, "ms");
+    Benchmark::printResult("background rebuild", rebuildMs, "ms");
+    Benchmark::printResult("frames refit while it ran", frames, "");
+    Benchmark::printResult("slowest of those frames, with the swap", slowestNs / 1e6, "ms");
+    Benchmark::printResult("frustum query, rebuilt", rebuiltNs / 1e6, "ms");
+}
+
+static int bvhBenchmark()
+{
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 400.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 20.0f, -300.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = Frustum::fromMatrix(proj * view);
+
+    benchmarkObjects(10000, frustum);
+    std::cout << "\n";
+    benchmarkObjects(100000, frustum);
+    std::cout << "\n";
+    benchmarkObjects(1000000, frustum);
+    return 0;
+}
+
+REGISTER_BENCHMARK("bvh", "BVH build, refit, frustum, ray and range queries at 10k, 100k and 1M objects", bvhBenchmark);
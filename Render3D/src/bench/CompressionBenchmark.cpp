@@ -0,0 +1,198 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../GLState.h"
+#include "../Texture.h"
+#include "../CompressedImage.h"
+#include "stb_image/stb_image.h"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+static const int IMAGE_SIZE = 1024;
+static const unsigned int ENCODE_ITERATIONS = 3;
+static const unsigned int LOAD_ITERATIONS = 200;
+static const unsigned int LARGE_LOAD_ITERATIONS = 5;
+// Drivers may round the thirds of BC1 and BC3 palettes differently from the CPU decoder.
+static const int MAX_DECODER_DIFFERENCE = 3;
+// Well under what any of the encoders reaches; a wrong bit layout lands far below it.
+static const double MIN_PSNR = 30.0;
+
+static const BlockFormat FORMATS[] = { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC7 };
+static const char* const TEXTURES[] = { "res/textures/Tile.png", "res/textures/whiteTile.png" };
+
+// Soft color gradients with a little noise, closer to a photograph than to flat test colors.
+static std::vector<unsigned char> createImage()
+{
+    std::mt19937 random(17);
+    std::vector<unsigned char> pixels((size_t)IMAGE_SIZE * IMAGE_SIZE * 4);
+    for (int y = 0; y < IMAGE_SIZE; y++)
+    {
+        for (int x = 0; x < IMAGE_SIZE; x++)
+        {
+            unsigned char* texel = &pixels[((size_t)y * IMAGE_SIZE + x) * 4];
+            float u = (float)x / IMAGE_SIZE, v = (float)y / IMAGE_SIZE;
+            float values[3] = { 0.5f + 0.5f * std::sin(u * 9.0f + v * 3.0f), 0.5f + 0.5f * std::sin(v * 7.0f - u * 2.0f), u * v };
+            for (int channel = 0; channel < 3; channel++)
+                texel[channel] = (unsigned char)std::max(0, std::min(255, (int)(values[channel] * 230.0f) + (int)(random() % 17)));
+            texel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+// Peak signal to noise ratio over the color channels, in decibels.
+static double measurePsnr(const unsigned char* a, const unsigned char* b, size_t texels)
+{
+    double squared = 0.0;
+    for (size_t i = 0; i < texels * 4; i++)
+    {
+        if (i % 4 != 3)
+            squared += (double)(a[i] - b[i]) * (a[i] - b[i]);
+    }
+    double mean = squared / (texels * 3);
+    return mean == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mean);
+}
+
+static int maxDifference(const unsigned char* a, const unsigned char* b, size_t bytes)
+{
+    int difference = 0;
+    for (size_t i = 0; i < bytes; i++)
+        difference = std::max(difference, std::abs((int)a[i] - (int)b[i]));
+    return difference;
+}
+
+// The base level of a texture, read back from GL, which decodes compressed textures.
+static std::vector<unsigned char> readBaseLevel(const Texture& texture)
+{
+    std::vector<unsigned char> pixels((size_t)texture.getWidth() * texture.getHeight() * 4);
+    GLState::bindTexture(GL_TEXTURE_2D, texture.getRendererId());
+    GLCall(glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    return pixels;
+}
+
+static std::string getTemporaryPath(BlockFormat format, const char* name)
+{
+    return std::string("compression_") + name + "_" + BlockCompression::getName(format) + ".dds";
+}
+
+static int compressionBenchmark()
+{
+    bool correct = true;
+    std::vector<unsigned char> image = createImage();
+    MipChain mips(IMAGE_SIZE, IMAGE_SIZE, image.data());
+    mips.generate(MipChain::Filter::Box, true, true);
+    std::vector<std::string> temporaryFiles;
+
+    // Encoding speed and quality, and whether the driver decodes the blocks as the CPU does.
+    std::cout << "Encoding a " << IMAGE_SIZE << "x" << IMAGE_SIZE << " image with its " << mips.getLevelCount() << " mip levels ("
+        << mips.getData().size() / 1024 << " KB as RGBA8):\n";
+    for (BlockFormat format : FORMATS)
+    {
+        CompressedImage compressed;
+        double ms = Benchmark::timeNs(ENCODE_ITERATIONS, [&](unsigned int) {
+            compressed = CompressedImage(mips, format);
+        }) / 1e6;
+        MipChain decoded = compressed.decode();
+        double psnr = measurePsnr(image.data(), decoded.getPixels(), (size_t)IMAGE_SIZE * IMAGE_SIZE);
+        std::cout << "  " << BlockCompression::getName(format) << ": " << ms << " ms, " << mips.getData().size() / (ms * 1e3) << " MB/s, "
+            << compressed.getSize() / 1024 << " KB, " << psnr << " dB";
+        correct &= psnr >= MIN_PSNR;
+
+        std::string path = getTemporaryPath(format, "image");
+        compressed.writeDDS(path);
+        temporaryFiles.push_back(path);
+        if (Texture::isFormatSupported(format))
+        {
+            Texture texture(path);
+            int difference = maxDifference(readBaseLevel(texture).data(), decoded.getPixels(), (size_t)IMAGE_SIZE * IMAGE_SIZE * 4);
+            std::cout << ", driver and CPU decodes differ by at most " << difference << "\n";
+            correct &= texture.isCompressed() && difference <= MAX_DECODER_DIFFERENCE;
+        }
+        else
+            std::cout << ", not sampled by this driver\n";
+    }
+
+    // What the engine's own textures take in video memory, made with the default options.
+    std::cout << "Video memory of res/textures with their mips:\n";
+    size_t uncompressedSize = 0;
+    for (const char* path : TEXTURES)
+        uncompressedSize += Texture(path).getVideoMemorySize();
+    Benchmark::printResult("RGBA8", uncompressedSize / 1024.0, "KB");
+    for (BlockFormat format : FORMATS)
+    {
+        size_t size = 0;
+        for (const char* path : TEXTURES)
+        {
+            stbi_set_flip_vertically_on_load_thread(1);
+            int width, height, bpp;
+            unsigned char* pixels = stbi_load(path, &width, &height, &bpp, 4);
+            if (!pixels)
+                continue;
+            MipChain chain(width, height, pixels);
+            stbi_image_free(pixels);
+            chain.generate(MipChain::Filter::Box, true, true);
+            CompressedImage compressed(chain, format);
+            size += compressed.getSize();
+
+            std::string name(path);
+            std::string output = getTemporaryPath(format, name.substr(name.find_last_of('/') + 1).c_str());
+            compressed.writeDDS(output);
+            temporaryFiles.push_back(output);
+        }
+        std::cout << "  " << BlockCompression::getName(format) << ": " << size / 1024.0 << " KB, " << (double)uncompressedSize / size << "x smaller\n";
+    }
+
+    // Load times to a texture ready to draw. The PNG path inflates and makes mips every time;
+    // the fallback decodes blocks on the CPU as drivers without the format need.
+    std::cout << "Loading res/textures/Tile.png and its conversions:\n";
+    double pngUs = Benchmark::timeNs(LOAD_ITERATIONS, [&](unsigned int) {
+        Texture texture(TEXTURES[0]);
+        GLCall(glFinish());
+    }) / 1e3;
+    Benchmark::printResult("PNG, box mips", pngUs, "us");
+    for (BlockFormat format : FORMATS)
+    {
+        std::string path = getTemporaryPath(format, "Tile.png");
+        for (int upload = 1; upload >= 0; upload--)
+        {
+            if (upload && !Texture::isFormatSupported(format))
+                continue;
+            Texture::setCompressedUpload(upload != 0);
+            double us = Benchmark::timeNs(LOAD_ITERATIONS, [&](unsigned int) {
+                Texture texture(path);
+                GLCall(glFinish());
+            }) / 1e3;
+            std::string label = std::string(BlockCompression::getName(format)) + (upload ? " DDS" : " DDS, decoded on the CPU");
+            Benchmark::printResult(label.c_str(), us, "us");
+        }
+        Texture::setCompressedUpload(true);
+    }
+
+    // The same for the large image, against its RGBA8 texels already in memory: the PNG path
+    // without the inflate, so the compressed files' lead here is the least they save.
+    std::cout << "Loading the " << IMAGE_SIZE << "x" << IMAGE_SIZE << " image:\n";
+    double rawMs = Benchmark::timeNs(LARGE_LOAD_ITERATIONS, [&](unsigned int) {
+        Texture texture(IMAGE_SIZE, IMAGE_SIZE, image.data());
+        GLCall(glFinish());
+    }) / 1e6;
+    Benchmark::printResult("RGBA8 from memory, box mips", rawMs, "ms");
+    for (BlockFormat format : FORMATS)
+    {
+        if (!Texture::isFormatSupported(format))
+            continue;
+        double ms = Benchmark::timeNs(LARGE_LOAD_ITERATIONS, [&](unsigned int) {
+            Texture texture(getTemporaryPath(format, "image"));
+            GLCall(glFinish());
+        }) / 1e6;
+        std::string label = std::string(BlockCompression::getName(format)) + " DDS";
+        Benchmark::printResult(label.c_str(), ms, "ms");
+    }
+
+    for (const std::string& path : temporaryFiles)
+        std::remove(path.c_str());
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("compression", "BC1, BC3 and BC7: encoding speed and quality, driver decoding, video memory and load times against PNG", compressionBenchmark);
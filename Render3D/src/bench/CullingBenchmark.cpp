@@ -0,0 +1,114 @@
+#include "../Benchmark.h"
+#include "../FrustumCuller.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <iostream>
+#include <random>
+#include <thread>
+
+static void cullObjects(unsigned int count, const Frustum& frustum)
+{
+    const unsigned int ITERATIONS = count >= 1000000 ? 20 : count >= 100000 ? 100 : 1000;
+
+    std::mt19937 random(count);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    std::vector<AABB> boxes(count);
+    FrustumCuller culler;
+    culler.reserve(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        glm::vec3 center(position(random), position(random) * 0.1f, position(random));
+        glm::vec3 extent(size(random), size(random), size(random));
+        boxes[i] = { center - extent, center + extent };
+        culler.add(boxes[i]);
+    }
+
+    std::vector<unsigned int> visible;
+    visible.reserve(count);
+    double aosNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        visible.clear();
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (frustum.intersects(boxes[i]))
+                visible.push_back(i);
+        }
+        Benchmark::consume(visible.size());
+    });
+
+    std::cout << count << " objects:\n";
+    Benchmark::printResult("array of AABBs, Frustum::intersects", count / aosNs * 1000.0, "M culls/s");
+
+    culler.setThreadCount(1);
+    const FrustumCuller::Kernel kernels[] = { FrustumCuller::Kernel::Scalar, FrustumCuller::Kernel::SSE, FrustumCuller::Kernel::AVX };
+    for (FrustumCuller::Kernel kernel : kernels)
+    {
+        if (kernel == FrustumCuller::Kernel::AVX && FrustumCuller::getBestKernel() != FrustumCuller::Kernel::AVX)
+            continue;
+        double ns = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+            culler.cull(frustum, visible, kernel);
+            Benchmark::consume(visible.size());
+        });
+        std::string label = std::string("SoA, ") + FrustumCuller::getKernelName(kernel) + ", 1 thread";
+        Benchmark::printResult(label.c_str(), count / ns * 1000.0, "M culls/s");
+    }
+
+    unsigned int threads = std::thread::hardware_concurrency();
+    culler.setThreadCount(threads);
+    double parallelNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        culler.cull(frustum, visible);
+        Benchmark::consume(visible.size());
+    });
+    std::string label = std::string("SoA, ") + FrustumCuller::getKernelName(FrustumCuller::Kernel::Best) + ", " + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+    if (count < FrustumCuller::PARALLEL_THRESHOLD)
+        label += " (below threshold)";
+    Benchmark::printResult(label.c_str(), count / parallelNs * 1000.0, "M culls/s");
+    Benchmark::printResult("visible", 100.0 * visible.size() / count, "%");
+}
+
+// Threads split the objects into chunks rounded to eight; a count that does not divide evenly
+// among them has to come out the same as culling on one thread.
+static bool checkUnevenSplit(const Frustum& frustum)
+{
+    const unsigned int COUNT = 65537;
+    std::mt19937 random(COUNT);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    FrustumCuller culler;
+    culler.reserve(COUNT);
+    for (unsigned int i = 0; i < COUNT; i++)
+    {
+        // The last object sits in front of the camera, so a chunk that misses it shows.
+        glm::vec3 center = i + 1 < COUNT ? glm::vec3(position(random), position(random) * 0.1f, position(random)) : glm::vec3(0.0f);
+        culler.add({ center - glm::vec3(1.0f), center + glm::vec3(1.0f) });
+    }
+
+    std::vector<unsigned int> single, threaded;
+    culler.setThreadCount(1);
+    culler.cull(frustum, single);
+    bool same = true;
+    for (unsigned int threads : { 2u, 3u, 7u })
+    {
+        culler.setThreadCount(threads);
+        culler.cull(frustum, threaded);
+        same &= threaded == single;
+    }
+    std::cout << COUNT << " objects on 2, 3 and 7 threads: " << (same ? "same as 1 thread" : "DIFFERENT from 1 thread") << "\n";
+    return same;
+}
+
+static int cullingBenchmark()
+{
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 400.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 20.0f, -300.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = Frustum::fromMatrix(proj * view);
+
+    cullObjects(10000, frustum);
+    std::cout << "\n";
+    cullObjects(100000, frustum);
+    std::cout << "\n";
+    cullObjects(1000000, frustum);
+    std::cout << "\n";
+    return checkUnevenSplit(frustum) ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("culling", "frustum culling throughput at 10k, 100k and 1M objects", cullingBenchmark);
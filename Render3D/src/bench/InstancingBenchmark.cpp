@@ -0,0 +1,48 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../Framebuffer.h"
+#include "../FrameTimer.h"
+#include "../FrameStats.h"
+#include "../TileFieldScene.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <iostream>
+
+static double renderTileField(bool instanced, const Camera& camera, unsigned int frames)
+{
+    // Unculled, so both paths draw every one of the 100k objects.
+    TileFieldScene scene(instanced, false);
+    FrameTimer timer(frames);
+    Benchmark::renderFrames(scene, camera, frames, timer);
+
+    std::cout << (instanced ? "Instanced" : "Per-object") << ": " << scene.getObjectCount() << " objects in "
+        << FrameStats::getLast(Stat::DrawCalls) << " draw calls\n";
+    Benchmark::printResult("frame time p50", timer.percentile(50.0), "ms");
+    Benchmark::printResult("frame time p95", timer.percentile(95.0), "ms");
+    return timer.mean();
+}
+
+static int instancingBenchmark()
+{
+    const int WIDTH = 1280;
+    const int HEIGHT = 720;
+    const unsigned int FRAMES = 20;
+
+    Framebuffer framebuffer(WIDTH, HEIGHT);
+    framebuffer.bind();
+
+    Camera camera;
+    camera.proj = glm::perspective(glm::radians(45.0f), (float)WIDTH / HEIGHT, 0.1f, 500.0f);
+    camera.position = glm::vec3(0.0f, 60.0f, -160.0f);
+    camera.view = glm::lookAt(camera.position, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    double perObjectMs = renderTileField(false, camera, FRAMES);
+    double instancedMs = renderTileField(true, camera, FRAMES);
+    std::cout << "\n";
+    Benchmark::printResult("per-object mean", perObjectMs, "ms/frame");
+    Benchmark::printResult("instanced mean", instancedMs, "ms/frame");
+    Benchmark::printResult("speedup", perObjectMs / instancedMs, "x");
+    return 0;
+}
+
+REGISTER_BENCHMARK("instancing", "100k-tile field: one draw per object vs instanced draws", instancingBenchmark);
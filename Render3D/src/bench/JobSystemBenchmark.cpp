@@ -0,0 +1,234 @@
+#include "../Benchmark.h"
+#include "../JobSystem.h"
+#include "../FrustumCuller.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+
+static const unsigned int OBJECTS = 1000000;
+static const unsigned int ITERATIONS = 20;
+
+// The frame work the job system is for, on a million objects: move them, cull them, and turn
+// the visible ones into a sorted list of draws.
+struct World
+{
+    std::vector<glm::mat4> models;
+    std::vector<glm::vec3> velocities;
+    std::vector<AABB> boxes;
+    FrustumCuller culler;
+    Frustum frustum;
+    std::vector<unsigned int> visible;
+    std::vector<unsigned long long> drawKeys;
+    Bounds meshBounds;
+};
+
+static void createWorld(World& world)
+{
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+    static const float cube[] = { -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+    world.meshBounds = Bounds::fromVertices(cube, 2, 3 * sizeof(float));
+    world.models.resize(OBJECTS);
+    world.velocities.resize(OBJECTS);
+    world.boxes.resize(OBJECTS);
+    world.culler.reserve(OBJECTS);
+    for (unsigned int i = 0; i < OBJECTS; i++)
+    {
+        world.models[i] = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random) * 0.1f, position(random)));
+        world.velocities[i] = glm::vec3(speed(random), 0.0f, speed(random));
+        world.boxes[i] = world.meshBounds.transformed(world.models[i]).box;
+        world.culler.add(world.boxes[i]);
+    }
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 1.0f, 1000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 20.0f, -500.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    world.frustum = Frustum::fromMatrix(proj * view);
+}
+
+static void moveObjects(World& world, unsigned int begin, unsigned int end)
+{
+    for (unsigned int i = begin; i < end; i++)
+    {
+        world.models[i] = glm::rotate(world.models[i], 0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+        world.models[i][3] += glm::vec4(world.velocities[i] * 0.016f, 0.0f);
+        world.boxes[i] = world.meshBounds.transformed(world.models[i]).box;
+    }
+}
+
+// Distance in the high bits, object in the low ones, like RenderQueue's keys.
+static void buildDrawKeys(World& world, unsigned int begin, unsigned int end)
+{
+    for (unsigned int i = begin; i < end; i++)
+    {
+        unsigned int object = world.visible[i];
+        float distance = glm::length(glm::vec3(world.models[object][3]));
+        unsigned int depth;
+        memcpy(&depth, &distance, sizeof(depth));
+        world.drawKeys[i] = (unsigned long long)depth << 32 | object;
+    }
+}
+
+// One frame as a graph: moving feeds the culler's boxes, culling needs them, and the draw
+// list needs the culling result. Culling itself spreads over the jobs through the culler.
+static void runFrame(World& world, JobSystem& jobs)
+{
+    JobHandle move = jobs.parallelFor("move objects", OBJECTS, 0, [&world](unsigned int begin, unsigned int end) {
+        moveObjects(world, begin, end);
+    });
+    JobHandle updateCuller = jobs.parallelFor("update culler", OBJECTS, 0, [&world](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++)
+            world.culler.set(i, world.boxes[i]);
+    }, { move });
+    jobs.wait(updateCuller);
+    world.culler.cull(world.frustum, world.visible);
+
+    world.drawKeys.resize(world.visible.size());
+    JobHandle keys = jobs.parallelFor("build draw list", (unsigned int)world.visible.size(), 0, [&world](unsigned int begin, unsigned int end) {
+        buildDrawKeys(world, begin, end);
+    });
+    jobs.wait(jobs.schedule("sort draw list", [&world]() { std::sort(world.drawKeys.begin(), world.drawKeys.end()); }, { keys }));
+}
+
+// Divide and conquer where every job waits on the two it spawns, which only works if waiting
+// threads run other jobs instead of blocking.
+static unsigned long long sumRange(JobSystem& jobs, const std::vector<unsigned int>& values, unsigned int begin, unsigned int end)
+{
+    if (end - begin <= 4096)
+    {
+        unsigned long long sum = 0;
+        for (unsigned int i = begin; i < end; i++)
+            sum += values[i];
+        return sum;
+    }
+    unsigned int middle = begin + (end - begin) / 2;
+    unsigned long long left = 0;
+    JobHandle leftJob = jobs.schedule("sum", [&jobs, &values, &left, begin, middle]() { left = sumRange(jobs, values, begin, middle); });
+    unsigned long long right = sumRange(jobs, values, middle, end);
+    jobs.wait(leftJob);
+    return left + right;
+}
+
+static void printScaling(const char* name, unsigned int threads, double ms, double oneThreadMs)
+{
+    std::string label = std::string(name) + ", " + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+    Benchmark::printResult(label.c_str(), ms, "ms");
+    if (threads > 1)
+        Benchmark::printResult("  speedup", oneThreadMs / ms, "x");
+}
+
+// Returns whether every job scheduled ran.
+static bool measureOverhead(unsigned int cores)
+{
+    const unsigned int JOBS = 100000;
+    const unsigned int threadCounts[] = { 1, cores };
+    bool ranAll = true;
+    for (unsigned int run = 0; run < (cores > 1 ? 2u : 1u); run++)
+    {
+        JobSystem jobs(threadCounts[run]);
+        std::atomic<unsigned int> counter(0);
+        double scheduleNs = Benchmark::timeNs(1, [&](unsigned int) {
+            std::vector<JobHandle> handles;
+            handles.reserve(JOBS);
+            for (unsigned int i = 0; i < JOBS; i++)
+                handles.push_back(jobs.schedule("empty", [&counter]() { counter++; }));
+            jobs.wait(jobs.schedule("join", []() {}, handles));
+        }) / JOBS;
+        std::string label = std::string("schedule and run an empty job, ") + std::to_string(threadCounts[run]) + (threadCounts[run] == 1 ? " thread" : " threads");
+        Benchmark::printResult(label.c_str(), scheduleNs, "ns");
+        if (counter != JOBS)
+            std::cout << "  ran " << counter << " of " << JOBS << " jobs!\n";
+        ranAll = ranAll && counter == JOBS;
+    }
+    return ranAll;
+}
+
+static int jobSystemBenchmark()
+{
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < cores; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(cores);
+
+    std::cout << "Overhead:\n";
+    bool correct = measureOverhead(cores);
+
+    World world;
+    createWorld(world);
+    std::vector<unsigned int> values(16 * 1024 * 1024);
+    for (unsigned int i = 0; i < values.size(); i++)
+        values[i] = i & 0xFFFF;
+
+    std::cout << "\n" << OBJECTS << " objects, " << cores << (cores == 1 ? " core" : " cores") << ":\n";
+    double oneThread[3] = {};
+    bool sumsMatch = true;
+    unsigned long long expectedSum = 0;
+    for (unsigned int value : values)
+        expectedSum += value;
+    for (unsigned int threads : threadCounts)
+    {
+        JobSystem jobs(threads);
+        world.culler.setJobSystem(&jobs);
+        double moveMs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+            jobs.wait(jobs.parallelFor("move objects", OBJECTS, 0, [&world](unsigned int begin, unsigned int end) { moveObjects(world, begin, end); }));
+        }) / 1e6;
+        double frameMs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+            runFrame(world, jobs);
+            Benchmark::consume(world.drawKeys.size());
+        }) / 1e6;
+        unsigned long long sum = 0;
+        double sumMs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+            sum = sumRange(jobs, values, 0, (unsigned int)values.size());
+            Benchmark::consume(sum);
+        }) / 1e6;
+        sumsMatch = sumsMatch && sum == expectedSum;
+        world.culler.setJobSystem(nullptr);
+
+        if (threads == 1)
+        {
+            oneThread[0] = moveMs;
+            oneThread[1] = frameMs;
+            oneThread[2] = sumMs;
+        }
+        printScaling("transform update", threads, moveMs, oneThread[0]);
+        printScaling("frame graph: move, cull, build and sort draws", threads, frameMs, oneThread[1]);
+        printScaling("recursive sum, jobs waiting on jobs", threads, sumMs, oneThread[2]);
+    }
+    std::cout << "  recursive sums " << (sumsMatch ? "match" : "DO NOT match") << " the serial sum\n";
+    correct = correct && sumsMatch;
+
+    // Jobs hand GL work to the main thread, which runs it while it waits.
+    {
+        JobSystem jobs(cores);
+        std::atomic<unsigned int> onMainThread(0);
+        JobHandle posts = jobs.parallelFor("post to main thread", 64, 1, [&jobs, &onMainThread](unsigned int, unsigned int) {
+            jobs.runOnMainThread([&jobs, &onMainThread]() { onMainThread += jobs.isMainThread(); });
+        });
+        jobs.wait(posts);
+        jobs.runMainThreadJobs();
+        std::cout << "  " << onMainThread << " of 64 main-thread jobs ran on the main thread\n";
+        correct = correct && onMainThread == 64;
+
+        jobs.setTimelineEnabled(true);
+        world.culler.setJobSystem(&jobs);
+        runFrame(world, jobs);
+        world.culler.setJobSystem(nullptr);
+        std::map<unsigned int, unsigned int> perThread;
+        std::vector<JobSystem::TimelineEvent> timeline = jobs.getTimeline();
+        for (const JobSystem::TimelineEvent& event : timeline)
+            perThread[event.thread]++;
+        std::cout << "\nTimeline of one frame graph on " << cores << (cores == 1 ? " thread" : " threads") << ": " << timeline.size() << " jobs";
+        for (const std::pair<const unsigned int, unsigned int>& thread : perThread)
+            std::cout << ", " << thread.second << " on thread " << thread.first;
+        std::cout << "\n";
+    }
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("jobs", "job system: overhead, scaling of frame work from 1 to N threads, nested waits and the main-thread queue", jobSystemBenchmark);
@@ -0,0 +1,168 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../MeshCache.h"
+#include "../MeshImporter.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// A height field of GRID x GRID quads: half a million triangles.
+static const unsigned int GRID = 512;
+static const unsigned int ITERATIONS = 3;
+static const char* const OBJ_PATH = "meshcache_bench.obj";
+static const char* const DIRECTORY = "meshcache_bench";
+
+static size_t writeOBJ(float height)
+{
+    std::ofstream file(OBJ_PATH, std::ios::binary);
+    char line[160];
+    file << "# " << GRID << "x" << GRID << " height field\nusemtl Ground\n";
+    for (unsigned int z = 0; z <= GRID; z++)
+    {
+        for (unsigned int x = 0; x <= GRID; x++)
+        {
+            float y = std::sin(x * 0.05f) * std::cos(z * 0.07f) * height;
+            int length = snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0.000000 1.000000 0.000000\n",
+                x * 0.1f, y, z * 0.1f, (float)x / GRID, (float)z / GRID);
+            file.write(line, length);
+        }
+    }
+    for (unsigned int z = 0; z < GRID; z++)
+    {
+        for (unsigned int x = 0; x < GRID; x++)
+        {
+            unsigned int a = z * (GRID + 1) + x + 1, b = a + 1, c = a + GRID + 2, d = a + GRID + 1;
+            int length = snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c, d, d, d);
+            file.write(line, length);
+        }
+    }
+    return (size_t)file.tellp();
+}
+
+// Drops the file's pages from the OS cache so the next read comes from the disk, as on the
+// first launch after a reboot. Only Linux has a call for one file; elsewhere it stays cached.
+static bool evict(const std::string& path)
+{
+#ifndef __linux__
+    return false;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    fdatasync(fd);
+    bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return evicted;
+#endif
+}
+
+// Milliseconds to create the mesh's buffers and have GL finish with them.
+template<typename T>
+static double timeUpload(const T& source)
+{
+    return Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        Mesh mesh(source);
+        GLCall(glFinish());
+    }) / 1e6;
+}
+
+static bool sameMesh(const MeshData& a, const MeshData& b)
+{
+    if (a.vertices.size() != b.vertices.size() || a.indices != b.indices || a.submeshes.size() != b.submeshes.size() || a.lods.size() != b.lods.size()
+        || memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(MeshData::Vertex)) != 0)
+        return false;
+    for (size_t i = 0; i < a.lods.size(); i++)
+    {
+        if (a.lods[i].error != b.lods[i].error || a.lods[i].submeshes.size() != b.lods[i].submeshes.size())
+            return false;
+    }
+    return a.submeshes[0].material == b.submeshes[0].material;
+}
+
+static int meshCacheBenchmark()
+{
+    std::string directory = MeshCache::getDirectory();
+    MeshCache::setDirectory(DIRECTORY);
+    std::string cachePath = MeshCache::getPath(OBJ_PATH);
+    std::remove(cachePath.c_str());
+    double objMB = writeOBJ(4.0f) / 1e6;
+
+    // Text import, warm and then with the source evicted.
+    MeshData imported;
+    bool correct = true;
+    double warmImportMs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        correct &= MeshImporter::import(OBJ_PATH, imported);
+    }) / 1e6;
+    bool cold = evict(OBJ_PATH);
+    double coldImportMs = Benchmark::timeNs(1, [&](unsigned int) {
+        correct &= MeshImporter::import(OBJ_PATH, imported);
+    }) / 1e6;
+
+    // The first load imports and writes the cache file; the next ones map it.
+    MeshCache::resetStats();
+    std::unique_ptr<CachedMesh> built = MeshCache::load(OBJ_PATH);
+    double buildMs = MeshCache::getStats().buildMs;
+    correct &= built && MeshCache::getStats().built == 1 && !built->getLods().empty();
+    MeshData reference = built ? built->toMeshData() : MeshData();
+    built.reset();
+
+    evict(OBJ_PATH);
+    evict(cachePath);
+    MeshCache::resetStats();
+    std::unique_ptr<CachedMesh> cached = MeshCache::load(OBJ_PATH);
+    MeshCache::Stats coldStats = MeshCache::getStats();
+    cached.reset();
+    MeshCache::resetStats();
+    for (unsigned int i = 0; i < ITERATIONS; i++)
+        cached = MeshCache::load(OBJ_PATH);
+    MeshCache::Stats warmStats = MeshCache::getStats();
+    correct &= cached && cached->isMapped() && coldStats.hits == 1 && warmStats.hits == ITERATIONS && sameMesh(cached->toMeshData(), reference);
+    double cacheMB = 0.0;
+    {
+        std::ifstream file(cachePath, std::ios::binary | std::ios::ate);
+        cacheMB = (double)file.tellg() / 1e6;
+    }
+
+    MeshData data = cached ? cached->toMeshData() : MeshData();
+    double uploadDataMs = timeUpload(data);
+    double uploadMappedMs = cached ? timeUpload(*cached) : 0.0;
+
+    std::cout << GRID * GRID * 2 << " triangles, OBJ of " << objMB << " MB, cache file of " << cacheMB << " MB with "
+        << reference.lods.size() << " levels of detail" << (cold ? ", cold reads with the files evicted" : ", cold reads from the page cache") << ":\n";
+    Benchmark::printResult("OBJ import, warm", warmImportMs, "ms");
+    Benchmark::printResult("OBJ import, cold", coldImportMs, "ms");
+    Benchmark::printResult("import, LODs and cache write", buildMs, "ms");
+    Benchmark::printResult("cache hit, cold: hash source", coldStats.hashMs, "ms");
+    Benchmark::printResult("cache hit, cold: map and check", coldStats.loadMs, "ms");
+    Benchmark::printResult("cache hit, warm: hash source", warmStats.hashMs / ITERATIONS, "ms");
+    Benchmark::printResult("cache hit, warm: map and check", warmStats.loadMs / ITERATIONS, "ms");
+    Benchmark::printResult("cold start speedup over OBJ", coldImportMs / (coldStats.hashMs + coldStats.loadMs), "x");
+    Benchmark::printResult("upload from MeshData", uploadDataMs, "ms");
+    Benchmark::printResult("upload from the mapping", uploadMappedMs, "ms");
+    cached.reset();
+
+    // A changed source is imported again and its file replaced.
+    writeOBJ(2.0f);
+    MeshCache::resetStats();
+    std::unique_ptr<CachedMesh> changed = MeshCache::load(OBJ_PATH);
+    correct &= changed && MeshCache::getStats().rebuilt == 1 && changed->getBounds().box.max.y < reference.bounds.box.max.y;
+    // And a file for other contents is turned down.
+    correct &= !MeshCache::open(cachePath, 0);
+    changed.reset();
+    MeshCache::printReport(std::cout);
+
+    std::remove(cachePath.c_str());
+    std::remove(DIRECTORY);
+    std::remove(OBJ_PATH);
+    MeshCache::setDirectory(directory);
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("meshcache", "Cold and warm loads of a half million triangle OBJ from the mesh cache against text import, and GL upload from the mapping", meshCacheBenchmark);
@@ -0,0 +1,210 @@
+#include "../Benchmark.h"
+#include "../JobSystem.h"
+#include "../MeshImporter.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+// A height field of GRID x GRID quads: 2 million triangles on a million vertices.
+static const unsigned int GRID = 1024;
+static const unsigned int ITERATIONS = 3;
+static const unsigned int FLOATS = 1000000;
+static const char* const OBJ_PATH = "meshimport_bench.obj";
+static const char* const GLB_PATH = "meshimport_bench.glb";
+
+static glm::vec3 getPosition(unsigned int x, unsigned int z)
+{
+    return glm::vec3(x * 0.1f, std::sin(x * 0.05f) * std::cos(z * 0.07f) * 4.0f, z * 0.1f);
+}
+
+// Every corner names its own position, texture coordinate and normal, as exporters write
+// smooth meshes, so the importer has to find the shared vertices.
+static size_t writeOBJ()
+{
+    std::ofstream file(OBJ_PATH, std::ios::binary);
+    char line[160];
+    file << "# " << GRID << "x" << GRID << " height field\nusemtl Ground\n";
+    for (unsigned int z = 0; z <= GRID; z++)
+    {
+        for (unsigned int x = 0; x <= GRID; x++)
+        {
+            glm::vec3 position = getPosition(x, z);
+            int length = snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0.000000 1.000000 0.000000\n",
+                position.x, position.y, position.z, (float)x / GRID, (float)z / GRID);
+            file.write(line, length);
+        }
+    }
+    for (unsigned int z = 0; z < GRID; z++)
+    {
+        for (unsigned int x = 0; x < GRID; x++)
+        {
+            unsigned int a = z * (GRID + 1) + x + 1, b = a + 1, c = a + GRID + 2, d = a + GRID + 1;
+            int length = snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c, d, d, d);
+            file.write(line, length);
+        }
+    }
+    return (size_t)file.tellp();
+}
+
+// The same grid with positions, normals and texture coordinates in buffer views of their own.
+static size_t writeGLB()
+{
+    unsigned int vertexCount = (GRID + 1) * (GRID + 1);
+    unsigned int indexCount = GRID * GRID * 6;
+    std::vector<unsigned char> bin;
+    auto append = [&bin](const void* data, size_t size) {
+        bin.insert(bin.end(), (const unsigned char*)data, (const unsigned char*)data + size);
+    };
+    glm::vec3 low(1e9f), high(-1e9f);
+    for (unsigned int z = 0; z <= GRID; z++)
+    {
+        for (unsigned int x = 0; x <= GRID; x++)
+        {
+            glm::vec3 position = getPosition(x, z);
+            low = glm::min(low, position);
+            high = glm::max(high, position);
+            append(&position, sizeof(position));
+        }
+    }
+    glm::vec3 up(0.0f, 1.0f, 0.0f);
+    for (unsigned int i = 0; i < vertexCount; i++)
+        append(&up, sizeof(up));
+    for (unsigned int z = 0; z <= GRID; z++)
+    {
+        for (unsigned int x = 0; x <= GRID; x++)
+        {
+            glm::vec2 texCoord((float)x / GRID, 1.0f - (float)z / GRID);
+            append(&texCoord, sizeof(texCoord));
+        }
+    }
+    for (unsigned int z = 0; z < GRID; z++)
+    {
+        for (unsigned int x = 0; x < GRID; x++)
+        {
+            unsigned int a = z * (GRID + 1) + x, b = a + 1, c = a + GRID + 2, d = a + GRID + 1;
+            unsigned int quad[] = { a, b, c, a, c, d };
+            append(quad, sizeof(quad));
+        }
+    }
+
+    size_t normals = (size_t)vertexCount * 12, texCoords = normals * 2, indices = texCoords + (size_t)vertexCount * 8;
+    char json[2048];
+    snprintf(json, sizeof(json),
+        "{\"asset\":{\"version\":\"2.0\"},\"materials\":[{\"name\":\"Ground\"}],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3,\"material\":0}]}],"
+        "\"accessors\":["
+        "{\"bufferView\":0,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\",\"min\":[%g,%g,%g],\"max\":[%g,%g,%g]},"
+        "{\"bufferView\":1,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},"
+        "{\"bufferView\":2,\"componentType\":5126,\"count\":%u,\"type\":\"VEC2\"},"
+        "{\"bufferView\":3,\"componentType\":5125,\"count\":%u,\"type\":\"SCALAR\"}],"
+        "\"bufferViews\":["
+        "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},"
+        "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],"
+        "\"buffers\":[{\"byteLength\":%zu}]}",
+        vertexCount, low.x, low.y, low.z, high.x, high.y, high.z, vertexCount, vertexCount, indexCount,
+        normals, normals, normals, texCoords, indices - texCoords, indices, bin.size() - indices, bin.size());
+    // Chunks are padded to 4 bytes, JSON with spaces.
+    std::string text = json;
+    text.resize((text.size() + 3) / 4 * 4, ' ');
+
+    std::ofstream file(GLB_PATH, std::ios::binary);
+    unsigned int header[] = { 0x46546C67, 2, (unsigned int)(12 + 8 + text.size() + 8 + bin.size()), (unsigned int)text.size(), 0x4E4F534A };
+    file.write((const char*)header, sizeof(header));
+    file.write(text.data(), text.size());
+    unsigned int binHeader[] = { (unsigned int)bin.size(), 0x004E4942 };
+    file.write((const char*)binHeader, sizeof(binHeader));
+    file.write((const char*)bin.data(), bin.size());
+    return (size_t)file.tellp();
+}
+
+// Compared corner by corner, since the OBJ importer numbers vertices in the order faces use them.
+static bool sameMesh(const MeshData& a, const MeshData& b, float tolerance)
+{
+    if (a.vertices.size() != b.vertices.size() || a.indices.size() != b.indices.size() || a.submeshes.size() != b.submeshes.size())
+        return false;
+    for (size_t i = 0; i < a.indices.size(); i++)
+    {
+        const MeshData::Vertex& first = a.vertices[a.indices[i]];
+        const MeshData::Vertex& second = b.vertices[b.indices[i]];
+        if (glm::length(first.position - second.position) > tolerance || glm::length(first.normal - second.normal) > tolerance
+            || glm::length(first.texCoord - second.texCoord) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+// Milliseconds per import, keeping the last result.
+static double timeImport(const char* path, MeshData& mesh, JobSystem* jobs, bool& imported)
+{
+    return Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        imported &= MeshImporter::import(path, mesh, jobs);
+    }) / 1e6;
+}
+
+// parseFloat against strtof on the kind of numbers OBJ files hold; every one has to match.
+static bool compareFloatParsing()
+{
+    std::mt19937 random(29);
+    std::uniform_real_distribution<float> distribution(-1000.0f, 1000.0f);
+    std::string text;
+    char number[32];
+    for (unsigned int i = 0; i < FLOATS; i++)
+    {
+        snprintf(number, sizeof(number), i % 2 ? "%.6f " : "%.9g ", distribution(random) * std::pow(10.0f, (float)(i % 7) - 3.0f));
+        text += number;
+    }
+    std::vector<float> parsed(FLOATS), reference(FLOATS);
+    const char* end = text.data() + text.size();
+    double parseNs = Benchmark::timeNs(1, [&](unsigned int) {
+        const char* p = text.data();
+        for (unsigned int i = 0; i < FLOATS; i++)
+            p = MeshImporter::parseFloat(p, end, parsed[i]) + 1;
+    });
+    double strtofNs = Benchmark::timeNs(1, [&](unsigned int) {
+        char* p = (char*)text.data();
+        for (unsigned int i = 0; i < FLOATS; i++)
+            reference[i] = strtof(p, &p);
+    });
+    Benchmark::printResult("parseFloat", parseNs / FLOATS, "ns/number");
+    Benchmark::printResult("strtof", strtofNs / FLOATS, "ns/number");
+    return parsed == reference;
+}
+
+static int meshImportBenchmark()
+{
+    double objMB = writeOBJ() / 1e6;
+    double glbMB = writeGLB() / 1e6;
+    unsigned int triangles = GRID * GRID * 2;
+
+    bool imported = true;
+    MeshData serial, parallel, binary;
+    JobSystem jobs;
+    double serialMs = timeImport(OBJ_PATH, serial, nullptr, imported);
+    double parallelMs = timeImport(OBJ_PATH, parallel, &jobs, imported);
+    double binaryMs = timeImport(GLB_PATH, binary, nullptr, imported);
+
+    std::cout << triangles << " triangles, OBJ of " << objMB << " MB, GLB of " << glbMB << " MB, from the page cache:\n";
+    Benchmark::printResult("OBJ, one thread", serialMs, "ms");
+    Benchmark::printResult("OBJ, one thread", objMB / (serialMs / 1e3), "MB/s");
+    std::string threaded = "OBJ, " + std::to_string(jobs.getThreadCount()) + " threads";
+    Benchmark::printResult(threaded.c_str(), parallelMs, "ms");
+    Benchmark::printResult(threaded.c_str(), objMB / (parallelMs / 1e3), "MB/s");
+    Benchmark::printResult("GLB", binaryMs, "ms");
+    Benchmark::printResult("GLB", glbMB / (binaryMs / 1e3), "MB/s");
+    Benchmark::printResult("OBJ triangles per second, threaded", triangles / (parallelMs / 1e3) / 1e6, "M");
+    bool correct = imported && compareFloatParsing();
+
+    // Dedup has to find the grid's shared vertices, and both formats have to agree.
+    unsigned int vertices = (GRID + 1) * (GRID + 1);
+    correct &= serial.vertices.size() == vertices && serial.indices.size() == (size_t)triangles * 3 && serial.submeshes.size() == 1
+        && serial.submeshes[0].material == "Ground" && serial.indices == parallel.indices && sameMesh(serial, parallel, 0.0f) && sameMesh(serial, binary, 1e-4f);
+
+    std::remove(OBJ_PATH);
+    std::remove(GLB_PATH);
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("import", "OBJ and binary glTF import of a 2 million triangle mesh, in MB/s, on one thread and with jobs", meshImportBenchmark);
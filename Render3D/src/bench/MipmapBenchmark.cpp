@@ -0,0 +1,249 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../Scene.h"
+#include "../Framebuffer.h"
+#include "../FrameTimer.h"
+#include "../GLState.h"
+#include "../VertexArray.h"
+#include "../VertexBuffer.h"
+#include "../VertexBufferLayout.h"
+#include "../IndexBuffer.h"
+#include "../Shader.h"
+#include "../Texture.h"
+#include "../UniformBuffer.h"
+#include "../UniformBlocks.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const int TEXTURE_SIZE = 1024;
+static const unsigned int FRAMES = 20;
+static const unsigned int ITERATIONS = 5;
+static const int LAYERS = 4;
+static const float FLOOR_SIZE = 2000.0f;
+static const float REPEATS = 500.0f;
+
+static constexpr Uniform<int> u_texture("u_texture");
+
+// A textured floor out to the horizon, every pixel of it minified and the far half by orders
+// of magnitude. It is drawn LAYERS times, each just above the last so it passes the depth
+// test, which makes the frame time mostly texture fetches.
+class MinifiedFloor : public Scene
+{
+private:
+    VertexArray m_va;
+    VertexBuffer m_vb;
+    IndexBuffer m_ib;
+    Shader m_shader;
+    UniformBuffer m_uniformBuffer;
+    const Texture* m_texture;
+public:
+    MinifiedFloor(const float* vertices, unsigned int size, const unsigned int* indices)
+        : m_vb(vertices, size), m_ib(indices, 6), m_shader("res/shaders/Simple.shader"), m_uniformBuffer(sizeof(CameraBlock) + LAYERS * sizeof(ObjectBlock)),
+        m_texture(nullptr)
+    {
+        VertexBufferLayout layout;
+        layout.push<float>(3);
+        layout.push<float>(2);
+        m_va.addBuffer(m_vb, layout);
+        m_va.bind();
+        m_ib.bind();
+        m_va.unbind();
+        m_shader.bindUniformBlock(CameraBlock::getLayout());
+        m_shader.bindUniformBlock(ObjectBlock::getLayout());
+        m_shader.bind();
+        m_shader.setUniform(u_texture, 0);
+    }
+
+    inline void setTexture(const Texture& texture) { m_texture = &texture; }
+
+    void onRender(const Renderer& renderer, const Camera& camera) override
+    {
+        m_uniformBuffer.beginFrame();
+        unsigned int cameraOffset = m_uniformBuffer.push(CameraBlock{ camera.proj * camera.view, glm::vec4(camera.position, 1.0f) });
+        unsigned int layerOffsets[LAYERS];
+        for (int layer = 0; layer < LAYERS; layer++)
+            layerOffsets[layer] = m_uniformBuffer.push(ObjectBlock{ glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, layer * 0.01f, 0.0f)), glm::vec4(1.0f) });
+        m_uniformBuffer.upload();
+        m_uniformBuffer.bindBlock<CameraBlock>(cameraOffset);
+        m_texture->bind(0);
+        for (int layer = 0; layer < LAYERS; layer++)
+        {
+            m_uniformBuffer.bindBlock<ObjectBlock>(layerOffsets[layer]);
+            renderer.draw(m_va, m_ib, m_shader);
+        }
+        m_uniformBuffer.endFrame();
+    }
+};
+
+// Fine colored noise over a 2 texel checker: detail everywhere, which is what aliases worst.
+static std::vector<unsigned char> createDetailedImage()
+{
+    std::mt19937 random(5);
+    std::vector<unsigned char> pixels((size_t)TEXTURE_SIZE * TEXTURE_SIZE * 4);
+    for (int y = 0; y < TEXTURE_SIZE; y++)
+    {
+        for (int x = 0; x < TEXTURE_SIZE; x++)
+        {
+            unsigned char* texel = &pixels[((size_t)y * TEXTURE_SIZE + x) * 4];
+            int base = (x / 2 + y / 2) % 2 ? 200 : 40;
+            for (int channel = 0; channel < 3; channel++)
+                texel[channel] = (unsigned char)std::min(255, base + (int)(random() % 56));
+            texel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+static Texture::Options makeOptions(Texture::Mips mips, bool trilinear, float anisotropy, bool srgb = true)
+{
+    Texture::Options options = Texture::getDefaultOptions();
+    options.mips = mips;
+    options.trilinear = trilinear;
+    options.anisotropy = anisotropy;
+    options.srgb = srgb;
+    return options;
+}
+
+// The 1x1 level of a texture, read back from GL.
+static unsigned char readSmallestLevel(const Texture& texture)
+{
+    unsigned char texel[4];
+    GLState::bindTexture(GL_TEXTURE_2D, texture.getRendererId());
+    GLCall(glGetTexImage(GL_TEXTURE_2D, MipChain::getFullLevelCount(texture.getWidth(), texture.getHeight()) - 1, GL_RGBA, GL_UNSIGNED_BYTE, texel));
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    return texel[0];
+}
+
+// Average change per channel between two frames, as a percentage of full scale.
+static double measureChange(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b)
+{
+    unsigned long long total = 0;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (i % 4 != 3)
+            total += std::abs((int)a[i] - (int)b[i]);
+    }
+    return 100.0 * total / (a.size() / 4 * 3 * 255.0);
+}
+
+static int mipmapBenchmark()
+{
+    std::vector<unsigned char> image = createDetailedImage();
+
+    // The chains on their own, and the textures they go into.
+    std::cout << "Mip chains for a " << TEXTURE_SIZE << "x" << TEXTURE_SIZE << " image:\n";
+    double boxMs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        MipChain mips(TEXTURE_SIZE, TEXTURE_SIZE, image.data());
+        mips.generate(MipChain::Filter::Box, true, true);
+        Benchmark::consume(mips.getData().size());
+    }) / 1e6;
+    double kaiserMs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        MipChain mips(TEXTURE_SIZE, TEXTURE_SIZE, image.data());
+        mips.generate(MipChain::Filter::Kaiser, true, true);
+        Benchmark::consume(mips.getData().size());
+    }) / 1e6;
+    Benchmark::printResult("CPU box filter, linear light", boxMs, "ms");
+    Benchmark::printResult("CPU Kaiser filter, linear light", kaiserMs, "ms");
+    const Texture::Mips creationModes[] = { Texture::Mips::None, Texture::Mips::Driver, Texture::Mips::Box };
+    const char* creationLabels[] = { "texture without mips", "texture with driver mips", "texture with box mips" };
+    for (int mode = 0; mode < 3; mode++)
+    {
+        double ms = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+            Texture texture(TEXTURE_SIZE, TEXTURE_SIZE, image.data(), makeOptions(creationModes[mode], true, 1.0f));
+            GLCall(glFinish());
+        }) / 1e6;
+        Benchmark::printResult(creationLabels[mode], ms, "ms");
+    }
+
+    // A black and white checker averages to half the light, which is 188 in sRGB.
+    std::vector<unsigned char> checker((size_t)256 * 256 * 4);
+    for (size_t i = 0; i < checker.size(); i += 4)
+    {
+        unsigned char value = (i / 4 % 256 + i / 4 / 256) % 2 ? 255 : 0;
+        checker[i] = checker[i + 1] = checker[i + 2] = value;
+        checker[i + 3] = 255;
+    }
+    Texture linearChecker(256, 256, checker.data(), makeOptions(Texture::Mips::Box, true, 1.0f));
+    Texture storedChecker(256, 256, checker.data(), makeOptions(Texture::Mips::Box, true, 1.0f, false));
+    Texture driverChecker(256, 256, checker.data(), makeOptions(Texture::Mips::Driver, true, 1.0f));
+    unsigned char linearValue = readSmallestLevel(linearChecker);
+    std::cout << "  1x1 level of a black and white checker: " << (int)linearValue << " filtered in linear light, "
+        << (int)readSmallestLevel(storedChecker) << " as stored, " << (int)readSmallestLevel(driverChecker) << " from the driver\n";
+    bool correct = linearValue >= 187 && linearValue <= 189;
+
+    // Fill rate of the minified floor with each kind of sampling.
+    Framebuffer framebuffer(WIDTH, HEIGHT);
+    framebuffer.bind();
+    const float vertices[] = {
+        -FLOOR_SIZE, 0.0f, -FLOOR_SIZE, 0.0f, 0.0f,
+         FLOOR_SIZE, 0.0f, -FLOOR_SIZE, REPEATS, 0.0f,
+         FLOOR_SIZE, 0.0f,  FLOOR_SIZE, REPEATS, REPEATS,
+        -FLOOR_SIZE, 0.0f,  FLOOR_SIZE, 0.0f, REPEATS,
+    };
+    const unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+    MinifiedFloor floor(vertices, sizeof(vertices), indices);
+
+    // Looking down steeply enough that the floor fills the frame up to just below the horizon.
+    Camera camera;
+    camera.proj = glm::perspective(glm::radians(60.0f), (float)WIDTH / HEIGHT, 1.0f, 5000.0f);
+    camera.position = glm::vec3(0.0f, 10.0f, 0.0f);
+    camera.view = glm::lookAt(camera.position, glm::vec3(0.0f, 0.0f, 15.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    // A hundredth of a unit, a texel or two of the floor: moves that small should barely
+    // change a frame, and aliasing is what makes them flicker.
+    Camera moved = camera;
+    moved.position.x += 0.01f;
+    moved.view = glm::lookAt(moved.position, glm::vec3(0.01f, 0.0f, 15.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    struct Variant
+    {
+        const char* name;
+        Texture::Mips mips;
+        bool trilinear;
+        float anisotropy;
+    };
+    const Variant variants[] = {
+        { "no mips, bilinear", Texture::Mips::None, false, 1.0f },
+        { "driver mips, trilinear", Texture::Mips::Driver, true, 1.0f },
+        { "box mips, nearest level", Texture::Mips::Box, false, 1.0f },
+        { "box mips, trilinear", Texture::Mips::Box, true, 1.0f },
+        { "Kaiser mips, trilinear", Texture::Mips::Kaiser, true, 1.0f },
+        { "box mips, trilinear, 4x anisotropic", Texture::Mips::Box, true, 4.0f },
+        { "box mips, trilinear, 16x anisotropic", Texture::Mips::Box, true, 16.0f },
+    };
+    std::cout << "\nMinified floor, " << WIDTH << "x" << HEIGHT << ", every pixel shaded " << LAYERS << " times, anisotropy up to "
+        << Texture::getMaxAnisotropy() << "x:\n";
+    double noMipsMs = 0.0, trilinearMs = 0.0;
+    for (const Variant& variant : variants)
+    {
+        Texture texture(TEXTURE_SIZE, TEXTURE_SIZE, image.data(), makeOptions(variant.mips, variant.trilinear, variant.anisotropy));
+        floor.setTexture(texture);
+        FrameTimer timer(FRAMES);
+        Benchmark::renderFrames(floor, camera, FRAMES, timer);
+        std::vector<unsigned char> still = framebuffer.readPixels();
+        FrameTimer movedTimer(1);
+        Benchmark::renderFrames(floor, moved, 1, movedTimer);
+        double change = measureChange(still, framebuffer.readPixels());
+
+        double ms = timer.percentile(50.0);
+        std::cout << variant.name << ":\n";
+        Benchmark::printResult("frame time p50", ms, "ms");
+        Benchmark::printResult("fill rate", (double)WIDTH * HEIGHT * LAYERS / (ms * 1e3), "Mpixels/s");
+        Benchmark::printResult("change after a hundredth of a unit", change, "%");
+        if (variant.mips == Texture::Mips::None)
+            noMipsMs = ms;
+        else if (variant.mips == Texture::Mips::Box && variant.trilinear && variant.anisotropy == 1.0f)
+            trilinearMs = ms;
+    }
+    Benchmark::printResult("trilinear box mips against no mips", noMipsMs / trilinearMs, "x");
+
+    if (!correct)
+        std::cout << "The box filter did not average the checker in linear light!\n";
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("mipmaps", "mip chains: CPU box and Kaiser filters, fill rate and aliasing of a minified floor with and without mips, trilinear and anisotropic", mipmapBenchmark);
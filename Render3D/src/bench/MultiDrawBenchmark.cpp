@@ -0,0 +1,55 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../Framebuffer.h"
+#include "../FrameTimer.h"
+#include "../FrameStats.h"
+#include "../MeshFieldScene.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <iostream>
+
+static double renderMeshField(MeshSubmission submission, const char* label, const Camera& camera, unsigned int frames)
+{
+    MeshFieldScene scene(submission);
+    FrameTimer timer(frames);
+    Benchmark::renderFrames(scene, camera, frames, timer);
+
+    std::cout << label << ": " << scene.getMeshCount() << " meshes in " << FrameStats::getLast(Stat::DrawCalls) << " draw calls, "
+        << FrameStats::getLast(Stat::BindMisses) << " binds\n";
+    Benchmark::printResult("frame time p50", timer.percentile(50.0), "ms");
+    Benchmark::printResult("frame time p95", timer.percentile(95.0), "ms");
+    return timer.mean();
+}
+
+static int multiDrawBenchmark()
+{
+    const int WIDTH = 1280;
+    const int HEIGHT = 720;
+    const unsigned int FRAMES = 50;
+
+    Framebuffer framebuffer(WIDTH, HEIGHT);
+    framebuffer.bind();
+
+    Camera camera;
+    camera.proj = glm::perspective(glm::radians(45.0f), (float)WIDTH / HEIGHT, 0.1f, 500.0f);
+    camera.position = glm::vec3(0.0f, 50.0f, -120.0f);
+    camera.view = glm::lookAt(camera.position, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    double separateMs = renderMeshField(MeshSubmission::Separate, "Separate vertex arrays", camera, FRAMES);
+    double multiDrawMs = renderMeshField(MeshSubmission::MultiDraw, "Arena + glMultiDrawElementsBaseVertex", camera, FRAMES);
+    double indirectMs = 0.0;
+    if (MeshBatch::isIndirectSupported())
+        indirectMs = renderMeshField(MeshSubmission::Indirect, "Arena + glMultiDrawElementsIndirect", camera, FRAMES);
+    else
+        std::cout << "glMultiDrawElementsIndirect is not available, skipping it\n";
+
+    std::cout << "\n";
+    Benchmark::printResult("separate mean", separateMs, "ms/frame");
+    Benchmark::printResult("multi-draw mean", multiDrawMs, "ms/frame");
+    if (indirectMs > 0.0)
+        Benchmark::printResult("indirect mean", indirectMs, "ms/frame");
+    Benchmark::printResult("multi-draw speedup", separateMs / multiDrawMs, "x");
+    return 0;
+}
+
+REGISTER_BENCHMARK("multidraw", "20k static meshes: one draw each vs a shared arena and multi-draw", multiDrawBenchmark);
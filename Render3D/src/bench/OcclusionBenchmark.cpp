@@ -0,0 +1,143 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../Framebuffer.h"
+#include "../FrameTimer.h"
+#include "../FrameStats.h"
+#include "../BuildingScene.h"
+#include "../OcclusionCuller.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <iostream>
+#include <random>
+#include <thread>
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+
+static double renderBuilding(bool occlusion, const Camera& camera, std::vector<unsigned char>& pixels)
+{
+    const unsigned int FRAMES = 30;
+    BuildingScene scene(occlusion);
+    FrameTimer timer(FRAMES);
+    Benchmark::renderFrames(scene, camera, FRAMES, timer);
+    pixels.resize(WIDTH * HEIGHT * 4);
+    GLCall(glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+
+    std::cout << (occlusion ? "Occlusion culled" : "Frustum culled only") << ": " << FrameStats::getLast(Stat::DrawCalls) << " draw calls, "
+        << FrameStats::getLast(Stat::DrawsOccluded) << " draws occluded\n";
+    Benchmark::printResult("frame time p50", timer.percentile(50.0), "ms");
+    return timer.mean();
+}
+
+// Returns whether culling left the image as it is, which it does unless something visible was culled.
+static bool compareBuilding(const char* label, const Camera& camera)
+{
+    std::cout << label << "\n";
+    std::vector<unsigned char> culledPixels, referencePixels;
+    double culledMs = renderBuilding(true, camera, culledPixels);
+    double referenceMs = renderBuilding(false, camera, referencePixels);
+    unsigned int different = 0;
+    for (size_t i = 0; i < culledPixels.size(); i += 4)
+        different += culledPixels[i] != referencePixels[i] || culledPixels[i + 1] != referencePixels[i + 1] || culledPixels[i + 2] != referencePixels[i + 2];
+    Benchmark::printResult("frame time saved", referenceMs - culledMs, "ms");
+    Benchmark::printResult("pixels that differ", different, "");
+    return different == 0;
+}
+
+// Times the culler alone on a city of random walls and a crowd of boxes between them.
+static void cullCity()
+{
+    const unsigned int WALLS = 2000;
+    const unsigned int BOXES = 100000;
+    const unsigned int ITERATIONS = 50;
+    static const float quad[] = {
+        0.0f, 0.0f, 0.0f,
+        1.0f, 0.0f, 0.0f,
+        1.0f, 1.0f, 0.0f,
+        0.0f, 1.0f, 0.0f,
+    };
+    static const unsigned int quadIndices[] = { 0, 1, 2, 2, 3, 0 };
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(-300.0f, 300.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    OcclusionCuller culler;
+    for (unsigned int i = 0; i < WALLS; i++)
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), 0.0f, position(random)));
+        model = glm::rotate(model, unit(random) * 6.2832f, glm::vec3(0.0f, 1.0f, 0.0f));
+        model = glm::scale(model, glm::vec3(10.0f + 30.0f * unit(random), 5.0f + 15.0f * unit(random), 1.0f));
+        culler.addOccluder(quad, 3 * sizeof(float), quadIndices, 6, model);
+    }
+    std::vector<AABB> boxes(BOXES);
+    std::vector<unsigned int> allObjects(BOXES);
+    for (unsigned int i = 0; i < BOXES; i++)
+    {
+        glm::vec3 center(position(random), 1.0f + 2.0f * unit(random), position(random));
+        boxes[i] = { center - glm::vec3(1.0f), center + glm::vec3(1.0f) };
+        allObjects[i] = i;
+    }
+
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), (float)WIDTH / HEIGHT, 0.5f, 1000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 3.0f, -320.0f), glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 viewProj = proj * view;
+
+    std::cout << WALLS << " wall occluders, " << BOXES << " boxes, " << culler.getWidth() << "x" << culler.getHeight() << " depth buffer:\n";
+    std::vector<unsigned int> visible;
+    const OcclusionCuller::Kernel kernels[] = { OcclusionCuller::Kernel::Scalar, OcclusionCuller::Kernel::SSE, OcclusionCuller::Kernel::AVX2 };
+    unsigned int cores = std::thread::hardware_concurrency();
+    for (OcclusionCuller::Kernel kernel : kernels)
+    {
+        if (kernel == OcclusionCuller::Kernel::AVX2 && OcclusionCuller::getBestKernel() != OcclusionCuller::Kernel::AVX2)
+            continue;
+        if (kernel == OcclusionCuller::Kernel::SSE && OcclusionCuller::getBestKernel() == OcclusionCuller::Kernel::Scalar)
+            continue;
+        // Threads only for the best kernel; one thread shows what the kernel itself gains.
+        const unsigned int threadCounts[] = { 1, cores };
+        unsigned int runs = cores > 1 && kernel == OcclusionCuller::getBestKernel() ? 2 : 1;
+        for (unsigned int run = 0; run < runs; run++)
+        {
+            unsigned int threads = threadCounts[run];
+            culler.setThreadCount(threads);
+            double rasterNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+                culler.beginFrame(viewProj, kernel);
+                culler.finishFrame();
+            });
+            std::string label = std::string(OcclusionCuller::getKernelName(kernel)) + ", " + std::to_string(threads) + (threads == 1 ? " thread" : " threads") + ": rasterize";
+            Benchmark::printResult(label.c_str(), rasterNs / 1e6, "ms");
+        }
+
+        double testNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+            visible = allObjects;
+            culler.cull(boxes, visible);
+            Benchmark::consume(visible.size());
+        });
+        std::string label = std::string(OcclusionCuller::getKernelName(kernel)) + ": test boxes";
+        Benchmark::printResult(label.c_str(), BOXES / testNs * 1000.0, "M boxes/s");
+    }
+    Benchmark::printResult("boxes kept", 100.0 * visible.size() / BOXES, "%");
+}
+
+static int occlusionBenchmark()
+{
+    Framebuffer framebuffer(WIDTH, HEIGHT);
+    framebuffer.bind();
+
+    // Standing in the middle room at eye height, looking through the doorways.
+    Camera camera;
+    camera.proj = glm::perspective(glm::radians(60.0f), (float)WIDTH / HEIGHT, 0.5f, 500.0f);
+    camera.position = glm::vec3(0.0f, 1.7f, -6.0f);
+    camera.view = glm::lookAt(camera.position, glm::vec3(0.0f, 1.7f, 20.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    bool correct = compareBuilding("Building, looking down the corridor of doorways:", camera);
+
+    std::cout << "\n";
+    camera.position = glm::vec3(-8.0f, 2.5f, -8.0f);
+    camera.view = glm::lookAt(camera.position, glm::vec3(20.0f, 1.0f, 30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    correct &= compareBuilding("Building, looking across the room into a corner:", camera);
+
+    std::cout << "\n";
+    cullCity();
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("occlusion", "software occlusion culling: draws rejected, image check and culler throughput", occlusionBenchmark);
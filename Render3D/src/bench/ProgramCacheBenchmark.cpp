@@ -0,0 +1,111 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../Shader.h"
+#include "../ProgramCache.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+static const struct
+{
+    const char* path;
+    unsigned int variant;
+} SHADERS[] = {
+    { "res/shaders/Simple.shader", 0 }, { "res/shaders/Simple.shader", SIMPLE_ATLAS }, { "res/shaders/Simple.shader", SIMPLE_INSTANCED },
+    { "res/shaders/Batched.shader", 0 }, { "res/shaders/Flat.shader", 0 }, { "res/shaders/Heatmap.shader", 0 }
+};
+static const unsigned int SHADER_COUNT = sizeof(SHADERS) / sizeof(SHADERS[0]);
+static const unsigned int ITERATIONS = 5;
+static const char* const DIRECTORY = "programcache_bench";
+
+// Milliseconds to make every shader, once the driver has finished linking them.
+static double createShaders(std::vector<std::unique_ptr<Shader>>& shaders)
+{
+    shaders.clear();
+    return Benchmark::timeNs(1, [&](unsigned int) {
+        for (const auto& shader : SHADERS)
+            shaders.emplace_back(new Shader(ShaderFile(shader.path), shader.variant));
+        GLCall(glFinish());
+    }) / 1e6;
+}
+
+// Whether two builds of the same shaders expose the same uniforms and inputs.
+static bool sameInterface(const std::vector<std::unique_ptr<Shader>>& a, const std::vector<std::unique_ptr<Shader>>& b)
+{
+    for (unsigned int i = 0; i < SHADER_COUNT; i++)
+    {
+        if (a[i]->getUniforms().size() != b[i]->getUniforms().size())
+            return false;
+        for (const char* name : { "a_position", "a_texCoord", "a_color", "a_model" })
+        {
+            if (a[i]->getAttributeLocation(name) != b[i]->getAttributeLocation(name))
+                return false;
+        }
+    }
+    return true;
+}
+
+static int programCacheBenchmark()
+{
+    std::string directory = ProgramCache::getDirectory();
+    std::vector<std::unique_ptr<Shader>> compiled, cached;
+
+    // Compiling every time, as without the cache. The driver may keep a cache of its own,
+    // which the later runs hit as well.
+    ProgramCache::setDirectory("");
+    double compileMs = 0.0;
+    for (unsigned int i = 0; i < ITERATIONS; i++)
+        compileMs += createShaders(compiled);
+    std::cout << SHADER_COUNT << " programs:\n";
+    Benchmark::printResult("compiled", compileMs / ITERATIONS, "ms");
+
+    ProgramCache::setDirectory(DIRECTORY);
+    if (!ProgramCache::isEnabled())
+    {
+        std::cout << "The driver has no program binary formats, so nothing is cached\n";
+        ProgramCache::setDirectory(directory);
+        return 0;
+    }
+    ProgramCache::resetStats();
+    double firstMs = createShaders(cached);
+    Benchmark::printResult("compiled and stored", firstMs, "ms");
+    ProgramCache::resetStats();
+    double cachedMs = 0.0;
+    for (unsigned int i = 0; i < ITERATIONS; i++)
+        cachedMs += createShaders(cached);
+    Benchmark::printResult("loaded from the cache", cachedMs / ITERATIONS, "ms");
+    ProgramCache::printReport(std::cout);
+    bool correct = ProgramCache::getStats().hits == SHADER_COUNT * ITERATIONS && sameInterface(compiled, cached);
+
+    // A binary the driver refuses is compiled again and replaced.
+    std::string path = ProgramCache::getPath(cached[0]->getProgramKey());
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(0, std::ios::end);
+        std::vector<char> garbage((size_t)file.tellp() - 48, 'x');
+        file.seekp(48);
+        file.write(garbage.data(), garbage.size());
+    }
+    ProgramCache::resetStats();
+    Shader rejected(SHADERS[0].path);
+    Shader replaced(SHADERS[0].path);
+    std::cout << "After overwriting a binary: ";
+    ProgramCache::printReport(std::cout);
+    const ProgramCache::Stats& stats = ProgramCache::getStats();
+    correct &= stats.rejected == 1 && stats.hits == 1 && rejected.getUniforms().size() == compiled[0]->getUniforms().size();
+
+    compiled.clear();
+    cached.clear();
+    for (const auto& shader : SHADERS)
+    {
+        std::unique_ptr<Shader> program(new Shader(ShaderFile(shader.path), shader.variant));
+        std::remove(ProgramCache::getPath(program->getProgramKey()).c_str());
+    }
+    std::remove(DIRECTORY);
+    ProgramCache::setDirectory(directory);
+    ProgramCache::resetStats();
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("programcache", "Program binaries kept on disk: compile time against loading, and binaries the driver rejects", programCacheBenchmark);
@@ -0,0 +1,80 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../Framebuffer.h"
+#include "../FrameTimer.h"
+#include "../FrameStats.h"
+#include "../RenderQueue.h"
+#include "../GridScene.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+static void sortKeys(unsigned int count)
+{
+    const unsigned int ITERATIONS = count > 10000 ? 50 : 1000;
+
+    std::mt19937_64 random(count);
+    std::vector<RenderQueue::SortItem> keys(count);
+    for (unsigned int i = 0; i < count; i++)
+        keys[i] = { random(), i };
+
+    std::vector<RenderQueue::SortItem> items, scratch;
+    items.reserve(count);
+    double radixNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        items.assign(keys.begin(), keys.end());
+        RenderQueue::radixSort(items, scratch);
+        Benchmark::consume(items[count / 2].key);
+    });
+    double stdNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        items.assign(keys.begin(), keys.end());
+        std::sort(items.begin(), items.end(), [](const RenderQueue::SortItem& a, const RenderQueue::SortItem& b) { return a.key < b.key; });
+        Benchmark::consume(items[count / 2].key);
+    });
+
+    std::cout << count << " keys:\n";
+    Benchmark::printResult("radix sort", radixNs / 1000.0, "us");
+    Benchmark::printResult("std::sort", stdNs / 1000.0, "us");
+}
+
+static double renderGrid(bool sorted, const Camera& camera, unsigned int frames)
+{
+    GridScene scene(sorted);
+    FrameTimer timer(frames);
+    Benchmark::renderFrames(scene, camera, frames, timer);
+
+    std::cout << (sorted ? "Sorted" : "Submission order") << ": " << FrameStats::getLast(Stat::DrawCalls) << " draws, "
+        << FrameStats::getLast(Stat::StateChangesSubmitted) << " state changes as submitted, "
+        << FrameStats::getLast(Stat::StateChangesSorted) << " as executed\n";
+    Benchmark::printResult("frame time p50", timer.percentile(50.0), "ms");
+    return timer.mean();
+}
+
+static int renderQueueBenchmark()
+{
+    sortKeys(4096);
+    sortKeys(100000);
+
+    const int WIDTH = 800;
+    const int HEIGHT = 600;
+    const unsigned int FRAMES = 100;
+
+    Framebuffer framebuffer(WIDTH, HEIGHT);
+    framebuffer.bind();
+
+    Camera camera;
+    camera.proj = glm::perspective(glm::radians(45.0f), (float)WIDTH / HEIGHT, 0.1f, 100.0f);
+    camera.position = glm::vec3(0.0f, 20.0f, -40.0f);
+    camera.view = glm::lookAt(camera.position, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    std::cout << "\n";
+    double unsortedMs = renderGrid(false, camera, FRAMES);
+    double sortedMs = renderGrid(true, camera, FRAMES);
+    std::cout << "\n";
+    Benchmark::printResult("submission order mean", unsortedMs, "ms/frame");
+    Benchmark::printResult("sorted mean", sortedMs, "ms/frame");
+    return 0;
+}
+
+REGISTER_BENCHMARK("renderqueue", "64-bit key radix sort and the state changes it saves on the grid scene", renderQueueBenchmark);
@@ -0,0 +1,116 @@
+#include "../Benchmark.h"
+#include "../ResourcePack.h"
+#include "../ShaderFile.h"
+#include "../Texture.h"
+#include "stb_image/stb_image.h"
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+static const char* const PACK_PATH = "resourcepack_bench.pack";
+static const unsigned int ITERATIONS = 200;
+static const unsigned int DECODE_ITERATIONS = 20;
+static const size_t ROUND_TRIP_SIZE = 1 << 20;
+
+// Nanoseconds to load every resource once and touch its bytes, through whatever is mounted.
+static double loadAll(const std::vector<std::string>& names, bool& matched, const std::vector<unsigned long long>& hashes)
+{
+    return Benchmark::timeNs(ITERATIONS, [&](unsigned int iteration) {
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            Resource resource = ResourcePack::load(names[i]);
+            // Hashing every byte on the first pass checks them; later passes read one per page.
+            if (iteration == 0)
+                matched &= resource.isValid() && ResourcePack::hash(resource.getData(), resource.getSize()) == hashes[i];
+            else
+            {
+                for (size_t offset = 0; offset < resource.getSize(); offset += 4096)
+                    Benchmark::consume(resource.getData()[offset]);
+            }
+        }
+    });
+}
+
+// Nanoseconds to read and decode every image and preprocess every shader, as a scene's setup does.
+static double decodeAll(const std::vector<std::string>& names)
+{
+    return Benchmark::timeNs(DECODE_ITERATIONS, [&](unsigned int) {
+        for (const std::string& name : names)
+        {
+            if (name.compare(name.size() - 4, 4, ".png") == 0)
+            {
+                int width, height, bpp;
+                unsigned char* pixels = Texture::decodeImage(name, &width, &height, &bpp);
+                Benchmark::consume(pixels ? pixels[0] : 0);
+                stbi_image_free(pixels);
+            }
+            else if (name.compare(name.size() - 7, 7, ".shader") == 0)
+                Benchmark::consume(ShaderFile(name).getVariant(0).VertexSource.size());
+        }
+    });
+}
+
+// Text, noise and runs, so the codec sees matches, literals and long lengths.
+static bool checkRoundTrip()
+{
+    std::mt19937 random(23);
+    std::vector<unsigned char> data(ROUND_TRIP_SIZE);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        size_t block = i / 4096 % 3;
+        data[i] = block == 0 ? "uniform mat4 u_viewProjection;\n"[i % 31] : block == 1 ? (unsigned char)random() : 7;
+    }
+    std::vector<unsigned char> compressed = ResourcePack::compressLZ(data.data(), data.size());
+    std::vector<unsigned char> expanded(data.size());
+    bool matched = ResourcePack::decompressLZ(compressed.data(), compressed.size(), expanded.data(), expanded.size()) && expanded == data;
+    std::cout << "LZ round trip of " << data.size() / 1024 << " KB to " << compressed.size() / 1024 << " KB: " << (matched ? "matched" : "MISMATCHED") << "\n";
+    // A truncated block has to fail rather than read past its end.
+    return matched && !ResourcePack::decompressLZ(compressed.data(), compressed.size() / 2, expanded.data(), expanded.size());
+}
+
+static int resourcePackBenchmark()
+{
+    // The benchmark's pack stands in for whatever the launch mounted.
+    ResourcePack::unmount();
+    if (!ResourcePack::build("res", PACK_PATH, std::cout))
+        return 1;
+    std::vector<std::string> names;
+    std::vector<unsigned long long> hashes;
+    {
+        ResourcePack pack(PACK_PATH);
+        if (!pack.isValid() || !pack.verify())
+            return 1;
+        for (unsigned int i = 0; i < pack.getEntryCount(); i++)
+        {
+            names.push_back(pack.getName(pack.getEntry(i)));
+            hashes.push_back(pack.getEntry(i).contentHash);
+        }
+    }
+
+    bool matched = true;
+    ResourcePack::resetStats();
+    double looseNs = loadAll(names, matched, hashes);
+    double looseDecodeNs = decodeAll(names);
+    ResourcePack::printReport(std::cout);
+
+    ResourcePack::mount(PACK_PATH);
+    ResourcePack::resetStats();
+    double packNs = loadAll(names, matched, hashes);
+    double packDecodeNs = decodeAll(names);
+    ResourcePack::printReport(std::cout);
+    ResourcePack::Stats stats = ResourcePack::getStats();
+    ResourcePack::unmount();
+
+    std::cout << names.size() << " resources:\n";
+    Benchmark::printResult("load every resource, loose", looseNs / 1e3, "us");
+    Benchmark::printResult("load every resource, pack", packNs / 1e3, "us");
+    Benchmark::printResult("decode images and shaders, loose", looseDecodeNs / 1e6, "ms");
+    Benchmark::printResult("decode images and shaders, pack", packDecodeNs / 1e6, "ms");
+
+    bool correct = matched && stats.loose == 0 && checkRoundTrip();
+    std::remove(PACK_PATH);
+    ResourcePack::resetStats();
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("pack", "Resources from loose files against a memory-mapped pack, and the pack's LZ codec", resourcePackBenchmark);
@@ -0,0 +1,132 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../FrameStats.h"
+#include "../ProgramCache.h"
+#include "../ShaderLibrary.h"
+#include "../Texture.h"
+#include "../VertexBufferLayout.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+static const unsigned int PROGRAMS = 100;
+static const unsigned int TEXTURE_LOADS = 32;
+static const char* const SOURCE = "res/shaders/Simple.shader";
+
+static std::string getTemporaryPath(unsigned int index)
+{
+    // Beside the original, so its #includes are found.
+    return "res/shaders/shadercompile_" + std::to_string(index) + ".shader";
+}
+
+// Copies of one shader whose stages differ by a comment, so neither the ProgramCache nor a
+// cache in the driver has seen them. run makes every pass's copies new.
+static std::vector<std::string> writeVariants(unsigned int run)
+{
+    unsigned long long seed = (unsigned long long)std::chrono::steady_clock::now().time_since_epoch().count();
+    std::vector<std::string> paths;
+    for (unsigned int i = 0; i < PROGRAMS; i++)
+    {
+        paths.push_back(getTemporaryPath(i));
+        std::ifstream source(SOURCE);
+        std::ofstream file(paths.back());
+        std::string line;
+        while (getline(source, line))
+        {
+            file << line << "\n";
+            if (line.compare(0, 8, "#version") == 0)
+                file << "// variant " << seed << " " << run << " " << i << "\n";
+        }
+    }
+    return paths;
+}
+
+// What a scene loads besides its programs.
+static void loadTextures(std::vector<std::unique_ptr<Texture>>& textures)
+{
+    for (unsigned int i = 0; i < TEXTURE_LOADS; i++)
+        textures.emplace_back(new Texture(i % 2 ? "res/textures/Tile.png" : "res/textures/whiteTile.png"));
+}
+
+static int shaderCompileBenchmark()
+{
+    std::string directory = ProgramCache::getDirectory();
+    ProgramCache::setDirectory("");
+    Shader reference(SOURCE);
+    bool correct = true;
+
+    // Each program compiled and linked before the next, then the textures.
+    std::vector<std::string> paths = writeVariants(0);
+    std::vector<std::unique_ptr<Shader>> serial;
+    std::vector<std::unique_ptr<Texture>> textures;
+    double serialMs = Benchmark::timeNs(1, [&](unsigned int) {
+        for (const std::string& path : paths)
+            serial.emplace_back(new Shader(path));
+        loadTextures(textures);
+        GLCall(glFinish());
+    }) / 1e6;
+    for (const std::unique_ptr<Shader>& shader : serial)
+        correct &= shader->getUniforms().size() == reference.getUniforms().size();
+    serial.clear();
+    textures.clear();
+
+    // Every program handed to the driver first, the textures loaded while it works, and then
+    // whatever is left waited for.
+    paths = writeVariants(1);
+    std::vector<std::shared_ptr<Shader>> library;
+    double waitMs = 0.0;
+    unsigned int pendingAfterTextures = 0;
+    ShaderLibrary::resetStats();
+    double overlappedMs = Benchmark::timeNs(1, [&](unsigned int) {
+        for (const std::string& path : paths)
+            library.push_back(ShaderLibrary::load(path));
+        loadTextures(textures);
+        pendingAfterTextures = ShaderLibrary::update();
+        waitMs = Benchmark::timeNs(1, [&](unsigned int) {
+            ShaderLibrary::finish();
+        }) / 1e6;
+        GLCall(glFinish());
+    }) / 1e6;
+    for (const std::shared_ptr<Shader>& shader : library)
+        correct &= shader->isReady() && shader->getUniforms().size() == reference.getUniforms().size();
+
+    std::cout << PROGRAMS << " programs and " << TEXTURE_LOADS << " textures:\n";
+    Benchmark::printResult("compiled one at a time, then textures", serialMs, "ms");
+    Benchmark::printResult("submitted, textures, then waited", overlappedMs, "ms");
+    Benchmark::printResult("of which waiting after the textures", waitMs, "ms");
+    Benchmark::printResult("programs still compiling after textures", (double)pendingAfterTextures, "");
+    ShaderLibrary::printReport(std::cout);
+
+    // A draw with a program that has only been submitted is skipped.
+    std::vector<std::string> skippedPath = { getTemporaryPath(PROGRAMS) };
+    std::rename(writeVariants(2)[0].c_str(), skippedPath[0].c_str());
+    std::shared_ptr<Shader> submitted = ShaderLibrary::load(skippedPath[0]);
+    {
+        static const float vertices[] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        static const unsigned int indices[] = { 0, 0, 0 };
+        VertexBuffer vb(vertices, sizeof(vertices));
+        IndexBuffer ib(indices, 3);
+        VertexArray va;
+        VertexBufferLayout layout;
+        layout.push<float>(3);
+        layout.push<float>(2);
+        va.addBuffer(vb, layout);
+        FrameStats::reset();
+        Renderer renderer;
+        renderer.draw(va, ib, *submitted);
+        FrameStats::endFrame();
+        std::cout << "Drawing with a program just submitted: " << FrameStats::getLast(Stat::DrawsSkipped) << " draw skipped\n";
+        correct &= FrameStats::getLast(Stat::DrawsSkipped) == (submitted->isReady() ? 0u : 1u);
+    }
+    ShaderLibrary::finish();
+    correct &= submitted->isReady();
+
+    for (unsigned int i = 0; i <= PROGRAMS; i++)
+        std::remove(getTemporaryPath(i).c_str());
+    ProgramCache::setDirectory(directory);
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("shadercompile", "A hundred programs compiled one at a time against handed to the driver while textures load", shaderCompileBenchmark);
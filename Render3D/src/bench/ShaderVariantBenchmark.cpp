@@ -0,0 +1,109 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../ShaderLibrary.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static const unsigned int ITERATIONS = 2000;
+static const char* const PLAIN_SHADER = "res/shaders/Heatmap.shader";
+static const char* const VARIANT_SHADER = "res/shaders/Simple.shader";
+
+// How Shader parsed files before ShaderFile: a line at a time into a stringstream per stage.
+static ShaderProgramSource parseByLine(const std::string& filepath)
+{
+    std::ifstream stream(filepath);
+    std::string line;
+    std::stringstream ss[2];
+    int type = -1;
+    while (getline(stream, line))
+    {
+        if (line.find("$Shader$") != std::string::npos)
+        {
+            if (line.find("%Vertex%") != std::string::npos)
+                type = 0;
+            else if (line.find("%Fragment%") != std::string::npos)
+                type = 1;
+        }
+        else if (type >= 0)
+        {
+            ss[type] << line << "\n";
+        }
+    }
+    return { ss[0].str(), ss[1].str() };
+}
+
+static unsigned int findUniformType(const Shader& shader, const char* name)
+{
+    unsigned int hash = fnv1a(name);
+    for (const ShaderUniform& uniform : shader.getUniforms())
+    {
+        if (uniform.hash == hash && uniform.location >= 0)
+            return uniform.type;
+    }
+    return GL_NONE;
+}
+
+static int shaderVariantBenchmark()
+{
+    bool correct = true;
+
+    // A file without includes or options reads to the same stages either way.
+    std::cout << "Reading " << PLAIN_SHADER << ":\n";
+    double lineNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        Benchmark::consume(parseByLine(PLAIN_SHADER).FragmentSource.size());
+    });
+    double fileNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        Benchmark::consume(ShaderFile(PLAIN_SHADER).getVariant(0).FragmentSource.size());
+    });
+    Benchmark::printResult("getline into a stringstream per stage", lineNs / 1000.0, "us");
+    Benchmark::printResult("one read, split in place", fileNs / 1000.0, "us");
+    ShaderProgramSource byLine = parseByLine(PLAIN_SHADER);
+    ShaderProgramSource byFile = ShaderFile(PLAIN_SHADER).getVariant(0);
+    correct &= byLine.VertexSource == byFile.VertexSource && byLine.FragmentSource == byFile.FragmentSource;
+
+    double includeNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        Benchmark::consume(ShaderFile(VARIANT_SHADER).getVariant(0).FragmentSource.size());
+    });
+    Benchmark::printResult("Simple.shader with its includes", includeNs / 1000.0, "us");
+
+    // Each variant is compiled on first use, from the one read of the file.
+    ShaderLibrary::resetStats();
+    const ShaderFile& file = ShaderLibrary::getFile(VARIANT_SHADER);
+    correct &= file.isValid() && file.getOption("INSTANCED") == SIMPLE_INSTANCED && file.getOption("ATLAS") == SIMPLE_ATLAS
+        && file.getOption("UNTINTED") == SIMPLE_UNTINTED;
+    std::cout << "\nVariants of " << VARIANT_SHADER << ":\n";
+    std::vector<std::shared_ptr<Shader>> programs;
+    std::shared_ptr<Shader> atlasProgram;
+    for (unsigned int variant = 0; variant < (1u << file.getOptions().size()); variant++)
+    {
+        // Instances carry no atlas region, so the shader refuses that pair.
+        if ((variant & SIMPLE_INSTANCED) && (variant & SIMPLE_ATLAS))
+            continue;
+        std::shared_ptr<Shader> shader;
+        double compileMs = Benchmark::timeNs(1, [&](unsigned int) {
+            shader = ShaderLibrary::load(VARIANT_SHADER, variant);
+            shader->waitUntilReady();
+        }) / 1e6;
+
+        std::string label;
+        for (const std::string& define : file.getDefines(variant))
+            label += (label.empty() ? "" : " ") + define;
+        Benchmark::printResult(label.empty() ? "no options" : label.c_str(), compileMs, "ms");
+
+        bool instanced = (variant & SIMPLE_INSTANCED) != 0;
+        bool atlas = (variant & SIMPLE_ATLAS) != 0;
+        correct &= shader->isReady() && shader->isDefined("UNTINTED") == ((variant & SIMPLE_UNTINTED) != 0)
+            && (shader->getAttributeLocation("a_model") >= 0) == instanced
+            && findUniformType(*shader, "u_texture") == (atlas ? GL_SAMPLER_2D_ARRAY : GL_SAMPLER_2D)
+            && shader->bindUniformBlock(CameraBlock::getLayout()) && shader->bindUniformBlock(ObjectBlock::getLayout()) != instanced;
+        programs.push_back(shader);
+        if (variant == SIMPLE_ATLAS)
+            atlasProgram = shader;
+    }
+    correct &= ShaderLibrary::load(VARIANT_SHADER, SIMPLE_ATLAS) == atlasProgram && &ShaderLibrary::getFile(VARIANT_SHADER) == &file;
+    ShaderLibrary::printReport(std::cout);
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("variants", "Shader files read once with includes, and their option variants compiled on first use", shaderVariantBenchmark);
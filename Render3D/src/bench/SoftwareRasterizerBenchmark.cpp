@@ -0,0 +1,138 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../Scene.h"
+#include "../Framebuffer.h"
+#include "../FrameTimer.h"
+#include "../FrameStats.h"
+#include "../SoftwareRasterizer.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const unsigned int FRAMES = 10;
+
+// Pixels whose RGB differs by more than tolerance in any channel.
+static unsigned int countDifferent(const unsigned char* a, const unsigned char* b, int tolerance)
+{
+    unsigned int different = 0;
+    for (size_t i = 0; i < (size_t)WIDTH * HEIGHT * 4; i += 4)
+    {
+        different += std::abs(a[i] - b[i]) > tolerance || std::abs(a[i + 1] - b[i + 1]) > tolerance || std::abs(a[i + 2] - b[i + 2]) > tolerance;
+    }
+    return different;
+}
+
+static double renderSoftware(Scene& scene, const Camera& camera, SoftwareRasterizer& rasterizer, std::vector<unsigned char>& pixels)
+{
+    FrameTimer timer(FRAMES);
+    Benchmark::renderFrames(scene, camera, FRAMES, timer, &rasterizer);
+    pixels.assign(rasterizer.getPixels(), rasterizer.getPixels() + (size_t)WIDTH * HEIGHT * 4);
+    return timer.mean();
+}
+
+// Returns whether every thread count drew the same image.
+static bool benchmarkScene(const std::string& name, const Camera& camera, unsigned int cores)
+{
+    std::unique_ptr<Scene> scene = Scene::create(name);
+    scene->onUpdate(0.0f);
+    std::cout << "Scene '" << name << "':\n";
+
+    FrameTimer timer(FRAMES);
+    Benchmark::renderFrames(*scene, camera, FRAMES, timer);
+    std::vector<unsigned char> gpuPixels(WIDTH * HEIGHT * 4);
+    GLCall(glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, gpuPixels.data()));
+    Benchmark::printResult("GPU frame time", timer.mean(), "ms");
+
+    // The same frame on 1, 2, 4 ... threads and one per core.
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < cores; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(cores);
+
+    SoftwareRasterizer rasterizer(WIDTH, HEIGHT);
+    std::vector<unsigned char> firstPixels, pixels;
+    bool identical = true;
+    for (unsigned int threads : threadCounts)
+    {
+        rasterizer.setThreadCount(threads);
+        double ms = renderSoftware(*scene, camera, rasterizer, threads == 1 ? firstPixels : pixels);
+        if (threads > 1)
+            identical = identical && pixels == firstPixels;
+        std::string label = std::string("CPU frame time, ") + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+        Benchmark::printResult(label.c_str(), ms, "ms");
+        if (threads == 1)
+            Benchmark::printResult("pixels per second, 1 thread", (double)WIDTH * HEIGHT / ms / 1000.0, "M");
+    }
+    // More threads than cores still hand tiles out in a different order than one thread does.
+    rasterizer.setThreadCount(cores * 4);
+    renderSoftware(*scene, camera, rasterizer, pixels);
+    identical = identical && pixels == firstPixels;
+
+    Benchmark::printResult("triangles binned per frame", FrameStats::getAverage(Stat::TrianglesBinned), "");
+    std::cout << "  image is " << (identical ? "identical" : "DIFFERENT") << " across thread counts\n";
+    Benchmark::printResult("pixels that differ from the GPU", 100.0 * countDifferent(firstPixels.data(), gpuPixels.data(), 0) / (WIDTH * HEIGHT), "%");
+    Benchmark::printResult("pixels off by more than 8/255", 100.0 * countDifferent(firstPixels.data(), gpuPixels.data(), 8) / (WIDTH * HEIGHT), "%");
+    return identical;
+}
+
+// Returns whether every kernel drew the same image as the scalar one.
+static bool compareKernels(const Camera& camera)
+{
+    std::unique_ptr<Scene> scene = Scene::create("grid");
+    scene->onUpdate(0.0f);
+    std::cout << "Kernels, scene 'grid', 1 thread:\n";
+
+    SoftwareRasterizer rasterizer(WIDTH, HEIGHT);
+    rasterizer.setThreadCount(1);
+    std::vector<unsigned char> scalarPixels, pixels;
+    bool identical = true;
+    const SoftwareRasterizer::Kernel kernels[] = { SoftwareRasterizer::Kernel::Scalar, SoftwareRasterizer::Kernel::SSE, SoftwareRasterizer::Kernel::AVX2 };
+    for (SoftwareRasterizer::Kernel kernel : kernels)
+    {
+        if (kernel == SoftwareRasterizer::Kernel::AVX2 && SoftwareRasterizer::getBestKernel() != SoftwareRasterizer::Kernel::AVX2)
+            continue;
+        if (kernel == SoftwareRasterizer::Kernel::SSE && SoftwareRasterizer::getBestKernel() == SoftwareRasterizer::Kernel::Scalar)
+            continue;
+        rasterizer.setKernel(kernel);
+        double ms = renderSoftware(*scene, camera, rasterizer, kernel == SoftwareRasterizer::Kernel::Scalar ? scalarPixels : pixels);
+        Benchmark::printResult(SoftwareRasterizer::getKernelName(kernel), ms, "ms");
+        if (kernel != SoftwareRasterizer::Kernel::Scalar)
+        {
+            std::string label = std::string("pixels that differ from scalar, ") + SoftwareRasterizer::getKernelName(kernel);
+            unsigned int different = countDifferent(pixels.data(), scalarPixels.data(), 0);
+            Benchmark::printResult(label.c_str(), different, "");
+            identical = identical && different == 0;
+        }
+    }
+    return identical;
+}
+
+static int softwareBenchmark()
+{
+    Framebuffer framebuffer(WIDTH, HEIGHT);
+    framebuffer.bind();
+
+    // The camera the headless runner uses.
+    Camera camera;
+    camera.proj = glm::perspective(glm::radians(60.0f), (float)WIDTH / HEIGHT, 1.0f, 1000.0f);
+    camera.position = glm::vec3(0.0f, 4.0f, -5.0f);
+    camera.view = glm::lookAt(camera.position, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    const char* scenes[] = { "room", "grid", "layers", "tiles", "meshes", "building" };
+    bool identical = true;
+    for (const char* name : scenes)
+    {
+        identical &= benchmarkScene(name, camera, cores);
+        std::cout << "\n";
+    }
+    identical &= compareKernels(camera);
+    return identical ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("software", "CPU rasterizer: frame time by thread count and kernel, determinism and difference from the GPU image", softwareBenchmark);
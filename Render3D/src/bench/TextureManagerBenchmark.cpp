@@ -0,0 +1,155 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../FrameStats.h"
+#include "../TextureManager.h"
+#include "../CompressedImage.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+static const int IMAGE_SIZE = 256;
+static const unsigned int TEXTURE_COUNT = 64;
+static const unsigned int WORKING_SET = 16;
+static const unsigned int FRAMES_PER_SET = 8;
+static const unsigned int FRAMES = 64;
+static const unsigned int LOAD_ITERATIONS = 200;
+
+static std::string getTemporaryPath(unsigned int index)
+{
+    return "texturemanager_" + std::to_string(index) + ".dds";
+}
+
+// BC1 files with full chains, each a different color and noise, so none share contents.
+static std::vector<std::string> writeImages()
+{
+    std::mt19937 random(19);
+    std::vector<std::string> paths;
+    std::vector<unsigned char> pixels((size_t)IMAGE_SIZE * IMAGE_SIZE * 4);
+    for (unsigned int i = 0; i < TEXTURE_COUNT; i++)
+    {
+        unsigned int color = random();
+        for (size_t texel = 0; texel < pixels.size(); texel += 4)
+        {
+            for (int channel = 0; channel < 3; channel++)
+                pixels[texel + channel] = (unsigned char)((color >> (channel * 8)) & 0xc0) + random() % 64;
+            pixels[texel + 3] = 255;
+        }
+        MipChain mips(IMAGE_SIZE, IMAGE_SIZE, pixels.data());
+        mips.generate(MipChain::Filter::Box, true, true);
+        paths.push_back(getTemporaryPath(i));
+        CompressedImage(mips, BlockFormat::BC1).writeDDS(paths.back());
+    }
+    return paths;
+}
+
+static bool checkDeduplication(const std::vector<std::string>& paths)
+{
+    // A byte for byte copy under another name.
+    std::string copy = getTemporaryPath(TEXTURE_COUNT);
+    {
+        std::ifstream source(paths[0], std::ios::binary);
+        std::ofstream destination(copy, std::ios::binary);
+        destination << source.rdbuf();
+    }
+
+    TextureManager manager;
+    std::shared_ptr<Texture> first = manager.load(paths[0]);
+    bool shared = manager.load("./" + paths[0]) == first && manager.load("res/../" + paths[0]) == first && manager.load(copy) == first
+        && manager.load(paths[0], Texture::Options{ Texture::Mips::None, false, 1.0f, false, true }) != first;
+    TextureManager::Stats stats = manager.getStats();
+    shared &= manager.getTextureCount() == 2 && stats.pathHits == 2 && stats.contentHits == 1;
+    std::cout << "Five loads of one image under four paths and two option sets: " << manager.getTextureCount() << " textures, "
+        << stats.pathHits << " path hits, " << stats.contentHits << " content hits\n";
+
+    double hitNs = Benchmark::timeNs(LOAD_ITERATIONS, [&](unsigned int) {
+        Benchmark::consume(manager.load(paths[0])->getRendererId());
+    });
+    double missNs = Benchmark::timeNs(LOAD_ITERATIONS, [&](unsigned int) {
+        Texture texture(paths[0]);
+        Benchmark::consume(texture.getRendererId());
+    });
+    Benchmark::printResult("load, already made", hitNs / 1000.0, "us");
+    Benchmark::printResult("Texture from the file", missNs / 1000.0, "us");
+
+    std::remove(copy.c_str());
+    return shared;
+}
+
+static int textureManagerBenchmark()
+{
+    bool correct = true;
+    std::vector<std::string> paths = writeImages();
+    correct &= checkDeduplication(paths);
+
+    // Every texture stays referenced while a working set of them is drawn, moving on every
+    // few frames, so the budget can only be met by dropping levels.
+    TextureManager manager;
+    std::vector<std::shared_ptr<Texture>> textures;
+    size_t fullSize = 0;
+    for (const std::string& path : paths)
+    {
+        textures.push_back(manager.load(path));
+        fullSize += textures.back()->getVideoMemorySize();
+    }
+    // Room for the working set and a little more, however the driver stores the textures.
+    size_t budget = fullSize / TEXTURE_COUNT * WORKING_SET * 3 / 2;
+    manager.setBudget(budget);
+    std::cout << "\n" << TEXTURE_COUNT << " " << IMAGE_SIZE << "x" << IMAGE_SIZE << " BC1 textures, " << fullSize / 1024 << " KB with every level, budget "
+        << budget / 1024 << " KB, " << WORKING_SET << " drawn a frame:\n";
+
+    FrameStats::reset();
+    size_t largest = 0;
+    double updateMs = 0.0;
+    for (unsigned int frame = 0; frame < FRAMES; frame++)
+    {
+        unsigned int first = frame / FRAMES_PER_SET * WORKING_SET;
+        for (unsigned int i = 0; i < WORKING_SET; i++)
+            textures[(first + i) % TEXTURE_COUNT]->bind(0);
+        updateMs += Benchmark::timeNs(1, [&](unsigned int) {
+            manager.update();
+            GLCall(glFinish());
+        }) / 1e6;
+        largest = std::max(largest, manager.getVideoMemorySize());
+        FrameStats::endFrame();
+    }
+    unsigned int first = (FRAMES - 1) / FRAMES_PER_SET * WORKING_SET;
+    double drawnLevel = 0.0, otherLevel = 0.0;
+    for (unsigned int i = 0; i < TEXTURE_COUNT; i++)
+    {
+        bool drawn = (i + TEXTURE_COUNT - first % TEXTURE_COUNT) % TEXTURE_COUNT < WORKING_SET;
+        (drawn ? drawnLevel : otherLevel) += textures[i]->getFirstLevel();
+    }
+    drawnLevel /= WORKING_SET;
+    otherLevel /= TEXTURE_COUNT - WORKING_SET;
+    Benchmark::printResult("most video memory after an update", largest / 1024.0, "KB");
+    Benchmark::printResult("update", updateMs / FRAMES, "ms/frame");
+    Benchmark::printResult("levels dropped", (double)manager.getStats().levelsDropped, "");
+    Benchmark::printResult("levels restored", (double)manager.getStats().levelsRestored, "");
+    Benchmark::printResult("first level, working set", drawnLevel, "");
+    Benchmark::printResult("first level, the rest", otherLevel, "");
+    correct &= largest <= budget && drawnLevel < otherLevel;
+
+    // Dropping the handles lets the unused textures go, and the rest get their levels back.
+    for (unsigned int i = WORKING_SET; i < TEXTURE_COUNT; i++)
+        textures[(first + i) % TEXTURE_COUNT].reset();
+    for (unsigned int i = 0; i < WORKING_SET; i++)
+        textures[(first + i) % TEXTURE_COUNT]->bind(0);
+    manager.update();
+    FrameStats::endFrame();
+    unsigned int droppedLevels = 0;
+    for (const std::shared_ptr<Texture>& texture : textures)
+        droppedLevels += texture ? texture->getFirstLevel() : 0;
+    std::cout << "After releasing all but the working set: " << manager.getTextureCount() << " textures, "
+        << manager.getVideoMemorySize() / 1024 << " KB, " << droppedLevels << " levels still dropped\n";
+    correct &= manager.getVideoMemorySize() <= budget && droppedLevels == 0;
+
+    std::cout << "\n";
+    FrameStats::printReport(std::cout);
+    textures.clear();
+    for (const std::string& path : paths)
+        std::remove(path.c_str());
+    return correct ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("textures", "TextureManager: sharing by path and contents, and a video memory budget met by dropping mip levels", textureManagerBenchmark);
@@ -0,0 +1,94 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include "../Framebuffer.h"
+#include "../FrameTimer.h"
+#include "../FrameStats.h"
+#include "../JobSystem.h"
+#include "../StreamingScene.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <iostream>
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const unsigned int FRAMES = 240;
+// How much longer than the slowest frame without loading a streaming frame may take: the
+// streamer's decode budget when it has no job threads, plus room for uploads and noise.
+static const double ALLOWED_STALL_MS = 5.0;
+
+// Frames of the scene with glFinish after each, optionally without onUpdate so nothing loads.
+static void renderFrames(StreamingScene& scene, const Camera& camera, bool update, FrameTimer& timer)
+{
+    Renderer renderer;
+    timer.beginRun();
+    for (unsigned int frame = 0; frame < FRAMES; frame++)
+    {
+        timer.beginFrame();
+        if (update)
+            scene.onUpdate(1.0f / 60.0f);
+        renderer.beginFrame();
+        renderer.clear();
+        scene.onRender(renderer, camera);
+        renderer.endFrame();
+        GLCall(glFinish());
+        timer.endFrame();
+    }
+    timer.endRun();
+}
+
+static void printTimes(const FrameTimer& timer)
+{
+    Benchmark::printResult("frame time p50", timer.percentile(50.0), "ms");
+    Benchmark::printResult("frame time p99", timer.percentile(99.0), "ms");
+    Benchmark::printResult("frame time max", timer.percentile(100.0), "ms");
+}
+
+static int textureStreamingBenchmark()
+{
+    Framebuffer framebuffer(WIDTH, HEIGHT);
+    framebuffer.bind();
+
+    Camera camera;
+    camera.proj = glm::perspective(glm::radians(60.0f), (float)WIDTH / HEIGHT, 1.0f, 1000.0f);
+    camera.position = glm::vec3(0.0f, 4.0f, -5.0f);
+    camera.view = glm::lookAt(camera.position, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    JobSystem jobs;
+    double baselineMax = 0.0, streamedMax = 0.0;
+    for (bool streamed : { false, true })
+    {
+        StreamingScene scene(streamed);
+        scene.setJobSystem(&jobs);
+        std::cout << (streamed ? "Streamed" : "Blocking") << ", " << scene.getTileCount() << " textures loaded again and again, "
+            << jobs.getThreadCount() << (jobs.getThreadCount() == 1 ? " thread" : " threads") << ":\n";
+
+        FrameStats::reset();
+        FrameTimer timer(FRAMES);
+        renderFrames(scene, camera, true, timer);
+        printTimes(timer);
+        if (streamed)
+        {
+            streamedMax = timer.percentile(100.0);
+            Benchmark::printResult("textures made resident", scene.getStreamer().getLoadedCount(), "");
+            Benchmark::printResult("uploaded per frame", FrameStats::getAverage(Stat::TextureBytesStreamed) / 1024.0, "KB");
+
+            // The same frames with every texture resident and nothing loading, for what a frame
+            // costs without streaming. The run may have ended just after the scene dropped them.
+            while (scene.getResidentCount() < scene.getTileCount())
+                scene.onUpdate(1.0f / 60.0f);
+            FrameTimer baseline(FRAMES);
+            renderFrames(scene, camera, false, baseline);
+            baselineMax = baseline.percentile(100.0);
+            std::cout << "Nothing loading:\n";
+            printTimes(baseline);
+        }
+        std::cout << "\n";
+    }
+
+    double bound = baselineMax + ALLOWED_STALL_MS;
+    bool passed = streamedMax <= bound;
+    std::cout << "Slowest streaming frame " << streamedMax << " ms, bound " << bound << " ms: " << (passed ? "passed" : "FAILED") << "\n";
+    return passed ? 0 : 1;
+}
+
+REGISTER_BENCHMARK("streaming", "texture streaming: frame times while loading hundreds of textures, blocking against streamed, with a bound on the slowest frame", textureStreamingBenchmark);
@@ -0,0 +1,58 @@
+#include "../Benchmark.h"
+#include "../Renderer.h"
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+static constexpr Uniform<glm::vec4> u_color("u_color");
+static constexpr Uniform<glm::mat4> u_mvp("u_mvp");
+
+// The lookup Shader used before uniforms were reflected: a string built per call, then
+// hashed once by find() and again by operator[].
+static int mapLookup(std::unordered_map<std::string, int>& cache, unsigned int program, const std::string& name)
+{
+    if (cache.find(name) != cache.end())
+        return cache[name];
+    int location = glGetUniformLocation(program, name.c_str());
+    cache[name] = location;
+    return location;
+}
+
+static int uniformBenchmark()
+{
+    const unsigned int ITERATIONS = 1000000;
+
+    Shader shader("res/shaders/Flat.shader");
+    shader.bind();
+
+    GLint program = 0;
+    GLCall(glGetIntegerv(GL_CURRENT_PROGRAM, &program));
+    std::unordered_map<std::string, int> cache;
+
+    std::cout << "Lookup of the uniforms one draw sets:\n";
+    double mapNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        Benchmark::consume(mapLookup(cache, program, "u_color") + mapLookup(cache, program, "u_mvp"));
+    });
+    double handleNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        Benchmark::consume(shader.getUniformLocation(u_color) + shader.getUniformLocation(u_mvp));
+    });
+    Benchmark::printResult("std::string + unordered_map", mapNs, "ns/draw");
+    Benchmark::printResult("constexpr UniformHandle + flat table", handleNs, "ns/draw");
+    Benchmark::printResult("speedup", mapNs / handleNs, "x");
+
+    std::cout << "\nLookup and glUniform* upload:\n";
+    glm::mat4 mvp(1.0f);
+    double mapSetNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        glUniform4f(mapLookup(cache, program, "u_color"), 1.0f, 1.0f, 1.0f, 1.0f);
+        glUniformMatrix4fv(mapLookup(cache, program, "u_mvp"), 1, GL_FALSE, &mvp[0][0]);
+    });
+    double handleSetNs = Benchmark::timeNs(ITERATIONS, [&](unsigned int) {
+        glUniform4f(shader.getUniformLocation(u_color), 1.0f, 1.0f, 1.0f, 1.0f);
+        glUniformMatrix4fv(shader.getUniformLocation(u_mvp), 1, GL_FALSE, &mvp[0][0]);
+    });
+    Benchmark::printResult("std::string + unordered_map", mapSetNs, "ns/draw");
+    Benchmark::printResult("constexpr UniformHandle + flat table", handleSetNs, "ns/draw");
+    return 0;
+}
+
+REGISTER_BENCHMARK("uniforms", "uniform location lookup: string map vs compile-time hashed handles", uniformBenchmark);